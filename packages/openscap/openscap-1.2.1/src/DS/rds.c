@@ -32,6 +32,7 @@
 #include "common/_error.h"
 #include "common/util.h"
 #include "common/list.h"
+#include "common/xmlstream_priv.h"
 
 #include "ds_common.h"
 #include "ds_rds_session.h"
@@ -44,6 +45,7 @@
 #include <time.h>
 #include <libgen.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <libxml/parser.h>
 #include <libxml/tree.h>
@@ -667,11 +669,8 @@ static void ds_rds_add_xccdf_test_results(xmlDocPtr doc, xmlNodePtr reports,
 	}
 }
 
-static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources)
+static xmlNodePtr ds_rds_create_root(xmlDocPtr doc, xmlNodePtr *relationships)
 {
-	*ret = NULL;
-
-	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
 	xmlNodePtr root = xmlNewNode(NULL, BAD_CAST "asset-report-collection");
 	xmlDocSetRootElement(doc, root);
 
@@ -681,10 +680,105 @@ static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr x
 	xmlNsPtr core_ns = xmlNewNs(root, BAD_CAST core_ns_uri, BAD_CAST "core");
 	xmlNewNs(root, BAD_CAST ai_ns_uri, BAD_CAST "ai");
 
-	xmlNodePtr relationships = xmlNewNode(core_ns, BAD_CAST "relationships");
-	xmlNewNs(relationships, BAD_CAST arfvocab_ns_uri, BAD_CAST "arfvocab");
-	xmlNewNs(relationships, BAD_CAST arfrel_ns_uri, BAD_CAST "arfrel");
-	xmlAddChild(root, relationships);
+	*relationships = xmlNewNode(core_ns, BAD_CAST "relationships");
+	xmlNewNs(*relationships, BAD_CAST arfvocab_ns_uri, BAD_CAST "arfvocab");
+	xmlNewNs(*relationships, BAD_CAST arfrel_ns_uri, BAD_CAST "arfrel");
+	xmlAddChild(root, *relationships);
+
+	return root;
+}
+
+/*
+ * Write `content_doc' wrapped in <`name' id=`id'><content> to the stream.
+ * The document is written as it is, not copied to the ARF document.
+ */
+static int ds_rds_stream_content(struct oscap_xml_stream *stream, xmlNodePtr parent,
+		const char *name, const char *id, xmlDocPtr content_doc)
+{
+	xmlNsPtr arf_ns = parent->ns;
+
+	xmlNodePtr node = xmlNewNode(arf_ns, BAD_CAST name);
+	xmlSetProp(node, BAD_CAST "id", BAD_CAST id);
+	xmlAddChild(parent, node);
+	oscap_xml_stream_push(stream, node);
+
+	xmlNodePtr content = xmlNewNode(arf_ns, BAD_CAST "content");
+	xmlAddChild(node, content);
+	oscap_xml_stream_push(stream, content);
+
+	oscap_xml_stream_copy(stream, content_doc, xmlDocGetRootElement(content_doc));
+
+	oscap_xml_stream_pop(stream);
+	return oscap_xml_stream_pop(stream);
+}
+
+/*
+ * Same output as ds_rds_create_from_dom() followed by saving the document,
+ * but the SDS and OVAL results, which make most of the report, are written
+ * straight from their own documents. Only the relationships, the assets and
+ * the XCCDF reports are built in memory. Each OVAL result source is parsed
+ * just before it is written and released again afterwards if it can be.
+ */
+static int ds_rds_stream_from_sources(struct oscap_xml_stream *stream, xmlDocPtr doc, xmlDocPtr sds_doc,
+		xmlDocPtr xccdf_result_file_doc, struct oscap_htable *oval_result_sources)
+{
+	xmlNodePtr relationships = NULL;
+	xmlNodePtr root = ds_rds_create_root(doc, &relationships);
+	xmlNsPtr arf_ns = root->ns;
+
+	// assets and reports are filled in together with the relationships,
+	// they are attached when their turn comes
+	xmlNodePtr assets = xmlNewNode(arf_ns, BAD_CAST "assets");
+	xmlNodePtr reports = xmlNewNode(arf_ns, BAD_CAST "reports");
+
+	ds_rds_add_xccdf_test_results(doc, reports, xccdf_result_file_doc,
+			relationships, assets, "collection1");
+
+	oscap_xml_stream_push(stream, root);
+	oscap_xml_stream_flush(stream);
+
+	xmlNodePtr report_requests = xmlNewNode(arf_ns, BAD_CAST "report-requests");
+	xmlAddChild(root, report_requests);
+	oscap_xml_stream_push(stream, report_requests);
+	ds_rds_stream_content(stream, report_requests, "report-request", "collection1", sds_doc);
+	oscap_xml_stream_pop(stream);
+
+	xmlAddChild(root, assets);
+	oscap_xml_stream_flush(stream);
+
+	xmlAddChild(root, reports);
+	oscap_xml_stream_push(stream, reports);
+	oscap_xml_stream_flush(stream);
+
+	unsigned int oval_report_suffix = 2;
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(oval_result_sources);
+	while (oscap_htable_iterator_has_more(hit)) {
+		struct oscap_source *oval_source = oscap_htable_iterator_next_value(hit);
+		xmlDoc *oval_result_doc = oscap_source_get_xmlDoc(oval_source);
+		if (oval_result_doc == NULL) {
+			oscap_htable_iterator_free(hit);
+			return -1;
+		}
+
+		char* report_id = oscap_sprintf("oval%i", oval_report_suffix++);
+		ds_rds_stream_content(stream, reports, "report", report_id, oval_result_doc);
+		oscap_free(report_id);
+
+		oscap_source_free_xmlDoc(oval_source);
+	}
+	oscap_htable_iterator_free(hit);
+
+	return 0;
+}
+
+static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources)
+{
+	*ret = NULL;
+
+	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
+	xmlNodePtr relationships = NULL;
+	xmlNodePtr root = ds_rds_create_root(doc, &relationships);
+	xmlNsPtr arf_ns = root->ns;
 
 	xmlNodePtr report_requests = xmlNewNode(arf_ns, BAD_CAST "report-requests");
 	xmlAddChild(root, report_requests);
@@ -750,37 +844,56 @@ struct oscap_source *ds_rds_create_source(struct oscap_source *sds_source, struc
 	return oscap_source_new_from_xmlDoc(rds_doc, target_file);
 }
 
+int ds_rds_create_file(struct oscap_source *sds_source, struct oscap_source *xccdf_result_source, struct oscap_htable *oval_result_sources, const char *target_file)
+{
+	xmlDoc *sds_doc = oscap_source_get_xmlDoc(sds_source);
+	if (sds_doc == NULL) {
+		return -1;
+	}
+	xmlDoc *result_file_doc = oscap_source_get_xmlDoc(xccdf_result_source);
+	if (result_file_doc == NULL) {
+		return -1;
+	}
+
+	xmlDocPtr rds_doc = xmlNewDoc(BAD_CAST "1.0");
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(target_file, rds_doc);
+	if (stream == NULL) {
+		xmlFreeDoc(rds_doc);
+		return -1;
+	}
+
+	int result = ds_rds_stream_from_sources(stream, rds_doc, sds_doc, result_file_doc, oval_result_sources);
+	if (oscap_xml_stream_close(stream) != 0) {
+		result = -1;
+	}
+	xmlFreeDoc(rds_doc);
+
+	// don't leave a truncated report behind
+	if (result != 0 && strcmp(target_file, "-") != 0) {
+		unlink(target_file);
+	}
+	return result;
+}
+
 int ds_rds_create(const char* sds_file, const char* xccdf_result_file, const char** oval_result_files, const char* target_file)
 {
 	struct oscap_source *sds_source = oscap_source_new_from_file(sds_file);
 	struct oscap_source *xccdf_result_source = oscap_source_new_from_file(xccdf_result_file);
 	struct oscap_htable *oval_result_sources = oscap_htable_new();
 
-	int result = 0;
 	// this check is there to allow passing NULL instead of having to allocate
-	// an empty array
+	// an empty array. The OVAL results are parsed one by one while the
+	// report is written.
 	if (oval_result_files != NULL)
 	{
 		while (*oval_result_files != NULL)
 		{
 			struct oscap_source *oval_source = oscap_source_new_from_file(*oval_result_files);
-			if (oscap_source_get_xmlDoc(oval_source) == NULL) {
-				result = -1;
-				oscap_source_free(oval_source);
-			} else {
-				oscap_htable_add(oval_result_sources, *oval_result_files, oval_source);
-			}
+			oscap_htable_add(oval_result_sources, *oval_result_files, oval_source);
 			oval_result_files++;
 		}
 	}
-	if (result == 0) {
-		struct oscap_source *target_rds = ds_rds_create_source(sds_source, xccdf_result_source, oval_result_sources, target_file);
-		result = target_rds == NULL;
-		if (result == 0) {
-			result = oscap_source_save_as(target_rds, NULL);
-		}
-		oscap_source_free(target_rds);
-	}
+	int result = ds_rds_create_file(sds_source, xccdf_result_source, oval_result_sources, target_file);
 	oscap_htable_free(oval_result_sources, (oscap_destruct_func) oscap_source_free);
 	oscap_source_free(sds_source);
 	oscap_source_free(xccdf_result_source);
@@ -0,0 +1,177 @@
+/**
+ * @file oval_arena.c
+ * \brief Open Vulnerability and Assessment Language
+ *
+ * See more details at http://oval.mitre.org/
+ */
+
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "oval_arena_impl.h"
+#include "common/alloc.h"
+
+/*
+ * The memory is cut from chunks by bumping the used offset of the newest
+ * chunk atomically, the mutex is taken only to add a chunk. Requests
+ * larger than a quarter of a chunk get a chunk of their own, which is
+ * linked behind the newest one so that its free space is not lost.
+ *
+ * A chunk with its header is as large as the default mmap threshold of
+ * glibc, so the chunks are mapped and unmapped as a whole instead of
+ * being merged with the small blocks around them.
+ */
+
+#define OVAL_ARENA_CHUNK (128 * 1024 - sizeof(struct oval_arena_chunk))
+#define OVAL_ARENA_ALIGN 8
+
+struct oval_arena_chunk {
+	struct oval_arena_chunk *next;
+	size_t size;
+	size_t used;	/* may exceed size, then the chunk is full */
+	char   data[] __attribute__ ((aligned (OVAL_ARENA_ALIGN)));
+};
+
+struct oval_arena {
+	struct oval_arena_chunk *volatile chunks; /* the newest first */
+	pthread_mutex_t lock;
+};
+
+static struct oval_arena_chunk *_oval_arena_chunk_new(size_t size)
+{
+	struct oval_arena_chunk *chunk = oscap_alloc(sizeof(struct oval_arena_chunk) + size);
+
+	if (chunk == NULL)
+		return NULL;
+
+	chunk->next = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+
+	return chunk;
+}
+
+struct oval_arena *oval_arena_new(void)
+{
+	struct oval_arena *arena = oscap_talloc(struct oval_arena);
+
+	if (arena == NULL)
+		return NULL;
+
+	arena->chunks = NULL;
+	if (pthread_mutex_init(&arena->lock, NULL) != 0) {
+		oscap_free(arena);
+		return NULL;
+	}
+
+	return arena;
+}
+
+void *oval_arena_alloc(struct oval_arena *arena, size_t size)
+{
+	struct oval_arena_chunk *chunk, *head;
+	size_t used;
+
+	size = (size + OVAL_ARENA_ALIGN - 1) & ~((size_t)OVAL_ARENA_ALIGN - 1);
+	if (size == 0)
+		size = OVAL_ARENA_ALIGN;
+
+	if (size > OVAL_ARENA_CHUNK / 4) {
+		chunk = _oval_arena_chunk_new(size);
+		if (chunk == NULL)
+			return NULL;
+		chunk->used = size;
+
+		if (pthread_mutex_lock(&arena->lock) != 0)
+			abort();
+		head = arena->chunks;
+		if (head != NULL) {
+			chunk->next = head->next;
+			head->next  = chunk;
+		} else
+			arena->chunks = chunk;
+		if (pthread_mutex_unlock(&arena->lock) != 0)
+			abort();
+
+		return chunk->data;
+	}
+
+	for (;;) {
+		head = arena->chunks;
+		if (head != NULL) {
+			used = __sync_fetch_and_add(&head->used, size);
+			if (used + size <= head->size)
+				return head->data + used;
+		}
+
+		if (pthread_mutex_lock(&arena->lock) != 0)
+			abort();
+		/* another thread may have added a chunk meanwhile */
+		if (arena->chunks == head) {
+			chunk = _oval_arena_chunk_new(OVAL_ARENA_CHUNK);
+			if (chunk != NULL) {
+				chunk->next = head;
+				__sync_synchronize();
+				arena->chunks = chunk;
+			}
+		} else
+			chunk = arena->chunks;
+		if (pthread_mutex_unlock(&arena->lock) != 0)
+			abort();
+
+		if (chunk == NULL)
+			return NULL;
+	}
+}
+
+char *oval_arena_strdup(struct oval_arena *arena, const char *str)
+{
+	size_t len;
+	char *copy;
+
+	if (str == NULL)
+		return NULL;
+
+	len  = strlen(str) + 1;
+	copy = oval_arena_alloc(arena, len);
+	if (copy != NULL)
+		memcpy(copy, str, len);
+
+	return copy;
+}
+
+void oval_arena_free(struct oval_arena *arena)
+{
+	struct oval_arena_chunk *chunk, *next;
+
+	if (arena == NULL)
+		return;
+
+	for (chunk = arena->chunks; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		oscap_free(chunk);
+	}
+	pthread_mutex_destroy(&arena->lock);
+	oscap_free(arena);
+}
@@ -0,0 +1,56 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * Region allocator. The memory allocated from an arena is never freed
+ * alone, all of it is released at once by oval_arena_free(). A model
+ * keeps the memory of its objects in its arena, so loading the model
+ * makes a few large allocations and freeing it releases them.
+ *
+ * Allocating from an arena is thread-safe.
+ */
+
+#ifndef OVAL_ARENA_H
+#define OVAL_ARENA_H
+
+#include <stddef.h>
+#include "common/util.h"
+
+OSCAP_HIDDEN_START;
+
+struct oval_arena;
+
+struct oval_arena *oval_arena_new(void);
+
+/**
+ * Allocate `size' bytes aligned for pointers, integers and doubles.
+ * @returns NULL if there is no memory left
+ */
+void *oval_arena_alloc(struct oval_arena *arena, size_t size);
+
+/**
+ * Copy the string `str' into the arena.
+ * @returns the copy or NULL if `str' is NULL
+ */
+char *oval_arena_strdup(struct oval_arena *arena, const char *str);
+
+/**
+ * Release all the memory allocated from the arena and the arena.
+ */
+void oval_arena_free(struct oval_arena *arena);
+
+OSCAP_HIDDEN_END;
+
+#endif
@@ -33,9 +33,11 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "oval_adt.h"
 #include "oval_collection_impl.h"
+#include "oval_arena_impl.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
 
@@ -43,21 +45,33 @@
 /* Variable definitions
  * */
 
-typedef struct _oval_collection_item_frame {
-	struct _oval_collection_item_frame *next;
-	void *item;
-} _oval_collection_item_frame_t;
+/*
+ * The items are kept in arrays instead of linked frames. A collection
+ * holds its first item inline, so a collection of a single item is one
+ * allocation. An iterator is always one allocation.
+ *
+ * A collection created with an arena keeps itself and its items in the
+ * arena, growing it leaves the old array behind and freeing it frees
+ * only the items.
+ */
+#define OVAL_COLLECTION_INLINE   1
+#define OVAL_COLLECTION_MIN_SIZE 4
 
 typedef struct oval_collection {
-	struct _oval_collection_item_frame *item_collection_frame;
+	void **items;		/* in the order they were added */
+	size_t count;
+	size_t size;
+	struct oval_arena *arena;	/* NULL if allocated from the heap */
+	void *inline_items[OVAL_COLLECTION_INLINE];
 } oval_collection_t;
 
 typedef struct oval_iterator {
-	struct _oval_collection_item_frame *item_iterator_frame;
+	void **items;		/* a stack, the next item is the last one */
+	size_t count;
+	size_t size;
+	void *inline_items[];	/* items of oval_collection_iterator() */
 } oval_iterator_t;
 
-static bool debug = true;
-static struct oval_iterator *_debugStack[0];
 static int iterator_count;
 
 /* End of variable definitions
@@ -70,7 +84,28 @@ struct oval_collection *oval_collection_new()
 	if (collection == NULL)
 		return NULL;
 
-	collection->item_collection_frame = NULL;
+	collection->items = collection->inline_items;
+	collection->count = 0;
+	collection->size = OVAL_COLLECTION_INLINE;
+	collection->arena = NULL;
+	return collection;
+}
+
+struct oval_collection *oval_collection_new_arena(struct oval_arena *arena)
+{
+	struct oval_collection *collection;
+
+	if (arena == NULL)
+		return oval_collection_new();
+
+	collection = oval_arena_alloc(arena, sizeof(oval_collection_t));
+	if (collection == NULL)
+		return NULL;
+
+	collection->items = collection->inline_items;
+	collection->count = 0;
+	collection->size = OVAL_COLLECTION_INLINE;
+	collection->arena = arena;
 	return collection;
 }
 
@@ -82,19 +117,19 @@ void oval_collection_free(struct oval_collection *collection)
 void oval_collection_free_items(struct oval_collection *collection, oscap_destruct_func free_func)
 {
 	if (collection) {
-		struct _oval_collection_item_frame *frame = collection->item_collection_frame;
-		while (frame != NULL) {
-			if (free_func != NULL) {
-				void *item = frame->item;
+		if (free_func != NULL) {
+			/* the most recently added item first */
+			size_t i = collection->count;
+			while (i-- > 0) {
+				void *item = collection->items[i];
 				if (item)
 					(*free_func) (item);
-				frame->item = NULL;
 			}
-			struct _oval_collection_item_frame *temp = frame;
-			frame = frame->next;
-			temp->next = NULL;
-			oscap_free(temp);
 		}
+		if (collection->arena != NULL)
+			return;
+		if (collection->items != collection->inline_items)
+			oscap_free(collection->items);
 		oscap_free(collection);
 	}
 }
@@ -103,42 +138,46 @@ void oval_collection_add(struct oval_collection *collection, void *item)
 {
 	__attribute__nonnull__(collection);
 
-	struct _oval_collection_item_frame *next = oscap_alloc(sizeof(_oval_collection_item_frame_t));
-	if (next == NULL)
-		return;
-
-	next->next = collection->item_collection_frame;
-	collection->item_collection_frame = next;
-	next->item = item;
+	if (collection->count == collection->size) {
+		size_t size = collection->size < OVAL_COLLECTION_MIN_SIZE ? OVAL_COLLECTION_MIN_SIZE : collection->size * 2;
+		void **items;
+
+		if (collection->arena != NULL) {
+			items = oval_arena_alloc(collection->arena, size * sizeof(void *));
+			if (items != NULL)
+				memcpy(items, collection->items, collection->count * sizeof(void *));
+		} else if (collection->items == collection->inline_items) {
+			items = oscap_alloc(size * sizeof(void *));
+			if (items != NULL)
+				memcpy(items, collection->items, collection->count * sizeof(void *));
+		} else
+			items = oscap_realloc(collection->items, size * sizeof(void *));
+		if (items == NULL)
+			return;
+		collection->items = items;
+		collection->size = size;
+	}
+	collection->items[collection->count++] = item;
 }
 
 struct oval_iterator *oval_collection_iterator(struct oval_collection *collection)
 {
 	__attribute__nonnull__(collection);
 
-	struct oval_iterator *iterator = (struct oval_iterator *)oscap_alloc(sizeof(oval_iterator_t));
+	size_t i, count = collection->count;
+	struct oval_iterator *iterator = (struct oval_iterator *)oscap_alloc(sizeof(oval_iterator_t) + count * sizeof(void *));
 	if (iterator == NULL)
 		return NULL;
 
-	if ((iterator_count++) < 0) {
-		_debugStack[iterator_count - 1] = iterator;
+	if ((iterator_count++) < 0)
 		oscap_dlprintf(DBG_W, "iterator_count: %d.\n", iterator_count);
-	}
-
-	iterator->item_iterator_frame = NULL;
-	struct _oval_collection_item_frame *collection_frame = collection->item_collection_frame;
 
-	while (collection_frame != NULL) {
-		struct _oval_collection_item_frame *iterator_frame =
-		    (struct _oval_collection_item_frame *)oscap_alloc(sizeof(_oval_collection_item_frame_t));
-		if (iterator_frame == NULL)
-			return NULL;
+	iterator->items = iterator->inline_items;
+	iterator->count = count;
+	iterator->size = count;
+	for (i = 0; i < count; ++i)
+		iterator->items[i] = collection->items[count - i - 1];
 
-		iterator_frame->next = iterator->item_iterator_frame;
-		iterator_frame->item = collection_frame->item;
-		iterator->item_iterator_frame = iterator_frame;
-		collection_frame = collection_frame->next;
-	}
 	return iterator;
 }
 
@@ -146,7 +185,7 @@ bool oval_collection_iterator_has_more(struct oval_iterator * iterator)
 {
 	__attribute__nonnull__(iterator);
 
-	return iterator->item_iterator_frame != NULL;
+	return iterator->count > 0;
 }
 
 int oval_collection_iterator_remaining(struct oval_iterator *iterator)
@@ -154,53 +193,27 @@ int oval_collection_iterator_remaining(struct oval_iterator *iterator)
 
 	__attribute__nonnull__(iterator);
 
-	int remaining;
-	struct _oval_collection_item_frame *next = iterator->item_iterator_frame;
-
-	for (remaining = 0; next; remaining++)
-		next = next->next;
-
-	return remaining;
+	return iterator->count;
 }
 
 void *oval_collection_iterator_next(struct oval_iterator *iterator)
 {
 	__attribute__nonnull__(iterator);
 
-	struct _oval_collection_item_frame *oc_next = iterator->item_iterator_frame;
-	void *next;
-
-	if (oc_next == NULL) {
-		next = NULL;
-	} else {
-		next = oc_next->item;
-		iterator->item_iterator_frame = oc_next->next;
-		oc_next->item = NULL;
-		oc_next->next = NULL;
-		oscap_free(oc_next);
-	}
-	return next;
+	if (iterator->count == 0)
+		return NULL;
+
+	return iterator->items[--iterator->count];
 }
 
 void oval_collection_iterator_free(struct oval_iterator *iterator)
 {
 	if (iterator) {		//NOOP if iterator is NULL
-		if ((--iterator_count) < 0) {
+		if ((--iterator_count) < 0)
 			oscap_dlprintf(DBG_W, "iterator_count: %d.\n", iterator_count);
-			if (iterator != _debugStack[iterator_count]) {
-				debug = false;
-			}
-		}
 
-		while (iterator->item_iterator_frame) {
-			struct _oval_collection_item_frame *oc_this;
-			oc_this = iterator->item_iterator_frame;
-			iterator->item_iterator_frame = oc_this->next;
-			oc_this->item = NULL;
-			oc_this->next = NULL;
-			oscap_free(oc_this);
-		}
-		iterator->item_iterator_frame = NULL;
+		if (iterator->items != iterator->inline_items)
+			oscap_free(iterator->items);
 		oscap_free(iterator);
 	}
 }
@@ -211,11 +224,12 @@ struct oval_iterator *oval_collection_iterator_new()
 	if (iterator == NULL)
 		return NULL;
 
-	if ((iterator_count++) < 0) {
-		_debugStack[iterator_count - 1] = iterator;
+	if ((iterator_count++) < 0)
 		oscap_dlprintf(DBG_W, "iterator_count: %d.\n", iterator_count);
-	}
-	iterator->item_iterator_frame = NULL;
+
+	iterator->items = iterator->inline_items;
+	iterator->count = 0;
+	iterator->size = 0;
 	return iterator;
 }
 
@@ -223,14 +237,23 @@ void oval_collection_iterator_add(struct oval_iterator *iterator, void *item)
 {
 	__attribute__nonnull__(iterator);
 
-	struct _oval_collection_item_frame *newframe =
-	    (struct _oval_collection_item_frame *)oscap_alloc(sizeof(_oval_collection_item_frame_t));
-	if (newframe == NULL)	/* We don't have any information that error occured ! */
-		return;
-
-	newframe->next = iterator->item_iterator_frame;
-	newframe->item = item;
-	iterator->item_iterator_frame = newframe;
+	if (iterator->count == iterator->size) {
+		size_t size = iterator->size > 0 ? iterator->size * 2 : OVAL_COLLECTION_MIN_SIZE * 2;
+		void **items;
+
+		if (iterator->items == iterator->inline_items) {
+			items = oscap_alloc(size * sizeof(void *));
+			if (items != NULL)
+				memcpy(items, iterator->items, iterator->count * sizeof(void *));
+		} else
+			items = oscap_realloc(iterator->items, size * sizeof(void *));
+		if (items == NULL)	/* We don't have any information that error occured ! */
+			return;
+		iterator->items = items;
+		iterator->size = size;
+	}
+	/* the item added last is returned first */
+	iterator->items[iterator->count++] = item;
 }
 
 bool oval_string_iterator_has_more(struct oval_string_iterator * iterator)
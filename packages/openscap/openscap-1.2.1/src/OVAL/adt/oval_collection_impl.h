@@ -37,6 +37,9 @@ OSCAP_HIDDEN_START;
 //struct oval_iterator;
 
 struct oval_collection *oval_collection_new(void);
+struct oval_arena;
+/// Create a collection kept in the arena, or on the heap if the arena is NULL
+struct oval_collection *oval_collection_new_arena(struct oval_arena *arena);
 void oval_collection_free(struct oval_collection *);
 void oval_collection_free_items(struct oval_collection *, oscap_destruct_func);
 void oval_collection_add(struct oval_collection *, void *);
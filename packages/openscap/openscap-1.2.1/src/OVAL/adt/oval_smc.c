@@ -38,6 +38,11 @@ struct oval_smc *oval_smc_new(void)
 	return (struct oval_smc *) oval_string_map_new();
 }
 
+struct oval_smc *oval_smc_new_arena(struct oval_arena *arena)
+{
+	return (struct oval_smc *) oval_string_map_new_arena(arena);
+}
+
 static inline struct oval_collection *_oval_smc_get_all(struct oval_smc *map, const char *key)
 {
 	return (struct oval_collection *) oval_string_map_get_value((struct oval_string_map *)map, key);
@@ -50,7 +55,7 @@ void oval_smc_put_last(struct oval_smc *map, const char *key, void *item)
 	if (item != NULL) {
 		struct oval_collection *list_col = _oval_smc_get_all(map, key);
 		if (list_col == NULL) {
-			list_col = oval_collection_new();
+			list_col = oval_collection_new_arena(oval_string_map_get_arena((struct oval_string_map *) map));
 			oval_string_map_put((struct oval_string_map *) map, key, list_col);
 		}
 		oval_collection_add(list_col, item);
@@ -64,7 +69,7 @@ void oval_smc_put_last_if_not_exists(struct oval_smc *map, const char *key, void
 	if (item != NULL) {
 		struct oval_collection *list_col = _oval_smc_get_all(map, key);
 		if (list_col == NULL) {
-			list_col = oval_collection_new();
+			list_col = oval_collection_new_arena(oval_string_map_get_arena((struct oval_string_map *) map));
 			oval_string_map_put((struct oval_string_map *) map, key, list_col);
 		}
 
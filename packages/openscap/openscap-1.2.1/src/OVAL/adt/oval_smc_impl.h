@@ -35,6 +35,10 @@ struct oval_smc;
 
 struct oval_smc *oval_smc_new(void);
 
+struct oval_arena;
+/// Create a map which keeps its keys and collections in the arena
+struct oval_smc *oval_smc_new_arena(struct oval_arena *arena);
+
 void oval_smc_put_last(struct oval_smc *map, const char *key, void *item);
 
 void oval_smc_put_last_if_not_exists(struct oval_smc *map, const char *key, void *item);
@@ -37,7 +37,9 @@
 #include <stdio.h>
 
 #include "oval_string_map_impl.h"
+#include "oval_arena_impl.h"
 #include "common/util.h"
+#include "common/strtab_priv.h"
 #include "common/debug_priv.h"
 
 #if defined(OVAL_STRINGMAP_OLD)
@@ -66,6 +68,16 @@ struct oval_string_map *oval_string_map_new()
 	return map;
 }
 
+struct oval_string_map *oval_string_map_new_arena(struct oval_arena *arena)
+{
+	return oval_string_map_new();
+}
+
+struct oval_arena *oval_string_map_get_arena(struct oval_string_map *map)
+{
+	return NULL;
+}
+
 static struct _oval_string_map_entry *_oval_string_map_entry_new(struct
 								 _oval_string_map_entry
 								 *after, struct
@@ -155,6 +167,8 @@ struct oval_iterator *oval_string_map_values(struct oval_string_map *map)
 
 void *oval_string_map_get_value(struct oval_string_map *map, const char *key)
 {
+	struct oscap_strtab_slot *slot;
+
 	__attribute__nonnull__(map);
 
 	if (key == NULL)
@@ -192,142 +206,222 @@ void oval_string_map_free_string(struct oval_string_map *map)
 	oval_string_map_free(map, oscap_free);
 }
 #else
-# include <rbt/rbt.h>
+# include <stdint.h>
 # include <assume.h>
 
-struct oval_string_map *oval_string_map_new(void)
+/*
+ * The map is a common string table (see common/strtab_priv.h). The keys
+ * are copied into chunks owned by the table, or into the arena the map
+ * was created with.
+ *
+ * The keys and values are handed over to the iterators and collections
+ * in the ascending order of the keys (as strcmp() orders them). These
+ * return the item added last first, so the listings come out in the
+ * descending order, which the exported documents depend on. The sorted
+ * order is kept until the next put.
+ */
+
+#define OVAL_STRING_MAP_MIN_SIZE  16
+#define OVAL_STRING_MAP_KEY_CHUNK 4096
+
+struct oval_string_map {
+	struct oscap_strtab        tab;
+	struct oval_arena         *arena;  /* owns the keys if not NULL */
+	struct oscap_strtab_slot **sorted; /* NULL if not listed yet */
+};
+
+static char *_oval_string_map_arena_strdup(void *arena, const char *key)
 {
-	return (struct oval_string_map *)(rbt_str_new());
+	return oval_arena_strdup(arena, key);
 }
 
-void oval_string_map_put(struct oval_string_map *map, const char *key, void *val)
+/* Add the key unless it is already there. @return false if it is */
+static bool _oval_string_map_add(struct oval_string_map *map, const char *key, void *val)
 {
-        char *key_copy;
+	struct oscap_strtab_slot *slot;
+	bool added;
 
-	assume_d(map != NULL, /* void */);
-	assume_d(key != NULL, /* void */);
+	slot = oscap_strtab_insert(&map->tab, key, &added);
+	if (!added)
+		return false;
+
+	slot->data = val;
+
+	/* the slots may have moved and the order changed */
+	oscap_free(map->sorted);
+	map->sorted = NULL;
 
-	if (rbt_str_add((rbt_t *)map, key_copy = strdup(key), val) != 0) {
-		dW("rbt_str_add: non-zero return code\n");
-                oscap_free(key_copy);
-        }
+	return true;
 }
 
-void oval_string_map_put_string(struct oval_string_map *map, const char *key, const char *val)
+static int _oval_string_map_slot_cmp(const void *a, const void *b)
 {
-	char *str = strdup(val), *key_copy;
+	return strcmp((*(const struct oscap_strtab_slot **)a)->key,
+		      (*(const struct oscap_strtab_slot **)b)->key);
+}
 
-	assume_d(map != NULL, /* void */);
-	assume_d(key != NULL, /* void */);
+/* @return the used slots sorted by their keys, NULL if there are none */
+static struct oscap_strtab_slot **_oval_string_map_sorted(struct oval_string_map *map)
+{
+	struct oscap_strtab_slot **sorted;
+	size_t i, n = 0;
 
-	if (rbt_str_add((rbt_t *)map, key_copy = strdup(key), str) == 0)
-		return;
-	else {
-		oscap_free(str);
-                oscap_free(key_copy);
-        }
-	return;
+	if (map->tab.count == 0 || map->sorted != NULL)
+		return map->sorted;
+
+	sorted = oscap_alloc(map->tab.count * sizeof(struct oscap_strtab_slot *));
+	for (i = 0; i < map->tab.size; ++i) {
+		if (map->tab.slots[i].key != NULL)
+			sorted[n++] = &map->tab.slots[i];
+	}
+	qsort(sorted, n, sizeof(struct oscap_strtab_slot *), _oval_string_map_slot_cmp);
+
+	/* listing doesn't modify the map otherwise, so it may run concurrently */
+	if (!__sync_bool_compare_and_swap(&map->sorted, NULL, sorted)) {
+		oscap_free(sorted);
+		sorted = map->sorted;
+	}
+
+	return sorted;
 }
 
-void *oval_string_map_get_value(struct oval_string_map *map, const char *key)
+struct oval_string_map *oval_string_map_new(void)
 {
-	void *val = NULL;
+	struct oval_string_map *map = oscap_talloc(struct oval_string_map);
 
-	assume_d(map != NULL, NULL);
-	assume_d(key != NULL, NULL);
+	/* the slots are allocated by the first put */
+	oscap_strtab_init(&map->tab, OVAL_STRING_MAP_MIN_SIZE, OVAL_STRING_MAP_KEY_CHUNK);
+	map->arena = NULL;
+	map->sorted = NULL;
 
-	if (rbt_str_get((rbt_t *)map, key, &val) != 0)
-		return (NULL);
-	else
-		return (val);
+	return map;
 }
 
-static void __oval_string_map_node_free(struct rbt_str_node *n, oscap_destruct_func destroy)
+struct oval_string_map *oval_string_map_new_arena(struct oval_arena *arena)
 {
-	if (destroy != NULL)
-		destroy(n->data);
-	oscap_free(n->key);
+	struct oval_string_map *map = oval_string_map_new();
+
+	map->arena = arena;
+	map->tab.keydup = _oval_string_map_arena_strdup;
+	map->tab.keydup_arg = arena;
+
+	return map;
 }
 
-void oval_string_map_free(struct oval_string_map *map, oscap_destruct_func destroy)
+struct oval_arena *oval_string_map_get_arena(struct oval_string_map *map)
 {
-	assume_d(map != NULL, /* void */);
-	rbt_str_free_cb2((rbt_t *)map,
-			 (void(*)(struct rbt_str_node *, void *))__oval_string_map_node_free,
-			 (void *)destroy);
+	assume_d(map != NULL, NULL);
+
+	return map->arena;
 }
 
-void oval_string_map_free0(struct oval_string_map *map)
+void oval_string_map_put(struct oval_string_map *map, const char *key, void *val)
 {
-	oval_string_map_free(map, NULL);
+	assume_d(map != NULL, /* void */);
+	assume_d(key != NULL, /* void */);
+
+	if (!_oval_string_map_add(map, key, val))
+		dW("oval_string_map_put: key '%s' already exists\n", key);
 }
 
-void oval_string_map_free_string(struct oval_string_map *map)
+void oval_string_map_put_string(struct oval_string_map *map, const char *key, const char *val)
 {
+	char *str = strdup(val);
+
 	assume_d(map != NULL, /* void */);
-	oval_string_map_free(map, oscap_free);
+	assume_d(key != NULL, /* void */);
+
+	if (!_oval_string_map_add(map, key, str))
+		oscap_free(str);
 }
 
-static int __oval_iterator_addkey(struct rbt_str_node *n, void *u)
+void *oval_string_map_get_value(struct oval_string_map *map, const char *key)
 {
-	struct oval_iterator *it = (struct oval_iterator *)u;
+	struct oscap_strtab_slot *slot;
 
-	oval_collection_iterator_add(it, (void *)n->key);
+	assume_d(map != NULL, NULL);
+	assume_d(key != NULL, NULL);
+
+	slot = oscap_strtab_lookup(&map->tab, key);
 
-	return (0);
+	return slot != NULL ? slot->data : NULL;
 }
 
-static int __oval_iterator_addval(struct rbt_str_node *n, void *u)
+void oval_string_map_free(struct oval_string_map *map, oscap_destruct_func destroy)
 {
-	struct oval_iterator *it = (struct oval_iterator *)u;
+	size_t i;
 
-	oval_collection_iterator_add(it, n->data);
+	assume_d(map != NULL, /* void */);
 
-	return (0);
+	if (destroy != NULL) {
+		for (i = 0; i < map->tab.size; ++i) {
+			if (map->tab.slots[i].key != NULL)
+				destroy(map->tab.slots[i].data);
+		}
+	}
+
+	oscap_strtab_clear(&map->tab);
+	oscap_free(map->sorted);
+	oscap_free(map);
 }
 
-static int __oval_collection_addval(struct rbt_str_node *n, void *u)
+void oval_string_map_free0(struct oval_string_map *map)
 {
-	struct oval_collection *c = (struct oval_collection *)u;
-
-	oval_collection_add(c, n->data);
+	oval_string_map_free(map, NULL);
+}
 
-	return (0);
+void oval_string_map_free_string(struct oval_string_map *map)
+{
+	assume_d(map != NULL, /* void */);
+	oval_string_map_free(map, oscap_free);
 }
 
 struct oval_iterator *oval_string_map_keys(struct oval_string_map *map)
 {
+	struct oscap_strtab_slot **sorted;
 	struct oval_iterator *it;
+	size_t i;
 
 	assume_d(map != NULL, NULL);
 
 	it = oval_collection_iterator_new();
-	rbt_str_walk_inorder2((rbt_t *)map, __oval_iterator_addkey, it, 0);
+	sorted = _oval_string_map_sorted(map);
+	for (i = 0; i < map->tab.count; ++i)
+		oval_collection_iterator_add(it, (void *)sorted[i]->key);
 
 	return (it);
 }
 
 struct oval_iterator *oval_string_map_values(struct oval_string_map *map)
 {
+	struct oscap_strtab_slot **sorted;
 	struct oval_iterator *it;
+	size_t i;
 
 	assume_d(map != NULL, NULL);
 
 	it = oval_collection_iterator_new();
-	rbt_str_walk_inorder2((rbt_t *)map, __oval_iterator_addval, it, 0);
+	sorted = _oval_string_map_sorted(map);
+	for (i = 0; i < map->tab.count; ++i)
+		oval_collection_iterator_add(it, sorted[i]->data);
 
 	return (it);
 }
 
 struct oval_collection *oval_string_map_collect_values(struct oval_string_map *map, struct oval_collection *collection)
 {
+	struct oscap_strtab_slot **sorted;
+	size_t i;
+
 	assume_d(map != NULL, NULL);
 
 	if (collection == NULL)
 		collection = oval_collection_new();
-	rbt_str_walk_inorder2((rbt_t *)map, __oval_collection_addval, collection, 0);
+	sorted = _oval_string_map_sorted(map);
+	for (i = 0; i < map->tab.count; ++i)
+		oval_collection_add(collection, sorted[i]->data);
 
 	return (collection);
 }
 
-#endif /* OVAL_STRINGMAP_LINEAR */
+#endif /* OVAL_STRINGMAP_OLD */
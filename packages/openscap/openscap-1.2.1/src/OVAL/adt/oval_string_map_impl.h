@@ -38,6 +38,10 @@ OSCAP_HIDDEN_START;
 struct oval_string_map;
 
 struct oval_string_map *oval_string_map_new(void);
+struct oval_arena;
+/// Create a map which copies the keys into the arena
+struct oval_string_map *oval_string_map_new_arena(struct oval_arena *arena);
+struct oval_arena *oval_string_map_get_arena(struct oval_string_map *map);
 void oval_string_map_put(struct oval_string_map *, const char *, void *);
 
 void oval_string_map_put_string(struct oval_string_map *, const char *, const char *);
@@ -115,14 +115,14 @@ struct oval_string_iterator *oval_affected_get_products(struct oval_affected *af
 
 struct oval_affected *oval_affected_new(struct oval_definition_model *model)
 {
-	struct oval_affected *affected = (struct oval_affected *)oscap_alloc(sizeof(oval_affected_t));
+	struct oval_affected *affected = (struct oval_affected *)oval_definition_model_alloc(model, sizeof(oval_affected_t));
 	if (affected == NULL)
 		return NULL;
 
 	affected->model = model;
 	affected->family = OVAL_AFCFML_UNKNOWN;
-	affected->platforms = oval_collection_new();
-	affected->products = oval_collection_new();
+	affected->platforms = oval_collection_new_arena(oval_definition_model_get_arena(model));
+	affected->products = oval_collection_new_arena(oval_definition_model_get_arena(model));
 	return affected;
 }
 
@@ -155,11 +155,11 @@ void oval_affected_free(struct oval_affected *affected)
 {
 	__attribute__nonnull__(affected);
 
-	oval_collection_free_items(affected->platforms, (oscap_destruct_func) & oscap_free);
+	oval_collection_free_items(affected->platforms, affected->model == NULL ? (oscap_destruct_func) & oscap_free : NULL);
 	affected->platforms = NULL;
-	oval_collection_free_items(affected->products, (oscap_destruct_func) & oscap_free);
+	oval_collection_free_items(affected->products, affected->model == NULL ? (oscap_destruct_func) & oscap_free : NULL);
 	affected->products = NULL;
-	oscap_free(affected);
+	oval_definition_model_release(affected->model, affected);
 }
 
 void oval_affected_set_family(struct oval_affected *affected, oval_affected_family_t family)
@@ -173,14 +173,14 @@ void oval_affected_add_platform(struct oval_affected *affected, char *platform)
 {
 	__attribute__nonnull__(affected);
 
-	oval_collection_add(affected->platforms, (void *)oscap_strdup(platform));
+	oval_collection_add(affected->platforms, (void *)oval_definition_model_strdup(affected->model, platform));
 }
 
 void oval_affected_add_product(struct oval_affected *affected, char *product)
 {
 	__attribute__nonnull__(affected);
 
-	oval_collection_add(affected->products, (void *)oscap_strdup(product));
+	oval_collection_add(affected->products, (void *)oval_definition_model_strdup(affected->model, product));
 }
 
 static oval_affected_family_t _odafamily(char *family)
@@ -60,6 +60,7 @@ struct oval_agent_session {
 	struct oval_syschar_model    * sys_models[2];
 	struct oval_results_model    * res_model;
 	oval_probe_session_t  * psess;
+	unsigned int eval_threads;
 };
 
 
@@ -122,6 +123,7 @@ oval_agent_session_t * oval_agent_new_session(struct oval_definition_model *mode
 
 
 	ag_sess->product_name = NULL;
+	ag_sess->eval_threads = 1;
 
 	return ag_sess;
 }
@@ -155,6 +157,11 @@ static struct oval_result_system *_oval_agent_get_first_result_system(oval_agent
 	return rsystem;
 }
 
+void oval_agent_set_eval_threads(oval_agent_session_t *ag_sess, unsigned int threads)
+{
+	ag_sess->eval_threads = (threads > 0 ? threads : 1);
+}
+
 int oval_agent_eval_definition(oval_agent_session_t *ag_sess, const char *id)
 {
 	int ret;
@@ -250,6 +257,10 @@ int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, vo
 	char   *id;
 	int ret = 0;
 
+	/* collect what can be collected in parallel, the rest is probed below */
+	if (ag_sess->eval_threads > 1)
+		oval_probe_prefetch_definitions(ag_sess->psess, ag_sess->eval_threads);
+
 	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
 	while (oval_definition_iterator_has_more(oval_def_it)) {
 		oval_def = oval_definition_iterator_next(oval_def_it);
@@ -92,7 +92,7 @@ char *oval_behavior_get_key(struct oval_behavior *behavior)
 
 struct oval_behavior *oval_behavior_new(struct oval_definition_model *model)
 {
-	oval_behavior_t *behavior = (oval_behavior_t *) oscap_alloc(sizeof(oval_behavior_t));
+	oval_behavior_t *behavior = (oval_behavior_t *) oval_definition_model_alloc(model, sizeof(oval_behavior_t));
 	if (behavior == NULL)
 		return NULL;
 
@@ -114,21 +114,19 @@ void oval_behavior_free(struct oval_behavior *behavior)
 {
 	__attribute__nonnull__(behavior);
 
-	if (behavior->value)
-		oscap_free(behavior->value);
-	if (behavior->key)
-		oscap_free(behavior->key);
+	oval_definition_model_release(behavior->model, behavior->value);
+	oval_definition_model_release(behavior->model, behavior->key);
 	behavior->key = NULL;
 	behavior->value = NULL;
-	oscap_free(behavior);
+	oval_definition_model_release(behavior->model, behavior);
 }
 
 void oval_behavior_set_keyval(struct oval_behavior *behavior, const char *key, const char *value)
 {
 	__attribute__nonnull__(behavior);
 
-	behavior->key = oscap_strdup(key);
-	behavior->value = oscap_strdup(value);
+	behavior->key = oval_definition_model_strdup(behavior->model, key);
+	behavior->value = oval_definition_model_strdup(behavior->model, value);
 }
 
 //typedef void (*oval_behavior_consumer)(struct oval_behavior_node *, void*);
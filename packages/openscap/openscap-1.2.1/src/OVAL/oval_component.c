@@ -305,7 +305,7 @@ char *oval_component_get_item_field(struct oval_component *component) {
 void oval_component_set_item_field(struct oval_component *component, char *field) {
 	__attribute__nonnull__(component);
 	if (oval_component_get_type(component) == OVAL_COMPONENT_OBJECTREF) {
-		((struct oval_component_OBJECTREF *)component)->item_field = oscap_strdup(field);
+		((struct oval_component_OBJECTREF *)component)->item_field = oval_definition_model_strdup(component->model, field);
 	}
 }
 
@@ -324,7 +324,7 @@ void oval_component_set_record_field(struct oval_component *component, char *fie
 		return;
 	}
 
-	((struct oval_component_OBJECTREF *) component)->record_field = oscap_strdup(field);
+	((struct oval_component_OBJECTREF *) component)->record_field = oval_definition_model_strdup(component->model, field);
 }
 
 struct oval_variable *oval_component_get_variable(struct oval_component *component) {
@@ -399,7 +399,7 @@ void oval_component_set_prefix(struct oval_component *component, char *character
 	/* type == OVAL_COMPONENT_BEGIN */
 	if (component->type == OVAL_FUNCTION_BEGIN) {
 		oval_component_BEGEND_t *begin = (oval_component_BEGEND_t *) component;
-		begin->character = oscap_strdup(character);
+		begin->character = oval_definition_model_strdup(component->model, character);
 	}
 }
 
@@ -423,7 +423,7 @@ void oval_component_set_suffix(struct oval_component *component, char *character
 	/* type == OVAL_COMPONENT_END */
 	if (component->type == OVAL_FUNCTION_END) {
 		oval_component_BEGEND_t *funcend = (oval_component_BEGEND_t *) component;
-		funcend->character = oscap_strdup(character);
+		funcend->character = oval_definition_model_strdup(component->model, character);
 	}
 }
 
@@ -447,7 +447,7 @@ void oval_component_set_split_delimiter(struct oval_component *component, char *
 	/* type == OVAL_COMPONENT_SPLIT */
 	if (component->type == OVAL_FUNCTION_SPLIT) {
 		oval_component_SPLIT_t *split = (oval_component_SPLIT_t *) component;
-		split->delimiter = oscap_strdup(delimeter);
+		split->delimiter = oval_definition_model_strdup(component->model, delimeter);
 	}
 }
 
@@ -570,7 +570,7 @@ void oval_component_set_regex_pattern(struct oval_component *component, char *pa
 	/* type == OVAL_COMPONENT_REGEX_CAPTURE */
 	if (component->type == OVAL_FUNCTION_REGEX_CAPTURE) {
 		oval_component_REGEX_CAPTURE_t *regex = (oval_component_REGEX_CAPTURE_t *) component;
-		regex->pattern = oscap_strdup(pattern);
+		regex->pattern = oval_definition_model_strdup(component->model, pattern);
 	}
 }
 
@@ -581,7 +581,7 @@ struct oval_component *oval_component_new(struct oval_definition_model *model, o
 	switch (type) {
 	case OVAL_COMPONENT_LITERAL:{
 			oval_component_LITERAL_t *literal =
-			    (oval_component_LITERAL_t *) oscap_alloc(sizeof(oval_component_LITERAL_t));
+			    (oval_component_LITERAL_t *) oval_definition_model_alloc(model, sizeof(oval_component_LITERAL_t));
 			if (literal == NULL)
 				return NULL;
 
@@ -591,7 +591,7 @@ struct oval_component *oval_component_new(struct oval_definition_model *model, o
 		break;
 	case OVAL_COMPONENT_OBJECTREF:{
 			oval_component_OBJECTREF_t *objectref =
-			    (oval_component_OBJECTREF_t *) oscap_alloc(sizeof(oval_component_OBJECTREF_t));
+			    (oval_component_OBJECTREF_t *) oval_definition_model_alloc(model, sizeof(oval_component_OBJECTREF_t));
 			if (objectref == NULL)
 				return NULL;
 
@@ -603,7 +603,7 @@ struct oval_component *oval_component_new(struct oval_definition_model *model, o
 		break;
 	case OVAL_COMPONENT_VARREF:{
 			oval_component_VARREF_t *varref =
-			    (oval_component_VARREF_t *) oscap_alloc(sizeof(oval_component_VARREF_t));
+			    (oval_component_VARREF_t *) oval_definition_model_alloc(model, sizeof(oval_component_VARREF_t));
 			if (varref == NULL)
 				return NULL;
 
@@ -618,7 +618,7 @@ struct oval_component *oval_component_new(struct oval_definition_model *model, o
 			case OVAL_FUNCTION_ARITHMETIC:{
 					oval_component_ARITHMETIC_t *arithmetic = (oval_component_ARITHMETIC_t *)
 					    (function = (oval_component_FUNCTION_t *)
-					     oscap_alloc(sizeof(oval_component_ARITHMETIC_t)));
+					     oval_definition_model_alloc(model, sizeof(oval_component_ARITHMETIC_t)));
 					if (arithmetic == NULL)
 						return NULL;
 
@@ -629,7 +629,7 @@ struct oval_component *oval_component_new(struct oval_definition_model *model, o
 			case OVAL_FUNCTION_END:{
 					oval_component_BEGEND_t *begin = (oval_component_BEGEND_t *)
 					    (function = (oval_component_FUNCTION_t *)
-					     oscap_alloc(sizeof(oval_component_BEGEND_t)));
+					     oval_definition_model_alloc(model, sizeof(oval_component_BEGEND_t)));
 					if (begin == NULL)
 						return NULL;
 
@@ -639,7 +639,7 @@ struct oval_component *oval_component_new(struct oval_definition_model *model, o
 			case OVAL_FUNCTION_SPLIT:{
 					oval_component_SPLIT_t *split = (oval_component_SPLIT_t *)
 					    (function = (oval_component_FUNCTION_t *)
-					     oscap_alloc(sizeof(oval_component_SPLIT_t)));
+					     oval_definition_model_alloc(model, sizeof(oval_component_SPLIT_t)));
 					if (split == NULL)
 						return NULL;
 
@@ -649,7 +649,7 @@ struct oval_component *oval_component_new(struct oval_definition_model *model, o
 			case OVAL_FUNCTION_SUBSTRING:{
 					oval_component_SUBSTRING_t *substring = (oval_component_SUBSTRING_t *)
 					    (function = (oval_component_FUNCTION_t *)
-					     oscap_alloc(sizeof(oval_component_SUBSTRING_t)));
+					     oval_definition_model_alloc(model, sizeof(oval_component_SUBSTRING_t)));
 					if (substring == NULL)
 						return NULL;
 
@@ -660,7 +660,7 @@ struct oval_component *oval_component_new(struct oval_definition_model *model, o
 			case OVAL_FUNCTION_TIMEDIF:{
 					oval_component_TIMEDIF_t *timedif = (oval_component_TIMEDIF_t *)
 					    (function = (oval_component_FUNCTION_t *)
-					     oscap_alloc(sizeof(oval_component_TIMEDIF_t)));
+					     oval_definition_model_alloc(model, sizeof(oval_component_TIMEDIF_t)));
 					if (timedif == NULL)
 						return NULL;
 
@@ -671,7 +671,7 @@ struct oval_component *oval_component_new(struct oval_definition_model *model, o
 			case OVAL_FUNCTION_REGEX_CAPTURE:{
 					oval_component_REGEX_CAPTURE_t *regex = (oval_component_REGEX_CAPTURE_t *)
 					    (function = (oval_component_FUNCTION_t *)
-					     oscap_alloc(sizeof(oval_component_REGEX_CAPTURE_t)));
+					     oval_definition_model_alloc(model, sizeof(oval_component_REGEX_CAPTURE_t)));
 					if (regex == NULL)
 						return NULL;
 
@@ -680,14 +680,14 @@ struct oval_component *oval_component_new(struct oval_definition_model *model, o
 				break;
 			default:{
 					function = (oval_component_FUNCTION_t *)
-					    oscap_alloc(sizeof(oval_component_FUNCTION_t));
+					    oval_definition_model_alloc(model, sizeof(oval_component_FUNCTION_t));
 					if (function == NULL)
 						return NULL;
 				}
 			}
 
 			component = (oval_component_t *) function;
-			function->function_components = oval_collection_new();
+			function->function_components = oval_collection_new_arena(oval_definition_model_get_arena(model));
 		}
 		break;
 
@@ -815,30 +815,28 @@ void oval_component_free(struct oval_component *component)
 		break;
 	case OVAL_COMPONENT_OBJECTREF:{
 			oval_component_OBJECTREF_t *objectref = (oval_component_OBJECTREF_t *) component;
-			if (objectref->item_field != NULL)
-				oscap_free(objectref->item_field);
+			oval_definition_model_release(component->model, objectref->item_field);
 			objectref->item_field = NULL;
-			if (objectref->record_field != NULL)
-				oscap_free(objectref->record_field);
+			oval_definition_model_release(component->model, objectref->record_field);
 			objectref->record_field = NULL;
 		}
 		break;
 	case OVAL_FUNCTION_BEGIN:
 	case OVAL_FUNCTION_END:{
 			oval_component_BEGEND_t *begin = (oval_component_BEGEND_t *) component;
-			oscap_free(begin->character);
+			oval_definition_model_release(component->model, begin->character);
 			begin->character = NULL;
 		};
 		break;
 	case OVAL_FUNCTION_SPLIT:{
 			oval_component_SPLIT_t *split = (oval_component_SPLIT_t *) component;
-			oscap_free(split->delimiter);
+			oval_definition_model_release(component->model, split->delimiter);
 			split->delimiter = NULL;
 		};
 		break;
 	case OVAL_FUNCTION_REGEX_CAPTURE:{
 			oval_component_REGEX_CAPTURE_t *regex = (oval_component_REGEX_CAPTURE_t *) component;
-			oscap_free(regex->pattern);
+			oval_definition_model_release(component->model, regex->pattern);
 			regex->pattern = NULL;
 		};
 		break;
@@ -860,7 +858,7 @@ void oval_component_free(struct oval_component *component)
 		oval_collection_free_items(function->function_components, (oscap_destruct_func) oval_component_free);
 		function->function_components = NULL;
 	}
-	oscap_free(component);
+	oval_definition_model_release(component->model, component);
 }
 
 void oval_component_add_function_component(struct oval_component *component, struct oval_component *func_component) 
@@ -979,7 +977,9 @@ static int _oval_component_parse_BEGEND_tag(xmlTextReaderPtr reader,
 	__attribute__nonnull__(component);
 
 	oval_component_BEGEND_t *begend = (oval_component_BEGEND_t *) component;
-	begend->character = (char *)xmlTextReaderGetAttribute(reader, BAD_CAST "character");
+	char *character = (char *)xmlTextReaderGetAttribute(reader, BAD_CAST "character");
+	begend->character = oval_definition_model_strdup(component->model, character);
+	oscap_free(character);
 
 	return _oval_component_parse_FUNCTION_tag(reader, context, component);
 }
@@ -991,7 +991,9 @@ static int _oval_component_parse_SPLIT_tag(xmlTextReaderPtr reader,
 	__attribute__nonnull__(component);
 
 	oval_component_SPLIT_t *split = (oval_component_SPLIT_t *) component;
-	split->delimiter = (char *)xmlTextReaderGetAttribute(reader, BAD_CAST "delimiter");
+	char *delimiter = (char *)xmlTextReaderGetAttribute(reader, BAD_CAST "delimiter");
+	split->delimiter = oval_definition_model_strdup(component->model, delimiter);
+	oscap_free(delimiter);
 
 	return _oval_component_parse_FUNCTION_tag(reader, context, component);
 }
@@ -1042,7 +1044,9 @@ static int _oval_component_parse_REGEX_CAPTURE_tag(xmlTextReaderPtr reader,
 
 	oval_component_REGEX_CAPTURE_t *regex = (oval_component_REGEX_CAPTURE_t *) component;
 
-	regex->pattern = (char *)xmlTextReaderGetAttribute(reader, BAD_CAST "pattern");
+	char *pattern = (char *)xmlTextReaderGetAttribute(reader, BAD_CAST "pattern");
+	regex->pattern = oval_definition_model_strdup(component->model, pattern);
+	oscap_free(pattern);
 
 	return _oval_component_parse_FUNCTION_tag(reader, context, component);
 }
@@ -185,16 +185,16 @@ struct oval_criteria_node *oval_criteria_node_new(struct oval_definition_model *
 	switch (type) {
 	case OVAL_NODETYPE_CRITERIA:{
 			node = (struct oval_criteria_node *)
-			    oscap_calloc(1, sizeof(oval_criteria_node_CRITERIA_t));
+			    oval_definition_model_calloc(model, 1, sizeof(oval_criteria_node_CRITERIA_t));
 			if (node == NULL)
 				return NULL;
 
 			((struct oval_criteria_node_CRITERIA *)node)->operator = OVAL_OPERATOR_UNKNOWN;
-			((struct oval_criteria_node_CRITERIA *)node)->subnodes = oval_collection_new();
+			((struct oval_criteria_node_CRITERIA *)node)->subnodes = oval_collection_new_arena(oval_definition_model_get_arena(model));
 		} break;
 	case OVAL_NODETYPE_CRITERION:{
 			node = (struct oval_criteria_node *)
-			    oscap_calloc(1, sizeof(oval_criteria_node_CRITERION_t));
+			    oval_definition_model_calloc(model, 1, sizeof(oval_criteria_node_CRITERION_t));
 			if (node == NULL)
 				return NULL;
 
@@ -202,7 +202,7 @@ struct oval_criteria_node *oval_criteria_node_new(struct oval_definition_model *
 		} break;
 	case OVAL_NODETYPE_EXTENDDEF:{
 			node = (struct oval_criteria_node *)
-			    oscap_calloc(1, sizeof(oval_criteria_node_EXTENDDEF_t));
+			    oval_definition_model_calloc(model, 1, sizeof(oval_criteria_node_EXTENDDEF_t));
 			if (node == NULL)
 				return NULL;
 
@@ -288,11 +288,8 @@ void oval_criteria_node_free(struct oval_criteria_node *node)
 			//NOOP
 		}
 	}
-	if (node->comment != NULL) {
-		oscap_free(node->comment);
-	}
 	node->comment = NULL;
-	oscap_free(node);
+	oval_definition_model_release(node->model, node);
 }
 
 void oval_criteria_set_node_type(struct oval_criteria_node *node, oval_criteria_node_type_t type)
@@ -317,9 +314,7 @@ void oval_criteria_node_set_applicability_check(struct oval_criteria_node *node,
 void oval_criteria_node_set_comment(struct oval_criteria_node *node, char *comm)
 {
 	__attribute__nonnull__(node);
-	if (node->comment != NULL)
-		oscap_free(node->comment);
-	node->comment = (comm == NULL) ? NULL : oscap_strdup(comm);
+	node->comment = oval_definition_model_strdup(node->model, comm);
 }
 
 void oval_criteria_node_set_operator(struct oval_criteria_node *node, oval_operator_t op)
@@ -39,6 +39,7 @@
 #include "oval_agent_api_impl.h"
 #include "oval_parser_impl.h"
 #include "adt/oval_string_map_impl.h"
+#include "adt/oval_arena_impl.h"
 #include "oval_system_characteristics_impl.h"
 #include "oval_probe_impl.h"
 #include "common/util.h"
@@ -58,6 +59,7 @@ typedef struct oval_definition_model {
 	struct oval_collection *bound_variable_models;
         char *schema;
 	struct oval_string_map *vardef_map;		///< look-up table for efficient @variable_instance processing
+	struct oval_arena *arena;			///< memory of the model's objects
 } oval_definition_model_t;
 
 /* failed   - NULL
@@ -69,12 +71,18 @@ struct oval_definition_model *oval_definition_model_new()
 	if (newmodel == NULL)
 		return NULL;
 
+	newmodel->arena = oval_arena_new();
+	if (newmodel->arena == NULL) {
+		oscap_free(newmodel);
+		return NULL;
+	}
+
 	newmodel->generator = oval_generator_new();
-	newmodel->definition_map = oval_string_map_new();
-	newmodel->object_map = oval_string_map_new();
-	newmodel->state_map = oval_string_map_new();
-	newmodel->test_map = oval_string_map_new();
-	newmodel->variable_map = oval_string_map_new();
+	newmodel->definition_map = oval_string_map_new_arena(newmodel->arena);
+	newmodel->object_map = oval_string_map_new_arena(newmodel->arena);
+	newmodel->state_map = oval_string_map_new_arena(newmodel->arena);
+	newmodel->test_map = oval_string_map_new_arena(newmodel->arena);
+	newmodel->variable_map = oval_string_map_new_arena(newmodel->arena);
 	newmodel->bound_variable_models = NULL;
         newmodel->schema = strdup(OVAL_DEF_SCHEMA_LOCATION);
 	newmodel->vardef_map = NULL;
@@ -148,9 +156,46 @@ void oval_definition_model_free(struct oval_definition_model *model)
 
 	oval_generator_free(model->generator);
 
+	/* the objects are freed above, this releases their memory */
+	oval_arena_free(model->arena);
 	oscap_free(model);
 }
 
+struct oval_arena *oval_definition_model_get_arena(struct oval_definition_model *model)
+{
+	return model != NULL ? model->arena : NULL;
+}
+
+void *oval_definition_model_alloc(struct oval_definition_model *model, size_t size)
+{
+	return model != NULL ? oval_arena_alloc(model->arena, size) : oscap_alloc(size);
+}
+
+void *oval_definition_model_calloc(struct oval_definition_model *model, size_t nmemb, size_t size)
+{
+	void *ptr;
+
+	if (model == NULL)
+		return oscap_calloc(nmemb, size);
+
+	ptr = oval_arena_alloc(model->arena, nmemb * size);
+	if (ptr != NULL)
+		memset(ptr, 0, nmemb * size);
+	return ptr;
+}
+
+char *oval_definition_model_strdup(struct oval_definition_model *model, const char *str)
+{
+	return model != NULL ? oval_arena_strdup(model->arena, str) : oscap_strdup(str);
+}
+
+void oval_definition_model_release(struct oval_definition_model *model, void *ptr)
+{
+	/* memory of a model is released with the model */
+	if (model == NULL)
+		oscap_free(ptr);
+}
+
 struct oval_generator *oval_definition_model_get_generator(struct oval_definition_model *model)
 {
 	return model->generator;
@@ -461,7 +506,8 @@ struct oval_test *oval_definition_model_get_new_test(struct oval_definition_mode
 	return test;
 }
 
-xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_model, xmlDocPtr doc, xmlNode * parent)
+xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_model, xmlDocPtr doc, xmlNode * parent,
+				      struct oscap_xml_stream *stream)
 {
 
 	xmlNodePtr root_node = NULL;
@@ -485,9 +531,11 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 	xmlSetNs(root_node, ns_ind);
 	xmlSetNs(root_node, ns_lin);
 	xmlSetNs(root_node, ns_defntns);
+	oscap_xml_stream_push(stream, root_node);
 
 	/* Always report the generator */
 	oval_generator_to_dom(definition_model->generator, doc, root_node);
+	oscap_xml_stream_flush(stream);
 
 	/* Report definitions */
 	struct oval_definition_iterator *definitions = oval_definition_model_get_definitions(definition_model);
@@ -497,9 +545,12 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 			struct oval_definition *definition = oval_definition_iterator_next(definitions);
 			if (definitions_node == NULL) {
 				definitions_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "definitions", NULL);
+				oscap_xml_stream_push(stream, definitions_node);
 			}
 			oval_definition_to_dom(definition, doc, definitions_node);
+			oscap_xml_stream_flush(stream);
 		}
+		oscap_xml_stream_pop(stream);
 	}
         oval_definition_iterator_free(definitions);
 
@@ -507,10 +558,13 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 	struct oval_test_iterator *tests = oval_definition_model_get_tests(definition_model);
 	if (oval_test_iterator_has_more(tests)) {
 		xmlNode *tests_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "tests", NULL);
+		oscap_xml_stream_push(stream, tests_node);
 		while (oval_test_iterator_has_more(tests)) {
 			struct oval_test *test = oval_test_iterator_next(tests);
 			oval_test_to_dom(test, doc, tests_node);
+			oscap_xml_stream_flush(stream);
 		}
+		oscap_xml_stream_pop(stream);
 	}
 	oval_test_iterator_free(tests);
 
@@ -518,13 +572,16 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 	struct oval_object_iterator *objects = oval_definition_model_get_objects(definition_model);
 	if (oval_object_iterator_has_more(objects)) {
 		xmlNode *objects_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "objects", NULL);
+		oscap_xml_stream_push(stream, objects_node);
 		while(oval_object_iterator_has_more(objects)) {
 			struct oval_object *object = oval_object_iterator_next(objects);
 			if (oval_object_get_base_obj(object))
 				/* Skip internal objects */
 				continue;
 			oval_object_to_dom(object, doc, objects_node);
+			oscap_xml_stream_flush(stream);
 		}
+		oscap_xml_stream_pop(stream);
 	}
 	oval_object_iterator_free(objects);
 
@@ -532,10 +589,13 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 	struct oval_state_iterator *states = oval_definition_model_get_states(definition_model);
 	if (oval_state_iterator_has_more(states)) {
 		xmlNode *states_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "states", NULL);
+		oscap_xml_stream_push(stream, states_node);
 		while (oval_state_iterator_has_more(states)) {
 			struct oval_state *state = oval_state_iterator_next(states);
 			oval_state_to_dom(state, doc, states_node);
+			oscap_xml_stream_flush(stream);
 		}
+		oscap_xml_stream_pop(stream);
 	}
 	oval_state_iterator_free(states);
 
@@ -543,12 +603,16 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 	struct oval_variable_iterator *variables = oval_definition_model_get_variables(definition_model);
 	if (oval_variable_iterator_has_more(variables)) {
 		xmlNode *variables_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "variables", NULL);
+		oscap_xml_stream_push(stream, variables_node);
 		while (oval_variable_iterator_has_more(variables)) {
 			struct oval_variable *variable = oval_variable_iterator_next(variables);
 			oval_variable_to_dom(variable, doc, variables_node);
+			oscap_xml_stream_flush(stream);
 		}
+		oscap_xml_stream_pop(stream);
 	}
 	oval_variable_iterator_free(variables);
+	oscap_xml_stream_pop(stream);
 
 	return root_node;
 }
@@ -566,7 +630,7 @@ int oval_definition_model_export(struct oval_definition_model *model, const char
 		return -1;
 	}
 
-	oval_definition_model_to_dom(model, doc, NULL);
+	oval_definition_model_to_dom(model, doc, NULL, NULL);
 	return oscap_xml_save_filename_free(file, doc);
 }
 
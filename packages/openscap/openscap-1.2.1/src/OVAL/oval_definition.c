@@ -151,19 +151,19 @@ struct oval_definition *oval_definition_new(struct oval_definition_model *model,
 	__attribute__nonnull__(model);
 	struct oval_definition *definition;
 
-	definition = (struct oval_definition *)oscap_talloc(oval_definition_t);
+	definition = (struct oval_definition *)oval_definition_model_alloc(model, sizeof(oval_definition_t));
 
         assume_r(definition != NULL, /* return */ NULL);
 
-	definition->id = oscap_strdup(id);
+	definition->id = oval_definition_model_strdup(model, id);
 	definition->version = 0;
 	definition->class = OVAL_CLASS_UNKNOWN;
 	definition->deprecated = 0;
 	definition->title = NULL;
 	definition->description = NULL;
-	definition->affected = oval_collection_new();
-	definition->reference = oval_collection_new();
-	definition->notes = oval_collection_new();
+	definition->affected = oval_collection_new_arena(oval_definition_model_get_arena(model));
+	definition->reference = oval_collection_new_arena(oval_definition_model_get_arena(model));
+	definition->notes = oval_collection_new_arena(oval_definition_model_get_arena(model));
 
 	definition->anyxml = NULL;
 	definition->criteria = NULL;
@@ -207,7 +207,7 @@ struct oval_definition *oval_definition_clone
 		}
 		oval_string_iterator_free(notes);
 
-		new_definition->anyxml = strdup(old_definition->anyxml);
+		new_definition->anyxml = oval_definition_model_strdup(new_model, old_definition->anyxml);
 
 		oval_definition_set_criteria(new_definition, oval_criteria_node_clone(new_model, old_definition->criteria));
 	}
@@ -218,19 +218,11 @@ void oval_definition_free(struct oval_definition *definition)
 {
 	__attribute__nonnull__(definition);
 
-	if (definition->id != NULL)
-		oscap_free(definition->id);
-	if (definition->title != NULL)
-		oscap_free(definition->title);
-	if (definition->description != NULL)
-		oscap_free(definition->description);
 	if (definition->criteria != NULL)
 		oval_criteria_node_free(definition->criteria);
 	oval_collection_free_items(definition->affected, (oscap_destruct_func) oval_affected_free);
 	oval_collection_free_items(definition->reference, (oscap_destruct_func) oval_reference_free);
-	oval_collection_free_items(definition->notes, (oscap_destruct_func) oscap_free);
-
-	oscap_free(definition->anyxml);
+	oval_collection_free_items(definition->notes, NULL);
 
 	definition->affected = NULL;
 	definition->criteria = NULL;
@@ -240,7 +232,7 @@ void oval_definition_free(struct oval_definition *definition)
 	definition->notes = NULL;
 	definition->anyxml = NULL;
 	definition->title = NULL;
-	oscap_free(definition);
+	oval_definition_model_release(definition->model, definition);
 }
 
 bool oval_definition_iterator_has_more(struct oval_definition_iterator
@@ -288,17 +280,13 @@ void oval_definition_set_deprecated(struct oval_definition *definition, bool dep
 void oval_definition_set_title(struct oval_definition *definition, char *title)
 {
 	__attribute__nonnull__(definition);
-	if (definition->title != NULL)
-		oscap_free(definition->title);
-	definition->title = (title == NULL) ? NULL : oscap_strdup(title);
+	definition->title = oval_definition_model_strdup(definition->model, title);
 }
 
 void oval_definition_set_description(struct oval_definition *definition, char *description)
 {
 	__attribute__nonnull__(definition);
-	if (definition->description)
-		oscap_free(definition->description);
-	definition->description = (description == NULL) ? NULL : oscap_strdup(description);
+	definition->description = oval_definition_model_strdup(definition->model, description);
 }
 
 void oval_definition_set_criteria(struct oval_definition *definition, struct oval_criteria_node *criteria)
@@ -321,7 +309,7 @@ void oval_definition_add_reference(struct oval_definition *definition, struct ov
 
 void oval_definition_add_note(struct oval_definition *definition, char *note) {
 	__attribute__nonnull__(definition);
-	oval_collection_add(definition->notes, note);
+	oval_collection_add(definition->notes, oval_definition_model_strdup(definition->model, note));
 }
 
 static void _oval_definition_title_consumer(char *string, void *user)
@@ -331,16 +319,16 @@ static void _oval_definition_title_consumer(char *string, void *user)
 	struct oval_definition *definition = (struct oval_definition *)user;
 	char *title = definition->title;
 	if (title == NULL)
-		title = oscap_strdup(string);
+		title = oval_definition_model_strdup(definition->model, string);
 	else {
 		int newsize = strlen(title) + strlen(string) + 1;
-		char *newtitle = (char *)oscap_alloc(newsize * sizeof(char));
+		char *newtitle = (char *)oval_definition_model_alloc(definition->model, newsize * sizeof(char));
 		if (newtitle == NULL)
 			return;
 
 		strcpy(newtitle, title);
 		strcat(newtitle, string);
-		oscap_free(title);
+		oval_definition_model_release(definition->model, title);
 		title = newtitle;
 	}
 	definition->title = title;
@@ -353,17 +341,17 @@ static void _oval_definition_description_consumer(char *string, void *user)
 	struct oval_definition *definition = (struct oval_definition *)user;
 	char *description = definition->description;
 	if (description == NULL)
-		description = oscap_strdup(string);
+		description = oval_definition_model_strdup(definition->model, string);
 	else {
 		int newsize = strlen(description) + strlen(string) + 1;
-		char *newdescription = (char *)oscap_alloc(newsize * sizeof(char));
+		char *newdescription = (char *)oval_definition_model_alloc(definition->model, newsize * sizeof(char));
 		if (newdescription == NULL)
 			return;
 
 		*newdescription = '\0';
 		strcpy(newdescription, description);
 		strcat(newdescription, string);
-		oscap_free(description);
+		oval_definition_model_release(definition->model, description);
 		description = newdescription;
 	}
 	definition->description = description;
@@ -402,7 +390,9 @@ static int _oval_definition_parse_metadata(xmlTextReaderPtr reader, struct oval_
 	} else if (strcmp(tagname, "reference") == 0) {
 		return_code = oval_reference_parse_tag(reader, context, &oval_reference_consume, definition);
 	} else {
-		definition->anyxml = (char *) xmlTextReaderReadOuterXml(reader);
+		char *anyxml = (char *) xmlTextReaderReadOuterXml(reader);
+		definition->anyxml = oval_definition_model_strdup(definition->model, anyxml);
+		oscap_free(anyxml);
 		return_code = oval_parser_skip_tag(reader, context);
 	}
 	oscap_free(tagname);
@@ -36,6 +36,7 @@
 #include "oval_parser_impl.h"
 #include "adt/oval_string_map_impl.h"
 #include "../common/util.h"
+#include "../common/xmlstream_priv.h"
 
 OSCAP_HIDDEN_START;
 
@@ -130,6 +131,7 @@ xmlNode *oval_set_to_dom(struct oval_setobject *, xmlDoc *, xmlNode *);
 void oval_set_propagate_filters(struct oval_definition_model *, struct oval_setobject *, char *);
 
 typedef void (*oval_value_consumer) (struct oval_value *, void *);
+struct oval_value *oval_value_new_arena(struct oval_arena *arena, oval_datatype_t datatype, const char *text_value);
 int oval_value_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, oval_value_consumer, void *);
 xmlNode *oval_value_to_dom(struct oval_value *, xmlDoc *, xmlNode *);
 int oval_value_cast(struct oval_value *value, oval_datatype_t new_dt);
@@ -155,7 +157,8 @@ int oval_generator_parse_tag(xmlTextReader *, struct oval_parser_context *, void
 xmlNode *oval_generator_to_dom(struct oval_generator *, xmlDocPtr, xmlNode *);
 
 /* definition_model */
-xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_model, xmlDocPtr doc, xmlNode * parent);
+xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_model, xmlDocPtr doc, xmlNode * parent,
+				      struct oscap_xml_stream *stream);
 void oval_definition_model_optimize_by_filter_propagation(struct oval_definition_model *);
 
 struct oval_definition *oval_definition_model_get_new_definition(struct oval_definition_model *, const char *);
@@ -173,6 +176,29 @@ const char * oval_definition_model_get_schema(struct oval_definition_model * mod
 void oval_definition_model_set_schema(struct oval_definition_model *model, const char *version);
 
 struct oval_string_map *oval_definition_model_build_vardef_mapping(struct oval_definition_model *model);
+
+/*
+ * The objects of a definition model, their strings and collections are
+ * allocated from the arena of the model and released all at once when
+ * the model is freed. The ownership rules that follow from it:
+ *
+ * - The setters of the model objects copy the given string into the
+ *   arena and don't free the previous value, it stays in the arena
+ *   until the model is freed.
+ * - The *_free() functions of the objects still walk their members, but
+ *   release nothing of the arena; oval_definition_model_release() is a
+ *   no-op for memory of a model.
+ * - Values parsed into a model point to its arena and oval_value_free()
+ *   leaves them alone. oval_value_new() and values computed at
+ *   evaluation time use the heap and are freed as before.
+ * - Objects created without a model use the heap and are freed by their
+ *   *_free() functions.
+ */
+struct oval_arena *oval_definition_model_get_arena(struct oval_definition_model *model);
+void *oval_definition_model_alloc(struct oval_definition_model *model, size_t size);
+void *oval_definition_model_calloc(struct oval_definition_model *model, size_t nmemb, size_t size);
+char *oval_definition_model_strdup(struct oval_definition_model *model, const char *str);
+void oval_definition_model_release(struct oval_definition_model *model, void *ptr);
 struct oval_string_iterator *oval_definition_model_get_definitions_dependent_on_variable(struct oval_definition_model *model, struct oval_variable *variable);
 
 /* variable model */
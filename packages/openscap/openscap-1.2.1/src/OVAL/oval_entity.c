@@ -45,6 +45,7 @@
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "common/elements.h"
+#include "common/intern_priv.h"
 #include "common/_error.h"
 
 /***************************************************************************/
@@ -160,7 +161,7 @@ struct oval_value *oval_entity_get_value(struct oval_entity *entity)
 
 struct oval_entity *oval_entity_new(struct oval_definition_model *model)
 {
-	struct oval_entity *entity = (struct oval_entity *)oscap_alloc(sizeof(struct oval_entity));
+	struct oval_entity *entity = (struct oval_entity *)oval_definition_model_alloc(model, sizeof(struct oval_entity));
 	if (entity == NULL)
 		return NULL;
 
@@ -209,13 +210,11 @@ void oval_entity_free(struct oval_entity *entity)
 
 	if (entity->value != NULL)
 		oval_value_free(entity->value);
-	if (entity->name != NULL)
-		oscap_free(entity->name);
 
 	entity->name = NULL;
 	entity->value = NULL;
 	entity->variable = NULL;
-	oscap_free(entity);
+	oval_definition_model_release(entity->model, entity);
 }
 
 void oval_entity_set_type(struct oval_entity *entity, oval_entity_type_t type)
@@ -269,9 +268,7 @@ void oval_entity_set_value(struct oval_entity *entity, struct oval_value *value)
 void oval_entity_set_name(struct oval_entity *entity, char *name)
 {
 	__attribute__nonnull__(entity);
-	if (entity->name != NULL)
-		oscap_free(entity->name);
-	entity->name = (name == NULL) ? NULL : oscap_strdup(name);
+	entity->name = (char *) oscap_intern(name);
 }
 
 static void oval_consume_varref(char *varref, void *user)
@@ -281,7 +278,7 @@ static void oval_consume_varref(char *varref, void *user)
 
 	struct oval_consume_varref_context *ctx = user;
 	*(ctx->variable) = oval_definition_model_get_new_variable((struct oval_definition_model *)ctx->model, varref, OVAL_VARIABLE_UNKNOWN);
-	*(ctx->value) = oval_value_new(OVAL_DATATYPE_STRING, varref);
+	*(ctx->value) = oval_value_new_arena(oval_definition_model_get_arena(ctx->model), OVAL_DATATYPE_STRING, varref);
 }
 
 static void oval_consume_value(struct oval_value *use_value, void *value)
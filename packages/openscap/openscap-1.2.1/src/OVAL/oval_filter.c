@@ -50,7 +50,7 @@ struct oval_filter *oval_filter_new(struct oval_definition_model *model)
 {
 	struct oval_filter *filter;
 
-	filter = (struct oval_filter *) oscap_alloc(sizeof (struct oval_filter));
+	filter = (struct oval_filter *) oval_definition_model_alloc(model, sizeof (struct oval_filter));
 	if (filter == NULL)
 		return NULL;
 
@@ -64,9 +64,8 @@ void oval_filter_free(struct oval_filter *filter)
 {
 	__attribute__nonnull__(filter);
 
-	filter->model = NULL;
 	filter->state = NULL;
-	oscap_free(filter);
+	oval_definition_model_release(filter->model, filter);
 }
 
 struct oval_filter *oval_filter_clone(struct oval_definition_model *new_model,
@@ -170,19 +170,19 @@ struct oval_object *oval_object_new(struct oval_definition_model *model, const c
 	__attribute__nonnull__(model);
 	oval_object_t *object;
 
-	object = (oval_object_t *) oscap_alloc(sizeof(oval_object_t));
+	object = (oval_object_t *) oval_definition_model_alloc(model, sizeof(oval_object_t));
 	if (object == NULL)
 		return NULL;
 
 	object->comment = NULL;
-	object->id = oscap_strdup(id);
+	object->id = oval_definition_model_strdup(model, id);
 	object->subtype = OVAL_SUBTYPE_UNKNOWN;
 	object->base_obj_ref = NULL;
 	object->deprecated = 0;
 	object->version = 0;
-	object->behaviors = oval_collection_new();
-	object->notes = oval_collection_new();
-	object->object_content = oval_collection_new();
+	object->behaviors = oval_collection_new_arena(oval_definition_model_get_arena(model));
+	object->notes = oval_collection_new_arena(oval_definition_model_get_arena(model));
+	object->object_content = oval_collection_new_arena(oval_definition_model_get_arena(model));
 	object->model = model;
 
 	oval_definition_model_add_object(model, object);
@@ -240,12 +240,8 @@ void oval_object_free(struct oval_object *object)
 	if (object == NULL)
 		return;
 
-	if (object->comment != NULL)
-		oscap_free(object->comment);
-	if (object->id != NULL)
-		oscap_free(object->id);
 	oval_collection_free_items(object->behaviors, (oscap_destruct_func) oval_behavior_free);
-	oval_collection_free_items(object->notes, (oscap_destruct_func) oscap_free);
+	oval_collection_free_items(object->notes, NULL);
 	oval_collection_free_items(object->object_content, (oscap_destruct_func) oval_object_content_free);
 
 	object->comment = NULL;
@@ -253,7 +249,7 @@ void oval_object_free(struct oval_object *object)
 	object->behaviors = NULL;
 	object->notes = NULL;
 	object->object_content = NULL;
-	oscap_free(object);
+	oval_definition_model_release(object->model, object);
 }
 
 void oval_object_set_subtype(struct oval_object *object, oval_subtype_t subtype)
@@ -265,15 +261,13 @@ void oval_object_set_subtype(struct oval_object *object, oval_subtype_t subtype)
 void oval_object_add_note(struct oval_object *object, char *note)
 {
 	__attribute__nonnull__(object);
-	oval_collection_add(object->notes, (void *)oscap_strdup(note));
+	oval_collection_add(object->notes, (void *)oval_definition_model_strdup(object->model, note));
 }
 
 void oval_object_set_comment(struct oval_object *object, char *comm)
 {
 	__attribute__nonnull__(object);
-	if (object->comment != NULL)
-		oscap_free(object->comment);
-	object->comment = (comm == NULL) ? NULL : oscap_strdup(comm);
+	object->comment = oval_definition_model_strdup(object->model, comm);
 }
 
 void oval_object_set_deprecated(struct oval_object *object, bool deprecated)
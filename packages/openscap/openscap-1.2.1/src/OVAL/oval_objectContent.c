@@ -163,7 +163,7 @@ struct oval_object_content
 	switch (type) {
 	case OVAL_OBJECTCONTENT_ENTITY:{
 			struct oval_object_content_ENTITY *entity =
-			    (oval_object_content_ENTITY_t *) oscap_alloc(sizeof(oval_object_content_ENTITY_t));
+			    (oval_object_content_ENTITY_t *) oval_definition_model_alloc(model, sizeof(oval_object_content_ENTITY_t));
 			if (entity == NULL)
 				return NULL;
 
@@ -174,7 +174,7 @@ struct oval_object_content
 		break;
 	case OVAL_OBJECTCONTENT_SET:{
 			struct oval_object_content_SET *set =
-			    (oval_object_content_SET_t *) oscap_alloc(sizeof(oval_object_content_SET_t));
+			    (oval_object_content_SET_t *) oval_definition_model_alloc(model, sizeof(oval_object_content_SET_t));
 			if (set == NULL)
 				return NULL;
 
@@ -184,7 +184,7 @@ struct oval_object_content
 		break;
 	case OVAL_OBJECTCONTENT_FILTER:{
 			struct oval_object_content_FILTER *filter =
-			    (oval_object_content_FILTER_t *) oscap_alloc(sizeof(oval_object_content_FILTER_t));
+			    (oval_object_content_FILTER_t *) oval_definition_model_alloc(model, sizeof(oval_object_content_FILTER_t));
 			if (filter == NULL)
 				return NULL;
 
@@ -232,8 +232,7 @@ void oval_object_content_free(struct oval_object_content *content)
 {
 	__attribute__nonnull__(content);
 
-	if (content->fieldName != NULL)
-		oscap_free(content->fieldName);
+	oval_definition_model_release(content->model, content->fieldName);
 	content->fieldName = NULL;
 	switch (content->type) {
 	case OVAL_OBJECTCONTENT_ENTITY:{
@@ -260,7 +259,7 @@ void oval_object_content_free(struct oval_object_content *content)
 	case OVAL_OBJECTCONTENT_UNKNOWN:
 		break;
 	}
-	oscap_free(content);
+	oval_definition_model_release(content->model, content);
 }
 
 void oval_object_content_set_type(struct oval_object_content *content, oval_object_content_type_t type)
@@ -272,9 +271,8 @@ void oval_object_content_set_type(struct oval_object_content *content, oval_obje
 void oval_object_content_set_field_name(struct oval_object_content *content, char *name)
 {
 	__attribute__nonnull__(content);
-	if (content->fieldName != NULL)
-		oscap_free(content->fieldName);
-	content->fieldName = (name == NULL) ? NULL : oscap_strdup(name);
+	oval_definition_model_release(content->model, content->fieldName);
+	content->fieldName = oval_definition_model_strdup(content->model, name);
 }
 
 void oval_object_content_set_entity(struct oval_object_content *content, struct oval_entity *entity)
@@ -362,7 +360,7 @@ int oval_object_content_parse_tag(xmlTextReaderPtr reader,
 	if (content == NULL)
 		return -1;
 
-	content->fieldName = tagname;
+	content->fieldName = oval_definition_model_strdup(content->model, tagname);
 	switch (type) {
 	case OVAL_OBJECTCONTENT_ENTITY:{
 			struct oval_object_content_ENTITY *content_entity =
@@ -391,6 +389,7 @@ int oval_object_content_parse_tag(xmlTextReaderPtr reader,
 	if (return_code != 0)
 		dW("Parsing of <%s> terminated by an error at line %d.\n",tagname, xmlTextReaderGetParserLineNumber(reader));
 
+	oscap_free(tagname);
 	oscap_free(namespace);
 	return return_code;
 }
@@ -257,7 +257,12 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 
 			dI("Syschar already exists, flag: %u, '%s'.\n", sc_flg, oval_syschar_collection_flag_get_text(sc_flg));
 
-			if (sc_flg != SYSCHAR_FLAG_UNKNOWN || (flags & OVAL_PDFLAG_NOREPLY)) {
+			/*
+			 * An object answered from the object cache hasn't reached
+			 * its probe, which has to collect it when it asks for it.
+			 */
+			if ((sc_flg != SYSCHAR_FLAG_UNKNOWN || (flags & OVAL_PDFLAG_NOREPLY)) &&
+			    !((flags & OVAL_PDFLAG_NOREPLY) && oval_probe_ext_shared(psess->pext, oid))) {
 				if (out_syschar)
 					*out_syschar = sysc;
 				return 0;
@@ -455,6 +460,380 @@ static int oval_probe_query_criteria(oval_probe_session_t *sess, struct oval_cri
         return -1;
 }
 
+/*
+ * Parallel object collection
+ *
+ * Objects which can be sent to a probe without any help from the library
+ * (i.e. objects without variable references, sets and filters) are collected
+ * before the definitions are evaluated. Objects of the same subtype are sent
+ * to their probe in the same order in which the serial evaluation would send
+ * them, so the collected items do not differ from the serial mode. Once an
+ * object which has to be collected serially is found, the remaining objects
+ * of its subtype and of all the subtypes its variables depend on are left to
+ * the serial evaluation.
+ */
+struct oval_probe_prefetch_queue {
+	oval_subtype_t        type;
+	bool                  closed;
+	struct oval_syschar **sysc;
+	size_t                count;
+	size_t                size;
+};
+
+struct oval_probe_prefetch {
+	oval_probe_session_t             *sess;
+	struct oval_probe_prefetch_queue *queue;
+	size_t                            queue_count;
+	struct oval_string_map           *objects; /* visited objects */
+	struct oval_string_map           *variables; /* visited variables */
+#if defined(OSCAP_THREAD_SAFE)
+	pthread_mutex_t                   lock;
+	size_t                            next;
+#endif
+};
+
+static struct oval_probe_prefetch_queue *_prefetch_queue_get(struct oval_probe_prefetch *pf, oval_subtype_t type)
+{
+	struct oval_probe_prefetch_queue *q;
+	size_t i;
+
+	for (i = 0; i < pf->queue_count; ++i) {
+		if (pf->queue[i].type == type)
+			return &pf->queue[i];
+	}
+
+	pf->queue = oscap_realloc(pf->queue, sizeof(struct oval_probe_prefetch_queue) * (pf->queue_count + 1));
+	q = &pf->queue[pf->queue_count++];
+	q->type   = type;
+	q->closed = false;
+	q->sysc   = NULL;
+	q->count  = 0;
+	q->size   = 0;
+
+	return q;
+}
+
+static void _prefetch_close_variable(struct oval_probe_prefetch *pf, struct oval_variable *var);
+
+static void _prefetch_close_object(struct oval_probe_prefetch *pf, struct oval_object *obj)
+{
+	struct oval_string_map *vm;
+	struct oval_iterator *var_itr;
+
+	_prefetch_queue_get(pf, oval_object_get_subtype(obj))->closed = true;
+
+	vm = oval_string_map_new();
+	oval_obj_collect_var_refs(obj, vm);
+	var_itr = oval_string_map_values(vm);
+	while (oval_collection_iterator_has_more(var_itr))
+		_prefetch_close_variable(pf, oval_collection_iterator_next(var_itr));
+	oval_collection_iterator_free(var_itr);
+	oval_string_map_free(vm, NULL);
+}
+
+static void _prefetch_close_component(struct oval_probe_prefetch *pf, struct oval_component *comp)
+{
+	struct oval_component_iterator *cmp_itr;
+
+	switch (oval_component_get_type(comp)) {
+	case OVAL_COMPONENT_OBJECTREF:
+		_prefetch_close_object(pf, oval_component_get_object(comp));
+		break;
+	case OVAL_COMPONENT_VARREF:
+		_prefetch_close_variable(pf, oval_component_get_variable(comp));
+		break;
+	case OVAL_FUNCTION_ARITHMETIC:
+	case OVAL_FUNCTION_BEGIN:
+	case OVAL_FUNCTION_CONCAT:
+	case OVAL_FUNCTION_END:
+	case OVAL_FUNCTION_ESCAPE_REGEX:
+	case OVAL_FUNCTION_REGEX_CAPTURE:
+	case OVAL_FUNCTION_SPLIT:
+	case OVAL_FUNCTION_SUBSTRING:
+	case OVAL_FUNCTION_TIMEDIF:
+		cmp_itr = oval_component_get_function_components(comp);
+		while (oval_component_iterator_has_more(cmp_itr))
+			_prefetch_close_component(pf, oval_component_iterator_next(cmp_itr));
+		oval_component_iterator_free(cmp_itr);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Close the queues of all subtypes which are queried when the value of
+ * the variable is computed.
+ */
+static void _prefetch_close_variable(struct oval_probe_prefetch *pf, struct oval_variable *var)
+{
+	char *var_id;
+
+	var_id = oval_variable_get_id(var);
+	if (oval_string_map_get_value(pf->variables, var_id) != NULL)
+		return;
+	oval_string_map_put(pf->variables, var_id, var);
+
+	if (oval_variable_get_type(var) == OVAL_VARIABLE_LOCAL)
+		_prefetch_close_component(pf, oval_variable_get_component(var));
+}
+
+static bool _prefetch_object_is_independent(struct oval_object *obj)
+{
+	struct oval_object_content_iterator *cont_itr;
+	struct oval_object_content *cont;
+	bool independent = true;
+
+	cont_itr = oval_object_get_object_contents(obj);
+	while (independent && oval_object_content_iterator_has_more(cont_itr)) {
+		cont = oval_object_content_iterator_next(cont_itr);
+
+		switch (oval_object_content_get_type(cont)) {
+		case OVAL_OBJECTCONTENT_ENTITY:
+			switch (oval_entity_get_varref_type(oval_object_content_get_entity(cont))) {
+			case OVAL_ENTITY_VARREF_ATTRIBUTE:
+			case OVAL_ENTITY_VARREF_ELEMENT:
+				independent = false;
+				break;
+			default:
+				break;
+			}
+			break;
+		default:
+			/* sets and filters are resolved by callbacks to the library */
+			independent = false;
+		}
+	}
+	oval_object_content_iterator_free(cont_itr);
+
+	return independent;
+}
+
+static void _prefetch_object(struct oval_probe_prefetch *pf, struct oval_object *obj)
+{
+	struct oval_probe_prefetch_queue *q;
+	struct oval_syschar *sysc;
+	char *oid;
+
+	oid = oval_object_get_id(obj);
+	if (oval_string_map_get_value(pf->objects, oid) != NULL)
+		return;
+	oval_string_map_put(pf->objects, oid, obj);
+
+	q = _prefetch_queue_get(pf, oval_object_get_subtype(obj));
+	if (q->closed)
+		return;
+
+	sysc = oval_syschar_model_get_syschar(pf->sess->sys_model, oid);
+	if (sysc != NULL) {
+		if (oval_syschar_get_variable_instance_hint(sysc) != oval_syschar_get_variable_instance(sysc)) {
+			q->closed = true;
+			return;
+		}
+		if (oval_syschar_get_flag(sysc) != SYSCHAR_FLAG_UNKNOWN)
+			return;
+	}
+
+	if (!_prefetch_object_is_independent(obj)) {
+		_prefetch_close_object(pf, obj);
+		return;
+	}
+
+	if (sysc == NULL)
+		sysc = oval_syschar_new(pf->sess->sys_model, obj);
+
+	if (q->count == q->size) {
+		q->size = q->size ? q->size * 2 : 32;
+		q->sysc = oscap_realloc(q->sysc, sizeof(struct oval_syschar *) * q->size);
+	}
+	q->sysc[q->count++] = sysc;
+}
+
+/**
+ * Walk the criteria in the same order as oval_probe_query_criteria does.
+ */
+static void _prefetch_criteria(struct oval_probe_prefetch *pf, struct oval_criteria_node *cnode)
+{
+	switch (oval_criteria_node_get_type(cnode)) {
+	case OVAL_NODETYPE_CRITERION:{
+		struct oval_test *test;
+		struct oval_object *object;
+		struct oval_state_iterator *ste_itr;
+
+		test = oval_criteria_node_get_test(cnode);
+		if (test == NULL)
+			return;
+		object = oval_test_get_object(test);
+		if (object == NULL)
+			return;
+		_prefetch_object(pf, object);
+
+		ste_itr = oval_test_get_states(test);
+		while (oval_state_iterator_has_more(ste_itr)) {
+			struct oval_state *state = oval_state_iterator_next(ste_itr);
+			struct oval_state_content_iterator *contents = oval_state_get_contents(state);
+			while (oval_state_content_iterator_has_more(contents)) {
+				struct oval_state_content *content = oval_state_content_iterator_next(contents);
+				struct oval_entity *entity = oval_state_content_get_entity(content);
+				if (oval_entity_get_varref_type(entity) == OVAL_ENTITY_VARREF_ATTRIBUTE)
+					_prefetch_close_variable(pf, oval_entity_get_variable(entity));
+			}
+			oval_state_content_iterator_free(contents);
+		}
+		oval_state_iterator_free(ste_itr);
+		break;
+	}
+	case OVAL_NODETYPE_CRITERIA:{
+		struct oval_criteria_node_iterator *cnode_it = oval_criteria_node_get_subnodes(cnode);
+		if (cnode_it == NULL)
+			return;
+		while (oval_criteria_node_iterator_has_more(cnode_it))
+			_prefetch_criteria(pf, oval_criteria_node_iterator_next(cnode_it));
+		oval_criteria_node_iterator_free(cnode_it);
+		break;
+	}
+	case OVAL_NODETYPE_EXTENDDEF:{
+		struct oval_definition *oval_def = oval_criteria_node_get_definition(cnode);
+		struct oval_criteria_node *node = oval_definition_get_criteria(oval_def);
+		if (node != NULL)
+			_prefetch_criteria(pf, node);
+		break;
+	}
+	case OVAL_NODETYPE_UNKNOWN:
+		break;
+	}
+}
+
+/**
+ * Collect the objects of one queue, starting with the object at index start.
+ * The rest of the queue is left to the serial evaluation after a failure.
+ */
+static void _prefetch_queue_eval(oval_probe_session_t *sess, struct oval_probe_prefetch_queue *q, size_t start)
+{
+	oval_ph_t *ph;
+	size_t i;
+
+	ph = oval_probe_handler_get(sess->ph, q->type);
+	if (ph == NULL)
+		return;
+
+	for (i = start; i < q->count; ++i) {
+		if (ph->func(q->type, ph->uptr, PROBE_HANDLER_ACT_EVAL, q->sysc[i], OVAL_PDFLAG_SLAVE) != 0) {
+			dW("Parallel collection of object %s failed.\n",
+			   oval_object_get_id(oval_syschar_get_object(q->sysc[i])));
+			break;
+		}
+	}
+}
+
+#if defined(OSCAP_THREAD_SAFE)
+static void *_prefetch_worker(void *arg)
+{
+	struct oval_probe_prefetch *pf = (struct oval_probe_prefetch *)arg;
+	struct oval_probe_prefetch_queue *q;
+
+	for (;;) {
+		pthread_mutex_lock(&pf->lock);
+		q = (pf->next < pf->queue_count) ? &pf->queue[pf->next++] : NULL;
+		pthread_mutex_unlock(&pf->lock);
+
+		if (q == NULL)
+			break;
+
+		_prefetch_queue_eval(pf->sess, q, 1);
+	}
+
+	return (NULL);
+}
+#endif
+
+int oval_probe_prefetch_definitions(oval_probe_session_t *sess, unsigned int threads)
+{
+	struct oval_probe_prefetch pf;
+	struct oval_definition_model *definition_model;
+	struct oval_definition_iterator *def_itr;
+	size_t i, pending;
+
+	pf.sess        = sess;
+	pf.queue       = NULL;
+	pf.queue_count = 0;
+	pf.objects     = oval_string_map_new();
+	pf.variables   = oval_string_map_new();
+
+	definition_model = oval_syschar_model_get_definition_model(sess->sys_model);
+	def_itr = oval_definition_model_get_definitions(definition_model);
+	while (oval_definition_iterator_has_more(def_itr)) {
+		struct oval_criteria_node *cnode;
+
+		cnode = oval_definition_get_criteria(oval_definition_iterator_next(def_itr));
+		if (cnode != NULL)
+			_prefetch_criteria(&pf, cnode);
+	}
+	oval_definition_iterator_free(def_itr);
+
+	/*
+	 * The first object of each subtype is collected by this thread so that
+	 * the probes are started and connected before any worker runs.
+	 */
+	pending = 0;
+	for (i = 0; i < pf.queue_count; ++i) {
+		struct oval_probe_prefetch_queue *q = &pf.queue[i];
+
+		if (q->count > 0
+		    && oval_probe_query_object(sess, oval_syschar_get_object(q->sysc[0]), 0, NULL) == 0
+		    && q->count > 1)
+			pf.queue[pending++] = *q;
+		else
+			oscap_free(q->sysc);
+	}
+	pf.queue_count = pending;
+
+	dI("Collecting objects of %zu subtypes using %u threads.\n", pf.queue_count, threads);
+
+#if defined(OSCAP_THREAD_SAFE)
+	{
+		pthread_t *tids;
+		size_t started = 0;
+
+		if (threads > pf.queue_count)
+			threads = pf.queue_count;
+
+		pthread_mutex_init(&pf.lock, NULL);
+		pf.next = 0;
+
+		/* this thread works as one of the workers */
+		tids = oscap_alloc(sizeof(pthread_t) * (threads + 1));
+		for (started = 0; started + 1 < threads; ++started) {
+			int err = pthread_create(&tids[started], NULL, _prefetch_worker, &pf);
+
+			if (err != 0) {
+				dW("Can't create a collection thread: %d, %s.\n", err, strerror(err));
+				break;
+			}
+		}
+
+		_prefetch_worker(&pf);
+
+		for (i = 0; i < started; ++i)
+			pthread_join(tids[i], NULL);
+
+		oscap_free(tids);
+		pthread_mutex_destroy(&pf.lock);
+	}
+#else
+	for (i = 0; i < pf.queue_count; ++i)
+		_prefetch_queue_eval(sess, &pf.queue[i], 1);
+#endif
+
+	for (i = 0; i < pf.queue_count; ++i)
+		oscap_free(pf.queue[i].sysc);
+	oscap_free(pf.queue);
+	oval_string_map_free(pf.objects, NULL);
+	oval_string_map_free(pf.variables, NULL);
+
+	return (0);
+}
+
 #if 0
 const oval_probe_meta_t * const oval_probe_meta_get(void)
 {
@@ -45,6 +45,7 @@
 #include "oval_probe_meta.h"
 
 #define __ERRBUF_SIZE 128
+#define OVAL_PEXT_STRBUF_MAX 4096
 
 #if defined(__SVR4) && defined (__sun)
 #define __STRING(x)     #x
@@ -61,12 +62,22 @@ static oval_pd_t    *oval_pdtbl_get(oval_pdtbl_t *table, oval_subtype_t type);
 oval_pext_t *oval_pext_new(void)
 {
         oval_pext_t *pext;
+        pthread_mutexattr_t mutex_attr;
 
         pext = oscap_talloc(oval_pext_t);
 
         pext->do_init = true;
         pthread_mutex_init(&pext->lock, NULL);
 
+        /*
+         * The model lock is taken again when an object's variables
+         * are resolved while converting the object to an S-exp.
+         */
+        pthread_mutexattr_init(&mutex_attr);
+        pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&pext->model_lock, &mutex_attr);
+        pthread_mutexattr_destroy(&mutex_attr);
+
 #if defined(OVAL_PROBEDIR_ENV)
         pext->probe_dir = getenv("OVAL_PROBE_DIR");
 #else
@@ -79,9 +90,35 @@ oval_pext_t *oval_pext_new(void)
         pext->pdsc      = NULL;
         pext->pdsc_cnt  = 0;
 
+        pext->ocache     = oval_string_map_new();
+        pext->ocache_ids = oval_string_map_new();
+        pext->ocache_lookups = 0;
+        pext->ocache_hits    = 0;
+
         return(pext);
 }
 
+/*
+ * The syschars of the object cache belong to the current syschar model and
+ * the probes forget the collected objects when they are reset.
+ */
+static void oval_pext_ocache_clear(oval_pext_t *pext, bool renew)
+{
+        if (pext->ocache_lookups > 0)
+                dI("Object cache: %u of %u probe calls saved.\n", pext->ocache_hits, pext->ocache_lookups);
+
+        oval_string_map_free(pext->ocache, NULL);
+        oval_string_map_free(pext->ocache_ids, NULL);
+
+        if (renew) {
+                pext->ocache     = oval_string_map_new();
+                pext->ocache_ids = oval_string_map_new();
+        }
+
+        pext->ocache_lookups = 0;
+        pext->ocache_hits    = 0;
+}
+
 void oval_pext_free(oval_pext_t *pext)
 {
         if (!pext->do_init) {
@@ -92,7 +129,9 @@ void oval_pext_free(oval_pext_t *pext)
                 oval_pdtbl_free(pext->pdtbl);
         }
 
+        oval_pext_ocache_clear(pext, false);
         pthread_mutex_destroy(&pext->lock);
+        pthread_mutex_destroy(&pext->model_lock);
         oscap_free(pext);
 }
 
@@ -359,10 +398,17 @@ static inline const char *_probe_strerror(uint32_t error_code)
 	return codemsg;
 }
 
-static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj, int flags, SEXP_t **out_sexp)
+/*
+ * Called by oval_probe_comm for each chunk of items the probe sends
+ * ahead of the reply.
+ */
+typedef void (oval_probe_chunk_fn)(const SEXP_t *s_chunk, void *arg);
+
+static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj, int flags, SEXP_t **out_sexp,
+			   oval_probe_chunk_fn *chunk_fn, void *chunk_arg)
 {
 	int retry, ret;
-	bool aborted = false;
+	bool aborted = false, chunked = false;
 
 	SEAP_msg_t *s_imsg, *s_omsg;
 	SEXP_t *s_oobj;
@@ -420,6 +466,19 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 			}
 		}
 
+		if (chunk_fn != NULL) {
+			if (SEAP_msgattr_set(s_omsg, "chunked", NULL) != 0) {
+                                protect_errno {
+                                        oscap_dlprintf(DBG_E, "Can't set chunked attribute.\n");
+                                }
+
+                                SEAP_msg_free(s_omsg);
+                                oscap_seterr (OSCAP_EFAMILY_OVAL, "OVAL_EPROBEUNKNOWN");
+
+				return (-1);
+			}
+		}
+
 		oscap_dlprintf(DBG_I, "Sending message.\n");
 
 		ret = SEAP_sendmsg(ctx, pd->sd, s_omsg);
@@ -481,7 +540,7 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 
 		oscap_dlprintf(DBG_I, "Waiting for reply.\n");
 
-		/* recv_retry: */
+	recv_retry:
 		s_imsg = NULL;
 
 		ret = SEAP_recvmsg(ctx, pd->sd, &s_imsg);
@@ -573,6 +632,20 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 			pd->sd = -1;
 
 			if (!aborted) {
+				/*
+				 * The items of the chunks received so far are in
+				 * the syschar already, sending the object again
+				 * would add them twice.
+				 */
+				if (chunked) {
+					oscap_dlprintf(DBG_E, "Recv: connection lost after a chunk, not retrying.\n");
+					SEAP_msg_free(s_imsg);
+					SEAP_msg_free(s_omsg);
+					oscap_seterr (OSCAP_EFAMILY_OVAL, "Connection to the probe lost while receiving items");
+
+					return (-1);
+				}
+
 				if (++retry <= OVAL_PROBE_MAXRETRY) {
 					oscap_dlprintf(DBG_I, "Recv: retry %u/%u.\n", retry, OVAL_PROBE_MAXRETRY);
 					continue;
@@ -601,6 +674,24 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 			}
 		}
 
+		if (SEAP_msgattr_exists(s_imsg, "chunk")) {
+			SEXP_t *s_chunk;
+
+			oscap_dlprintf(DBG_I, "Chunk received.\n");
+
+			s_chunk = SEAP_msg_get(s_imsg);
+			SEAP_msg_free(s_imsg);
+			chunked = true;
+
+			if (chunk_fn != NULL)
+				chunk_fn(s_chunk, chunk_arg);
+			else
+				oscap_dlprintf(DBG_W, "Unexpected chunk from probe!\n");
+
+			SEXP_free(s_chunk);
+			goto recv_retry;
+		}
+
 		oscap_dlprintf(DBG_I, "Message received.\n");
 		break;
 	}
@@ -655,7 +746,7 @@ static int oval_probe_sys_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, struct oval_sysch
                 SEXP_free (r0);
         }
 
-        ret = oval_probe_comm(ctx, pd, s_obj, 0, &r0);
+        ret = oval_probe_comm(ctx, pd, s_obj, 0, &r0, NULL, NULL);
         SEXP_free(s_obj);
 
 	if (ret != 0)
@@ -932,6 +1023,12 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
         case PROBE_HANDLER_ACT_RESET:
 	case PROBE_HANDLER_ACT_ABORT:
         {
+                if (act == PROBE_HANDLER_ACT_RESET) {
+                        pthread_mutex_lock(&pext->model_lock);
+                        oval_pext_ocache_clear(pext, true);
+                        pthread_mutex_unlock(&pext->model_lock);
+                }
+
                 if (type == OVAL_SUBTYPE_ALL) {
                         /*
                          * Iterate thru probe descriptor table and execute the reset operation
@@ -1065,10 +1162,104 @@ _ret:
         return(ret);
 }
 
+/*
+ * Canonical form of an object S-exp: everything but the object's id. The
+ * entities already carry the values of the variables they reference.
+ */
+static char *oval_probe_ext_objkey(const SEXP_t *s_obj)
+{
+	strbuf_t *sb;
+	SEXP_t *r0;
+	char *name, *key;
+
+	sb   = strbuf_new(OVAL_PEXT_STRBUF_MAX);
+	name = probe_obj_getname(s_obj);
+
+	strbuf_add0(sb, name != NULL ? name : "");
+	strbuf_addc(sb, '\n');
+	oscap_free(name);
+
+	if ((r0 = probe_obj_getattrval(s_obj, "oval_version")) != NULL) {
+		SEXP_sbprintf_t(r0, sb);
+		SEXP_free(r0);
+	}
+
+	strbuf_addc(sb, '\n');
+
+	if ((r0 = probe_obj_getattrval(s_obj, "skip_eval")) != NULL) {
+		SEXP_sbprintf_t(r0, sb);
+		SEXP_free(r0);
+	}
+
+	strbuf_addc(sb, '\n');
+	r0 = SEXP_list_rest(s_obj);
+	if (r0 != NULL) {
+		SEXP_sbprintf_t(r0, sb);
+		SEXP_free(r0);
+	}
+
+	strbuf_addc(sb, '\0');
+	key = strbuf_cstr(sb);
+	strbuf_free(sb);
+
+	return (key);
+}
+
+/* Fill in the syschar with what was collected for an equal object */
+static void oval_probe_ext_share(struct oval_syschar *syschar, struct oval_syschar *shared)
+{
+	struct oval_message_iterator *msg_itr;
+	struct oval_sysitem_iterator *item_itr;
+
+	oval_syschar_set_flag(syschar, oval_syschar_get_flag(shared));
+
+	msg_itr = oval_syschar_get_messages(shared);
+	while (oval_message_iterator_has_more(msg_itr))
+		oval_syschar_add_message(syschar, oval_message_clone(oval_message_iterator_next(msg_itr)));
+	oval_message_iterator_free(msg_itr);
+
+	item_itr = oval_syschar_get_sysitem(shared);
+	while (oval_sysitem_iterator_has_more(item_itr))
+		oval_syschar_add_sysitem(syschar, oval_sysitem_iterator_next(item_itr));
+	oval_sysitem_iterator_free(item_itr);
+}
+
+struct oval_probe_chunk {
+	oval_pext_t *pext;
+	struct oval_syschar *syschar;
+	struct oval_string_map *itm_ids; /* NULL until the first chunk */
+};
+
+/* Convert the items the probe sent ahead of the reply */
+static void oval_probe_ext_chunk(const SEXP_t *s_chunk, void *arg)
+{
+	struct oval_probe_chunk *chunk = arg;
+
+	pthread_mutex_lock(&chunk->pext->model_lock);
+	if (chunk->itm_ids == NULL)
+		chunk->itm_ids = oval_string_map_new();
+	oval_sexp_to_sysch_items(s_chunk, chunk->syschar, chunk->itm_ids);
+	pthread_mutex_unlock(&chunk->pext->model_lock);
+}
+
+bool oval_probe_ext_shared(oval_pext_t *pext, const char *obj_id)
+{
+	bool shared;
+
+	pthread_mutex_lock(&pext->model_lock);
+	shared = oval_string_map_get_value(pext->ocache_ids, obj_id) != NULL;
+	pthread_mutex_unlock(&pext->model_lock);
+
+	return (shared);
+}
+
 int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags)
 {
         SEXP_t *s_obj, *s_sys;
 	struct oval_object *object;
+	struct oval_syschar *shared;
+	struct oval_probe_chunk chunk;
+	char *key;
 	int ret;
 
 	if (syschar == NULL) {
@@ -1077,15 +1268,65 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 	}
 
 	object = oval_syschar_get_object(syschar);
+
+	key    = NULL;
+	shared = NULL;
+
+	pthread_mutex_lock(&pext->model_lock);
 	ret = oval_object_to_sexp(pext->sess_ptr, oval_subtype_to_str(oval_object_get_subtype(object)), syschar, &s_obj);
 
+	/*
+	 * Objects requested by a probe without a reply have to reach the
+	 * probe, it looks them up in its own cache afterwards.
+	 */
+	if (ret == 0 && !(flags & OVAL_PDFLAG_NOREPLY)) {
+		key    = oval_probe_ext_objkey(s_obj);
+		shared = key != NULL ? oval_string_map_get_value(pext->ocache, key) : NULL;
+		++pext->ocache_lookups;
+
+		if (shared != NULL) {
+			const char *id = oval_object_get_id(object);
+
+			dI("Object %s is equal to %s, probe call saved.\n",
+			   id, oval_object_get_id(oval_syschar_get_object(shared)));
+
+			oval_probe_ext_share(syschar, shared);
+			if (oval_string_map_get_value(pext->ocache_ids, id) == NULL)
+				oval_string_map_put(pext->ocache_ids, id, syschar);
+			++pext->ocache_hits;
+		}
+	}
+	pthread_mutex_unlock(&pext->model_lock);
+
 	if (ret != 0)
 		return (1);
 
-	ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
+	if (shared != NULL) {
+		SEXP_free(s_obj);
+		oscap_free(key);
+		return (0);
+	}
+
+	chunk.pext    = pext;
+	chunk.syschar = syschar;
+	chunk.itm_ids = NULL;
+
+	ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys,
+			      (flags & OVAL_PDFLAG_NOREPLY) ? NULL : oval_probe_ext_chunk, &chunk);
 	SEXP_free(s_obj);
 
 	if (ret != 0) {
+		oscap_free(key);
+
+		protect_errno {
+			pthread_mutex_lock(&pext->model_lock);
+			oval_syschar_set_flag(syschar, SYSCHAR_FLAG_ERROR);
+			pthread_mutex_unlock(&pext->model_lock);
+			/* some items may have been converted already */
+			if (chunk.itm_ids != NULL)
+				oval_string_map_free(chunk.itm_ids, NULL);
+		}
+
 		switch (errno) {
 		case ECONNABORTED:
 			dI("Closing sd=%d (pd=%p) after abort\n", pd->sd, pd);
@@ -1106,14 +1347,23 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
                         oscap_dlprintf(DBG_W, "Obtrusive data from probe!\n");
                         SEXP_free(s_sys);
 		}
+		oscap_free(key);
 		return (0);
 	}
 
         /*
 	 * Convert the received S-exp to OVAL system characteristic.
 	 */
-	ret = oval_sexp_to_sysch(s_sys, syschar);
+	pthread_mutex_lock(&pext->model_lock);
+	ret = oval_sexp_to_sysch(s_sys, syschar, chunk.itm_ids);
+	if (ret == 0 && key != NULL && oval_syschar_get_flag(syschar) != SYSCHAR_FLAG_ERROR
+	    && oval_string_map_get_value(pext->ocache, key) == NULL)
+		oval_string_map_put(pext->ocache, key, syschar);
+	pthread_mutex_unlock(&pext->model_lock);
+	if (chunk.itm_ids != NULL)
+		oval_string_map_free(chunk.itm_ids, NULL);
 	SEXP_free(s_sys);
+	oscap_free(key);
 
 	return (ret);
 }
@@ -28,6 +28,7 @@
 #include "oval_probe_impl.h"
 #include "oval_system_characteristics_impl.h"
 #include "common/util.h"
+#include "adt/oval_string_map_impl.h"
 
 typedef struct {
 	oval_subtype_t subtype;
@@ -51,6 +52,7 @@ typedef struct oval_pdsc oval_pdsc_t;
 
 struct oval_pext {
         pthread_mutex_t lock;
+        pthread_mutex_t model_lock; /**< serializes syschar model updates of concurrent evaluations */
         bool            do_init;
 
         SEAP_CTX_t   *sctx;
@@ -61,6 +63,16 @@ struct oval_pext {
 
         void *sess_ptr;
         struct oval_syschar_model **model;
+
+        /*
+         * Structurally equal objects (equal but for their id) are sent to
+         * the probe only once. The first syschar collected for an object
+         * is shared with the others. Guarded by the model lock.
+         */
+        struct oval_string_map *ocache;     /**< object S-exp without the id -> syschar */
+        struct oval_string_map *ocache_ids; /**< ids of objects answered from ocache */
+        unsigned int ocache_lookups;
+        unsigned int ocache_hits;
 };
 
 typedef struct oval_pext oval_pext_t;
@@ -72,6 +84,12 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 int oval_probe_ext_abort(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 
+/**
+ * Check whether the object was answered from the object cache, i.e. its
+ * probe hasn't seen it and has to collect it if asked for it by id.
+ */
+bool oval_probe_ext_shared(oval_pext_t *pext, const char *obj_id);
+
 int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...);
 int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...);
 
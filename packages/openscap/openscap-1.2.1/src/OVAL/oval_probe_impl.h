@@ -70,5 +70,13 @@ oval_subtype_t oval_str_to_subtype(const char *str);
 
 int oval_probe_hint_definition(oval_probe_session_t *sess, struct oval_definition *definition, int variable_instance_hint);
 
+/**
+ * Collect the objects of all definitions in the session's model which can be
+ * collected without the help of the library, using up to the given number of
+ * threads. Objects of different subtypes are collected concurrently.
+ * @return 0 on success
+ */
+int oval_probe_prefetch_definitions(oval_probe_session_t *sess, unsigned int threads);
+
 #endif /* OVAL_PROBE_IMPL_H */
 /// @}
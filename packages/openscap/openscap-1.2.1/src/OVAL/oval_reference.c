@@ -92,7 +92,7 @@ char *oval_reference_get_url(struct oval_reference *ref)
 
 struct oval_reference *oval_reference_new(struct oval_definition_model *model)
 {
-	struct oval_reference *ref = (struct oval_reference *)oscap_alloc(sizeof(oval_reference_t));
+	struct oval_reference *ref = (struct oval_reference *)oval_definition_model_alloc(model, sizeof(oval_reference_t));
 	if (ref == NULL)
 		return NULL;
 
@@ -119,40 +119,34 @@ void oval_reference_free(struct oval_reference *ref)
 {
 	__attribute__nonnull__(ref);
 
-	if (ref->id != NULL)
-		oscap_free(ref->id);
-	if (ref->source != NULL)
-		oscap_free(ref->source);
-	if (ref->url != NULL)
-		oscap_free(ref->url);
+	oval_definition_model_release(ref->model, ref->id);
+	oval_definition_model_release(ref->model, ref->source);
+	oval_definition_model_release(ref->model, ref->url);
 	ref->id = NULL;
 	ref->source = NULL;
 	ref->url = NULL;
-	oscap_free(ref);
+	oval_definition_model_release(ref->model, ref);
 }
 
 void oval_reference_set_source(struct oval_reference *ref, char *source)
 {
 	__attribute__nonnull__(ref);
-	if (ref->source != NULL)
-		oscap_free(ref->source);
-	ref->source = (source == NULL) ? NULL : oscap_strdup(source);
+	oval_definition_model_release(ref->model, ref->source);
+	ref->source = oval_definition_model_strdup(ref->model, source);
 }
 
 void oval_reference_set_id(struct oval_reference *ref, char *id)
 {
 	__attribute__nonnull__(ref);
-	if (ref->id != NULL)
-		free(ref->id);
-	ref->id = (id == NULL) ? NULL : oscap_strdup(id);
+	oval_definition_model_release(ref->model, ref->id);
+	ref->id = oval_definition_model_strdup(ref->model, id);
 }
 
 void oval_reference_set_url(struct oval_reference *ref, char *url)
 {
 	__attribute__nonnull__(ref);
-	if (ref->url != NULL)
-		free(ref->url);
-	ref->url = (url == NULL) ? NULL : oscap_strdup(url);
+	oval_definition_model_release(ref->model, ref->url);
+	ref->url = oval_definition_model_strdup(ref->model, url);
 }
 
 /*typedef void (*oval_reference_consumer)(struct oval_reference*, void*);*/
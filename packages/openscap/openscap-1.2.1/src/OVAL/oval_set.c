@@ -132,7 +132,7 @@ struct oval_filter_iterator *oval_setobject_get_filters(struct oval_setobject *s
 
 struct oval_setobject *oval_setobject_new(struct oval_definition_model *model)
 {
-	oval_set_t *set = (oval_set_t *) oscap_alloc(sizeof(oval_set_t));
+	oval_set_t *set = (oval_set_t *) oval_definition_model_alloc(model, sizeof(oval_set_t));
 	if (set == NULL)
 		return NULL;
 
@@ -189,7 +189,7 @@ void oval_setobject_free(struct oval_setobject *set)
 			oval_set_AGGREGATE_t *aggregate = (oval_set_AGGREGATE_t *) set->extension;
 			oval_collection_free_items(aggregate->subsets, (oscap_destruct_func) oval_setobject_free);
 			aggregate->subsets = NULL;
-			oscap_free(set->extension);
+			oval_definition_model_release(set->model, set->extension);
 			set->extension = NULL;
 		}
 		break;
@@ -200,14 +200,14 @@ void oval_setobject_free(struct oval_setobject *set)
 			oval_collection_free_items(collective->objects, NULL);
 			collective->filters = NULL;
 			collective->objects = NULL;
-			oscap_free(set->extension);
+			oval_definition_model_release(set->model, set->extension);
 			set->extension = NULL;
 		}
 		break;
 	case OVAL_SET_UNKNOWN:
 		break;
 	}
-	oscap_free(set);
+	oval_definition_model_release(set->model, set);
 }
 
 void oval_setobject_set_type(struct oval_setobject *set, oval_setobject_type_t type)
@@ -219,16 +219,16 @@ void oval_setobject_set_type(struct oval_setobject *set, oval_setobject_type_t t
 	case OVAL_SET_AGGREGATE:{
 			oval_set_AGGREGATE_t *aggregate =
 			    (oval_set_AGGREGATE_t *) (set->extension =
-						      oscap_alloc(sizeof(oval_set_AGGREGATE_t)));
-			aggregate->subsets = oval_collection_new();
+						      oval_definition_model_alloc(set->model, sizeof(oval_set_AGGREGATE_t)));
+			aggregate->subsets = oval_collection_new_arena(oval_definition_model_get_arena(set->model));
 		}
 		break;
 	case OVAL_SET_COLLECTIVE:{
 			oval_set_COLLECTIVE_t *collective =
 			    (oval_set_COLLECTIVE_t *) (set->extension =
-						       oscap_alloc(sizeof(oval_set_COLLECTIVE_t)));
-			collective->filters = oval_collection_new();
-			collective->objects = oval_collection_new();
+						       oval_definition_model_alloc(set->model, sizeof(oval_set_COLLECTIVE_t)));
+			collective->filters = oval_collection_new_arena(oval_definition_model_get_arena(set->model));
+			collective->objects = oval_collection_new_arena(oval_definition_model_get_arena(set->model));
 		}
 		break;
 	case OVAL_SET_UNKNOWN:
@@ -406,7 +406,7 @@ void oval_set_propagate_filters(struct oval_definition_model *model, struct oval
 	struct oval_collection *new_objects;
 	struct oval_set_COLLECTIVE *ext_col;
 
-	new_objects = oval_collection_new();
+	new_objects = oval_collection_new_arena(oval_definition_model_get_arena(model));
 
 	obj_itr = oval_setobject_get_objects(set);
 	while (oval_object_iterator_has_more(obj_itr)) {
@@ -800,6 +800,7 @@ static struct oval_sysent *oval_sexp_to_sysent(struct oval_syschar_model *model,
 
 	ent = oval_sysent_new(model);
 	oval_sysent_set_name(ent, key);
+	key = oval_sysent_get_name(ent); /* interned */
 	oval_sysent_set_status(ent, status);
 	oval_sysent_set_datatype(ent, dt);
 	if (mask_map == NULL || oval_string_map_get_value(mask_map, key) == NULL)
@@ -943,30 +944,15 @@ static struct oval_sysitem *oval_sexp_to_sysitem(struct oval_syschar_model *mode
 	return sysitem;
 }
 
-int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar)
+int oval_sexp_to_sysch_items(const SEXP_t *cobj, struct oval_syschar *syschar, struct oval_string_map *itm_ids)
 {
-	oval_syschar_collection_flag_t flag;
-	SEXP_t *messages, *msg, *items, *item, *mask;
+	SEXP_t *items, *item, *mask;
 	struct oval_syschar_model *model;
-	struct oval_string_map *itm_id_map;
         struct oval_string_map *item_mask_map;
 
 	_A(cobj != NULL);
+	_A(itm_ids != NULL);
 
-	flag = probe_cobj_get_flag(cobj);
-	oval_syschar_set_flag(syschar, flag);
-
-	messages = probe_cobj_get_msgs(cobj);
-	SEXP_list_foreach(msg, messages) {
-		struct oval_message *omsg;
-
-		omsg = oval_sexp_to_msg(msg);
-		if (omsg != NULL)
-			oval_syschar_add_message(syschar, omsg);
-	}
-	SEXP_free(messages);
-
-	itm_id_map = oval_string_map_new();
 	model = oval_syschar_get_model(syschar);
 	items = probe_cobj_get_items(cobj);
 
@@ -991,18 +977,48 @@ int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar)
 			char *itm_id;
 
 			itm_id = oval_sysitem_get_id(sysitem);
-			if (oval_string_map_get_value(itm_id_map, itm_id) == NULL) {
-				oval_string_map_put(itm_id_map, itm_id, itm_id);
+			if (oval_string_map_get_value(itm_ids, itm_id) == NULL) {
+				oval_string_map_put(itm_ids, itm_id, itm_id);
 				oval_syschar_add_sysitem(syschar, sysitem);
 			}
 		}
 	}
 	SEXP_free(items);
-	oval_string_map_free(itm_id_map, NULL);
         if (item_mask_map != NULL)
             oval_string_map_free_string(item_mask_map);
 
 	return 0;
 }
 
+int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar, struct oval_string_map *itm_ids)
+{
+	oval_syschar_collection_flag_t flag;
+	SEXP_t *messages, *msg;
+	int ret;
+
+	_A(cobj != NULL);
+
+	flag = probe_cobj_get_flag(cobj);
+	oval_syschar_set_flag(syschar, flag);
+
+	messages = probe_cobj_get_msgs(cobj);
+	SEXP_list_foreach(msg, messages) {
+		struct oval_message *omsg;
+
+		omsg = oval_sexp_to_msg(msg);
+		if (omsg != NULL)
+			oval_syschar_add_message(syschar, omsg);
+	}
+	SEXP_free(messages);
+
+	if (itm_ids == NULL) {
+		itm_ids = oval_string_map_new();
+		ret = oval_sexp_to_sysch_items(cobj, syschar, itm_ids);
+		oval_string_map_free(itm_ids, NULL);
+	} else
+		ret = oval_sexp_to_sysch_items(cobj, syschar, itm_ids);
+
+	return ret;
+}
+
 /// @}
@@ -51,7 +51,13 @@ int oval_state_to_sexp(void *sess, struct oval_state *state, SEXP_t **out_sexp);
 /*
  * S-exp -> OVAL
  */
-int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar);
+/*
+ * `itm_ids' holds the IDs of the items already added to `syschar' from
+ * the chunks sent by the probe ahead of the reply, NULL if there were
+ * none. oval_sexp_to_sysch_items() converts the items of a chunk only.
+ */
+int oval_sexp_to_sysch(const SEXP_t *cobj, struct oval_syschar *syschar, struct oval_string_map *itm_ids);
+int oval_sexp_to_sysch_items(const SEXP_t *cobj, struct oval_syschar *syschar, struct oval_string_map *itm_ids);
 OSCAP_HIDDEN_END;
 
 #endif				/* OVAL_SEXP_H */
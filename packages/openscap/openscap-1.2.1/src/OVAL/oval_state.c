@@ -145,7 +145,7 @@ struct oval_state *oval_state_new(struct oval_definition_model *model, const cha
 	__attribute__nonnull__(model);
 	oval_state_t *state;
 
-	state = (oval_state_t *) oscap_alloc(sizeof(oval_state_t));
+	state = (oval_state_t *) oval_definition_model_alloc(model, sizeof(oval_state_t));
 	if (state == NULL)
 		return NULL;
 
@@ -154,9 +154,9 @@ struct oval_state *oval_state_new(struct oval_definition_model *model, const cha
 	state->operator = OVAL_OPERATOR_UNKNOWN;
 	state->subtype = OVAL_SUBTYPE_UNKNOWN;
 	state->comment = NULL;
-	state->id = strdup(id);
-	state->notes = oval_collection_new();
-	state->contents = oval_collection_new();
+	state->id = oval_definition_model_strdup(model, id);
+	state->notes = oval_collection_new_arena(oval_definition_model_get_arena(model));
+	state->contents = oval_collection_new_arena(oval_definition_model_get_arena(model));
 	state->model = model;
 
 	oval_definition_model_add_state(model, state);
@@ -196,18 +196,14 @@ void oval_state_free(struct oval_state *state)
 {
 	__attribute__nonnull__(state);
 
-	if (state->comment != NULL)
-		free(state->comment);
-	if (state->id != NULL)
-		free(state->id);
-	oval_collection_free_items(state->notes, &free);
+	oval_collection_free_items(state->notes, NULL);
 	oval_collection_free_items(state->contents, (oscap_destruct_func) oval_state_content_free);
 
 	state->comment = NULL;
 	state->contents = NULL;
 	state->id = NULL;
 	state->notes = NULL;
-	free(state);
+	oval_definition_model_release(state->model, state);
 }
 
 void oval_state_set_subtype(struct oval_state *state, oval_subtype_t subtype)
@@ -219,15 +215,13 @@ void oval_state_set_subtype(struct oval_state *state, oval_subtype_t subtype)
 void oval_state_add_note(struct oval_state *state, char *notes)
 {
 	__attribute__nonnull__(state);
-	oval_collection_add(state->notes, (void *)strdup(notes));
+	oval_collection_add(state->notes, (void *)oval_definition_model_strdup(state->model, notes));
 }
 
 void oval_state_set_comment(struct oval_state *state, char *comm)
 {
 	__attribute__nonnull__(state);
-	if (state->comment != NULL)
-		free(state->comment);
-	state->comment = comm == NULL ? NULL : strdup(comm);
+	state->comment = oval_definition_model_strdup(state->model, comm);
 }
 
 void oval_state_set_deprecated(struct oval_state *state, bool deprecated)
@@ -107,12 +107,12 @@ oval_check_t oval_state_content_get_ent_check(struct oval_state_content * conten
 struct oval_state_content *oval_state_content_new(struct oval_definition_model *model)
 {
 	oval_state_content_t *content = (oval_state_content_t *)
-	    oscap_alloc(sizeof(oval_state_content_t));
+	    oval_definition_model_alloc(model, sizeof(oval_state_content_t));
 	if (content == NULL)
 		return NULL;
 
 	content->entity = NULL;
-	content->record_fields = oval_collection_new();
+	content->record_fields = oval_collection_new_arena(oval_definition_model_get_arena(model));
 	content->ent_check = OVAL_CHECK_UNKNOWN;
 	content->var_check = OVAL_CHECK_UNKNOWN;
 	content->model = model;
@@ -139,7 +139,7 @@ void oval_state_content_free(struct oval_state_content *content)
 		oval_entity_free(content->entity);
 	if (content->record_fields)
 		oval_collection_free_items(content->record_fields, (oscap_destruct_func) oval_record_field_free);
-	oscap_free(content);
+	oval_definition_model_release(content->model, content);
 }
 
 void oval_state_content_set_entity(struct oval_state_content *content, struct oval_entity *entity)
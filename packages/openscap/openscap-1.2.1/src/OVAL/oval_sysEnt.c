@@ -44,6 +44,7 @@
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "common/elements.h"
+#include "common/intern_priv.h"
 
 typedef struct oval_sysent {
 	struct oval_syschar_model *model;
@@ -80,10 +81,8 @@ struct oval_sysent *oval_sysent_clone(struct oval_syschar_model *new_model, stru
 		oval_sysent_set_value(new_item, oscap_strdup(old_value));
 	}
 
-	char *old_name = oval_sysent_get_name(old_item);
-	if (old_name) {
-		oval_sysent_set_name(new_item, oscap_strdup(old_name));
-	}
+	/* the name is interned */
+	new_item->name = old_item->name;
 
 	oval_sysent_set_datatype(new_item, oval_sysent_get_datatype(old_item));
 	oval_sysent_set_mask(new_item, oval_sysent_get_mask(old_item));
@@ -97,8 +96,6 @@ void oval_sysent_free(struct oval_sysent *sysent)
 	if (sysent == NULL)
 		return;
 
-	if (sysent->name != NULL)
-		oscap_free(sysent->name);
 	if (sysent->value != NULL)
 		oscap_free(sysent->value);
 	if (sysent->record_fields)
@@ -174,9 +171,8 @@ int oval_sysent_get_mask(struct oval_sysent *sysent)
 void oval_sysent_set_name(struct oval_sysent *sysent, char *name)
 {
 	__attribute__nonnull__(sysent);
-	if (sysent->name != NULL)
-		oscap_free(sysent->name);
-	sysent->name = name;
+	sysent->name = (char *) oscap_intern(name);
+	oscap_free(name);
 }
 
 void oval_sysent_set_status(struct oval_sysent *sysent, oval_syschar_status_t status)
@@ -165,7 +165,7 @@ struct oval_test *oval_test_new(struct oval_definition_model *model, const char
 	__attribute__nonnull__(model);
 	oval_test_t *test;
 
-	test = (oval_test_t *) oscap_alloc(sizeof(oval_test_t));
+	test = (oval_test_t *) oval_definition_model_alloc(model, sizeof(oval_test_t));
 	if (test == NULL)
 		return NULL;
 
@@ -176,10 +176,10 @@ struct oval_test *oval_test_new(struct oval_definition_model *model, const char
 	test->state_operator = OVAL_OPERATOR_AND;
 	test->subtype = OVAL_SUBTYPE_UNKNOWN;
 	test->comment = NULL;
-	test->id = oscap_strdup(id);
+	test->id = oval_definition_model_strdup(model, id);
 	test->object = NULL;
-	test->states = oval_collection_new();
-	test->notes = oval_collection_new();
+	test->states = oval_collection_new_arena(oval_definition_model_get_arena(model));
+	test->notes = oval_collection_new_arena(oval_definition_model_get_arena(model));
 	test->model = model;
 
 	oval_definition_model_add_test(model, test);
@@ -231,11 +231,7 @@ void oval_test_free(struct oval_test *test)
 {
 	__attribute__nonnull__(test);
 
-	if (test->comment != NULL)
-		oscap_free(test->comment);
-	if (test->id != NULL)
-		oscap_free(test->id);
-	oval_collection_free_items(test->notes, &oscap_free);
+	oval_collection_free_items(test->notes, NULL);
 	oval_collection_free(test->states);
 
 	test->comment = NULL;
@@ -244,7 +240,7 @@ void oval_test_free(struct oval_test *test)
 	test->object = NULL;
 	test->states = NULL;
 
-	oscap_free(test);
+	oval_definition_model_release(test->model, test);
 }
 
 void oval_test_set_deprecated(struct oval_test *test, bool deprecated)
@@ -268,9 +264,7 @@ void oval_test_set_subtype(struct oval_test *test, oval_subtype_t subtype)
 void oval_test_set_comment(struct oval_test *test, char *comm)
 {
 	__attribute__nonnull__(test);
-	if (test->comment != NULL)
-		oscap_free(test->comment);
-	test->comment = oscap_strdup(comm);
+	test->comment = oval_definition_model_strdup(test->model, comm);
 }
 
 void oval_test_set_existence(struct oval_test *test, oval_existence_t existence)
@@ -306,7 +300,7 @@ void oval_test_add_state(struct oval_test *test, struct oval_state *state)
 void oval_test_add_note(struct oval_test *test, char *note)
 {
 	__attribute__nonnull__(test);
-	oval_collection_add(test->notes, (void *)oscap_strdup(note));
+	oval_collection_add(test->notes, (void *)oval_definition_model_strdup(test->model, note));
 }
 
 static void _oval_test_parse_notes_consumer(char *text, void *test)
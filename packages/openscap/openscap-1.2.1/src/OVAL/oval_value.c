@@ -38,6 +38,7 @@
 
 #include "oval_definitions_impl.h"
 #include "adt/oval_collection_impl.h"
+#include "adt/oval_arena_impl.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "common/elements.h"
@@ -45,6 +46,7 @@
 typedef struct oval_value {
 	oval_datatype_t datatype;
 	char *text;
+	struct oval_arena *arena;	/* NULL if allocated from the heap */
 } oval_value_t;
 
 bool oval_value_iterator_has_more(struct oval_value_iterator *oc_value)
@@ -124,6 +126,24 @@ struct oval_value *oval_value_new(oval_datatype_t datatype, char *text_value)
 
 	value->datatype = datatype;
 	value->text = oscap_strdup(text_value);
+	value->arena = NULL;
+	return value;
+}
+
+struct oval_value *oval_value_new_arena(struct oval_arena *arena, oval_datatype_t datatype, const char *text_value)
+{
+	oval_value_t *value;
+
+	if (arena == NULL)
+		return oval_value_new(datatype, (char *) text_value);
+
+	value = (oval_value_t *) oval_arena_alloc(arena, sizeof(oval_value_t));
+	if (value == NULL)
+		return NULL;
+
+	value->datatype = datatype;
+	value->text = oval_arena_strdup(arena, text_value);
+	value->arena = arena;
 	return value;
 }
 
@@ -138,7 +158,7 @@ struct oval_value *oval_value_clone(struct oval_value *old_value)
 
 void oval_value_free(struct oval_value *value)
 {
-	if (value) {
+	if (value && value->arena == NULL) {
 		oscap_free(value->text);
 		value->text = NULL;
 		oscap_free(value);
@@ -189,7 +209,8 @@ int oval_value_parse_tag(xmlTextReaderPtr reader,
 	} else {
 		return_code = oscap_parser_text_value(reader, &oval_value_parse_tag_consume_text, &text);
 	}
-	struct oval_value *value = oval_value_new(datatype, text ? text : "");
+	struct oval_value *value = oval_value_new_arena(oval_definition_model_get_arena(context->definition_model),
+							 datatype, text ? text : "");
 	oscap_free(text);
 	(*consumer) (value, user);
 	return return_code;
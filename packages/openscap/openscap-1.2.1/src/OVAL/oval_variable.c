@@ -323,7 +323,7 @@ struct oval_variable *oval_variable_new(struct oval_definition_model *model, con
 	case OVAL_VARIABLE_CONSTANT:{
 			oval_variable_CONSTANT_t *cvar;
 
-			variable = (oval_variable_t *) oscap_alloc(sizeof(oval_variable_CONSTANT_t));
+			variable = (oval_variable_t *) oval_definition_model_alloc(model, sizeof(oval_variable_CONSTANT_t));
 			if (variable == NULL)
 				return NULL;
 
@@ -335,7 +335,7 @@ struct oval_variable *oval_variable_new(struct oval_definition_model *model, con
 	case OVAL_VARIABLE_EXTERNAL:{
 			oval_variable_EXTERNAL_t *evar;
 
-			variable = (oval_variable_t *) oscap_alloc(sizeof(oval_variable_EXTERNAL_t));
+			variable = (oval_variable_t *) oval_definition_model_alloc(model, sizeof(oval_variable_EXTERNAL_t));
 			if (variable == NULL)
 				return NULL;
 
@@ -347,7 +347,7 @@ struct oval_variable *oval_variable_new(struct oval_definition_model *model, con
 	case OVAL_VARIABLE_LOCAL:{
 			oval_variable_LOCAL_t *lvar;
 
-			variable = (oval_variable_t *) oscap_alloc(sizeof(oval_variable_LOCAL_t));
+			variable = (oval_variable_t *) oval_definition_model_alloc(model, sizeof(oval_variable_LOCAL_t));
 			if (variable == NULL)
 				return NULL;
 
@@ -358,7 +358,7 @@ struct oval_variable *oval_variable_new(struct oval_definition_model *model, con
 		}
 		break;
 	case OVAL_VARIABLE_UNKNOWN:{
-			variable = (oval_variable_t *) oscap_alloc(sizeof(oval_variable_UNKNOWN_t));
+			variable = (oval_variable_t *) oval_definition_model_alloc(model, sizeof(oval_variable_UNKNOWN_t));
 			if (variable == NULL)
 				return NULL;
 
@@ -371,7 +371,7 @@ struct oval_variable *oval_variable_new(struct oval_definition_model *model, con
 	}
 
 	variable->model = model;
-	variable->id = oscap_strdup(id);
+	variable->id = oval_definition_model_strdup(model, id);
 	variable->comment = NULL;
 	variable->datatype = OVAL_DATATYPE_UNKNOWN;
 	variable->type = type;
@@ -455,10 +455,8 @@ struct oval_variable *oval_variable_clone(struct oval_definition_model *new_mode
 void oval_variable_free(struct oval_variable *variable)
 {
 	if (variable) {
-		if (variable->id)
-			oscap_free(variable->id);
-		if (variable->comment)
-			oscap_free(variable->comment);
+		oval_definition_model_release(variable->model, variable->id);
+		oval_definition_model_release(variable->model, variable->comment);
 		variable->id = variable->comment = NULL;
 
 		switch (variable->type) {
@@ -495,7 +493,7 @@ void oval_variable_free(struct oval_variable *variable)
 			break;
 		}
 
-		oscap_free(variable);
+		oval_definition_model_release(variable->model, variable);
 	}
 }
 
@@ -552,9 +550,8 @@ void oval_variable_set_comment(struct oval_variable *variable, char *comm)
 {
 	__attribute__nonnull__(variable);
 
-	if (variable->comment != NULL)
-		oscap_free(variable->comment);
-	variable->comment = oscap_strdup(comm);
+	oval_definition_model_release(variable->model, variable->comment);
+	variable->comment = oval_definition_model_strdup(variable->model, comm);
 
 }
 
@@ -38,6 +38,9 @@ OSCAP_HIDDEN_START;
 #define SEAP_SYM_CMD    SEAP_SYM_PREFIX"cmd"
 #define SEAP_SYM_ERR    SEAP_SYM_PREFIX"err"
 
+/* Message attribute advertising support for binary S-exp frames */
+#define SEAP_ATTR_BINARY "seap-binary"
+
 struct SEAP_packet {
         uint8_t type;
         union {
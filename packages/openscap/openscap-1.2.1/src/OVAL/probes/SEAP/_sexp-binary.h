@@ -0,0 +1,84 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+#ifndef _SEXP_BINARY_H
+#define _SEXP_BINARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "public/sexp-output.h"
+#include "public/sexp-parser.h"
+#include "generic/rbt/rbt.h"
+#include "../../../common/util.h"
+
+OSCAP_HIDDEN_START;
+
+/*
+ * Binary frame layout:
+ *
+ *   +-------+----------------+-----------------+
+ *   | magic | payload length | encoded S-exp   |
+ *   | 1B    | 4B big-endian  | payload length  |
+ *   +-------+----------------+-----------------+
+ *
+ * The magic byte can't start a textual S-exp so that the receiver
+ * is able to tell the two formats apart.
+ */
+#define SEXP_BFRAME_HDRSZ 5
+
+/*
+ * Node tags
+ */
+#define SEXP_BTAG_END    0x00 /* end of list */
+#define SEXP_BTAG_LIST   0x01 /* list; members follow, terminated by END */
+#define SEXP_BTAG_STR    0x02 /* varint length + bytes */
+#define SEXP_BTAG_SYMDEF 0x03 /* varint length + bytes; gets the next symbol index */
+#define SEXP_BTAG_SYMREF 0x04 /* varint symbol index */
+#define SEXP_BTAG_UINT   0x05 /* varint */
+#define SEXP_BTAG_NINT   0x06 /* varint of the one's complement of a negative integer */
+#define SEXP_BTAG_DOUBLE 0x07 /* 8 bytes, host byte order */
+#define SEXP_BTAG_FALSE  0x08
+#define SEXP_BTAG_TRUE   0x09
+#define SEXP_BTAG_DTYPE  0x0a /* datatype name (STR/SYMDEF/SYMREF) + value */
+
+/*
+ * Only short strings which are likely to repeat are interned:
+ * list heads (item and entity names), keywords (":id", ":mask")
+ * and datatype names.
+ */
+#define SEXP_BSYM_MAXLEN 64
+#define SEXP_BSYM_MAXCNT 4096
+
+#define SEXP_BPARSE_MAXDEPTH 512
+
+struct SEXP_bostate {
+        rbt_t   *s_tbl; /* interned string -> symbol index + 1 */
+        uint32_t s_cnt; /* number of symbols defined */
+};
+
+struct SEXP_bpstate {
+        uint8_t  *b_buf;  /* incomplete frame data */
+        size_t    b_len;
+        size_t    b_size;
+        char    **s_tbl;  /* symbol index -> interned string */
+        size_t   *s_len;
+        uint32_t  s_cnt;
+};
+
+OSCAP_HIDDEN_END;
+
+#endif /* _SEXP_BINARY_H */
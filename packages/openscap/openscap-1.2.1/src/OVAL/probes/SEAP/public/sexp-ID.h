@@ -33,4 +33,10 @@ typedef uint64_t SEXP_ID_t;
 SEXP_ID_t SEXP_ID_v(const SEXP_t *s);
 SEXP_ID_t SEXP_ID_v2(const SEXP_t *s);
 
+/**
+ * Compute a cheaper S-exp value hash. Equal values have equal
+ * hashes, but collisions are more likely than with SEXP_ID_v.
+ */
+SEXP_ID_t SEXP_ID_fast(const SEXP_t *s);
+
 #endif /* SEXP_ID_H */
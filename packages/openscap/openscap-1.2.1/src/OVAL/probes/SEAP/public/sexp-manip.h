@@ -297,7 +297,7 @@ char  *SEXP_string_cstrp (const SEXP_t *s_exp);
  * Get a C substring from a sexp object.
  * @param s_sexp the queried sexp object
  * @param beg the position of the fisrt character of the substring
- * @param len the length of the substring
+ * @param len the length of the substring, 0 for the rest of the string
  */
 char *SEXP_string_subcstr (const SEXP_t *s_exp, size_t beg, size_t len);
 
@@ -381,6 +381,16 @@ SEXP_t *SEXP_list_nth (const SEXP_t *list, uint32_t n);
  */
 SEXP_t *SEXP_list_add (SEXP_t *list, const SEXP_t *s_exp);
 
+/**
+ * Add `count' elements to a list. Faster than adding them one by one
+ * with SEXP_list_add.
+ * This function increments elements' reference count.
+ * @param list the modified sexp object
+ * @param s_exp the elements to be added
+ * @param count number of the elements
+ */
+SEXP_t *SEXP_list_add_array (SEXP_t *list, SEXP_t *s_exp[], size_t count);
+
 /**
  * Create a new list containing the concatenated contents of two lists.
  * This function increments element's reference count.
@@ -39,6 +39,18 @@ size_t SEXP_fprintfa (FILE *fp, const SEXP_t *s_exp);
 
 int SEXP_sbprintf_t (SEXP_t *s_exp, strbuf_t *sb);
 
+/*
+ * Binary transport format. The output state holds the table of
+ * strings interned by previous calls and has to be kept for the
+ * whole lifetime of the stream.
+ */
+typedef struct SEXP_bostate SEXP_bostate_t;
+
+SEXP_bostate_t *SEXP_bostate_new (void);
+void            SEXP_bostate_free (SEXP_bostate_t *ostate);
+
+int SEXP_sbprintf_b (SEXP_t *s_exp, strbuf_t *sb, SEXP_bostate_t *ostate);
+
 #ifdef __cplusplus
 }
 #endif
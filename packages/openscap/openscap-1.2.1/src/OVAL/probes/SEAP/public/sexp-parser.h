@@ -55,6 +55,20 @@ SEXP_t *SEXP_parse (const SEXP_psetup_t *psetup, char *buffer, size_t buflen, SE
 
 bool SEXP_pstate_errorp(SEXP_pstate_t *pstate);
 
+/*
+ * Binary transport format (see SEXP_sbprintf_b). Frames start with
+ * SEXP_BFRAME_MAGIC which never starts a textual S-exp.
+ */
+#define SEXP_BFRAME_MAGIC 0xb5
+
+typedef struct SEXP_bpstate SEXP_bpstate_t;
+
+SEXP_bpstate_t *SEXP_bpstate_new (void);
+void            SEXP_bpstate_free (SEXP_bpstate_t *pstate);
+bool            SEXP_bpstate_pending (const SEXP_bpstate_t *pstate);
+
+SEXP_t *SEXP_parse_b (SEXP_bpstate_t *pstate, const char *buffer, size_t buflen);
+
 #ifdef __cplusplus
 }
 #endif
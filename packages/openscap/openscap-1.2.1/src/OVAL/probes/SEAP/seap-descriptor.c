@@ -70,6 +70,9 @@ int SEAP_desc_add (SEAP_desctable_t *sd_table, SEXP_pstate_t *pstate,
                 sd_dsc->scheme  = scheme;
                 sd_dsc->scheme_data = scheme_data;
                 sd_dsc->ostate  = NULL;
+                sd_dsc->ofmt    = SEXP_FMT_CANONICAL;
+                sd_dsc->bostate = NULL;
+                sd_dsc->bpstate = NULL;
                 sd_dsc->next_cid = 0;
                 sd_dsc->cmd_c_table = SEAP_cmdtbl_new ();
                 sd_dsc->cmd_w_table = SEAP_cmdtbl_new ();
@@ -131,6 +134,8 @@ void SEAP_desc_free(SEAP_desc_t *dsc)
         SEAP_cmdtbl_free(dsc->cmd_c_table);
         SEAP_cmdtbl_free(dsc->cmd_w_table);
 	SEAP_packetq_free(&dsc->pck_queue);
+        SEXP_bostate_free(dsc->bostate);
+        SEXP_bpstate_free(dsc->bpstate);
         pthread_mutex_destroy(&(dsc->r_lock));
         pthread_mutex_destroy(&(dsc->w_lock));
 	rbt_i32_free_cb(dsc->err_queue, __SEAP_desc_errqueue_free_cb);
@@ -168,6 +173,22 @@ SEAP_desc_t *SEAP_desc_get (SEAP_desctable_t *sd_table, int sd)
         return(dsc);
 }
 
+/*
+ * Writes the S-exp in the output format negotiated for the descriptor.
+ * Must be called with the write lock held.
+ */
+int SEAP_desc_sbprintf (SEAP_desc_t *dsc, SEXP_t *sexp, strbuf_t *sb)
+{
+        if (dsc->ofmt == SEXP_FMT_BINARY) {
+                if (dsc->bostate == NULL)
+                        dsc->bostate = SEXP_bostate_new ();
+
+                return SEXP_sbprintf_b (sexp, sb, dsc->bostate);
+        }
+
+        return SEXP_sbprintf_t (sexp, sb);
+}
+
 SEAP_msgid_t SEAP_desc_genmsgid (SEAP_desctable_t *sd_table, int sd)
 {
         SEAP_desc_t *dsc;
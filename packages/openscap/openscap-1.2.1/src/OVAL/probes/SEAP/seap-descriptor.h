@@ -49,6 +49,9 @@ typedef struct {
         SEAP_msgid_t   next_id;
         SEXP_ostate_t *ostate; /* Output state */
         SEXP_pstate_t *pstate; /* Parser state */
+        SEXP_format_t   ofmt;    /* Output format (SEXP_FMT_CANONICAL or SEXP_FMT_BINARY) */
+        SEXP_bostate_t *bostate; /* Binary output state */
+        SEXP_bpstate_t *bpstate; /* Binary parser state */
         SEAP_scheme_t  scheme; /* Protocol/Scheme used for this descriptor */
         void          *scheme_data; /* Protocol/Scheme related data */
 
@@ -132,6 +135,8 @@ static inline int SEAP_desc_unlock (pthread_mutex_t *m)
 #define DESC_WLOCK(d)    SEAP_desc_lock (&((d)->w_lock))
 #define DESC_WUNLOCK(d)  SEAP_desc_unlock (&((d)->w_lock))
 
+int SEAP_desc_sbprintf (SEAP_desc_t *dsc, SEXP_t *sexp, strbuf_t *sb);
+
 SEAP_msgid_t SEAP_desc_genmsgid (SEAP_desctable_t *sd_table, int sd);
 SEAP_cmdid_t SEAP_desc_gencmdid (SEAP_desctable_t *sd_table, int sd);
 
@@ -217,7 +217,7 @@ static int SEAP_packet_sexp2msg (SEXP_t *sexp_msg, SEAP_msg_t *seap_msg)
         return (0);
 }
 
-static SEXP_t *SEAP_packet_msg2sexp (SEAP_msg_t *msg)
+static SEXP_t *SEAP_packet_msg2sexp (SEAP_msg_t *msg, bool advertise)
 {
         SEXP_t *sexp;
         uint16_t i;
@@ -250,6 +250,12 @@ static SEXP_t *SEAP_packet_msg2sexp (SEAP_msg_t *msg)
                 SEXP_free (r0);
         }
 
+        /* Tell the peer we understand binary frames */
+        if (advertise) {
+                SEXP_list_add (sexp, r0 = SEXP_string_new (SEAP_ATTR_BINARY, strlen (SEAP_ATTR_BINARY)));
+                SEXP_free (r0);
+        }
+
         /* Add data */
         if (msg->sexp != NULL)
                 SEXP_list_add (sexp, msg->sexp);
@@ -568,13 +574,111 @@ static SEXP_t *SEAP_packet_err2sexp (SEAP_err_t *err)
         return (sexp);
 }
 
-static SEXP_t *SEAP_packet2sexp (SEAP_packet_t *packet)
+/*
+ * Switch the output of the descriptor to the binary format. The receiving
+ * side must not wait for the write lock: a sender holding it may be blocked
+ * on a full channel until this side reads more data. The switch is retried
+ * on the next frame if the lock is busy.
+ */
+static void SEAP_packet_binary_switch (SEAP_CTX_t *ctx, SEAP_desc_t *dsc)
+{
+        if (ctx->fmt_out != SEXP_FMT_BINARY)
+                return;
+
+        if (DESC_TRYWLOCK (dsc) == 1) {
+                dsc->ofmt = SEXP_FMT_BINARY;
+                DESC_WUNLOCK(dsc);
+        }
+}
+
+/*
+ * Position of the textual stream. The peer switches its output to binary
+ * frames between two messages, so a chunk read from the descriptor may hold
+ * the tail of a textual message followed by binary frames. The only place
+ * where SEXP_BFRAME_MAGIC can start a binary frame is outside of any list,
+ * string or raw (length prefixed) data or datatype name.
+ */
+typedef struct {
+        uint32_t depth;  /* list nesting level */
+        size_t   rawlen; /* octets of raw data still to be skipped */
+        size_t   number; /* value of the digits read so far */
+        bool     digits; /* the previous octet was a digit */
+        bool     dquote; /* inside of a double quoted string */
+        bool     escape; /* the previous octet was an escape character */
+} SEAP_tscan_t;
+
+/*
+ * Scans the chunk and returns the number of octets of textual data at
+ * its beginning. The rest of the chunk, if any, are binary frames.
+ */
+static size_t SEAP_packet_textlen (SEAP_tscan_t *ts, const uint8_t *buf, size_t len)
+{
+        size_t i;
+
+        for (i = 0; i < len; ++i) {
+                uint8_t c = buf[i];
+
+                if (ts->rawlen > 0) {
+                        size_t skip = ts->rawlen < len - i ? ts->rawlen : len - i;
+
+                        ts->rawlen -= skip;
+                        i += skip - 1;
+                        continue;
+                }
+
+                if (ts->dquote) {
+                        if (ts->escape)
+                                ts->escape = false;
+                        else if (c == '\\')
+                                ts->escape = true;
+                        else if (c == '"')
+                                ts->dquote = false;
+                        continue;
+                }
+
+                if (c >= '0' && c <= '9') {
+                        ts->number = (ts->digits ? ts->number * 10 : 0) + (c - '0');
+                        ts->digits = true;
+                        continue;
+                }
+
+                if (ts->digits) {
+                        ts->digits = false;
+
+                        if (c == ':' || c == '[') {
+                                ts->rawlen = ts->number;
+                                continue;
+                        }
+                }
+
+                switch (c) {
+                case '(':
+                        ++ts->depth;
+                        break;
+                case ')':
+                        if (ts->depth > 0)
+                                --ts->depth;
+                        break;
+                case '"':
+                        ts->dquote = true;
+                        break;
+                case SEXP_BFRAME_MAGIC:
+                        if (ts->depth == 0)
+                                return (i);
+                        break;
+                }
+        }
+
+        return (len);
+}
+
+static SEXP_t *SEAP_packet2sexp (SEAP_packet_t *packet, bool advertise)
 {
         SEXP_t *sexp = NULL;
 
         switch (packet->type) {
         case SEAP_PACKET_MSG:
-                sexp = SEAP_packet_msg2sexp (SEAP_packet_msg (packet));
+                sexp = SEAP_packet_msg2sexp (SEAP_packet_msg (packet), advertise);
                 break;
         case SEAP_PACKET_CMD:
                 sexp = SEAP_packet_cmd2sexp (SEAP_packet_cmd (packet));
@@ -606,6 +710,11 @@ int SEAP_packet_recv (SEAP_CTX_t *ctx, int sd, SEAP_packet_t **packet)
         char       *psym_cstr;
 
 	SEAP_packet_t *_packet;
+        bool           peer_binary = false;
+
+        SEAP_tscan_t tscan;
+        void        *bin_buffer;
+        size_t       bin_length;
 
         dsc = SEAP_desc_get (ctx->sd_table, sd);
 
@@ -673,6 +782,7 @@ eloop_exit:
 
         pstate = NULL;
         psetup = SEXP_psetup_new ();
+        memset (&tscan, 0, sizeof tscan);
 
         /*
          * All buffer passed to SEXP_parse will be freed by
@@ -718,11 +828,93 @@ eloop_exit:
 			data_buflen = data_length;
 		}
 
+                if (pstate == NULL &&
+                    (SEXP_bpstate_pending (dsc->bpstate) ||
+                     ((uint8_t *)data_buffer)[0] == SEXP_BFRAME_MAGIC))
+                {
+                        /*
+                         * Binary frames. Incomplete frames are kept in the
+                         * descriptor's parser state until the rest arrives.
+                         */
+                        if (dsc->bpstate == NULL)
+                                dsc->bpstate = SEXP_bpstate_new ();
+
+                        sexp_buffer = SEXP_parse_b (dsc->bpstate, data_buffer, data_length);
+                        sm_free (data_buffer);
+
+                        if (sexp_buffer == NULL) {
+                                dI("FAIL: binary S-exp frame decoding error\n");
+
+                                SEXP_psetup_free (psetup);
+                                DESC_RUNLOCK(dsc);
+
+                                errno = EILSEQ;
+                                return (-1);
+                        }
+
+                        /*
+                         * The peer talks binary, use it for replies too
+                         * (if not disabled on this side).
+                         */
+                        peer_binary = true;
+
+                        if (SEXP_list_length (sexp_buffer) > 0) {
+                                DESC_RUNLOCK(dsc);
+                                break;
+                        }
+
+                        SEXP_free (sexp_buffer);
+                        sexp_buffer = NULL;
+
+                        goto recv_wait;
+                }
+
+                /*
+                 * The peer may have switched to binary frames right after
+                 * a textual message in this chunk. Each part is decoded by
+                 * its own parser.
+                 */
+                bin_buffer = NULL;
+                bin_length = data_length - SEAP_packet_textlen (&tscan, data_buffer, data_length);
+
+                if (bin_length > 0 && bin_length < (size_t)data_length) {
+                        bin_buffer = sm_alloc (bin_length);
+                        memcpy (bin_buffer, (uint8_t *)data_buffer + data_length - bin_length, bin_length);
+                        data_length -= bin_length;
+                }
+
                 sexp_buffer = SEXP_parse (psetup, data_buffer, data_length, &pstate);
 
                 if (sexp_buffer != NULL) {
                         _A(pstate == NULL);
 
+                        if (bin_buffer != NULL) {
+                                SEXP_t *frames, *frame;
+
+                                if (dsc->bpstate == NULL)
+                                        dsc->bpstate = SEXP_bpstate_new ();
+
+                                frames = SEXP_parse_b (dsc->bpstate, bin_buffer, bin_length);
+                                sm_free (bin_buffer);
+
+                                if (frames == NULL) {
+                                        dI("FAIL: binary S-exp frame decoding error\n");
+
+                                        SEXP_free (sexp_buffer);
+                                        SEXP_psetup_free (psetup);
+                                        DESC_RUNLOCK(dsc);
+
+                                        errno = EILSEQ;
+                                        return (-1);
+                                }
+
+                                SEXP_list_foreach (frame, frames)
+                                        SEXP_list_add (sexp_buffer, frame);
+
+                                SEXP_free (frames);
+                                peer_binary = true;
+                        }
+
                         DESC_RUNLOCK(dsc);
 
                         if (SEXP_list_length (sexp_buffer) > 0) {
@@ -735,10 +927,13 @@ eloop_exit:
                                 goto eloop_start;
                         }
                 } else {
-			if (pstate == NULL || SEXP_pstate_errorp(pstate)) {
+			if (pstate == NULL || SEXP_pstate_errorp(pstate) || bin_buffer != NULL) {
 				dI("FAIL: S-exp parsing error, buffer: length: %ld, content:\n%*.s\n",
 				   data_length, data_length, data_buffer);
 
+				if (bin_buffer != NULL)
+					sm_free(bin_buffer);
+
 				SEXP_psetup_free(psetup);
 				SEXP_pstate_free(pstate);
 
@@ -748,6 +943,7 @@ eloop_exit:
 			}
 		}
 
+recv_wait:
                 if (SCH_SELECT(dsc->scheme, dsc, SEAP_IO_EVREAD, ctx->recv_timeout, 0) != 0) {
                         switch (errno) {
                         case ETIMEDOUT:
@@ -847,6 +1043,9 @@ eloop_exit:
 					errno = EINVAL;
 					return (-1);
 				}
+
+				if (SEAP_msgattr_exists (&(_packet->data.msg), SEAP_ATTR_BINARY))
+					peer_binary = true;
 				break;
 			}
 			goto invalid;
@@ -916,6 +1115,9 @@ eloop_exit:
 
         SEXP_free(sexp_buffer);
 
+        if (peer_binary)
+                SEAP_packet_binary_switch (ctx, dsc);
+
         return (0);
 }
 
@@ -957,6 +1159,7 @@ int SEAP_packet_send (SEAP_CTX_t *ctx, int sd, SEAP_packet_t *packet)
 {
         SEXP_t *packet_sexp;
         SEAP_desc_t *dsc;
+        bool advertise;
         int ret;
 
         ret = -1;
@@ -965,7 +1168,20 @@ int SEAP_packet_send (SEAP_CTX_t *ctx, int sd, SEAP_packet_t *packet)
         if (dsc == NULL)
                 return (-1);
 
-        packet_sexp = SEAP_packet2sexp (packet);
+        /*
+         * Keep advertising binary support until the peer switches this
+         * descriptor to binary output.
+         */
+        advertise = false;
+
+        if (ctx->fmt_out == SEXP_FMT_BINARY) {
+                if (DESC_WLOCK (dsc)) {
+                        advertise = dsc->ofmt != SEXP_FMT_BINARY;
+                        DESC_WUNLOCK(dsc);
+                }
+        }
+
+        packet_sexp = SEAP_packet2sexp (packet, advertise);
 
         if (packet_sexp == NULL) {
                 dI("Can't convert S-exp to packet\n");
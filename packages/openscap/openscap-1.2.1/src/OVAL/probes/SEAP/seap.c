@@ -51,7 +51,12 @@ static void SEAP_CTX_initdefault (SEAP_CTX_t *ctx)
         ctx->parser  = NULL /* PARSER(label) */;
         ctx->pflags  = SEXP_PFLAG_EOFOK;
         ctx->fmt_in  = SEXP_FMT_CANONICAL;
-        ctx->fmt_out = SEXP_FMT_CANONICAL;
+        /*
+         * Use the binary format unless disabled. The textual format
+         * is still understood on input and it's used for output until
+         * the peer advertises binary support too.
+         */
+        ctx->fmt_out = getenv ("SEAP_BINARY_DISABLE") != NULL ? SEXP_FMT_CANONICAL : SEXP_FMT_BINARY;
 
         /* Initialize descriptor table */
         ctx->sd_table    = SEAP_desctable_new();
@@ -134,6 +139,10 @@ int SEAP_connect (SEAP_CTX_t *ctx, const char *uri, uint32_t flags)
                 return (-1);
         }
 
+        /*
+         * Every connection starts in the textual format. Binary frames
+         * are used only after the peer advertises support for them.
+         */
         return (sd);
 }
 
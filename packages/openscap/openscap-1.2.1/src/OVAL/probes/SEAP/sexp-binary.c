@@ -0,0 +1,686 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "generic/common.h"
+#include "public/strbuf.h"
+#include "public/sm_alloc.h"
+#include "_sexp-types.h"
+#include "_sexp-value.h"
+#include "_sexp-datatype.h"
+#include "_sexp-rawptr.h"
+#include "_sexp-manip.h"
+#include "_sexp-binary.h"
+
+/*
+ * Output
+ */
+
+static void SEXP_bsym_free_cb (struct rbt_str_node *n)
+{
+        sm_free (n->key);
+}
+
+SEXP_bostate_t *SEXP_bostate_new (void)
+{
+        SEXP_bostate_t *ostate;
+
+        ostate = sm_talloc (SEXP_bostate_t);
+        ostate->s_tbl = rbt_str_new ();
+        ostate->s_cnt = 0;
+
+        return (ostate);
+}
+
+void SEXP_bostate_free (SEXP_bostate_t *ostate)
+{
+        if (ostate == NULL)
+                return;
+
+        rbt_str_free_cb (ostate->s_tbl, &SEXP_bsym_free_cb);
+        sm_free (ostate);
+}
+
+static size_t SEXP_bvarint (uint8_t *buf, uint64_t n)
+{
+        size_t l = 0;
+
+        while (n >= 0x80) {
+                buf[l++] = (uint8_t)(n | 0x80);
+                n >>= 7;
+        }
+
+        buf[l++] = (uint8_t)n;
+
+        return (l);
+}
+
+static int SEXP_bwrite_num (strbuf_t *sb, uint8_t tag, uint64_t n)
+{
+        uint8_t buf[1 + 10];
+
+        buf[0] = tag;
+
+        return strbuf_add (sb, (const char *)buf, 1 + SEXP_bvarint (buf + 1, n));
+}
+
+static int SEXP_bwrite_str (strbuf_t *sb, SEXP_bostate_t *ostate,
+                            const char *str, size_t len, bool intern)
+{
+        uintptr_t idx;
+        char      key[SEXP_BSYM_MAXLEN + 1];
+
+        if (intern && len > 0 && len <= SEXP_BSYM_MAXLEN &&
+            memchr (str, '\0', len) == NULL)
+        {
+                memcpy (key, str, len);
+                key[len] = '\0';
+
+                if (rbt_str_get (ostate->s_tbl, key, (void **)&idx) == 0)
+                        return SEXP_bwrite_num (sb, SEXP_BTAG_SYMREF, idx - 1);
+
+                if (ostate->s_cnt < SEXP_BSYM_MAXCNT) {
+                        char *k = sm_alloc (len + 1);
+
+                        memcpy (k, key, len + 1);
+
+                        if (rbt_str_add (ostate->s_tbl, k, (void *)(uintptr_t)(ostate->s_cnt + 1)) != 0) {
+                                sm_free (k);
+                                return (-1);
+                        }
+
+                        ++ostate->s_cnt;
+
+                        if (SEXP_bwrite_num (sb, SEXP_BTAG_SYMDEF, len) != 0)
+                                return (-1);
+
+                        return strbuf_add (sb, str, len);
+                }
+        }
+
+        if (SEXP_bwrite_num (sb, SEXP_BTAG_STR, len) != 0)
+                return (-1);
+
+        return (len > 0 ? strbuf_add (sb, str, len) : 0);
+}
+
+struct SEXP_bwrite_ctx {
+        strbuf_t       *sb;
+        SEXP_bostate_t *ostate;
+        uint32_t        pos;
+};
+
+static int SEXP_bwrite (SEXP_t *s_exp, struct SEXP_bwrite_ctx *ctx);
+
+static int SEXP_bwrite_lmemb (SEXP_t *s_exp, void *arg)
+{
+        struct SEXP_bwrite_ctx *ctx = (struct SEXP_bwrite_ctx *)arg;
+        int ret;
+
+        ret = SEXP_bwrite (s_exp, ctx);
+        ++ctx->pos;
+
+        return (ret);
+}
+
+static int SEXP_bwrite (SEXP_t *s_exp, struct SEXP_bwrite_ctx *ctx)
+{
+        SEXP_val_t v_dsc;
+        uint8_t    tag;
+
+        if (SEXP_rawptr_mask(s_exp->s_type, SEXP_DATATYPEPTR_MASK) != NULL) {
+                const char *name = SEXP_datatype_name(s_exp->s_type);
+
+                tag = SEXP_BTAG_DTYPE;
+
+                if (strbuf_add (ctx->sb, (const char *)&tag, 1) != 0)
+                        return (-1);
+                if (SEXP_bwrite_str (ctx->sb, ctx->ostate, name, strlen (name), true) != 0)
+                        return (-1);
+        }
+
+        SEXP_val_dsc (&v_dsc, s_exp->s_valp);
+
+        switch (v_dsc.type) {
+        case SEXP_VALTYPE_NUMBER:
+        {
+                int64_t i;
+
+                switch (SEXP_NTYPEP(v_dsc.hdr->size, v_dsc.mem)) {
+                case SEXP_NUM_BOOL:
+                        tag = SEXP_NCASTP(b, v_dsc.mem)->n ? SEXP_BTAG_TRUE : SEXP_BTAG_FALSE;
+                        return strbuf_add (ctx->sb, (const char *)&tag, 1);
+                case SEXP_NUM_UINT8:
+                        return SEXP_bwrite_num (ctx->sb, SEXP_BTAG_UINT, SEXP_NCASTP(u8, v_dsc.mem)->n);
+                case SEXP_NUM_UINT16:
+                        return SEXP_bwrite_num (ctx->sb, SEXP_BTAG_UINT, SEXP_NCASTP(u16, v_dsc.mem)->n);
+                case SEXP_NUM_UINT32:
+                        return SEXP_bwrite_num (ctx->sb, SEXP_BTAG_UINT, SEXP_NCASTP(u32, v_dsc.mem)->n);
+                case SEXP_NUM_UINT64:
+                        return SEXP_bwrite_num (ctx->sb, SEXP_BTAG_UINT, SEXP_NCASTP(u64, v_dsc.mem)->n);
+                case SEXP_NUM_INT8:
+                        i = SEXP_NCASTP(i8, v_dsc.mem)->n;
+                        break;
+                case SEXP_NUM_INT16:
+                        i = SEXP_NCASTP(i16, v_dsc.mem)->n;
+                        break;
+                case SEXP_NUM_INT32:
+                        i = SEXP_NCASTP(i32, v_dsc.mem)->n;
+                        break;
+                case SEXP_NUM_INT64:
+                        i = SEXP_NCASTP(i64, v_dsc.mem)->n;
+                        break;
+                case SEXP_NUM_DOUBLE:
+                {
+                        uint8_t buf[1 + sizeof (double)];
+                        char    str[64];
+                        double  f;
+
+                        /*
+                         * Keep the precision and the type the number would
+                         * have after a round trip through the textual format.
+                         * Probes depend on that (e.g. an integral double is
+                         * received as an integer).
+                         */
+                        snprintf (str, sizeof str, "%g", SEXP_NCASTP(f, v_dsc.mem)->n);
+
+                        if (strpbrk (str, ".eEnN") == NULL) {
+                                if (str[0] == '-') {
+                                        i = strtoll (str, NULL, 10);
+                                        break;
+                                }
+
+                                return SEXP_bwrite_num (ctx->sb, SEXP_BTAG_UINT, strtoull (str, NULL, 10));
+                        }
+
+                        f = strtod (str, NULL);
+                        buf[0] = SEXP_BTAG_DOUBLE;
+                        memcpy (buf + 1, &f, sizeof (double));
+
+                        return strbuf_add (ctx->sb, (const char *)buf, sizeof buf);
+                }
+                default:
+                        abort ();
+                }
+
+                /*
+                 * Signed numbers are sent the same way as in the
+                 * textual format, i.e. non-negative values are
+                 * received as unsigned ones.
+                 */
+                if (i >= 0)
+                        return SEXP_bwrite_num (ctx->sb, SEXP_BTAG_UINT, (uint64_t)i);
+                else
+                        return SEXP_bwrite_num (ctx->sb, SEXP_BTAG_NINT, ~(uint64_t)i);
+        }
+        case SEXP_VALTYPE_STRING:
+                /*
+                 * List heads are item/entity names and strings starting
+                 * with a colon are attribute names, all others are sent
+                 * as they are.
+                 */
+                return SEXP_bwrite_str (ctx->sb, ctx->ostate, (const char *)v_dsc.mem,
+                                        v_dsc.hdr->size / sizeof (char),
+                                        ctx->pos == 0 || (v_dsc.hdr->size > 0 && *(char *)v_dsc.mem == ':'));
+        case SEXP_VALTYPE_LIST:
+        {
+                struct SEXP_bwrite_ctx l_ctx;
+
+                tag = SEXP_BTAG_LIST;
+
+                if (strbuf_add (ctx->sb, (const char *)&tag, 1) != 0)
+                        return (-1);
+
+                l_ctx.sb     = ctx->sb;
+                l_ctx.ostate = ctx->ostate;
+                l_ctx.pos    = 0;
+
+                if (SEXP_rawval_lblk_cb ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, &SEXP_bwrite_lmemb, (void *)&l_ctx,
+                                         SEXP_LCASTP(v_dsc.mem)->offset + 1) != 0)
+                        return (-1);
+
+                tag = SEXP_BTAG_END;
+
+                return strbuf_add (ctx->sb, (const char *)&tag, 1);
+        }
+        default:
+                abort ();
+        }
+
+        return (0);
+}
+
+/*
+ * Overwrite `len' bytes at offset `off' of an already filled strbuf.
+ */
+static void SEXP_bpatch (strbuf_t *sb, size_t off, const uint8_t *data, size_t len)
+{
+        struct strblk *blk;
+
+        for (blk = sb->beg; blk != NULL && len > 0; blk = blk->next) {
+                if (off >= blk->size) {
+                        off -= blk->size;
+                        continue;
+                }
+
+                while (len > 0 && off < blk->size) {
+                        blk->data[off++] = (char)*data++;
+                        --len;
+                }
+
+                off = 0;
+        }
+}
+
+int SEXP_sbprintf_b (SEXP_t *s_exp, strbuf_t *sb, SEXP_bostate_t *ostate)
+{
+        struct SEXP_bwrite_ctx ctx;
+        uint8_t hdr[SEXP_BFRAME_HDRSZ];
+        size_t  beg, len;
+
+        if (s_exp == NULL || sb == NULL || ostate == NULL) {
+                errno = EFAULT;
+                return (-1);
+        }
+
+        beg = strbuf_length (sb);
+        memset (hdr, 0, sizeof hdr);
+
+        if (strbuf_add (sb, (const char *)hdr, sizeof hdr) != 0)
+                return (-1);
+
+        ctx.sb     = sb;
+        ctx.ostate = ostate;
+        ctx.pos    = 1;
+
+        if (SEXP_bwrite (s_exp, &ctx) != 0)
+                return (-1);
+
+        len = strbuf_length (sb) - beg - SEXP_BFRAME_HDRSZ;
+
+        if (len > UINT32_MAX) {
+                errno = EFBIG;
+                return (-1);
+        }
+
+        hdr[0] = SEXP_BFRAME_MAGIC;
+        hdr[1] = (uint8_t)(len >> 24);
+        hdr[2] = (uint8_t)(len >> 16);
+        hdr[3] = (uint8_t)(len >>  8);
+        hdr[4] = (uint8_t)(len);
+
+        SEXP_bpatch (sb, beg, hdr, sizeof hdr);
+
+        return (0);
+}
+
+/*
+ * Input
+ */
+
+SEXP_bpstate_t *SEXP_bpstate_new (void)
+{
+        SEXP_bpstate_t *pstate;
+
+        pstate = sm_talloc (SEXP_bpstate_t);
+        pstate->b_buf  = NULL;
+        pstate->b_len  = 0;
+        pstate->b_size = 0;
+        pstate->s_tbl  = NULL;
+        pstate->s_len  = NULL;
+        pstate->s_cnt  = 0;
+
+        return (pstate);
+}
+
+void SEXP_bpstate_free (SEXP_bpstate_t *pstate)
+{
+        uint32_t i;
+
+        if (pstate == NULL)
+                return;
+
+        for (i = 0; i < pstate->s_cnt; ++i)
+                sm_free (pstate->s_tbl[i]);
+
+        sm_free (pstate->s_tbl);
+        sm_free (pstate->s_len);
+        sm_free (pstate->b_buf);
+        sm_free (pstate);
+}
+
+bool SEXP_bpstate_pending (const SEXP_bpstate_t *pstate)
+{
+        return (pstate != NULL && pstate->b_len > 0);
+}
+
+static int SEXP_bread_varint (const uint8_t **p, const uint8_t *e, uint64_t *n)
+{
+        uint64_t v = 0;
+        unsigned s = 0;
+
+        while (*p < e) {
+                uint8_t b = *(*p)++;
+
+                if (s > 63)
+                        return (-1);
+
+                v |= (uint64_t)(b & 0x7f) << s;
+
+                if ((b & 0x80) == 0) {
+                        *n = v;
+                        return (0);
+                }
+
+                s += 7;
+        }
+
+        return (-1);
+}
+
+/*
+ * Reads a STR/SYMDEF/SYMREF node. The returned pointer references either
+ * the input buffer or the symbol table, interned strings are NUL terminated.
+ */
+static int SEXP_bread_str (SEXP_bpstate_t *pstate, uint8_t tag, const uint8_t **p, const uint8_t *e,
+                           const char **str, size_t *len)
+{
+        uint64_t n;
+
+        if (SEXP_bread_varint (p, e, &n) != 0)
+                return (-1);
+
+        switch (tag) {
+        case SEXP_BTAG_SYMREF:
+                if (n >= pstate->s_cnt)
+                        return (-1);
+
+                *str = pstate->s_tbl[n];
+                *len = pstate->s_len[n];
+
+                return (0);
+        case SEXP_BTAG_SYMDEF:
+                if (n == 0 || n > SEXP_BSYM_MAXLEN || pstate->s_cnt >= SEXP_BSYM_MAXCNT)
+                        return (-1);
+                /* FALLTHROUGH */
+        case SEXP_BTAG_STR:
+                if (n > (uint64_t)(e - *p))
+                        return (-1);
+
+                *str = (const char *)*p;
+                *len = (size_t)n;
+                *p  += n;
+
+                break;
+        default:
+                return (-1);
+        }
+
+        if (tag == SEXP_BTAG_SYMDEF) {
+                char *s;
+
+                if ((pstate->s_cnt & 63) == 0) {
+                        pstate->s_tbl = sm_realloc (pstate->s_tbl, sizeof (char *) * (pstate->s_cnt + 64));
+                        pstate->s_len = sm_realloc (pstate->s_len, sizeof (size_t) * (pstate->s_cnt + 64));
+                }
+
+                s = sm_alloc (*len + 1);
+                memcpy (s, *str, *len);
+                s[*len] = '\0';
+
+                pstate->s_tbl[pstate->s_cnt] = s;
+                pstate->s_len[pstate->s_cnt] = *len;
+                ++pstate->s_cnt;
+
+                *str = s;
+        }
+
+        return (0);
+}
+
+static SEXP_t *SEXP_bread (SEXP_bpstate_t *pstate, const uint8_t **p, const uint8_t *e, unsigned int depth)
+{
+        uint8_t  tag;
+        uint64_t n;
+
+        if (*p >= e || depth > SEXP_BPARSE_MAXDEPTH)
+                return (NULL);
+
+        tag = *(*p)++;
+
+        switch (tag) {
+        case SEXP_BTAG_LIST:
+        {
+                SEXP_t *list, *memb;
+
+                list = SEXP_list_new (NULL);
+
+                for (;;) {
+                        if (*p >= e) {
+                                SEXP_free (list);
+                                return (NULL);
+                        }
+
+                        if (**p == SEXP_BTAG_END) {
+                                ++(*p);
+                                break;
+                        }
+
+                        memb = SEXP_bread (pstate, p, e, depth + 1);
+
+                        if (memb == NULL) {
+                                SEXP_free (list);
+                                return (NULL);
+                        }
+
+                        SEXP_list_add (list, memb);
+                        SEXP_free (memb);
+                }
+
+                return (list);
+        }
+        case SEXP_BTAG_STR:
+        case SEXP_BTAG_SYMDEF:
+        case SEXP_BTAG_SYMREF:
+        {
+                const char *str;
+                size_t      len;
+
+                if (SEXP_bread_str (pstate, tag, p, e, &str, &len) != 0)
+                        return (NULL);
+
+                return SEXP_string_new (str, len);
+        }
+        case SEXP_BTAG_UINT:
+                if (SEXP_bread_varint (p, e, &n) != 0)
+                        return (NULL);
+
+                /* Use the same (smallest) number type as the textual parser */
+                if (n > UINT16_MAX)
+                        return (n > UINT32_MAX ? SEXP_number_newu_64 (n) : SEXP_number_newu_32 ((uint32_t)n));
+                else
+                        return (n > UINT8_MAX ? SEXP_number_newu_16 ((uint16_t)n) : SEXP_number_newu_8 ((uint8_t)n));
+        case SEXP_BTAG_NINT:
+        {
+                int64_t i;
+
+                if (SEXP_bread_varint (p, e, &n) != 0 || n > INT64_MAX)
+                        return (NULL);
+
+                i = (int64_t)~n;
+
+                if (i < INT16_MIN)
+                        return (i < INT32_MIN ? SEXP_number_newi_64 (i) : SEXP_number_newi_32 ((int32_t)i));
+                else
+                        return (i < INT8_MIN ? SEXP_number_newi_16 ((int16_t)i) : SEXP_number_newi_8 ((int8_t)i));
+        }
+        case SEXP_BTAG_DOUBLE:
+        {
+                double f;
+
+                if ((size_t)(e - *p) < sizeof (double))
+                        return (NULL);
+
+                memcpy (&f, *p, sizeof (double));
+                *p += sizeof (double);
+
+                return SEXP_number_newf (f);
+        }
+        case SEXP_BTAG_FALSE:
+                return SEXP_number_newb (false);
+        case SEXP_BTAG_TRUE:
+                return SEXP_number_newb (true);
+        case SEXP_BTAG_DTYPE:
+        {
+                SEXP_t     *s_exp;
+                const char *str;
+                char       *name;
+                size_t      len;
+
+                if (*p >= e)
+                        return (NULL);
+
+                tag = *(*p)++;
+
+                if (SEXP_bread_str (pstate, tag, p, e, &str, &len) != 0 || len == 0)
+                        return (NULL);
+
+                s_exp = SEXP_bread (pstate, p, e, depth + 1);
+
+                if (s_exp == NULL)
+                        return (NULL);
+
+                if (tag == SEXP_BTAG_STR) {
+                        name = sm_alloc (len + 1);
+                        memcpy (name, str, len);
+                        name[len] = '\0';
+                } else
+                        name = (char *)str;
+
+                if (SEXP_datatype_set (s_exp, name) != 0) {
+                        SEXP_free (s_exp);
+                        s_exp = NULL;
+                }
+
+                if (name != str)
+                        sm_free (name);
+
+                return (s_exp);
+        }
+        }
+
+        return (NULL);
+}
+
+SEXP_t *SEXP_parse_b (SEXP_bpstate_t *pstate, const char *buffer, size_t buflen)
+{
+        SEXP_t        *s_list, *s_exp;
+        const uint8_t *beg, *end;
+
+        if (pstate == NULL || (buffer == NULL && buflen > 0)) {
+                errno = EFAULT;
+                return (NULL);
+        }
+
+        /*
+         * Decode directly from the caller's buffer unless there's
+         * an incomplete frame left from the previous call.
+         */
+        if (pstate->b_len > 0) {
+                if (pstate->b_len + buflen > pstate->b_size) {
+                        pstate->b_size = pstate->b_len + buflen;
+                        pstate->b_buf  = sm_realloc (pstate->b_buf, pstate->b_size);
+                }
+
+                memcpy (pstate->b_buf + pstate->b_len, buffer, buflen);
+                pstate->b_len += buflen;
+
+                beg = pstate->b_buf;
+                end = pstate->b_buf + pstate->b_len;
+        } else {
+                beg = (const uint8_t *)buffer;
+                end = (const uint8_t *)buffer + buflen;
+        }
+
+        s_list = SEXP_list_new (NULL);
+
+        while ((size_t)(end - beg) >= SEXP_BFRAME_HDRSZ) {
+                const uint8_t *p, *e;
+                size_t len;
+
+                if (beg[0] != SEXP_BFRAME_MAGIC)
+                        goto fail;
+
+                len = ((size_t)beg[1] << 24) | ((size_t)beg[2] << 16) | ((size_t)beg[3] << 8) | (size_t)beg[4];
+
+                if ((size_t)(end - beg) - SEXP_BFRAME_HDRSZ < len)
+                        break;
+
+                p = beg + SEXP_BFRAME_HDRSZ;
+                e = p + len;
+
+                s_exp = SEXP_bread (pstate, &p, e, 0);
+
+                if (s_exp == NULL)
+                        goto fail;
+                if (p != e) {
+                        SEXP_free (s_exp);
+                        goto fail;
+                }
+
+                SEXP_list_add (s_list, s_exp);
+                SEXP_free (s_exp);
+
+                beg = e;
+        }
+
+        /*
+         * Keep the rest of the data for the next call
+         */
+        if (beg != end) {
+                size_t rest = (size_t)(end - beg);
+
+                if (pstate->b_len > 0)
+                        memmove (pstate->b_buf, beg, rest);
+                else {
+                        if (rest > pstate->b_size) {
+                                pstate->b_size = rest;
+                                pstate->b_buf  = sm_realloc (pstate->b_buf, pstate->b_size);
+                        }
+
+                        memcpy (pstate->b_buf, beg, rest);
+                }
+
+                pstate->b_len = rest;
+        } else
+                pstate->b_len = 0;
+
+        return (s_list);
+fail:
+        SEXP_free (s_list);
+        pstate->b_len = 0;
+        errno = EILSEQ;
+
+        return (NULL);
+}
@@ -842,11 +842,10 @@ char *SEXP_string_subcstr (const SEXP_t *s_exp, size_t beg, size_t len)
 
         s_len -= beg;
 
-        if (s_len > len)
+        if (len > 0 && s_len > len)
                 s_len = len;
 
         if (s_len > 0) {
-                s_len = v_dsc.hdr->size / sizeof (char);
                 s_str = sm_alloc (sizeof (char) * (s_len + 1));
 
                 memcpy (s_str, ((char *) v_dsc.mem) + beg, sizeof (char) * s_len);
@@ -1178,6 +1177,33 @@ SEXP_t *SEXP_listref_nth (SEXP_t *list, uint32_t n)
         return (s_exp == NULL ? NULL : SEXP_softref (s_exp));
 }
 
+/*
+ * Create a private copy of a shared list value and decrement the
+ * reference counter in the original value. If the other owners freed
+ * their references in the meantime, the original value is freed here.
+ */
+static int SEXP_list_unshare (SEXP_t *list, SEXP_val_t *v_dsc)
+{
+        uintptr_t uptr = SEXP_rawval_list_copy (list->s_valp);
+
+        if (uptr == (uintptr_t)NULL) {
+                errno = ENOMEM;
+                return (-1);
+        }
+
+        if (SEXP_rawval_decref (list->s_valp)) {
+                if (SEXP_LCASTP(v_dsc->mem)->b_addr != NULL)
+                        SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc->mem)->b_addr, SEXP_free_r);
+
+                sm_free (v_dsc->hdr);
+        }
+
+        list->s_valp = uptr;
+        SEXP_val_dsc (v_dsc, list->s_valp);
+
+        return (0);
+}
+
 SEXP_t *SEXP_list_add (SEXP_t *list, const SEXP_t *s_exp)
 {
         SEXP_val_t v_dsc;
@@ -1199,20 +1225,10 @@ SEXP_t *SEXP_list_add (SEXP_t *list, const SEXP_t *s_exp)
         }
 
         if (v_dsc.hdr->refs > 1) {
-                /*
-                 * Create a private copy of the value and
-                 * decrement the reference counter in the
-                 * original value.
-                 */
-                uintptr_t uptr = SEXP_rawval_list_copy (list->s_valp);
+                uintptr_t uptr;
 
-                if (SEXP_rawval_decref (list->s_valp)) {
-                        /* TODO: handle this */
-                        abort ();
-                }
-
-                list->s_valp = uptr;
-                SEXP_val_dsc (&v_dsc, list->s_valp);
+                if (SEXP_list_unshare (list, &v_dsc) != 0)
+                        return (NULL);
 
                 uptr = SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr);
                 SEXP_rawval_lblk_add1 (uptr, s_exp);
@@ -1230,6 +1246,52 @@ SEXP_t *SEXP_list_add (SEXP_t *list, const SEXP_t *s_exp)
         return (list);
 }
 
+SEXP_t *SEXP_list_add_array (SEXP_t *list, SEXP_t *s_exp[], size_t count)
+{
+        SEXP_val_t v_dsc;
+        uintptr_t  last;
+        size_t     i;
+
+        if (list == NULL || (s_exp == NULL && count > 0)) {
+                errno = EFAULT;
+                return (NULL);
+        }
+
+        _A(list->s_valp != 0);
+        SEXP_VALIDATE(list);
+
+        SEXP_val_dsc (&v_dsc, list->s_valp);
+
+        if (v_dsc.type != SEXP_VALTYPE_LIST) {
+                errno = EINVAL;
+                return (NULL);
+        }
+
+        if (count == 0)
+                return (list);
+
+        if (v_dsc.hdr->refs > 1) {
+                if (SEXP_list_unshare (list, &v_dsc) != 0)
+                        return (NULL);
+        }
+
+        /*
+         * The first element may need a copy of the shared blocks,
+         * the others are appended to the last block directly.
+         */
+        SEXP_VALIDATE(s_exp[0]);
+        SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)SEXP_rawval_lblk_add ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, s_exp[0]);
+        last = SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr);
+
+        for (i = 1; i < count; ++i) {
+                SEXP_VALIDATE(s_exp[i]);
+                SEXP_rawval_lblk_add1 (last, s_exp[i]);
+                last = SEXP_rawval_lblk_last (last);
+        }
+
+        return (list);
+}
+
 SEXP_t *SEXP_list_join (const SEXP_t *list_a, const SEXP_t *list_b)
 {
         SEXP_t *list_j, *memb;
@@ -1293,12 +1355,16 @@ SEXP_t *SEXP_list_pop (SEXP_t *list)
         lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc.mem)->b_addr);
 
         if (lblk != NULL) {
+                /*
+                 * Release the block only after its last member was
+                 * popped, the others are still reachable via offset.
+                 */
                 if (++SEXP_LCASTP(v_dsc.mem)->offset == lblk->real) {
                         SEXP_LCASTP(v_dsc.mem)->offset = 0;
                         SEXP_LCASTP(v_dsc.mem)->b_addr = SEXP_VALP_LBLK(lblk->nxsz);
-                }
 
-                SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb);
+                        SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb);
+                }
         }
 
 #if !defined(NDEBUG)
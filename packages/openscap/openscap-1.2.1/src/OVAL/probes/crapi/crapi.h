@@ -25,6 +25,15 @@
 
 #define CRAPI_IO_BUFSZ 4096
 
+/*
+ * Size of the blocks passed to the digest functions by
+ * crapi_mdigest_fd(). Each block is hashed by all the requested
+ * algorithms while it is still in the CPU cache.
+ */
+#ifndef CRAPI_MDIGEST_BUFSZ
+#define CRAPI_MDIGEST_BUFSZ (128 * 1024)
+#endif
+
 #ifndef _FILE_OFFSET_BITS
 # define _FILE_OFFSET_BITS 32
 #endif
@@ -27,7 +27,9 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <assume.h>
 #include <errno.h>
 
@@ -64,18 +66,79 @@ int crapi_digest_fd (int fd, crapi_alg_t alg, void *dst, size_t *size)
         return (-1);
 }
 
-int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t *size, ...*/)
+static int crapi_digest_ctbl (crapi_alg_t alg, struct digest_ctbl_t *ctbl)
+{
+        switch (alg) {
+        case CRAPI_DIGEST_MD5:
+                ctbl->init   = &crapi_md5_init;
+                ctbl->update = &crapi_md5_update;
+                ctbl->fini   = &crapi_md5_fini;
+                ctbl->free   = &crapi_md5_free;
+                break;
+        case CRAPI_DIGEST_SHA1:
+                ctbl->init   = &crapi_sha1_init;
+                ctbl->update = &crapi_sha1_update;
+                ctbl->fini   = &crapi_sha1_fini;
+                ctbl->free   = &crapi_sha1_free;
+                break;
+        case CRAPI_DIGEST_SHA224:
+                ctbl->init   = &crapi_sha224_init;
+                ctbl->update = &crapi_sha224_update;
+                ctbl->fini   = &crapi_sha224_fini;
+                ctbl->free   = &crapi_sha224_free;
+                break;
+        case CRAPI_DIGEST_SHA256:
+                ctbl->init   = &crapi_sha256_init;
+                ctbl->update = &crapi_sha256_update;
+                ctbl->fini   = &crapi_sha256_fini;
+                ctbl->free   = &crapi_sha256_free;
+                break;
+        case CRAPI_DIGEST_SHA384:
+                ctbl->init   = &crapi_sha384_init;
+                ctbl->update = &crapi_sha384_update;
+                ctbl->fini   = &crapi_sha384_fini;
+                ctbl->free   = &crapi_sha384_free;
+                break;
+        case CRAPI_DIGEST_SHA512:
+                ctbl->init   = &crapi_sha512_init;
+                ctbl->update = &crapi_sha512_update;
+                ctbl->fini   = &crapi_sha512_fini;
+                ctbl->free   = &crapi_sha512_free;
+                break;
+        case CRAPI_DIGEST_RMD160:
+                ctbl->init   = &crapi_rmd160_init;
+                ctbl->update = &crapi_rmd160_update;
+                ctbl->fini   = &crapi_rmd160_fini;
+                ctbl->free   = &crapi_rmd160_free;
+                break;
+        default:
+                return (-1);
+        }
+
+        return (0);
+}
+
+static int crapi_mdigest_update (struct digest_ctbl_t *ctbl, int num, void *buf, size_t len)
 {
         register int i;
-        va_list ap;
-        struct digest_ctbl_t ctbl[num];
 
-        crapi_alg_t alg;
-        void       *dst;
-        size_t     *size;
+        for (i = 0; i < num; ++i) {
+                if (ctbl[i].ctx == NULL)
+                        continue;
+                if (ctbl[i].update (ctbl[i].ctx, buf, len) != 0)
+                        return (-1);
+        }
+
+        return (0);
+}
 
-        uint8_t fd_buf[CRAPI_IO_BUFSZ];
-        ssize_t ret;
+int crapi_mdigest_fdv (int fd, int num, const crapi_alg_t alg[], void *dst[], size_t *size[])
+{
+        register int i;
+        struct digest_ctbl_t ctbl[num];
+
+        uint8_t *buf = NULL;
+        ssize_t  ret;
 
         assume_r (num > 0, -1, errno = EINVAL;);
         assume_r (fd  > 0, -1, errno = EINVAL;);
@@ -83,95 +146,45 @@ int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t
         for (i = 0; i < num; ++i)
                 ctbl[i].ctx = NULL;
 
-        va_start (ap, num);
-
         for (i = 0; i < num; ++i) {
-                alg  = va_arg (ap, crapi_alg_t);
-                dst  = va_arg (ap, void *);
-                size = va_arg (ap, size_t *);
-
-                switch (alg) {
-                case CRAPI_DIGEST_MD5:
-                        ctbl[i].init   = &crapi_md5_init;
-                        ctbl[i].update = &crapi_md5_update;
-                        ctbl[i].fini   = &crapi_md5_fini;
-                        ctbl[i].free   = &crapi_md5_free;
-                        break;
-                case CRAPI_DIGEST_SHA1:
-                        ctbl[i].init   = &crapi_sha1_init;
-                        ctbl[i].update = &crapi_sha1_update;
-                        ctbl[i].fini   = &crapi_sha1_fini;
-                        ctbl[i].free   = &crapi_sha1_free;
-                        break;
-                case CRAPI_DIGEST_SHA224:
-                        ctbl[i].init   = &crapi_sha224_init;
-                        ctbl[i].update = &crapi_sha224_update;
-                        ctbl[i].fini   = &crapi_sha224_fini;
-                        ctbl[i].free   = &crapi_sha224_free;
-                        break;
-                case CRAPI_DIGEST_SHA256:
-                        ctbl[i].init   = &crapi_sha256_init;
-                        ctbl[i].update = &crapi_sha256_update;
-                        ctbl[i].fini   = &crapi_sha256_fini;
-                        ctbl[i].free   = &crapi_sha256_free;
-                        break;
-                case CRAPI_DIGEST_SHA384:
-                        ctbl[i].init   = &crapi_sha384_init;
-                        ctbl[i].update = &crapi_sha384_update;
-                        ctbl[i].fini   = &crapi_sha384_fini;
-                        ctbl[i].free   = &crapi_sha384_free;
-                        break;
-                case CRAPI_DIGEST_SHA512:
-                        ctbl[i].init   = &crapi_sha512_init;
-                        ctbl[i].update = &crapi_sha512_update;
-                        ctbl[i].fini   = &crapi_sha512_fini;
-                        ctbl[i].free   = &crapi_sha512_free;
-                        break;
-                case CRAPI_DIGEST_RMD160:
-                        ctbl[i].init   = &crapi_rmd160_init;
-                        ctbl[i].update = &crapi_rmd160_update;
-                        ctbl[i].fini   = &crapi_rmd160_fini;
-                        ctbl[i].free   = &crapi_rmd160_free;
-                        break;
-                default:
-                        va_end (ap);
+                if (crapi_digest_ctbl (alg[i], ctbl + i) != 0) {
+                        errno = EINVAL;
                         goto fail;
                 }
 
-                if ((ctbl[i].ctx = ctbl[i].init (dst, size)) == NULL)
-			*size = 0;
+                if ((ctbl[i].ctx = ctbl[i].init (dst[i], size[i])) == NULL)
+                        *size[i] = 0;
         }
 
-        va_end (ap);
+        /*
+         * The file is read rather than mapped: a mapping of a file that
+         * gets truncated meanwhile would kill the probe with SIGBUS. Every
+         * algorithm hashes a block while it's in the CPU cache.
+         */
+        (void)posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 
-        while ((ret = read (fd, fd_buf, sizeof fd_buf)) == sizeof fd_buf) {
-#pragma omp parallel for
-                for (i = 0; i < num; ++i) {
-			if (ctbl[i].ctx == NULL)
-				continue;
-                        if (ctbl[i].update (ctbl[i].ctx, fd_buf, sizeof fd_buf) != 0) {
-                                goto fail;
-                        }
-                }
+        if (posix_memalign ((void **)&buf, 64, CRAPI_MDIGEST_BUFSZ) != 0) {
+                buf = NULL;
+                errno = ENOMEM;
+                goto fail;
         }
 
-        switch (ret) {
-        case 0:
-                break;
-        case -1:
-                goto fail;
-        default:
-                assume_r (ret > 0, -1, goto fail;);
-
-                for (i = 0; i < num; ++i) {
-			if (ctbl[i].ctx == NULL)
-				continue;
-                        if (ctbl[i].update (ctbl[i].ctx, fd_buf, (size_t)ret) != 0) {
-                                goto fail;
-                        }
+        for (;;) {
+                ret = read (fd, buf, CRAPI_MDIGEST_BUFSZ);
+
+                if (ret == 0)
+                        break;
+                if (ret < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        goto fail;
                 }
+                if (crapi_mdigest_update (ctbl, num, buf, (size_t)ret) != 0)
+                        goto fail;
         }
 
+        free (buf);
+
         for (i = 0; i < num; ++i) {
 		if (ctbl[i].ctx == NULL)
 			continue;
@@ -180,9 +193,35 @@ int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t
 
         return (0);
 fail:
+        free (buf);
+
         for (i = 0; i < num; ++i)
                 if (ctbl[i].ctx != NULL)
                         ctbl[i].free (ctbl[i].ctx);
 
         return (-1);
 }
+
+int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t *size, ...*/)
+{
+        register int i;
+        va_list ap;
+
+        crapi_alg_t alg[num > 0 ? num : 1];
+        void       *dst[num > 0 ? num : 1];
+        size_t     *size[num > 0 ? num : 1];
+
+        assume_r (num > 0, -1, errno = EINVAL;);
+
+        va_start (ap, num);
+
+        for (i = 0; i < num; ++i) {
+                alg[i]  = va_arg (ap, crapi_alg_t);
+                dst[i]  = va_arg (ap, void *);
+                size[i] = va_arg (ap, size_t *);
+        }
+
+        va_end (ap);
+
+        return crapi_mdigest_fdv (fd, num, alg, dst, size);
+}
@@ -55,4 +55,11 @@ struct digest_ctbl_t {
 
 int crapi_mdigest_fd (int fd, int num, ... /*crapi_alg_t alg, void *dst, size_t *size, ...*/);
 
+/**
+ * Compute `num' digests of the content of `fd' in one pass. The file
+ * is read in blocks of CRAPI_MDIGEST_BUFSZ bytes. The size of a digest
+ * which can't be computed is set to 0.
+ */
+int crapi_mdigest_fdv (int fd, int num, const crapi_alg_t alg[], void *dst[], size_t *size[]);
+
 #endif /* CRAPI_DIGEST_H */
@@ -103,14 +103,14 @@ static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
 	return (0);
 }
 
-static int filehash58_cb (const char *p, const char *f, const char *h, probe_ctx *ctx)
+static int filehash58_cb (const char *p, const char *f, int algc, const crapi_alg_t algv[], const char *names[], probe_ctx *ctx)
 {
 	SEXP_t *itm;
 
 	char   pbuf[PATH_MAX+1];
 	size_t plen, flen;
 
-	int fd;
+	int fd, i;
 
 	if (f == NULL)
 		return (0);
@@ -140,61 +140,68 @@ static int filehash58_cb (const char *p, const char *f, const char *h, probe_ctx
 	fd = open (pbuf, O_RDONLY);
 
 	if (fd < 0) {
-		strerror_r (errno, pbuf, PATH_MAX);
-		pbuf[PATH_MAX] = '\0';
-
-		itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					NULL);
-		probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-			"Can't open \"%s\": errno=%d, %s.", pbuf, errno, strerror (errno));
-		probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+		int err = errno;
+
+		for (i = 0; i < algc; ++i) {
+			itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
+						"filepath", OVAL_DATATYPE_STRING, pbuf,
+						"path",     OVAL_DATATYPE_STRING, p,
+						"filename", OVAL_DATATYPE_STRING, f,
+						"hash_type",OVAL_DATATYPE_STRING, names[i],
+						NULL);
+			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+				"Can't open \"%s\": errno=%d, %s.", pbuf, err, strerror (err));
+			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			probe_item_collect(ctx, itm);
+		}
 	} else {
-		uint8_t hash_dst[1025];
-		size_t  hash_dstlen = sizeof hash_dst;
-		char    hash_str[2051];
-
-		crapi_alg_t hash_type;
-
-		hash_type = oscap_string_to_enum(CRAPI_ALG_MAP, h);
-		hash_dstlen = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, h);
+		uint8_t hash_dst[algc][64];
+		size_t  hash_dstlen[algc];
+		void   *dstv[algc];
+		size_t *sizev[algc];
+		char    hash_str[129];
+
+		for (i = 0; i < algc; ++i) {
+			hash_dstlen[i] = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, names[i]);
+			dstv[i]  = hash_dst[i];
+			sizev[i] = &hash_dstlen[i];
+		}
 
 		/*
-		 * Compute hash value
+		 * Compute all the hash values in one pass over the file
 		 */
-		if (crapi_mdigest_fd (fd, 1, hash_type, hash_dst, &hash_dstlen) != 0) {
+		if (crapi_mdigest_fdv (fd, algc, algv, dstv, sizev) != 0) {
 			close (fd);
 			return (-1);
 		}
 
 		close (fd);
 
-		hash_str[0] = '\0';
-		mem2hex (hash_dst, hash_dstlen, hash_str, sizeof hash_str);
+		for (i = 0; i < algc; ++i) {
+			hash_str[0] = '\0';
+			mem2hex (hash_dst[i], hash_dstlen[i], hash_str, sizeof hash_str);
+
+			/*
+			 * Create and add the item
+			 */
+			itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
+						"filepath", OVAL_DATATYPE_STRING, pbuf,
+						"path",     OVAL_DATATYPE_STRING, p,
+						"filename", OVAL_DATATYPE_STRING, f,
+						"hash_type",OVAL_DATATYPE_STRING, names[i],
+						"hash",     OVAL_DATATYPE_STRING, hash_str,
+						NULL);
+
+			if (hash_dstlen[i] == 0) {
+				probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+						   "Unable to compute %s hash value of \"%s\".", names[i], pbuf);
+				probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			}
 
-		/*
-		 * Create and add the item
-		 */
-		itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					"hash",     OVAL_DATATYPE_STRING, hash_str,
-					NULL);
-
-		if (hash_dstlen == 0) {
-			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-					   "Unable to compute %s hash value of \"%s\".", h, pbuf);
-			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			probe_item_collect(ctx, itm);
 		}
 	}
 
-	probe_item_collect(ctx, itm);
-
 	return (0);
 }
 
@@ -217,6 +224,7 @@ void *probe_init (void)
 	}
 
 	probe_setoption(PROBEOPT_OFFLINE_MODE_SUPPORTED, PROBE_OFFLINE_CHROOT);
+	probe_setoption(PROBEOPT_PERSISTENT_CACHE, PROBE_PCACHE_DEP_OBJPATH, NULL);
 
 	return (NULL);
 }
@@ -243,6 +251,11 @@ int probe_main(probe_ctx *ctx, void *mutex)
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
 
+	const struct oscap_string_map *p;
+	crapi_alg_t algv[CRAPI_DIGEST_CNT];
+	const char *names[CRAPI_DIGEST_CNT];
+	int algc = 0;
+
 	if (mutex == NULL) {
 		return (PROBE_EINIT);
 	}
@@ -281,19 +294,25 @@ int probe_main(probe_ctx *ctx, void *mutex)
 		goto cleanup;
 	}
 
-	if ((ofts = oval_fts_open(path, filename, filepath, behaviors)) != NULL) {
+	/*
+	 * Find the hash types to compare with the entity, think "not
+	 * satisfy". All of them are computed in one pass over a file.
+	 */
+	for (p = CRAPI_ALG_MAP; p->value != CRAPI_INVALID; ++p) {
+		SEXP_t *crapi_hash_type_sexp = SEXP_string_new(p->string, strlen(p->string));
+
+		if (probe_entobj_cmp(hash_type, crapi_hash_type_sexp) == OVAL_RESULT_TRUE) {
+			algv[algc]  = p->value;
+			names[algc] = p->string;
+			++algc;
+		}
+
+		SEXP_free(crapi_hash_type_sexp);
+	}
+
+	if (algc > 0 && (ofts = oval_fts_open(path, filename, filepath, behaviors)) != NULL) {
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-			/* find hash types to compare with entity, think "not satisfy" */
-			const struct oscap_string_map *p = CRAPI_ALG_MAP;
-			while (p->value != CRAPI_INVALID) {
-				SEXP_t *crapi_hash_type_sexp = SEXP_string_new(p->string, strlen(p->string));
-				if (probe_entobj_cmp(hash_type, crapi_hash_type_sexp) == OVAL_RESULT_TRUE) {
-					filehash58_cb(ofts_ent->path, ofts_ent->file, p->string, ctx);
-				}
-
-				SEXP_free(crapi_hash_type_sexp);
-				p++;
-			}
+			filehash58_cb(ofts_ent->path, ofts_ent->file, algc, algv, names, ctx);
 			oval_ftsent_free(ofts_ent);
 		}
 
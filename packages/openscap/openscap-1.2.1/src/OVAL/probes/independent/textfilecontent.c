@@ -330,6 +330,7 @@ static int process_file(const char *path, const char *filename, void *arg)
 void *probe_init(void)
 {
 	probe_setoption(PROBEOPT_OFFLINE_MODE_SUPPORTED, PROBE_OFFLINE_CHROOT);
+	probe_setoption(PROBEOPT_PERSISTENT_CACHE, PROBE_PCACHE_DEP_OBJPATH, NULL);
 	return NULL;
 }
 
@@ -36,6 +36,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
 #include <errno.h>
 #include <sys/stat.h>
@@ -64,7 +65,13 @@
 oval_version_t over;
 
 #if defined USE_REGEX_PCRE
-static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char ***substrings) {
+/*
+ * Matches starting at or beyond `limit' are ignored and `*ofs' is not
+ * updated in that case. A negative `*ofs' means that the previous match
+ * ended before the start of `str'; the search starts at `base'.
+ */
+static int get_substrings(char *str, int str_len, int base, int limit, int *ofs, pcre *re, pcre_extra *re_extra,
+			  int want_substrs, char ***substrings) {
 	int i, ret, rc;
 	int ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
 	char **substrs;
@@ -75,14 +82,14 @@ static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char
 		ovector[i] = -1;
 
 #if defined(__SVR4) && defined(__sun)
-	rc = pcre_exec(re, NULL, str, strlen(str), *ofs, PCRE_NO_UTF8_CHECK, ovector, ovector_len);
+	rc = pcre_exec(re, re_extra, str, str_len, *ofs < base ? base : *ofs, PCRE_NO_UTF8_CHECK, ovector, ovector_len);
 #else
-	rc = pcre_exec(re, NULL, str, strlen(str), *ofs, 0, ovector, ovector_len);
+	rc = pcre_exec(re, re_extra, str, str_len, *ofs < base ? base : *ofs, 0, ovector, ovector_len);
 #endif
 
 	if (rc < -1) {
 		return -1;
-	} else if (rc == -1) {
+	} else if (rc == -1 || ovector[0] >= limit) {
 		/* no match */
 		return 0;
 	}
@@ -121,7 +128,8 @@ static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char
 	return ret;
 }
 #elif defined USE_REGEX_POSIX
-static int get_substrings(char *str, int *ofs, regex_t *re, int want_substrs, char ***substrings) {
+static int get_substrings(char *str, int str_len, int base, int limit, int *ofs, regex_t *re, void *re_extra,
+			  int want_substrs, char ***substrings) {
 	int i, ret, rc;
 	regmatch_t pmatch[40];
 	int pmatch_len = sizeof (pmatch) / sizeof (pmatch[0]);
@@ -212,20 +220,278 @@ struct pfdata {
 	int re_opts;
 	SEXP_t *instance_ent;
         probe_ctx *ctx;
+	bool stream;
 #if defined USE_REGEX_PCRE
 	pcre *compiled_regex;
+	pcre_extra *regex_extra;
 #elif defined USE_REGEX_POSIX
 	regex_t *compiled_regex;
+	void *regex_extra;
 #endif
 };
 
+#ifndef TFC54_STREAM_BUFSIZE
+#define TFC54_STREAM_BUFSIZE (64 * 1024)
+#endif
+
+/*
+ * Can the pattern be matched line by line? That is the case when no
+ * part of it can match a newline character, so that the result for a
+ * line doesn't depend on the other lines. The check is conservative:
+ * constructs which might match a newline or change the meaning of the
+ * anchors make the whole file to be scanned at once.
+ */
+static bool pattern_is_singleline(const char *pattern, int re_opts)
+{
+#if defined USE_REGEX_PCRE
+	const char *p;
+	bool in_class = false;
+
+	if (!(re_opts & PCRE_MULTILINE) || (re_opts & PCRE_DOTALL))
+		return false;
+
+	if (strstr(pattern, "[^") != NULL || strstr(pattern, "[:^") != NULL ||
+	    strstr(pattern, "[:space:]") != NULL || strstr(pattern, "[:cntrl:]") != NULL ||
+	    strstr(pattern, "[:ascii:]") != NULL || strstr(pattern, "(*") != NULL)
+		return false;
+
+	for (p = pattern; *p != '\0'; ++p) {
+		if ((unsigned char)*p < 0x20 || *p == 0x7f)
+			return false;
+
+		if (in_class) {
+			/* an escape may be the end point of a range
+			   which spans a newline, e.g. [\t-\f] */
+			if (*p == '\\')
+				return false;
+			if (*p == '[' && p[1] == ':') {
+				p = strstr(p + 2, ":]");
+				if (p == NULL)
+					return false;
+				++p;
+			} else if (*p == ']')
+				in_class = false;
+			continue;
+		}
+
+		if (*p == '[') {
+			in_class = true;
+			if (p[1] == ']')
+				++p; /* a leading ']' is a literal */
+			continue;
+		}
+
+		if (*p == '(' && p[1] == '?' &&
+		    strchr(":=!<>", p[2]) == NULL)
+			return false; /* inline options, comments, ... */
+
+		if (*p == '\\') {
+			++p;
+
+			if (*p == '\0')
+				return false;
+			/* escapes that match a newline, refer to a character
+			   by its code or anchor to the start/end of the subject */
+			if (strchr("snrvRDWHxoc0123456789pPXCAzZGg", *p) != NULL)
+				return false;
+		}
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+static void report_error(struct pfdata *pfd, const char *fmt, const char *fn, const char *whole_path)
+{
+	SEXP_t *msg;
+
+	msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, fmt, fn, whole_path, strerror(errno));
+	probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+	SEXP_free(msg);
+	probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+}
+
+/*
+ * Collect the matches in `buf' which start before `limit'. The caller
+ * keeps `ofs' and `cur_inst' between calls on consecutive parts of the
+ * same file.
+ */
+static int process_buffer(struct pfdata *pfd, const char *path, const char *file,
+			  char *buf, int len, int base, int limit, int *ofs, int *cur_inst)
+{
+	int substr_cnt;
+
+	do {
+		char **substrs;
+		int want_instance;
+		SEXP_t *next_inst;
+
+		next_inst = SEXP_number_newi_32(*cur_inst + 1);
+
+		if (probe_entobj_cmp(pfd->instance_ent, next_inst) == OVAL_RESULT_TRUE)
+			want_instance = 1;
+		else
+			want_instance = 0;
+
+		SEXP_free(next_inst);
+		substr_cnt = get_substrings(buf, len, base, limit, ofs, pfd->compiled_regex, pfd->regex_extra,
+					    want_instance, &substrs);
+
+		if (substr_cnt > 0) {
+			++(*cur_inst);
+
+			if (want_instance) {
+				int k;
+				SEXP_t *item;
+
+				item = create_item(path, file, pfd->pattern,
+						   *cur_inst, substrs, substr_cnt);
+
+                                probe_item_collect(pfd->ctx, item);
+
+				for (k = 0; k < substr_cnt; ++k)
+					oscap_free(substrs[k]);
+				oscap_free(substrs);
+			}
+		}
+	} while (substr_cnt > 0 && *ofs <= len);
+
+	return (substr_cnt < 0 ? -1 : 0);
+}
+
+/*
+ * Scan the file a few lines at a time. Only complete lines are passed to
+ * the regex engine; the newline which ends the previous part is kept in
+ * front of the next one so that the anchors behave as if the whole file
+ * was scanned at once. The buffer grows only if a line doesn't fit in it.
+ */
+static int process_stream(struct pfdata *pfd, const char *path, const char *file,
+			  const char *whole_path, int fd)
+{
+	int ret = 0, buf_size = TFC54_STREAM_BUFSIZE, buf_used = 0, base = 0,
+		ofs = 0, cur_inst = 0;
+	bool eof = false;
+	char *buf, *nl;
+	ssize_t rd;
+
+	buf = oscap_alloc(buf_size);
+
+	for (;;) {
+		while (!eof && buf_used < buf_size) {
+			rd = read(fd, buf + buf_used, buf_size - buf_used);
+
+			if (rd == -1) {
+				if (errno == EINTR)
+					continue;
+
+				report_error(pfd, "%s(): '%s' %s.", "read", whole_path);
+				ret = -2;
+				goto cleanup;
+			} else if (rd == 0) {
+				eof = true;
+			} else {
+				/* the content is handled as a C string */
+				nl = memchr(buf + buf_used, '\0', rd);
+
+				if (nl != NULL) {
+					buf_used = nl - buf;
+					eof = true;
+				} else
+					buf_used += rd;
+			}
+		}
+
+		if (eof) {
+			process_buffer(pfd, path, file, buf, buf_used, base, buf_used + 1, &ofs, &cur_inst);
+			break;
+		}
+
+		nl = memrchr(buf + base, '\n', buf_used - base);
+
+		if (nl == NULL) {
+			/* a line longer than the buffer */
+			if (buf_size > INT_MAX / 2) {
+				errno = EFBIG;
+				report_error(pfd, "%s(): '%s' %s.", "read", whole_path);
+				ret = -2;
+				goto cleanup;
+			}
+
+			buf_size *= 2;
+			buf = oscap_realloc(buf, buf_size);
+			continue;
+		}
+
+		if (process_buffer(pfd, path, file, buf, nl - buf + 1, base, nl - buf + 1, &ofs, &cur_inst) != 0)
+			break;
+
+		/* keep the newline */
+		buf_used -= nl - buf;
+		ofs      -= nl - buf;
+		memmove(buf, nl, buf_used);
+		base = 1;
+	}
+
+ cleanup:
+	oscap_free(buf);
+
+	return ret;
+}
+
+/*
+ * Read the whole file into memory. The size reported by stat() is only
+ * a hint, files in /proc report zero size.
+ */
+static char *read_file(struct pfdata *pfd, const char *whole_path, int fd, size_t size_hint, int *len)
+{
+	size_t buf_size, buf_used = 0;
+	char *buf;
+	ssize_t rd;
+
+	buf_size = size_hint < 4096 ? 4096 : size_hint + 2;
+	buf = oscap_alloc(buf_size);
+
+	for (;;) {
+		if (buf_used + 1 >= buf_size) {
+			if (buf_size > INT_MAX / 2) {
+				errno = EFBIG;
+				report_error(pfd, "%s(): '%s' %s.", "read", whole_path);
+				oscap_free(buf);
+				return NULL;
+			}
+
+			buf_size *= 2;
+			buf = oscap_realloc(buf, buf_size);
+		}
+
+		rd = read(fd, buf + buf_used, buf_size - buf_used - 1);
+
+		if (rd == -1) {
+			if (errno == EINTR)
+				continue;
+
+			report_error(pfd, "%s(): '%s' %s.", "read", whole_path);
+			oscap_free(buf);
+			return NULL;
+		} else if (rd == 0)
+			break;
+
+		buf_used += rd;
+	}
+
+	buf[buf_used] = '\0';
+	*len = strlen(buf);
+
+	return buf;
+}
+
 static int process_file(const char *path, const char *file, void *arg)
 {
 	struct pfdata *pfd = (struct pfdata *) arg;
-	int ret = 0, path_len, file_len, cur_inst = 0, fd = -1, substr_cnt,
-		buf_size = 0, buf_used = 0, ofs = 0, buf_inc = 4096;
+	int ret = 0, path_len, file_len, cur_inst = 0, fd = -1, ofs = 0, len;
 	char *whole_path = NULL, *buf = NULL;
-	SEXP_t *next_inst = NULL;
 	struct stat st;
 
 	if (file == NULL)
@@ -260,74 +526,34 @@ static int process_file(const char *path, const char *file, void *arg)
 
 	fd = open(whole_path, O_RDONLY);
 	if (fd == -1) {
-		SEXP_t *msg;
-
-		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "open(): '%s' %s.", whole_path, strerror(errno));
-		probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-		SEXP_free(msg);
-		probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+		report_error(pfd, "%s(): '%s' %s.", "open", whole_path);
 		ret = -1;
 		goto cleanup;
 	}
 
-	do {
-		buf_size += buf_inc;
-		buf = oscap_realloc(buf, buf_size);
-		ret = read(fd, buf + buf_used, buf_inc);
-		if (ret == -1) {
-			SEXP_t *msg;
-
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno));
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-			ret = -2;
-			goto cleanup;
-		}
-		buf_used += ret;
-	} while (ret == buf_inc);
-
-	if (buf_used == buf_size)
-		buf = realloc(buf, ++buf_size);
-	buf[buf_used++] = '\0';
-
-	do {
-		char **substrs;
-		int want_instance;
-
-		next_inst = SEXP_number_newi_32(cur_inst + 1);
-
-		if (probe_entobj_cmp(pfd->instance_ent, next_inst) == OVAL_RESULT_TRUE)
-			want_instance = 1;
-		else
-			want_instance = 0;
-
-		SEXP_free(next_inst);
-		substr_cnt = get_substrings(buf, &ofs, pfd->compiled_regex, want_instance, &substrs);
-
-		if (substr_cnt > 0) {
-			++cur_inst;
-
-			if (want_instance) {
-				int k;
-				SEXP_t *item;
+	if (pfd->stream) {
+		ret = process_stream(pfd, path, file, whole_path, fd);
+		goto cleanup;
+	}
 
-				item = create_item(path, file, pfd->pattern,
-						   cur_inst, substrs, substr_cnt);
+	/*
+	 * The file is read instead of being mapped: a mapping of a file
+	 * that gets truncated meanwhile would kill the probe with SIGBUS.
+	 */
+	buf = read_file(pfd, whole_path, fd, st.st_size, &len);
 
-                                probe_item_collect(pfd->ctx, item);
+	if (buf == NULL) {
+		ret = -2;
+		goto cleanup;
+	}
 
-				for (k = 0; k < substr_cnt; ++k)
-					oscap_free(substrs[k]);
-				oscap_free(substrs);
-			}
-		}
-	} while (substr_cnt > 0 && ofs < buf_used);
+	process_buffer(pfd, path, file, buf, len, 0, len + 1, &ofs, &cur_inst);
 
  cleanup:
 	if (fd != -1)
 		close(fd);
-	oscap_free(buf);
+	if (buf != NULL)
+		oscap_free(buf);
 	if (whole_path != NULL)
 		oscap_free(whole_path);
 
@@ -337,6 +563,7 @@ static int process_file(const char *path, const char *file, void *arg)
 void *probe_init(void)
 {
   probe_setoption(PROBEOPT_OFFLINE_MODE_SUPPORTED, PROBE_OFFLINE_CHROOT);
+  probe_setoption(PROBEOPT_PERSISTENT_CACHE, PROBE_PCACHE_DEP_OBJPATH, NULL);
   return NULL;
 }
 
@@ -353,7 +580,6 @@ int probe_main(probe_ctx *ctx, void *arg)
 	const char *error;
 #elif defined USE_REGEX_POSIX
 	regex_t _re;
-	pfd.compiled_regex = &_re;
 	int err;
 #endif
 	OVAL_FTS    *ofts;
@@ -362,6 +588,9 @@ int probe_main(probe_ctx *ctx, void *arg)
         (void)arg;
 
 	memset(&pfd, 0, sizeof(pfd));
+#if defined USE_REGEX_POSIX
+	pfd.compiled_regex = &_re;
+#endif
 
         probe_in = probe_ctx_getobject(ctx);
 
@@ -450,6 +679,9 @@ int probe_main(probe_ctx *ctx, void *arg)
 		probe_cobj_set_flag(probe_ctx_getresult(pfd.ctx), SYSCHAR_FLAG_ERROR);
 		goto cleanup;
 	}
+	pfd.regex_extra = pcre_study(pfd.compiled_regex, 0, &error);
+	pfd.stream = pattern_is_singleline(pfd.pattern, pfd.re_opts);
+	dI("pattern '%s' is %smatched line by line\n", pfd.pattern, pfd.stream ? "" : "not ");
 #elif defined USE_REGEX_POSIX
 	pfd.re_opts = REG_EXTENDED | REG_NEWLINE;
 	r0 = probe_ent_getattrval(bh_ent, "ignore_case");
@@ -492,10 +724,12 @@ int probe_main(probe_ctx *ctx, void *arg)
 	if (pfd.pattern != NULL)
 		oscap_free(pfd.pattern);
 #if defined USE_REGEX_PCRE
+	if (pfd.regex_extra != NULL)
+		pcre_free(pfd.regex_extra);
 	if (pfd.compiled_regex != NULL)
 		pcre_free(pfd.compiled_regex);
 #elif defined USE_REGEX_POSIX
-	regfree(re);
+	regfree(pfd.compiled_regex);
 #endif
 	return ret;
 }
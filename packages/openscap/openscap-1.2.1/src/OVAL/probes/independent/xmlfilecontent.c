@@ -88,6 +88,7 @@ void *probe_init(void)
 	xmlInitParser();
 	xmlSetGenericErrorFunc(NULL, dummy_err_func);
 	probe_setoption(PROBEOPT_OFFLINE_MODE_SUPPORTED, PROBE_OFFLINE_CHROOT);
+	probe_setoption(PROBEOPT_PERSISTENT_CACHE, PROBE_PCACHE_DEP_OBJPATH, NULL);
 
 	return NULL;
 }
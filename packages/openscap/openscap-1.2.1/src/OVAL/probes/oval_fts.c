@@ -25,6 +25,7 @@
 #include <config.h>
 #endif
 
+#include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
@@ -43,10 +44,7 @@
 #include "debug_priv.h"
 #include "oval_fts.h"
 #if defined(__SVR4) && defined(__sun)
-#include "fts_sun.h"
 #include <sys/mntent.h>
-#else
-#include <fts.h>
 #endif
 
 #undef OSCAP_FTS_DEBUG
@@ -68,9 +66,9 @@ static OVAL_FTS *OVAL_FTS_new()
 static void OVAL_FTS_free(OVAL_FTS *ofts)
 {
 	if (ofts->ofts_match_path_fts != NULL)
-		fts_close(ofts->ofts_match_path_fts);
+		oval_ftsw_close(ofts->ofts_match_path_fts);
 	if (ofts->ofts_recurse_path_fts != NULL)
-		fts_close(ofts->ofts_recurse_path_fts);
+		oval_ftsw_close(ofts->ofts_recurse_path_fts);
 
 	oscap_free(ofts);
 	return;
@@ -91,7 +89,7 @@ static int pathlen_from_ftse(int fts_pathlen, int fts_namelen)
 	return pathlen;
 }
 
-static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, FTSENT *fts_ent)
+static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, OVAL_FTSWENT *fts_ent)
 {
 	OVAL_FTSENT *ofts_ent;
 
@@ -734,14 +732,14 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 	dI("fts_open args: path: \"%s\", options: %d.\n", paths[0], mtc_fts_options);
 
 	ofts = OVAL_FTS_new();
-	/* reset errno as fts_open() doesn't do it itself. */
+	/* reset errno as oval_ftsw_open() doesn't do it itself. */
 	errno = 0;
-	ofts->ofts_match_path_fts = fts_open((char * const *) paths, mtc_fts_options, NULL);
+	ofts->ofts_match_path_fts = oval_ftsw_open(paths[0], mtc_fts_options);
 	free((void *) paths[0]);
-	/* fts_open() doesn't return NULL for all errors (e.g. nonexistent paths),
+	/* oval_ftsw_open() doesn't return NULL for all errors (e.g. nonexistent paths),
 	   so check errno to detect it. Far from being perfect. */
 	if (ofts->ofts_match_path_fts == NULL || errno != 0) {
-		dE("fts_open() failed, errno: %d \"%s\".\n", errno, strerror(errno));
+		dE("oval_ftsw_open() failed, errno: %d \"%s\".\n", errno, strerror(errno));
 		OVAL_FTS_free(ofts);
 		return (NULL);
 	}
@@ -762,22 +760,18 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 		ofts->localdevs = fsdev_init(NULL, 0);
 		if (ofts->localdevs == NULL) {
 			dE("fsdev_init() failed.\n");
-			/* One dummy read to get rid of an uninitialized
-			 * value in the FTS data before calling
-			 * fts_close() on it. */
-			fts_read(ofts->ofts_match_path_fts);
 			oval_fts_close(ofts);
 			return (NULL);
 		}
 #endif
 	} else if (filesystem == OVAL_RECURSE_FS_DEFINED) {
 		/* store the device id for future comparison */
-		FTSENT *fts_ent;
+		OVAL_FTSWENT *fts_ent;
 
-		fts_ent = fts_read(ofts->ofts_match_path_fts);
+		fts_ent = oval_ftsw_read(ofts->ofts_match_path_fts);
 		if (fts_ent != NULL) {
 			ofts->ofts_recurse_path_devid = fts_ent->fts_statp->st_dev;
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_AGAIN);
+			oval_ftsw_set(ofts->ofts_match_path_fts, fts_ent, FTS_AGAIN);
 		}
 	}
 
@@ -798,7 +792,7 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 	return (ofts);
 }
 
-static inline int _oval_fts_is_local(OVAL_FTS *ofts, FTSENT *fts_ent) {
+static inline int _oval_fts_is_local(OVAL_FTS *ofts, OVAL_FTSWENT *fts_ent) {
 # if defined (__SVR4) && defined(__sun)
 	/* pseudo filesystems will be skipped */
 	/* don't recurse into remote fs if local is specified */
@@ -816,16 +810,50 @@ static inline int _oval_fts_is_local(OVAL_FTS *ofts, FTSENT *fts_ent) {
 #endif
 }
 
+/*
+ * oval_ftsw_prefetch() callback, does the same checks as
+ * oval_fts_read_recurse_path() before entering a directory
+ */
+static bool oval_fts_descend(void *arg, const char *path, const struct stat *st, int level, bool symlink)
+{
+	OVAL_FTS *ofts = arg;
+
+	if (level > 0) {
+		/* limit recursion depth */
+		if (ofts->max_depth != -1 && level > ofts->max_depth)
+			return (false);
+		/* limit recursion only to selected file types */
+		if (!(ofts->recurse & OVAL_RECURSE_DIRS))
+			return (false);
+		if (symlink && !(ofts->recurse & OVAL_RECURSE_SYMLINKS))
+			return (false);
+	}
+#if defined(__SVR4) && defined(__sun)
+	if (!OVAL_FTS_localp(ofts, path, (void *)&st->st_fstype))
+		return (false);
+#else
+	if (ofts->filesystem == OVAL_RECURSE_FS_LOCAL
+	    && !OVAL_FTS_localp(ofts, path, (void *)&st->st_dev))
+		return (false);
+#endif
+	/* don't recurse beyond the initial filesystem */
+	if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
+	    && ofts->ofts_recurse_path_devid != st->st_dev)
+		return (false);
+
+	return (true);
+}
+
 /* find the first matching path or filepath */
-static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
+static OVAL_FTSWENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 {
-	FTSENT *fts_ent = NULL;
+	OVAL_FTSWENT *fts_ent = NULL;
 	SEXP_t *stmp;
 	oval_result_t ores;
 
 	/* iterate until a match is found or all elements have been traversed */
 	for (;;) {
-		fts_ent = fts_read(ofts->ofts_match_path_fts);
+		fts_ent = oval_ftsw_read(ofts->ofts_match_path_fts);
 		if (fts_ent == NULL)
 			return NULL;
 		switch (fts_ent->fts_info) {
@@ -833,7 +861,7 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 			continue;
 		case FTS_DC:
 			dW("Filesystem tree cycle detected at '%s'.\n", fts_ent->fts_path);
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+			oval_ftsw_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 
@@ -848,19 +876,19 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 #if defined(OSCAP_FTS_DEBUG)
 			dI("Only the target of a symlink gets reported, skipping '%s'.\n", fts_ent->fts_path, fts_ent->fts_name);
 #endif
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_FOLLOW);
+			oval_ftsw_set(ofts->ofts_match_path_fts, fts_ent, FTS_FOLLOW);
 			continue;
 		}
 		if (_oval_fts_is_local(ofts, fts_ent)) {
 			dI("Don't recurse into non-local filesystems, skipping '%s'.\n", fts_ent->fts_path);
-			fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+			oval_ftsw_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 		/* don't recurse beyond the initial filesystem */
 		if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
 		    && (fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
 		    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev) {
-			fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+			oval_ftsw_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 
@@ -875,7 +903,7 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 				switch (ret) {
 				case PCRE_ERROR_NOMATCH:
 					dI("Partial match optimization: PCRE_ERROR_NOMATCH, skipping.\n");
-					fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+					oval_ftsw_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 					continue;
 				case PCRE_ERROR_PARTIAL:
 					dI("Partial match optimization: PCRE_ERROR_PARTIAL, continuing.\n");
@@ -914,16 +942,16 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 	    ofts->ofts_sfilename == NULL &&
 	    ofts->ofts_sfilepath == NULL)
 	{
-		fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+		oval_ftsw_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 	}
 
 	return fts_ent;
 }
 
 /* find the first matching file or directory */
-static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
+static OVAL_FTSWENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 {
-	FTSENT *out_fts_ent = NULL;
+	OVAL_FTSWENT *out_fts_ent = NULL;
 	/* the condition below is correct because ofts_sfilepath is NULL here */
 	bool collect_dirs = (ofts->ofts_sfilename == NULL);
 
@@ -943,26 +971,35 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 		if (ofts->ofts_recurse_path_fts == NULL) {
 			char * const paths[2] = { ofts->ofts_match_path_fts_ent->fts_path, NULL };
 
+			/* read the subtree in parallel, the walk below gets it from the cache */
+			if (ofts->direction == OVAL_RECURSE_DIRECTION_DOWN && ofts->max_depth != 0) {
+				char key[64];
+
+				snprintf(key, sizeof key, "%d %d %d %ju", ofts->max_depth, ofts->recurse,
+					 ofts->filesystem, (uintmax_t)ofts->ofts_recurse_path_devid);
+				oval_ftsw_prefetch(paths[0], key, oval_fts_descend, ofts);
+			}
+
 #if defined(OSCAP_FTS_DEBUG)
 			dI("fts_open args: path: \"%s\", options: %d.\n",
 				paths[0], ofts->ofts_recurse_path_fts_opts);
 #endif
-			/* reset errno as fts_open() doesn't do it itself. */
+			/* reset errno as oval_ftsw_open() doesn't do it itself. */
 			errno = 0;
-			ofts->ofts_recurse_path_fts = fts_open(paths,
-				ofts->ofts_recurse_path_fts_opts, NULL);
-			/* fts_open() doesn't return NULL for all errors
+			ofts->ofts_recurse_path_fts = oval_ftsw_open(paths[0],
+				ofts->ofts_recurse_path_fts_opts);
+			/* oval_ftsw_open() doesn't return NULL for all errors
 			   (e.g. nonexistent paths), so check errno to detect it.
 			   Far from being perfect. */
 			if (ofts->ofts_recurse_path_fts == NULL || errno != 0) {
-				dE("fts_open() failed, errno: %d \"%s\".\n",
+				dE("oval_ftsw_open() failed, errno: %d \"%s\".\n",
 					errno, strerror(errno));
 #if !defined(OSCAP_FTS_DEBUG)
 				dE("fts_open args: path: \"%s\", options: %d.\n",
 					paths[0], ofts->ofts_recurse_path_fts_opts);
 #endif
 				if (ofts->ofts_recurse_path_fts != NULL) {
-					fts_close(ofts->ofts_recurse_path_fts);
+					oval_ftsw_close(ofts->ofts_recurse_path_fts);
 					ofts->ofts_recurse_path_fts = NULL;
 				}
 				return (NULL);
@@ -971,11 +1008,11 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 
 		/* iterate until a match is found or all elements have been traversed */
 		while (out_fts_ent == NULL) {
-			FTSENT *fts_ent;
+			OVAL_FTSWENT *fts_ent;
 
-			fts_ent = fts_read(ofts->ofts_recurse_path_fts);
+			fts_ent = oval_ftsw_read(ofts->ofts_recurse_path_fts);
 			if (fts_ent == NULL) {
-				fts_close(ofts->ofts_recurse_path_fts);
+				oval_ftsw_close(ofts->ofts_recurse_path_fts);
 				ofts->ofts_recurse_path_fts = NULL;
 
 				return NULL;
@@ -986,7 +1023,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				continue;
 			case FTS_DC:
 				dW("Filesystem tree cycle detected at '%s'.\n", fts_ent->fts_path);
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				oval_ftsw_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 
@@ -1017,7 +1054,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				/* limit recursion depth */
 				if (ofts->direction == OVAL_RECURSE_DIRECTION_NONE
 				    || (ofts->max_depth != -1 && fts_ent->fts_level > ofts->max_depth)) {
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+					oval_ftsw_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 					continue;
 				}
 
@@ -1025,30 +1062,30 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				switch (fts_ent->fts_info) {
 				case FTS_D:
 					if (!(ofts->recurse & OVAL_RECURSE_DIRS)) {
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						oval_ftsw_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						continue;
 					}
 					break;
 				case FTS_SL:
 					if (!(ofts->recurse & OVAL_RECURSE_SYMLINKS)) {
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						oval_ftsw_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						continue;
 					}
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
+					oval_ftsw_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
 					break;
 				default:
 					continue;
 				}
 			}
 			if (_oval_fts_is_local(ofts, fts_ent)) {
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				oval_ftsw_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 			/* don't recurse beyond the initial filesystem */
 			if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
 			    && (fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
 			    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev) {
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				oval_ftsw_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 		}
@@ -1070,22 +1107,22 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				dI("fts_open args: path: \"%s\", options: %d.\n",
 					paths[0], ofts->ofts_recurse_path_fts_opts);
 #endif
-				/* reset errno as fts_open() doesn't do it itself. */
+				/* reset errno as oval_ftsw_open() doesn't do it itself. */
 				errno = 0;
-				/* fts_open() doesn't return NULL for all errors
+				/* oval_ftsw_open() doesn't return NULL for all errors
 				   (e.g. nonexistent paths), so check errno to
 				   detect it. Far from being perfect. */
-				ofts->ofts_recurse_path_fts = fts_open(paths,
-					ofts->ofts_recurse_path_fts_opts, NULL);
+				ofts->ofts_recurse_path_fts = oval_ftsw_open(paths[0],
+					ofts->ofts_recurse_path_fts_opts);
 				if (ofts->ofts_recurse_path_fts == NULL || errno != 0) {
-					dE("fts_open() failed, errno: %d \"%s\".\n",
+					dE("oval_ftsw_open() failed, errno: %d \"%s\".\n",
 						errno, strerror(errno));
 #if !defined(OSCAP_FTS_DEBUG)
 					dE("fts_open args: path: \"%s\", options: %d.\n",
 						paths[0], ofts->ofts_recurse_path_fts_opts);
 #endif
 					if (ofts->ofts_recurse_path_fts != NULL) {
-						fts_close(ofts->ofts_recurse_path_fts);
+						oval_ftsw_close(ofts->ofts_recurse_path_fts);
 						ofts->ofts_recurse_path_fts = NULL;
 					}
 					return (NULL);
@@ -1094,9 +1131,9 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 
 			/* iterate until a match is found or all elements have been traversed */
 			while (out_fts_ent == NULL) {
-				FTSENT *fts_ent;
+				OVAL_FTSWENT *fts_ent;
 
-				fts_ent = fts_read(ofts->ofts_recurse_path_fts);
+				fts_ent = oval_ftsw_read(ofts->ofts_recurse_path_fts);
 				if (fts_ent == NULL)
 					break;
 
@@ -1130,7 +1167,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 					/* only fts root is collected */
 					if (fts_ent->fts_level == 0 && fts_ent->fts_info == FTS_D) {
 						out_fts_ent = fts_ent;
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						oval_ftsw_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						break;
 					}
 				} else {
@@ -1145,16 +1182,16 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				}
 
 				if (fts_ent->fts_info == FTS_SL)
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
+					oval_ftsw_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
 				/* limit recursion only to fts root */
 				else if (fts_ent->fts_level > 0)
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+					oval_ftsw_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			}
 
 			if (out_fts_ent != NULL)
 				break;
 
-			fts_close(ofts->ofts_recurse_path_fts);
+			oval_ftsw_close(ofts->ofts_recurse_path_fts);
 			ofts->ofts_recurse_path_fts = NULL;
 
 			if (!strcmp(ofts->ofts_recurse_path_curpth, "/"))
@@ -1177,7 +1214,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 
 OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 {
-	FTSENT *fts_ent;
+	OVAL_FTSWENT *fts_ent;
 
 #if defined(OSCAP_FTS_DEBUG)
 	dI("ofts: %p.\n", ofts);
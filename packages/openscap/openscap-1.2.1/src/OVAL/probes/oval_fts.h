@@ -23,13 +23,9 @@
 #define OVAL_FTS_H
 
 #include <sexp.h>
-#if defined(__SVR4) && defined(__sun)
-#include "fts_sun.h"
-#else
-#include <fts.h>
-#endif
 #include <pcre.h>
 #include "fsdev.h"
+#include "oval_fts_walk.h"
 
 #define ENT_GET_AREF(ent, dst, attr_name, mandatory)			\
 	do {								\
@@ -66,10 +62,10 @@
 
 typedef struct {
 	/* oval_fts_read_match_path() state */
-	FTS *ofts_match_path_fts;
-	FTSENT *ofts_match_path_fts_ent;
+	OVAL_FTSW *ofts_match_path_fts;
+	OVAL_FTSWENT *ofts_match_path_fts_ent;
 	/* oval_fts_read_recurse_path() state */
-	FTS *ofts_recurse_path_fts;
+	OVAL_FTSW *ofts_recurse_path_fts;
 	int ofts_recurse_path_fts_opts;
 	int ofts_recurse_path_curdepth;
 	char *ofts_recurse_path_pthcpy;
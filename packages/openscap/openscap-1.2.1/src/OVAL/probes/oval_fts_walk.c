@@ -0,0 +1,1096 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "alloc.h"
+#include "debug_priv.h"
+#include "SEAP/generic/rbt/rbt.h"
+#include "oval_fts_walk.h"
+
+struct oval_fts_dent {
+	uint32_t     name;      /* offset of the name in oval_fts_dir.names */
+	int          lst_errno; /* lstat() failed */
+	struct stat  lst;
+	int          fst_errno; /* stat() failed */
+	struct stat *fst;       /* stat(), done on demand for symlinks */
+};
+
+struct oval_fts_dir {
+	char    *path;
+	dev_t    dev;
+	ino_t    ino;
+	struct timespec mtim;
+	struct timespec ctim;
+
+	uint32_t refs;   /* walks using the listing + 1 if cached */
+	bool     cached;
+	size_t   size;
+
+	uint32_t count;
+	struct oval_fts_dent *ent;
+	char    *names;
+};
+
+static struct {
+	pthread_once_t  once;
+	pthread_mutex_t mutex;
+	rbt_t          *tree; /* path -> struct oval_fts_dir */
+	rbt_t          *prefetched; /* trees read by oval_ftsw_prefetch() */
+	int             threads;
+	oval_fts_cache_stats_t stats;
+} ofts_cache = {
+	.once  = PTHREAD_ONCE_INIT,
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.tree  = NULL
+};
+
+static void ofts_cache_init(void)
+{
+	char *str, *end;
+
+	ofts_cache.stats.max_size = OVAL_FTS_CACHE_DEFAULT_SIZE;
+
+	if ((str = getenv("OSCAP_PROBE_FTS_CACHE_SIZE")) != NULL) {
+		unsigned long long size;
+
+		errno = 0;
+		size = strtoull(str, &end, 10);
+
+		if (errno != 0 || *end != '\0')
+			dW("Invalid value of OSCAP_PROBE_FTS_CACHE_SIZE: %s\n", str);
+		else
+			ofts_cache.stats.max_size = (size_t)size;
+	}
+
+	ofts_cache.threads = OVAL_FTS_WALK_DEFAULT_THREADS;
+#if defined(_SC_NPROCESSORS_ONLN)
+	{
+		long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+		if (ncpu > 0 && ncpu < ofts_cache.threads)
+			ofts_cache.threads = (int)ncpu;
+	}
+#endif
+
+	if ((str = getenv("OSCAP_PROBE_FTS_THREADS")) != NULL) {
+		long threads;
+
+		errno = 0;
+		threads = strtol(str, &end, 10);
+
+		if (errno != 0 || *end != '\0' || threads < 1 || threads > OVAL_FTS_WALK_MAX_THREADS)
+			dW("Invalid value of OSCAP_PROBE_FTS_THREADS: %s\n", str);
+		else
+			ofts_cache.threads = (int)threads;
+	}
+
+	ofts_cache.tree = rbt_str_new();
+	ofts_cache.prefetched = rbt_str_new();
+	dI("FTS cache: max_size=%zu, threads=%d\n", ofts_cache.stats.max_size, ofts_cache.threads);
+}
+
+static void ofts_dir_free(struct oval_fts_dir *dir)
+{
+	uint32_t i;
+
+	for (i = 0; i < dir->count; ++i)
+		oscap_free(dir->ent[i].fst);
+
+	oscap_free(dir->ent);
+	oscap_free(dir->names);
+	oscap_free(dir->path);
+	oscap_free(dir);
+}
+
+/* called with ofts_cache.mutex locked */
+static void ofts_dir_unref(struct oval_fts_dir *dir)
+{
+	if (--dir->refs == 0)
+		ofts_dir_free(dir);
+}
+
+static void ofts_dir_release(struct oval_fts_dir *dir)
+{
+	pthread_mutex_lock(&ofts_cache.mutex);
+	ofts_dir_unref(dir);
+	pthread_mutex_unlock(&ofts_cache.mutex);
+}
+
+static bool ofts_dir_valid(const struct oval_fts_dir *dir, const struct stat *st)
+{
+	return (dir->dev == st->st_dev &&
+		dir->ino == st->st_ino &&
+		dir->mtim.tv_sec  == st->st_mtim.tv_sec &&
+		dir->mtim.tv_nsec == st->st_mtim.tv_nsec &&
+		dir->ctim.tv_sec  == st->st_ctim.tv_sec &&
+		dir->ctim.tv_nsec == st->st_ctim.tv_nsec);
+}
+
+/*
+ * Read a directory and lstat() its entries. The listing is keyed on
+ * the stat() of the opened directory, taken before it's read, so that
+ * a change made during the read invalidates it. The stat() is stored
+ * in `st'.
+ */
+static struct oval_fts_dir *ofts_dir_read(const char *path, struct stat *st, uint64_t *lstat_cnt)
+{
+	struct oval_fts_dir *dir;
+	struct dirent *de;
+	DIR   *dp;
+	size_t ent_size, names_size, names_len, len;
+
+	if ((dp = opendir(path)) == NULL)
+		return (NULL);
+
+	if (fstat(dirfd(dp), st) != 0) {
+		protect_errno {
+			closedir(dp);
+		}
+		return (NULL);
+	}
+
+	dir = oscap_talloc(struct oval_fts_dir);
+	memset(dir, 0, sizeof *dir);
+
+	dir->path = strdup(path);
+	dir->dev  = st->st_dev;
+	dir->ino  = st->st_ino;
+	dir->mtim = st->st_mtim;
+	dir->ctim = st->st_ctim;
+	dir->refs = 1;
+
+	ent_size   = 0;
+	names_size = 0;
+	names_len  = 0;
+
+	while ((de = readdir(dp)) != NULL) {
+		struct oval_fts_dent *ent;
+
+		if (de->d_name[0] == '.' &&
+		    (de->d_name[1] == '\0' || (de->d_name[1] == '.' && de->d_name[2] == '\0')))
+			continue;
+
+		if (dir->count == ent_size) {
+			ent_size = ent_size == 0 ? 16 : ent_size * 2;
+			dir->ent = oscap_realloc(dir->ent, sizeof(struct oval_fts_dent) * ent_size);
+		}
+
+		len = strlen(de->d_name) + 1;
+
+		if (names_len + len > names_size) {
+			names_size = names_size == 0 ? 256 : names_size * 2;
+			if (names_size < names_len + len)
+				names_size = names_len + len;
+			dir->names = oscap_realloc(dir->names, names_size);
+		}
+
+		ent = &dir->ent[dir->count++];
+		ent->name = names_len;
+		memcpy(dir->names + names_len, de->d_name, len);
+		names_len += len;
+
+		ent->fst = NULL;
+		ent->fst_errno = 0;
+		ent->lst_errno = 0;
+
+		++(*lstat_cnt);
+		if (fstatat(dirfd(dp), de->d_name, &ent->lst, AT_SYMLINK_NOFOLLOW) != 0) {
+			ent->lst_errno = errno;
+			memset(&ent->lst, 0, sizeof ent->lst);
+		}
+	}
+
+	closedir(dp);
+
+	dir->size = sizeof(struct oval_fts_dir)
+		+ sizeof(struct oval_fts_dent) * ent_size
+		+ names_size + strlen(path) + 1;
+
+	return (dir);
+}
+
+/*
+ * Get the listing of the directory `path'. A cached listing is used
+ * only if it matches a fresh stat() of the directory; the stat of the
+ * parent's listing can't be used for that, it may be older than the
+ * cached listing of its subdirectory. The caller has to release the
+ * listing using ofts_dir_release().
+ */
+static struct oval_fts_dir *ofts_dir_get(const char *path)
+{
+	struct oval_fts_dir *dir, *old;
+	struct stat st;
+	uint64_t lstat_cnt = 0;
+	int errnum;
+
+	pthread_once(&ofts_cache.once, ofts_cache_init);
+
+	if (stat(path, &st) != 0)
+		return (NULL);
+
+	pthread_mutex_lock(&ofts_cache.mutex);
+	++ofts_cache.stats.stat;
+
+	if (rbt_str_get(ofts_cache.tree, path, (void **)&dir) == 0) {
+		if (ofts_dir_valid(dir, &st)) {
+			++dir->refs;
+			++ofts_cache.stats.dir_hits;
+			pthread_mutex_unlock(&ofts_cache.mutex);
+
+			return (dir);
+		}
+
+		dI("FTS cache: %s changed, dropping the cached listing\n", path);
+		rbt_str_del(ofts_cache.tree, path, NULL);
+		ofts_cache.stats.size -= dir->size;
+		--ofts_cache.stats.dir_count;
+		dir->cached = false;
+		ofts_dir_unref(dir);
+	}
+
+	pthread_mutex_unlock(&ofts_cache.mutex);
+
+	dir = ofts_dir_read(path, &st, &lstat_cnt);
+	errnum = errno;
+
+	pthread_mutex_lock(&ofts_cache.mutex);
+
+	++ofts_cache.stats.dir_reads;
+	ofts_cache.stats.lstat += lstat_cnt;
+
+	if (dir != NULL && ofts_cache.stats.size + dir->size <= ofts_cache.stats.max_size) {
+		if (rbt_str_get(ofts_cache.tree, path, (void **)&old) == 0) {
+			/* another walk was faster */
+			if (ofts_dir_valid(old, &st)) {
+				ofts_dir_free(dir);
+				dir = old;
+				++dir->refs;
+			}
+		} else if (rbt_str_add(ofts_cache.tree, dir->path, dir) == 0) {
+			dir->cached = true;
+			++dir->refs;
+			ofts_cache.stats.size += dir->size;
+			++ofts_cache.stats.dir_count;
+		}
+	}
+
+	pthread_mutex_unlock(&ofts_cache.mutex);
+	errno = errnum;
+
+	return (dir);
+}
+
+/* stat() of the i-th entry, cached in the listing */
+static int ofts_dir_stat(struct oval_fts_dir *dir, uint32_t i, struct stat *st)
+{
+	struct oval_fts_dent *ent = &dir->ent[i];
+	struct stat *fst;
+	char *path;
+	size_t plen, nlen;
+	int ret, errnum;
+
+	pthread_mutex_lock(&ofts_cache.mutex);
+
+	if (ent->fst != NULL || ent->fst_errno != 0) {
+		if (ent->fst != NULL)
+			memcpy(st, ent->fst, sizeof *st);
+		errnum = ent->fst_errno;
+		pthread_mutex_unlock(&ofts_cache.mutex);
+
+		if (errnum != 0) {
+			errno = errnum;
+			return (-1);
+		}
+		return (0);
+	}
+
+	++ofts_cache.stats.stat;
+	pthread_mutex_unlock(&ofts_cache.mutex);
+
+	plen = strlen(dir->path);
+	nlen = strlen(dir->names + ent->name);
+	path = oscap_alloc(plen + nlen + 2);
+	memcpy(path, dir->path, plen);
+	if (plen == 0 || path[plen - 1] != '/')
+		path[plen++] = '/';
+	memcpy(path + plen, dir->names + ent->name, nlen + 1);
+
+	ret = stat(path, st);
+	errnum = errno;
+	oscap_free(path);
+
+	pthread_mutex_lock(&ofts_cache.mutex);
+
+	if (ent->fst == NULL && ent->fst_errno == 0) {
+		if (ret == 0) {
+			fst = oscap_talloc(struct stat);
+			memcpy(fst, st, sizeof *st);
+			ent->fst = fst;
+		} else
+			ent->fst_errno = errnum;
+	}
+
+	pthread_mutex_unlock(&ofts_cache.mutex);
+
+	errno = errnum;
+	return (ret);
+}
+
+static void ofts_stat_count(bool follow)
+{
+	pthread_once(&ofts_cache.once, ofts_cache_init);
+	pthread_mutex_lock(&ofts_cache.mutex);
+
+	if (follow)
+		++ofts_cache.stats.stat;
+	else
+		++ofts_cache.stats.lstat;
+
+	pthread_mutex_unlock(&ofts_cache.mutex);
+}
+
+void oval_fts_cache_stats(oval_fts_cache_stats_t *stats)
+{
+	pthread_once(&ofts_cache.once, ofts_cache_init);
+	pthread_mutex_lock(&ofts_cache.mutex);
+	memcpy(stats, &ofts_cache.stats, sizeof *stats);
+	pthread_mutex_unlock(&ofts_cache.mutex);
+}
+
+static void ofts_cache_node_free(struct rbt_str_node *n)
+{
+	struct oval_fts_dir *dir = n->data;
+
+	dir->cached = false;
+	ofts_dir_unref(dir);
+}
+
+static void ofts_cache_key_free(struct rbt_str_node *n)
+{
+	oscap_free(n->key);
+}
+
+void oval_fts_cache_reset(void)
+{
+	pthread_once(&ofts_cache.once, ofts_cache_init);
+	pthread_mutex_lock(&ofts_cache.mutex);
+
+	rbt_str_free_cb(ofts_cache.tree, ofts_cache_node_free);
+	ofts_cache.tree = rbt_str_new();
+	rbt_str_free_cb(ofts_cache.prefetched, ofts_cache_key_free);
+	ofts_cache.prefetched = rbt_str_new();
+	ofts_cache.stats.size = 0;
+	ofts_cache.stats.dir_count = 0;
+
+	pthread_mutex_unlock(&ofts_cache.mutex);
+}
+
+/*
+ * Parallel prefetch
+ */
+/*
+ * A directory to read. Its stat from the parent's listing isn't kept,
+ * the listing may be older than the directory; ofts_dir_get() stats it
+ * when the task is processed.
+ */
+typedef struct {
+	char       *path;
+	int         level;
+} ofts_ptask_t;
+
+/* per-thread task queue, the owner uses the tail, thieves the head */
+typedef struct {
+	pthread_mutex_t mutex;
+	ofts_ptask_t   *task;
+	size_t          head;
+	size_t          tail;
+	size_t          size;
+} ofts_pqueue_t;
+
+typedef struct {
+	dev_t dev;
+	ino_t ino;
+} ofts_pid_t;
+
+typedef struct {
+	int             threads;
+	ofts_pqueue_t  *queue;
+
+	pthread_mutex_t mutex;   /* protects the members below */
+	pthread_cond_t  cond;
+	size_t          queued;  /* tasks in the queues */
+	size_t          pending; /* tasks in the queues or being processed */
+	bool            stop;    /* the cache is full */
+	ofts_pid_t     *visited; /* open addressing set of directories */
+	size_t          visited_cnt;
+	size_t          visited_size;
+
+	oval_ftsw_descend_t descend;
+	void           *arg;
+} ofts_prefetch_t;
+
+typedef struct {
+	ofts_prefetch_t *pf;
+	int              id;
+} ofts_pworker_t;
+
+static size_t ofts_pid_hash(dev_t dev, ino_t ino, size_t size)
+{
+	uint64_t h = ((uint64_t)dev * UINT64_C(0x9e3779b97f4a7c15)) ^ (uint64_t)ino;
+
+	h ^= h >> 29;
+	h *= UINT64_C(0xbf58476d1ce4e5b9);
+	h ^= h >> 32;
+
+	return (size_t)(h & (size - 1));
+}
+
+/*
+ * Add a directory to the visited set. Called with pf->mutex locked.
+ * @return false if the directory was already visited
+ */
+static bool ofts_prefetch_visit(ofts_prefetch_t *pf, const struct stat *st)
+{
+	size_t i;
+
+	if ((pf->visited_cnt + 1) * 2 > pf->visited_size) {
+		ofts_pid_t *old = pf->visited;
+		size_t      old_size = pf->visited_size, j;
+
+		pf->visited_size = old_size == 0 ? 256 : old_size * 2;
+		pf->visited = oscap_alloc(sizeof(ofts_pid_t) * pf->visited_size);
+		memset(pf->visited, 0, sizeof(ofts_pid_t) * pf->visited_size);
+
+		for (j = 0; j < old_size; ++j) {
+			if (old[j].ino == 0)
+				continue;
+			i = ofts_pid_hash(old[j].dev, old[j].ino, pf->visited_size);
+			while (pf->visited[i].ino != 0)
+				i = (i + 1) & (pf->visited_size - 1);
+			pf->visited[i] = old[j];
+		}
+
+		oscap_free(old);
+	}
+
+	i = ofts_pid_hash(st->st_dev, st->st_ino, pf->visited_size);
+
+	while (pf->visited[i].ino != 0) {
+		if (pf->visited[i].ino == st->st_ino && pf->visited[i].dev == st->st_dev)
+			return (false);
+		i = (i + 1) & (pf->visited_size - 1);
+	}
+
+	pf->visited[i].dev = st->st_dev;
+	pf->visited[i].ino = st->st_ino;
+	++pf->visited_cnt;
+
+	return (true);
+}
+
+static void ofts_prefetch_push(ofts_prefetch_t *pf, int id, char *path, int level)
+{
+	ofts_pqueue_t *q = &pf->queue[id];
+	ofts_ptask_t  *t;
+
+	pthread_mutex_lock(&q->mutex);
+
+	if (q->tail == q->size) {
+		if (q->head > 0) {
+			memmove(q->task, q->task + q->head, sizeof(ofts_ptask_t) * (q->tail - q->head));
+			q->tail -= q->head;
+			q->head  = 0;
+		}
+		if (q->tail == q->size) {
+			q->size = q->size == 0 ? 64 : q->size * 2;
+			q->task = oscap_realloc(q->task, sizeof(ofts_ptask_t) * q->size);
+		}
+	}
+
+	t = &q->task[q->tail++];
+	t->path  = path;
+	t->level = level;
+
+	pthread_mutex_unlock(&q->mutex);
+
+	pthread_mutex_lock(&pf->mutex);
+	++pf->queued;
+	++pf->pending;
+	pthread_cond_signal(&pf->cond);
+	pthread_mutex_unlock(&pf->mutex);
+}
+
+/* take a task from the own queue (newest first) or steal one (oldest first) */
+static bool ofts_prefetch_pop(ofts_prefetch_t *pf, int id, ofts_ptask_t *task)
+{
+	int i, victim;
+
+	for (i = 0; i < pf->threads; ++i) {
+		ofts_pqueue_t *q;
+		bool found = false;
+
+		victim = (id + i) % pf->threads;
+		q = &pf->queue[victim];
+
+		pthread_mutex_lock(&q->mutex);
+
+		if (q->head < q->tail) {
+			if (victim == id)
+				*task = q->task[--q->tail];
+			else
+				*task = q->task[q->head++];
+			found = true;
+		}
+
+		pthread_mutex_unlock(&q->mutex);
+
+		if (found) {
+			pthread_mutex_lock(&pf->mutex);
+			--pf->queued;
+			pthread_mutex_unlock(&pf->mutex);
+
+			if (victim != id) {
+				pthread_mutex_lock(&ofts_cache.mutex);
+				++ofts_cache.stats.steals;
+				pthread_mutex_unlock(&ofts_cache.mutex);
+			}
+
+			return (true);
+		}
+	}
+
+	return (false);
+}
+
+static void ofts_prefetch_task(ofts_prefetch_t *pf, int id, ofts_ptask_t *task)
+{
+	struct oval_fts_dir *dir;
+	uint32_t i;
+	bool full;
+
+	dir = ofts_dir_get(task->path);
+	if (dir == NULL)
+		return;
+
+	pthread_mutex_lock(&ofts_cache.mutex);
+	++ofts_cache.stats.prefetched;
+	full = ofts_cache.stats.size >= ofts_cache.stats.max_size || !dir->cached;
+	pthread_mutex_unlock(&ofts_cache.mutex);
+
+	if (full) {
+		/* no point in reading directories which won't be kept */
+		pthread_mutex_lock(&pf->mutex);
+		pf->stop = true;
+		pthread_mutex_unlock(&pf->mutex);
+		ofts_dir_release(dir);
+		return;
+	}
+
+	for (i = 0; i < dir->count; ++i) {
+		struct oval_fts_dent *ent = &dir->ent[i];
+		const char *name = dir->names + ent->name;
+		struct stat st;
+		bool symlink, visit;
+		size_t plen, nlen;
+		char *path;
+
+		if (ent->lst_errno != 0)
+			continue;
+
+		if (S_ISDIR(ent->lst.st_mode)) {
+			memcpy(&st, &ent->lst, sizeof st);
+			symlink = false;
+		} else if (S_ISLNK(ent->lst.st_mode)) {
+			if (ofts_dir_stat(dir, i, &st) != 0 || !S_ISDIR(st.st_mode))
+				continue;
+			symlink = true;
+		} else
+			continue;
+
+		plen = strlen(task->path);
+		nlen = strlen(name);
+		path = oscap_alloc(plen + nlen + 2);
+		memcpy(path, task->path, plen);
+		if (plen == 0 || path[plen - 1] != '/')
+			path[plen++] = '/';
+		memcpy(path + plen, name, nlen + 1);
+
+		if (!pf->descend(pf->arg, path, &st, task->level + 1, symlink)) {
+			oscap_free(path);
+			continue;
+		}
+
+		pthread_mutex_lock(&pf->mutex);
+		visit = !pf->stop && ofts_prefetch_visit(pf, &st);
+		pthread_mutex_unlock(&pf->mutex);
+
+		if (visit)
+			ofts_prefetch_push(pf, id, path, task->level + 1);
+		else
+			oscap_free(path);
+	}
+
+	ofts_dir_release(dir);
+}
+
+static void *ofts_prefetch_worker(void *arg)
+{
+	ofts_pworker_t  *w  = arg;
+	ofts_prefetch_t *pf = w->pf;
+	ofts_ptask_t     task;
+
+	for (;;) {
+		if (ofts_prefetch_pop(pf, w->id, &task)) {
+			ofts_prefetch_task(pf, w->id, &task);
+			oscap_free(task.path);
+
+			pthread_mutex_lock(&pf->mutex);
+			if (--pf->pending == 0)
+				pthread_cond_broadcast(&pf->cond);
+			pthread_mutex_unlock(&pf->mutex);
+
+			continue;
+		}
+
+		pthread_mutex_lock(&pf->mutex);
+
+		while (pf->queued == 0 && pf->pending > 0)
+			pthread_cond_wait(&pf->cond, &pf->mutex);
+
+		if (pf->pending == 0) {
+			pthread_mutex_unlock(&pf->mutex);
+			break;
+		}
+
+		pthread_mutex_unlock(&pf->mutex);
+	}
+
+	return (NULL);
+}
+
+void oval_ftsw_prefetch(const char *path, const char *key, oval_ftsw_descend_t descend, void *arg)
+{
+	ofts_prefetch_t pf;
+	ofts_pworker_t *w;
+	pthread_t *th;
+	struct stat st;
+	char *pkey;
+	size_t plen, klen;
+	int i, started;
+
+	pthread_once(&ofts_cache.once, ofts_cache_init);
+
+	if (ofts_cache.threads < 2 || ofts_cache.stats.max_size == 0)
+		return;
+
+	plen = strlen(path);
+	klen = strlen(key);
+	pkey = oscap_alloc(plen + klen + 2);
+	memcpy(pkey, path, plen);
+	pkey[plen] = '\t';
+	memcpy(pkey + plen + 1, key, klen + 1);
+
+	pthread_mutex_lock(&ofts_cache.mutex);
+
+	if (rbt_str_add(ofts_cache.prefetched, pkey, NULL) != 0) {
+		/* already done */
+		pthread_mutex_unlock(&ofts_cache.mutex);
+		oscap_free(pkey);
+		return;
+	}
+
+	++ofts_cache.stats.stat;
+	pthread_mutex_unlock(&ofts_cache.mutex);
+
+	if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode) || !descend(arg, path, &st, 0, false))
+		return;
+
+	memset(&pf, 0, sizeof pf);
+	pf.threads = ofts_cache.threads;
+	pf.queue   = oscap_alloc(sizeof(ofts_pqueue_t) * pf.threads);
+	pf.descend = descend;
+	pf.arg     = arg;
+
+	memset(pf.queue, 0, sizeof(ofts_pqueue_t) * pf.threads);
+	for (i = 0; i < pf.threads; ++i)
+		pthread_mutex_init(&pf.queue[i].mutex, NULL);
+
+	pthread_mutex_init(&pf.mutex, NULL);
+	pthread_cond_init(&pf.cond, NULL);
+
+	ofts_prefetch_visit(&pf, &st);
+	ofts_prefetch_push(&pf, 0, strdup(path), 0);
+
+	w  = oscap_alloc(sizeof(ofts_pworker_t) * pf.threads);
+	th = oscap_alloc(sizeof(pthread_t) * pf.threads);
+
+	for (i = 0; i < pf.threads; ++i) {
+		w[i].pf = &pf;
+		w[i].id = i;
+	}
+
+	/* the calling thread is worker 0 */
+	for (started = 1; started < pf.threads; ++started) {
+		int ret;
+
+		if ((ret = pthread_create(&th[started], NULL, ofts_prefetch_worker, &w[started])) != 0) {
+			dW("Can't start a directory walker thread: %s\n", strerror(ret));
+			break;
+		}
+	}
+
+	ofts_prefetch_worker(&w[0]);
+
+	for (i = 1; i < started; ++i)
+		pthread_join(th[i], NULL);
+
+	dI("Prefetched %s: %zu directories, %d threads\n", path, pf.visited_cnt, started);
+
+	for (i = 0; i < pf.threads; ++i) {
+		pthread_mutex_destroy(&pf.queue[i].mutex);
+		oscap_free(pf.queue[i].task);
+	}
+
+	pthread_mutex_destroy(&pf.mutex);
+	pthread_cond_destroy(&pf.cond);
+
+	oscap_free(pf.visited);
+	oscap_free(pf.queue);
+	oscap_free(w);
+	oscap_free(th);
+}
+
+/*
+ * Walker
+ */
+static OVAL_FTSWENT *OVAL_FTSWENT_new(const char *ppath, size_t ppathlen, const char *name, size_t namelen, short level)
+{
+	OVAL_FTSWENT *ent;
+
+	ent = oscap_talloc(OVAL_FTSWENT);
+	memset(ent, 0, sizeof *ent);
+
+	/* don't double the slash of the root directory */
+	if (ppathlen > 0 && ppath[ppathlen - 1] == '/')
+		--ppathlen;
+
+	ent->fts_path = oscap_alloc(ppathlen + namelen + 2);
+	memcpy(ent->fts_path, ppath, ppathlen);
+	ent->fts_path[ppathlen] = '/';
+	memcpy(ent->fts_path + ppathlen + 1, name, namelen);
+	ent->fts_path[ppathlen + namelen + 1] = '\0';
+
+	ent->fts_pathlen = ppathlen + namelen + 1;
+	ent->fts_name    = ent->fts_path + ppathlen + 1;
+	ent->fts_namelen = namelen;
+	ent->fts_level   = level;
+	ent->fts_statp   = &ent->ofts_st;
+	ent->ofts_instr  = FTS_NOINSTR;
+
+	return (ent);
+}
+
+static void OVAL_FTSWENT_free(OVAL_FTSWENT *ent)
+{
+	oscap_free(ent->fts_path);
+	oscap_free(ent);
+}
+
+static unsigned short ftsw_classify(OVAL_FTSW *ftsw, OVAL_FTSWENT *ent)
+{
+	const struct stat *st = &ent->ofts_st;
+	size_t i;
+
+	if (S_ISDIR(st->st_mode)) {
+		/* tree cycle: the directory is one of the ancestors */
+		for (i = 0; i < ftsw->depth; ++i) {
+			const struct stat *ast = &ftsw->stack[i].ent->ofts_st;
+
+			if (ftsw->stack[i].ent != ent &&
+			    ast->st_ino == st->st_ino && ast->st_dev == st->st_dev)
+				return (FTS_DC);
+		}
+		return (FTS_D);
+	}
+	if (S_ISLNK(st->st_mode))
+		return (FTS_SL);
+	if (S_ISREG(st->st_mode))
+		return (FTS_F);
+
+	return (FTS_DEFAULT);
+}
+
+/* fts_stat() */
+static unsigned short ftsw_stat(OVAL_FTSW *ftsw, OVAL_FTSWENT *ent, bool follow)
+{
+	struct stat *st = &ent->ofts_st;
+	int ret;
+
+	ent->fts_errno = 0;
+
+	if (ent->ofts_pdir != NULL) {
+		struct oval_fts_dent *dent = &ent->ofts_pdir->ent[ent->ofts_eidx];
+
+		if (dent->lst_errno != 0) {
+			ent->fts_errno = dent->lst_errno;
+			memset(st, 0, sizeof *st);
+			return (FTS_NS);
+		}
+
+		if (follow && S_ISLNK(dent->lst.st_mode)) {
+			if (ofts_dir_stat(ent->ofts_pdir, ent->ofts_eidx, st) != 0) {
+				memcpy(st, &dent->lst, sizeof *st);
+				return (FTS_SLNONE);
+			}
+		} else
+			memcpy(st, &dent->lst, sizeof *st);
+
+		return ftsw_classify(ftsw, ent);
+	}
+
+	ofts_stat_count(follow);
+
+	if (follow) {
+		ret = stat(ent->fts_path, st);
+		if (ret != 0) {
+			int errnum = errno;
+
+			ofts_stat_count(false);
+			if (lstat(ent->fts_path, st) == 0)
+				return (FTS_SLNONE);
+			ent->fts_errno = errnum;
+		}
+	} else
+		ret = lstat(ent->fts_path, st);
+
+	if (ret != 0) {
+		if (ent->fts_errno == 0)
+			ent->fts_errno = errno;
+		memset(st, 0, sizeof *st);
+		return (FTS_NS);
+	}
+
+	return ftsw_classify(ftsw, ent);
+}
+
+OVAL_FTSW *oval_ftsw_open(const char *path, int options)
+{
+	OVAL_FTSW *ftsw;
+	OVAL_FTSWENT *root;
+	const char *name;
+	size_t pathlen;
+
+	pathlen = strlen(path);
+	if (pathlen == 0) {
+		errno = ENOENT;
+		return (NULL);
+	}
+
+	ftsw = oscap_talloc(OVAL_FTSW);
+	memset(ftsw, 0, sizeof *ftsw);
+	ftsw->options = options;
+
+	/* the root keeps the path as given, its name is the last component */
+	root = oscap_talloc(OVAL_FTSWENT);
+	memset(root, 0, sizeof *root);
+
+	root->fts_path    = strdup(path);
+	root->fts_pathlen = pathlen;
+	root->fts_statp   = &root->ofts_st;
+	root->ofts_instr  = FTS_NOINSTR;
+	root->fts_level   = 0;
+
+	name = strrchr(path, '/');
+	if (name != NULL && (name != path || name[1] != '\0'))
+		++name;
+	else
+		name = path;
+
+	root->fts_name    = root->fts_path + (name - path);
+	root->fts_namelen = strlen(root->fts_name);
+	root->fts_info    = ftsw_stat(ftsw, root, true);
+
+	ftsw->root = root;
+
+	/* like fts_open(), report a root which can't be stat'ed in errno */
+	errno = root->fts_info == FTS_NS ? root->fts_errno : 0;
+
+	return (ftsw);
+}
+
+static void ftsw_ent_drop(OVAL_FTSW *ftsw, OVAL_FTSWENT *ent)
+{
+	if (ent == ftsw->root)
+		ftsw->root = NULL;
+	OVAL_FTSWENT_free(ent);
+}
+
+static void ftsw_pop(OVAL_FTSW *ftsw)
+{
+	OVAL_FTSWFRAME *frame = &ftsw->stack[--ftsw->depth];
+
+	ofts_dir_release(frame->dir);
+	ftsw_ent_drop(ftsw, frame->ent);
+}
+
+OVAL_FTSWENT *oval_ftsw_read(OVAL_FTSW *ftsw)
+{
+	OVAL_FTSWENT *ent = ftsw->cur;
+	int instr;
+
+	if (ent == NULL) {
+		if (ftsw->started || ftsw->root == NULL)
+			return (NULL);
+
+		ftsw->started = true;
+		ent = ftsw->cur = ftsw->root;
+		if (ent->fts_info == FTS_D)
+			ftsw->rootdev = ent->ofts_st.st_dev;
+
+		return (ent);
+	}
+
+	if (ftsw->cur_done) {
+		/* the post-order visit of the top directory */
+		ftsw->cur_done = false;
+		ftsw_pop(ftsw);
+	} else {
+		instr = ent->ofts_instr;
+		ent->ofts_instr = FTS_NOINSTR;
+
+		if (instr == FTS_AGAIN) {
+			ent->fts_info = ftsw_stat(ftsw, ent, false);
+			return (ent);
+		}
+
+		if (instr == FTS_FOLLOW && (ent->fts_info == FTS_SL || ent->fts_info == FTS_SLNONE)) {
+			ent->fts_info = ftsw_stat(ftsw, ent, true);
+			return (ent);
+		}
+
+		if (ent->fts_info == FTS_D) {
+			OVAL_FTSDIR *dir;
+
+			if (instr == FTS_SKIP ||
+			    ((ftsw->options & FTS_XDEV) && ent->ofts_st.st_dev != ftsw->rootdev)) {
+				ent->fts_info = FTS_DP;
+				return (ent);
+			}
+
+			dir = ofts_dir_get(ent->fts_path);
+			if (dir == NULL) {
+				ent->fts_info  = FTS_DNR;
+				ent->fts_errno = errno;
+				return (ent);
+			}
+
+			if (dir->count == 0) {
+				ofts_dir_release(dir);
+				ent->fts_info = FTS_DP;
+				return (ent);
+			}
+
+			if (ftsw->depth == ftsw->stack_size) {
+				ftsw->stack_size = ftsw->stack_size == 0 ? 16 : ftsw->stack_size * 2;
+				ftsw->stack = oscap_realloc(ftsw->stack, sizeof(OVAL_FTSWFRAME) * ftsw->stack_size);
+			}
+
+			ftsw->stack[ftsw->depth].ent  = ent;
+			ftsw->stack[ftsw->depth].dir  = dir;
+			ftsw->stack[ftsw->depth].next = 0;
+			++ftsw->depth;
+		} else
+			ftsw_ent_drop(ftsw, ent);
+	}
+
+	ftsw->cur = NULL;
+
+	if (ftsw->depth > 0) {
+		OVAL_FTSWFRAME *frame = &ftsw->stack[ftsw->depth - 1];
+
+		if (frame->next < frame->dir->count) {
+			struct oval_fts_dent *dent = &frame->dir->ent[frame->next];
+			const char *name = frame->dir->names + dent->name;
+
+			ent = OVAL_FTSWENT_new(frame->ent->fts_path, frame->ent->fts_pathlen,
+					       name, strlen(name), frame->ent->fts_level + 1);
+			ent->ofts_pdir = frame->dir;
+			ent->ofts_eidx = frame->next++;
+			ent->fts_info  = ftsw_stat(ftsw, ent, false);
+		} else {
+			ent = frame->ent;
+			ent->fts_info  = FTS_DP;
+			ftsw->cur_done = true;
+		}
+
+		ftsw->cur = ent;
+		return (ent);
+	}
+
+	return (NULL);
+}
+
+int oval_ftsw_set(OVAL_FTSW *ftsw, OVAL_FTSWENT *ent, int instr)
+{
+	(void)ftsw;
+
+	if (ent == NULL)
+		return (0);
+
+	if (instr != FTS_AGAIN && instr != FTS_FOLLOW &&
+	    instr != FTS_NOINSTR && instr != FTS_SKIP) {
+		errno = EINVAL;
+		return (1);
+	}
+
+	ent->ofts_instr = instr;
+	return (0);
+}
+
+int oval_ftsw_close(OVAL_FTSW *ftsw)
+{
+	if (ftsw == NULL)
+		return (0);
+
+	while (ftsw->depth > 0) {
+		if (ftsw->stack[ftsw->depth - 1].ent == ftsw->cur)
+			ftsw->cur = NULL;
+		ftsw_pop(ftsw);
+	}
+
+	if (ftsw->cur != NULL)
+		ftsw_ent_drop(ftsw, ftsw->cur);
+	if (ftsw->root != NULL)
+		OVAL_FTSWENT_free(ftsw->root);
+
+	oscap_free(ftsw->stack);
+	oscap_free(ftsw);
+
+	return (0);
+}
@@ -0,0 +1,163 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef OVAL_FTS_WALK_H
+#define OVAL_FTS_WALK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined(__SVR4) && defined(__sun)
+#include "fts_sun.h"
+#else
+#include <fts.h>
+#endif
+
+/*
+ * Shared directory tree walker used by oval_fts.
+ *
+ * Every object of the file based probes used to open its own fts(3)
+ * walk, so objects with the same (or overlapping) path and recursion
+ * behaviors read the same directories over and over. The walker below
+ * implements the subset of the fts(3) interface used by oval_fts
+ * (FTS_PHYSICAL | FTS_COMFOLLOW | FTS_NOCHDIR [| FTS_XDEV], fts_set()
+ * with FTS_SKIP, FTS_FOLLOW and FTS_AGAIN) on top of a cache of
+ * directory listings shared by all walks in the process. A directory
+ * is read (opendir + readdir + lstat of each entry) by the first walk
+ * which enters it and every later walk of any object is served from
+ * memory, so a set of objects costs one traversal per root.
+ *
+ * A cached listing is used only if the directory's device, inode,
+ * modification and change time match the ones seen by the walker.
+ * The cache is limited by OSCAP_PROBE_FTS_CACHE_SIZE (bytes, 0
+ * disables the cache). Once the limit is reached, new directories
+ * are still read but not kept.
+ *
+ * Recursive walks can fill the cache in parallel before they start
+ * (oval_ftsw_prefetch()). Each directory is a task; the tasks found
+ * by a thread go to its own queue and idle threads steal from the
+ * others. The number of threads is set by OSCAP_PROBE_FTS_THREADS
+ * (1 disables the prefetch), the default is the number of online
+ * CPUs up to OVAL_FTS_WALK_DEFAULT_THREADS.
+ */
+
+#ifndef OVAL_FTS_CACHE_DEFAULT_SIZE
+#define OVAL_FTS_CACHE_DEFAULT_SIZE (64 * 1024 * 1024) /* bytes */
+#endif
+
+#ifndef OVAL_FTS_WALK_DEFAULT_THREADS
+#define OVAL_FTS_WALK_DEFAULT_THREADS 4
+#endif
+
+#ifndef OVAL_FTS_WALK_MAX_THREADS
+#define OVAL_FTS_WALK_MAX_THREADS 64
+#endif
+
+typedef struct {
+	uint64_t dir_reads;  /* directories read from the filesystem (opendir + readdir) */
+	uint64_t dir_hits;   /* directories served from the cache */
+	uint64_t lstat;      /* lstat() calls */
+	uint64_t stat;       /* stat() calls */
+	uint64_t prefetched; /* directories read by oval_ftsw_prefetch() */
+	uint64_t steals;     /* tasks taken from the queue of another thread */
+	uint64_t dir_count;  /* directories kept in the cache */
+	size_t   size;       /* memory used by the cache */
+	size_t   max_size;
+} oval_fts_cache_stats_t;
+
+typedef struct oval_fts_dir OVAL_FTSDIR;
+
+typedef struct OVAL_FTSWENT {
+	char        *fts_path;    /* path of the entry */
+	int          fts_pathlen;
+	char        *fts_name;    /* file name, points into fts_path */
+	int          fts_namelen;
+	short        fts_level;   /* depth, the root has level 0 */
+	unsigned short fts_info;  /* FTS_D, FTS_F, FTS_SL, ... */
+	int          fts_errno;
+	struct stat *fts_statp;
+
+	/* walker private */
+	struct stat  ofts_st;
+	int          ofts_instr;
+	uint32_t     ofts_eidx;   /* index in the parent listing */
+	OVAL_FTSDIR *ofts_pdir;   /* parent listing */
+} OVAL_FTSWENT;
+
+typedef struct {
+	OVAL_FTSWENT *ent;  /* directory */
+	OVAL_FTSDIR  *dir;  /* its listing */
+	uint32_t      next; /* next entry of the listing to visit */
+} OVAL_FTSWFRAME;
+
+typedef struct {
+	int             options;
+	dev_t           rootdev;
+	OVAL_FTSWENT   *root;
+	OVAL_FTSWENT   *cur;      /* last returned entry */
+	bool            cur_done; /* cur was returned as FTS_DP and is popped on the next read */
+	bool            started;
+	OVAL_FTSWFRAME *stack;
+	size_t          depth;
+	size_t          stack_size;
+} OVAL_FTSW;
+
+/**
+ * Open a walk of the tree rooted at `path'. Only FTS_XDEV is honored
+ * in `options', the walk always behaves as if FTS_PHYSICAL,
+ * FTS_COMFOLLOW and FTS_NOCHDIR were set.
+ * @return walker or NULL if `path' is empty
+ */
+OVAL_FTSW *oval_ftsw_open(const char *path, int options);
+
+/**
+ * Return the next entry of the walk in the fts_read(3) order. The
+ * entry is valid until the next call on the same walker.
+ */
+OVAL_FTSWENT *oval_ftsw_read(OVAL_FTSW *ftsw);
+
+/**
+ * Set FTS_SKIP, FTS_FOLLOW or FTS_AGAIN for the last returned entry.
+ */
+int oval_ftsw_set(OVAL_FTSW *ftsw, OVAL_FTSWENT *ent, int instr);
+
+int oval_ftsw_close(OVAL_FTSW *ftsw);
+
+/**
+ * Decide whether a walk enters the directory `path' at depth `level'.
+ * `st' describes the directory, `symlink' is set if it was reached
+ * through a symbolic link. Called from several threads at once.
+ */
+typedef bool (*oval_ftsw_descend_t)(void *arg, const char *path, const struct stat *st, int level, bool symlink);
+
+/**
+ * Read the directories of the tree rooted at `path' which a walk
+ * would enter into the cache, using several threads. A tree is read
+ * only once for the same `key' (the options which affect `descend').
+ * Does nothing if the cache or the threads are disabled.
+ */
+void oval_ftsw_prefetch(const char *path, const char *key, oval_ftsw_descend_t descend, void *arg);
+
+/**
+ * Drop all cached directories. Walks which are in progress keep the
+ * listings they use until they are closed.
+ */
+void oval_fts_cache_reset(void);
+
+void oval_fts_cache_stats(oval_fts_cache_stats_t *stats);
+
+#endif /* OVAL_FTS_WALK_H */
@@ -106,7 +106,7 @@ SEXP_t *probe_item_new(const char *name, SEXP_t * attrs)
 
         /*
          * Allocate space for the ID which will be generated
-         * in the icache worker
+         * by the item cache
          */
 	sid  = SEXP_string_new("", 0);
 	attr = probe_attr_creat("id", sid, NULL);
@@ -655,6 +655,30 @@ int probe_cobj_add_item(SEXP_t *cobj, const SEXP_t *item)
 	return 0;
 }
 
+int probe_cobj_add_items(SEXP_t *cobj, SEXP_t *items[], size_t count)
+{
+	SEXP_t *lst, **oitems;
+	size_t i;
+
+	if (count == 0)
+		return 0;
+
+	oitems = oscap_alloc(sizeof(SEXP_t *) * count);
+
+	for (i = 0; i < count; ++i)
+		oitems[i] = probe_item_optimize(items[i]);
+
+	lst = SEXP_listref_nth(cobj, 3);
+	SEXP_list_add_array(lst, oitems, count);
+	SEXP_free(lst);
+
+	for (i = 0; i < count; ++i)
+		SEXP_free(oitems[i]);
+	oscap_free(oitems);
+
+	return 0;
+}
+
 SEXP_t *probe_cobj_get_items(const SEXP_t *cobj)
 {
 	return SEXP_list_nth(cobj, 3);
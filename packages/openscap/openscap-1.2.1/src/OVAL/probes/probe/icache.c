@@ -30,7 +30,6 @@
 #include <string.h>
 #include <inttypes.h>
 
-#include "../SEAP/generic/rbt/rbt.h"
 #include "probe-api.h"
 #include "common/debug_priv.h"
 #include "common/memusage.h"
@@ -84,370 +83,260 @@ static void probe_icache_item_setID(SEXP_t *item, SEXP_ID_t item_ID)
         return;
 }
 
-static void *probe_icache_worker(void *arg)
+/*
+ * Look up an item in the shard and add it if it's not there. Returns the
+ * cached item on a hit, `item' otherwise. Must be called with the shard
+ * mutex locked.
+ */
+static SEXP_t *probe_icache_shard_lookup(probe_icache_shard_t *shard, SEXP_ID_t item_ID, SEXP_t *item)
 {
-        probe_icache_t *cache = (probe_icache_t *)(arg);
-        probe_iqpair_t *pair, pair_mem;
-        SEXP_ID_t       item_ID;
-
-        assume_d(cache != NULL, NULL);
+        probe_citem_t *cached;
+        uint32_t       b;
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s\n",
-                   errno, strerror(errno));
-                return (NULL);
-        }
+        b = (uint32_t)item_ID & (shard->size - 1);
 
-	pair = &pair_mem;
-        dI("icache worker ready\n");
-
-        switch (errno = pthread_barrier_wait(&OSCAP_GSYM(th_barrier)))
-        {
-        case 0:
-        case PTHREAD_BARRIER_SERIAL_THREAD:
-	        break;
-        default:
-	        dE("pthread_barrier_wait: %d, %s.\n",
-	           errno, strerror(errno));
-	        pthread_mutex_unlock(&cache->queue_mutex);
-	        return (NULL);
-        }
+        for (cached = shard->bucket[b]; cached != NULL; cached = cached->next)
+                if (cached->id == item_ID)
+                        break;
 
-        while(pthread_cond_wait(&cache->queue_notempty, &cache->queue_mutex) == 0) {
-                assume_d(cache->queue_cnt > 0, NULL);
-        next:
-                dI("Extracting item from the cache queue: cnt=%"PRIu16", beg=%"PRIu16"\n", cache->queue_cnt, cache->queue_beg);
+        if (cached != NULL) {
+                register uint16_t i;
+                SEXP_t   rest1, rest2;
                 /*
-                 * Extract an item from the queue and update queue beg, end & cnt
+                 * Maybe a cache HIT
                  */
-                pair_mem = cache->queue[cache->queue_beg];
-#ifndef NDEBUG
-		memset(cache->queue + cache->queue_beg, 0, sizeof(probe_iqpair_t));
-#endif
-                --cache->queue_cnt;
-		++cache->queue_beg;
-
-		if (cache->queue_beg == cache->queue_max)
-			cache->queue_beg = 0;
-
-		assume_d(cache->queue_cnt == 0 ?
-			 cache->queue_end == cache->queue_beg :
-			 cache->queue_end != cache->queue_beg, NULL);
+                dI("cache HIT #1\n");
+
+                for (i = 0; i < cached->count; ++i) {
+                        if (SEXP_deepcmp(SEXP_list_rest_r(&rest1, item),
+                                         SEXP_list_rest_r(&rest2, cached->item[i])))
+                        {
+                                SEXP_free_r(&rest1);
+                                SEXP_free_r(&rest2);
+                                break;
+                        }
 
-                /*
-                 * Release the mutex
-                 */
-                if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while unlocking the queue mutex: %u, %s\n",
-                           errno, strerror(errno));
-                        abort();
+                        SEXP_free_r(&rest1);
+                        SEXP_free_r(&rest2);
                 }
 
-                dI("Signaling `notfull'\n");
+                if (i < cached->count) {
+                        dI("cache HIT #2 -> real HIT\n");
+                        ++shard->hits;
 
-                if (pthread_cond_signal(&cache->queue_notfull) != 0) {
-                        dE("An error ocured while signaling the `notfull' condition: %u, %s\n",
-                           errno, strerror(errno));
-                        abort();
+                        return (cached->item[i]);
                 }
 
-                if (pair->cobj == NULL) {
-                        /*
-                         * Handle NOP case (synchronization)
-                         */
-                        assume_d(pair->p.cond != NULL, NULL);
-
-                        dI("Handling NOP\n");
+                dI("cache MISS (collision)\n");
+                ++shard->collisions;
 
-                        if (pthread_cond_signal(pair->p.cond) != 0) {
-                                dE("An error ocured while signaling NOP condition: %u, %s\n",
-                                   errno, strerror(errno));
-                                abort();
-                        }
-                } else {
-                        probe_citem_t *cached = NULL;
+                cached->item = oscap_realloc(cached->item, sizeof(SEXP_t *) * ++cached->count);
+                cached->item[cached->count - 1] = item;
+        } else {
+                dI("cache MISS\n");
 
-                        dI("Handling cache request\n");
+                cached = oscap_talloc(probe_citem_t);
+                cached->id    = item_ID;
+                cached->item  = oscap_talloc(SEXP_t *);
+                cached->item[0] = item;
+                cached->count = 1;
+                cached->next  = shard->bucket[b];
+                shard->bucket[b] = cached;
 
+                if (++shard->count > 2 * shard->size) {
                         /*
-                         * Compute item ID
+                         * Double the number of buckets
                          */
-                        item_ID = SEXP_ID_v(pair->p.item);
-                        dI("item ID=%"PRIu64"\n", item_ID);
+                        probe_citem_t **bucket;
+                        uint32_t i, size = shard->size * 2;
 
-                        /*
-                         * Perform cache lookup
-                         */
-                        if (rbt_i64_get(cache->tree, (int64_t)item_ID, (void *)&cached) == 0) {
-                                register uint16_t i;
-				SEXP_t   rest1, rest2;
-                                /*
-                                 * Maybe a cache HIT
-                                 */
-                                dI("cache HIT #1\n");
-
-                                for (i = 0; i < cached->count; ++i) {
-                                        if (SEXP_deepcmp(SEXP_list_rest_r(&rest1, pair->p.item),
-							 SEXP_list_rest_r(&rest2, cached->item[i])))
-					{
-						SEXP_free_r(&rest1);
-						SEXP_free_r(&rest2);
-                                                break;
-					}
-
-					SEXP_free_r(&rest1);
-					SEXP_free_r(&rest2);
-                                }
+                        bucket = oscap_alloc(sizeof(probe_citem_t *) * size);
+                        memset(bucket, 0, sizeof(probe_citem_t *) * size);
 
-                                if (i == cached->count) {
-                                        /*
-                                         * Cache MISS
-                                         */
-                                        dI("cache MISS\n");
-
-                                        cached->item = oscap_realloc(cached->item, sizeof(SEXP_t *) * ++cached->count);
-                                        cached->item[cached->count - 1] = pair->p.item;
-
-                                        /* Assign an unique item ID */
-                                        probe_icache_item_setID(pair->p.item, item_ID);
-                                } else {
-                                        /*
-                                         * Cache HIT
-                                         */
-                                        dI("cache HIT #2 -> real HIT\n");
-                                        SEXP_free(pair->p.item);
-                                        pair->p.item = cached->item[i];
-                                }
-                        } else {
-                                /*
-                                 * Cache MISS
-                                 */
-                                dI("cache MISS\n");
-                                cached = oscap_talloc(probe_citem_t);
-                                cached->item = oscap_talloc(SEXP_t *);
-                                cached->item[0] = pair->p.item;
-                                cached->count = 1;
-
-                                /* Assign an unique item ID */
-                                probe_icache_item_setID(pair->p.item, item_ID);
-
-                                if (rbt_i64_add(cache->tree, (int64_t)item_ID, (void *)cached, NULL) != 0) {
-                                        dE("Can't add item (k=%"PRIi64" to the cache (%p)\n", (int64_t)item_ID, cache->tree);
-
-                                        oscap_free(cached->item);
-                                        oscap_free(cached);
-
-                                        /* now what? */
-                                        abort();
+                        for (i = 0; i < shard->size; ++i) {
+                                while (shard->bucket[i] != NULL) {
+                                        cached = shard->bucket[i];
+                                        shard->bucket[i] = cached->next;
+
+                                        b = (uint32_t)cached->id & (size - 1);
+                                        cached->next = bucket[b];
+                                        bucket[b] = cached;
                                 }
                         }
 
-                        if (probe_cobj_add_item(pair->cobj, pair->p.item) != 0) {
-                            dW("An error ocured while adding the item to the collected object\n");
-                        }
+                        oscap_free(shard->bucket);
+                        shard->bucket = bucket;
+                        shard->size   = size;
                 }
+        }
 
-                if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while re-locking the queue mutex: %u, %s\n",
-                           errno, strerror(errno));
-                        abort();
-                }
+        ++shard->misses;
 
-                if (cache->queue_cnt > 0)
-                        goto next;
-        }
+        /* Assign an unique item ID */
+        probe_icache_item_setID(item, item_ID);
 
-        return (NULL);
+        return (item);
 }
 
 probe_icache_t *probe_icache_new(void)
 {
         probe_icache_t *cache;
+        uint32_t i;
 
         cache = oscap_talloc(probe_icache_t);
-        cache->tree = rbt_i64_new();
-
-        if (pthread_mutex_init(&cache->queue_mutex, NULL) != 0) {
-                dE("Can't initialize icache mutex: %u, %s\n", errno, strerror(errno));
-                goto fail;
-        }
 
-        cache->queue_beg = 0;
-        cache->queue_end = 0;
-        cache->queue_cnt = 0;
-        cache->queue_max = PROBE_IQUEUE_CAPACITY;
+        for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+                probe_icache_shard_t *shard = cache->shard + i;
 
-        if (pthread_cond_init(&cache->queue_notempty, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (notempty): %u, %s\n",
-                   errno, strerror(errno));
-                goto fail;
-        }
+                if (pthread_mutex_init(&shard->mutex, NULL) != 0) {
+                        dE("Can't initialize icache mutex: %u, %s\n", errno, strerror(errno));
+                        goto fail;
+                }
 
-        if (pthread_cond_init(&cache->queue_notfull, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (notfull): %u, %s\n",
-                   errno, strerror(errno));
-                goto fail;
-        }
+                shard->size   = PROBE_ICACHE_SHARD_INITSIZE;
+                shard->count  = 0;
+                shard->bucket = oscap_alloc(sizeof(probe_citem_t *) * shard->size);
+                memset(shard->bucket, 0, sizeof(probe_citem_t *) * shard->size);
 
-        if (pthread_create(&cache->thid, NULL,
-                           probe_icache_worker, (void *)cache) != 0)
-        {
-                dE("Can't start the icache worker: %u, %s\n", errno, strerror(errno));
-                goto fail;
+                shard->hits       = 0;
+                shard->misses     = 0;
+                shard->collisions = 0;
         }
 
         return (cache);
 fail:
-        if (cache->tree != NULL)
-                rbt_i64_free(cache->tree);
+        while (i-- > 0) {
+                pthread_mutex_destroy(&cache->shard[i].mutex);
+                oscap_free(cache->shard[i].bucket);
+        }
 
-        pthread_mutex_destroy(&cache->queue_mutex);
-        pthread_cond_destroy(&cache->queue_notempty);
         oscap_free(cache);
 
         return (NULL);
 }
 
-static int __probe_icache_add_nolock(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item, pthread_cond_t *cond)
+/*
+ * Return the cached item equal to `item', `item' itself if there is
+ * none. `item' is freed if it's not the returned one. Must be called
+ * with cancelation disabled.
+ */
+static SEXP_t *probe_icache_get(probe_icache_t *cache, SEXP_t *item)
 {
-        assume_d((cond == NULL) ^ (item == NULL), -1);
-retry:
-        if (cache->queue_cnt < cache->queue_max) {
-                cache->queue[cache->queue_end].cobj = cobj;
-
-                if (item != NULL) {
-			assume_d(cobj != NULL, -1);
-                        cache->queue[cache->queue_end].p.item = item;
-                } else {
-			assume_d(item == NULL && cobj == NULL, -1);
-                        cache->queue[cache->queue_end].p.cond = cond;
-		}
+        probe_icache_shard_t *shard;
+        SEXP_ID_t item_ID;
+        SEXP_t   *cached;
 
-                ++cache->queue_cnt;
-		++cache->queue_end;
+        item_ID = SEXP_ID_fast(item);
+        dI("item ID=%"PRIu64"\n", item_ID);
 
-                if (cache->queue_end == cache->queue_max)
-                        cache->queue_end = 0;
-        } else {
-                /*
-                 * The queue is full, we have to wait
-                 */
-                if (pthread_cond_wait(&cache->queue_notfull, &cache->queue_mutex) == 0)
-                        goto retry;
-                else {
-                        dE("An error ocured while waiting for the `notfull' queue condition: %u, %s\n",
-                           errno, strerror(errno));
-                        return (-1);
-                }
-        }
+        /* use the upper bits, the lower ones select the bucket */
+        shard = cache->shard + (item_ID >> 32) % PROBE_ICACHE_SHARDS;
 
-        return (0);
-}
-
-int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
-{
-        int ret;
-
-        if (cache == NULL || cobj == NULL || item == NULL)
-                return (-1); /* XXX: EFAULT */
-
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s\n",
+        if (pthread_mutex_lock(&shard->mutex) != 0) {
+                dE("An error ocured while locking the icache shard mutex: %u, %s\n",
                    errno, strerror(errno));
-                return (-1);
+                return (NULL);
         }
 
-        ret = __probe_icache_add_nolock(cache, cobj, item, NULL);
+        cached = probe_icache_shard_lookup(shard, item_ID, item);
 
-        if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while unlocking the queue mutex: %u, %s\n",
+        if (pthread_mutex_unlock(&shard->mutex) != 0) {
+                dE("An error ocured while unlocking the icache shard mutex: %u, %s\n",
                    errno, strerror(errno));
                 abort();
         }
 
-        if (ret != 0)
-                return (-1);
-
-        if (pthread_cond_signal(&cache->queue_notempty) != 0) {
-                dE("An error ocured while signaling the `notempty' condition: %u, %s\n",
-                   errno, strerror(errno));
-                return (-1);
-        }
+        if (cached != item)
+                SEXP_free(item);
 
-        return (0);
+        return (cached);
 }
 
-int probe_icache_nop(probe_icache_t *cache)
+/*
+ * Add the item to the collected object. An equal item which is already
+ * in the cache is used instead of the new one so that the same items
+ * found by different objects get the same ID.
+ */
+int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
 {
-        pthread_cond_t cond;
-
-        dI("NOP\n");
+        SEXP_t *cached;
+        int     cstate, ret, unused;
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s\n",
-                   errno, strerror(errno));
-                return (-1);
-        }
+        if (cache == NULL || cobj == NULL || item == NULL)
+                return (-1); /* XXX: EFAULT */
 
-        if (pthread_cond_init(&cond, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (NOP): %u, %s\n",
-                   errno, strerror(errno));
-                return (-1);
-        }
+        /*
+         * probe_main() runs with asynchronous cancelation enabled. Don't
+         * let the thread be canceled while it holds the shard lock.
+         */
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cstate);
 
-        if (__probe_icache_add_nolock(cache, NULL, NULL, &cond) != 0) {
-                if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while unlocking the queue mutex: %u, %s\n",
-                           errno, strerror(errno));
-                        abort();
-                }
+        cached = probe_icache_get(cache, item);
 
-                pthread_cond_destroy(&cond);
+        if (cached == NULL) {
+                pthread_setcancelstate(cstate, &unused);
                 return (-1);
         }
 
-        dI("Signaling `notempty'\n");
+        ret = probe_cobj_add_item(cobj, cached);
+        pthread_setcancelstate(cstate, &unused);
 
-        if (pthread_cond_signal(&cache->queue_notempty) != 0) {
-                dE("An error ocured while signaling the `notempty' condition: %u, %s\n",
-                   errno, strerror(errno));
-
-                pthread_cond_destroy(&cond);
-                return (-1);
+        if (ret != 0) {
+                dW("An error ocured while adding the item to the collected object\n");
         }
 
-        dI("Waiting for icache worker to handle the NOP\n");
+        return (0);
+}
 
-        if (pthread_cond_wait(&cond, &cache->queue_mutex) != 0) {
-                dE("An error ocured while waiting for the `NOP' queue condition: %u, %s\n",
-                   errno, strerror(errno));
-                return (-1);
-        }
+/*
+ * Items are added to the collected object directly by probe_icache_add,
+ * so there's nothing to wait for. Kept for the callers that need to be
+ * sure all items were added before modifying the collected object.
+ */
+int probe_icache_nop(probe_icache_t *cache)
+{
+        dI("NOP\n");
+        return (0);
+}
 
-        dI("Sync\n");
+void probe_icache_stats(probe_icache_t *cache, probe_icache_stats_t *stats)
+{
+        uint32_t i;
 
-        if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while unlocking the queue mutex: %u, %s\n",
-                   errno, strerror(errno));
-                abort();
-        }
+        stats->hits       = 0;
+        stats->misses     = 0;
+        stats->collisions = 0;
 
-        pthread_cond_destroy(&cond);
+        for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+                probe_icache_shard_t *shard = cache->shard + i;
 
-        return (0);
+                pthread_mutex_lock(&shard->mutex);
+                stats->hits       += shard->hits;
+                stats->misses     += shard->misses;
+                stats->collisions += shard->collisions;
+                pthread_mutex_unlock(&shard->mutex);
+        }
 }
 
 #define PROBE_RESULT_MEMCHECK_CTRESHOLD  32768  /* item count */
+#define PROBE_RESULT_MEMCHECK_INTERVAL   1024   /* item count */
 #define PROBE_RESULT_MEMCHECK_MINFREEMEM 512    /* MiB */
 #define PROBE_RESULT_MEMCHECK_MAXRATIO   0.8   /* max. memory usage ratio - used/total */
 
 /**
  * Returns 0 if the memory constraints are not reached. Otherwise, 1 is returned.
  * In case of an error, -1 is returned.
+ *
+ * The memory usage is read once per PROBE_RESULT_MEMCHECK_INTERVAL items,
+ * i.e. when the `item_add' items to be added to the `item_cnt' ones may
+ * cross a multiple of the interval.
  */
-static int probe_cobj_memcheck(size_t item_cnt)
+static int probe_cobj_memcheck(size_t item_cnt, size_t item_add)
 {
-	if (item_cnt > PROBE_RESULT_MEMCHECK_CTRESHOLD) {
+	if (item_cnt > PROBE_RESULT_MEMCHECK_CTRESHOLD
+	    && (item_cnt % PROBE_RESULT_MEMCHECK_INTERVAL == 0
+	        || item_cnt / PROBE_RESULT_MEMCHECK_INTERVAL != (item_cnt + item_add) / PROBE_RESULT_MEMCHECK_INTERVAL))
+	{
 		struct proc_memusage mu_proc;
 		struct sys_memusage  mu_sys;
 		double c_ratio;
@@ -478,6 +367,44 @@ static int probe_cobj_memcheck(size_t item_cnt)
 	return (0);
 }
 
+int probe_chunk_send(struct probe_ctx *ctx)
+{
+	SEXP_t *chunk, *mask;
+	SEAP_msg_t *msg;
+	int ret;
+
+	assume_d(ctx->msg != NULL, -1);
+
+	if (ctx->chunk == NULL)
+		return (0);
+
+	mask  = probe_cobj_get_mask(ctx->probe_out);
+	chunk = probe_cobj_new(SYSCHAR_FLAG_UNKNOWN, NULL, ctx->chunk, mask);
+
+	msg = SEAP_msg_new();
+	SEAP_msg_set(msg, chunk);
+
+	if (SEAP_msgattr_set(msg, "chunk", NULL) != 0) {
+		dE("Can't set the chunk attribute\n");
+		ret = -1;
+	} else if (SEAP_reply(ctx->probe->SEAP_ctx, ctx->probe->sd, msg, ctx->msg) != 0) {
+		dE("Can't send a chunk of %zu items: %u, %s\n",
+		   ctx->chunk_len, errno, strerror(errno));
+		ret = -1;
+	} else {
+		++ctx->chunks;
+		ret = 0;
+	}
+
+	SEAP_msg_free(msg);
+	SEXP_vfree(chunk, mask, ctx->chunk, NULL);
+
+	ctx->chunk     = NULL;
+	ctx->chunk_len = 0;
+
+	return (ret);
+}
+
 /**
  * Collect an item
  * This function adds an item the collected object assosiated
@@ -491,22 +418,41 @@ static int probe_cobj_memcheck(size_t item_cnt)
  *-1 ... unexpected/internal error
  *
  * The caller must not free the item, it's freed automatically
- * by this function or by the icache worker thread.
+ * by this function or by the item cache.
  */
 int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
+{
+	assume_d(item != NULL, -1);
+
+	return probe_item_collect_batch(ctx, &item, 1);
+}
+
+/**
+ * Collect `count' items, see probe_item_collect. The memory
+ * constraints are checked once for all of them and the items
+ * which aren't filtered out are added to the collected object
+ * at once. 1 is returned if all the items were filtered out.
+ *
+ * The contents of `items' is undefined after the call.
+ */
+int probe_item_collect_batch(struct probe_ctx *ctx, SEXP_t *items[], size_t count)
 {
 	SEXP_t *cobj_content;
-	size_t  cobj_itemcnt;
+	size_t  cobj_itemcnt, i, n;
+	int     cstate, unused, ret;
 
 	assume_d(ctx != NULL, -1);
 	assume_d(ctx->probe_out != NULL, -1);
-	assume_d(item != NULL, -1);
+	assume_d(items != NULL, -1);
+
+	if (count == 0)
+		return (0);
 
 	cobj_content = SEXP_listref_nth(ctx->probe_out, 3);
 	cobj_itemcnt = SEXP_list_length(cobj_content);
 	SEXP_free(cobj_content);
 
-	if (probe_cobj_memcheck(cobj_itemcnt) != 0) {
+	if (probe_cobj_memcheck(cobj_itemcnt, count) != 0) {
 
 		/*
 		 * Don't set the message again if the collected object is
@@ -519,7 +465,7 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 			 * collected object.
 			 */
 			if (probe_icache_nop(ctx->icache) != 0)
-				return -1;
+				goto fail;
 
 			msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_WARNING,
 			                      "Object is incomplete due to memory constraints.");
@@ -530,48 +476,103 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 			SEXP_free(msg);
 		}
 
+		for (i = 0; i < count; ++i)
+			SEXP_free(items[i]);
+
 		return 2;
 	}
 
-        if (ctx->filters != NULL && probe_item_filtered(item, ctx->filters)) {
-                SEXP_free(item);
+	/*
+	 * Move the items which aren't filtered out to the beginning
+	 * of the array and replace them with the cached ones.
+	 */
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cstate);
+
+	for (i = 0, n = 0; i < count; ++i) {
+		SEXP_t *cached;
+
+		if (ctx->filters != NULL && probe_item_filtered(items[i], ctx->filters)) {
+			SEXP_free(items[i]);
+			continue;
+		}
+
+		cached = probe_icache_get(ctx->icache, items[i]);
+
+		if (cached == NULL) {
+			dE("Can't add item (%p) to the item cache (%p)\n", items[i], ctx->icache);
+
+			while (i < count)
+				SEXP_free(items[i++]);
+
+			pthread_setcancelstate(cstate, &unused);
+			return (-1);
+		}
+
+		items[n++] = cached;
+	}
+
+	if (n == 0) {
+		pthread_setcancelstate(cstate, &unused);
 		return (1);
-        }
+	}
 
-        if (probe_icache_add(ctx->icache, ctx->probe_out, item) != 0) {
-                dE("Can't add item (%p) to the item cache (%p)\n", item, ctx->icache);
-                SEXP_free(item);
-                return (-1);
-        }
+	if (probe_cobj_add_items(ctx->probe_out, items, n) != 0)
+		dW("An error ocured while adding the items to the collected object\n");
 
-        return (0);
-}
+	ret = 0;
 
-static void probe_icache_free_node(struct rbt_i64_node *n)
-{
-        probe_citem_t *ci = (probe_citem_t *)n->data;
+	if (ctx->msg != NULL) {
+		if (ctx->chunk == NULL)
+			ctx->chunk = SEXP_list_new(NULL);
 
-        while (ci->count > 0) {
-                SEXP_free(ci->item[ci->count - 1]);
-                --ci->count;
-        }
+		SEXP_list_add_array(ctx->chunk, items, n);
+		ctx->chunk_len += n;
 
-        oscap_free(ci->item);
-        oscap_free(ci);
-        return;
+		if (ctx->chunk_len >= PROBE_CHUNK_ITEMS && probe_chunk_send(ctx) != 0)
+			ret = -1;
+	}
+
+	pthread_setcancelstate(cstate, &unused);
+
+	return (ret);
+fail:
+	for (i = 0; i < count; ++i)
+		SEXP_free(items[i]);
+
+	return (-1);
 }
 
 void probe_icache_free(probe_icache_t *cache)
 {
-        void *ret = NULL;
+        probe_icache_stats_t stats;
+        probe_citem_t *ci;
+        uint32_t i, b;
 
-        pthread_cancel(cache->thid);
-        pthread_join(cache->thid, &ret);
-        pthread_mutex_destroy(&cache->queue_mutex);
-        pthread_cond_destroy(&cache->queue_notempty);
-        pthread_cond_destroy(&cache->queue_notfull);
+        probe_icache_stats(cache, &stats);
+        dI("icache stats: hits=%"PRIu64", misses=%"PRIu64", collisions=%"PRIu64"\n",
+           stats.hits, stats.misses, stats.collisions);
+
+        for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+                probe_icache_shard_t *shard = cache->shard + i;
+
+                for (b = 0; b < shard->size; ++b) {
+                        while ((ci = shard->bucket[b]) != NULL) {
+                                shard->bucket[b] = ci->next;
+
+                                while (ci->count > 0) {
+                                        SEXP_free(ci->item[ci->count - 1]);
+                                        --ci->count;
+                                }
+
+                                oscap_free(ci->item);
+                                oscap_free(ci);
+                        }
+                }
+
+                pthread_mutex_destroy(&shard->mutex);
+                oscap_free(shard->bucket);
+        }
 
-        rbt_i64_free_cb(cache->tree, &probe_icache_free_node);
         oscap_free(cache);
         return;
 }
@@ -23,44 +23,54 @@
 #define ICACHE_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
 #include <sexp.h>
-#include "../SEAP/generic/rbt/rbt.h"
 
-#ifndef PROBE_IQUEUE_CAPACITY
-#define PROBE_IQUEUE_CAPACITY 1024
+#ifndef PROBE_ICACHE_SHARDS
+#define PROBE_ICACHE_SHARDS 64 /* must be a power of 2 */
 #endif
 
-typedef struct {
-        SEXP_t *cobj;
-        union {
-                SEXP_t         *item;
-                pthread_cond_t *cond;
-        } p;
-} probe_iqpair_t;
+#ifndef PROBE_ICACHE_SHARD_INITSIZE
+#define PROBE_ICACHE_SHARD_INITSIZE 64 /* must be a power of 2 */
+#endif
+
+typedef struct probe_citem {
+        SEXP_ID_t  id;
+        SEXP_t   **item;
+        uint16_t   count;
+        struct probe_citem *next;
+} probe_citem_t;
 
+/*
+ * The cache is split into shards by the item hash. Each shard is
+ * a chained hash table protected by its own mutex.
+ */
 typedef struct {
-        rbt_t    *tree; /* XXX: rewrite to extensible or linear hashing */
-        pthread_t thid;
+        pthread_mutex_t  mutex;
+        probe_citem_t  **bucket;
+        uint32_t         size;  /* number of buckets */
+        uint32_t         count; /* number of distinct hashes */
 
-        pthread_mutex_t queue_mutex;
-        pthread_cond_t  queue_notempty;
-        pthread_cond_t  queue_notfull;
+        uint64_t hits;       /* items replaced by a cached one */
+        uint64_t misses;     /* new items */
+        uint64_t collisions; /* equal hashes of different items */
+} probe_icache_shard_t;
 
-        probe_iqpair_t  queue[PROBE_IQUEUE_CAPACITY];
-        uint16_t        queue_beg;
-        uint16_t        queue_end;
-        uint16_t        queue_cnt;
-        uint16_t        queue_max;
+typedef struct {
+        probe_icache_shard_t shard[PROBE_ICACHE_SHARDS];
 } probe_icache_t;
 
 typedef struct {
-        SEXP_t  **item;
-        uint16_t  count;
-} probe_citem_t;
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t collisions;
+} probe_icache_stats_t;
 
 probe_icache_t *probe_icache_new(void);
 int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item);
 int probe_icache_nop(probe_icache_t *cache);
+void probe_icache_stats(probe_icache_t *cache, probe_icache_stats_t *stats);
 void probe_icache_free(probe_icache_t *cache);
 
 #endif /* ICACHE_H */
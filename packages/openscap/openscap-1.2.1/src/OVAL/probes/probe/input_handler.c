@@ -39,13 +39,12 @@
 
 /*
  * The input handler waits for incomming eval requests and either returns
- * a result immediately if it is found in the result cache or spawns a new
- * worker thread which takes care of evaluating the request, caching the
- * result and sending it to the requestee.
+ * a result immediately if it is found in the result cache or queues the
+ * request for the worker thread pool which takes care of evaluating it,
+ * caching the result and sending it to the requestee.
  */
 void *probe_input_handler(void *arg)
 {
-        pthread_attr_t pth_attr;
         probe_t       *probe = (probe_t *)arg;
 
         int probe_ret, cstate; /* XXX */
@@ -57,16 +56,6 @@ void *probe_input_handler(void *arg)
 
         TH_CANCEL_OFF;
 
-        if (pthread_attr_init(&pth_attr))
-                return (NULL);
-
-        if (pthread_attr_setdetachstate(&pth_attr, PTHREAD_CREATE_JOINABLE)) {
-                pthread_attr_destroy(&pth_attr);
-                return (NULL);
-        }
-
-        pthread_cleanup_push((void(*)(void *))pthread_attr_destroy, (void *)&pth_attr);
-        
         switch (errno = pthread_barrier_wait(&OSCAP_GSYM(th_barrier)))
         {
         case 0:
@@ -175,14 +164,13 @@ void *probe_input_handler(void *arg)
 						} else {
 							/* OK */
 
-							if (pthread_create(&pair->pth->tid, &pth_attr, &probe_worker_runfn, pair))
+							if (probe_wpool_dispatch(probe->wpool, pair) != 0)
 							{
-								dE("Cannot start a new worker thread: %d, %s.\n", errno, strerror(errno));
+								dE("Cannot queue the request: %d, %s.\n", errno, strerror(errno));
 
 								if (rbt_i32_del(probe->workers, pair->pth->sid, NULL) != 0)
 									dE("rbt_i32_del: failed to remove worker thread (ID=%u)\n", pair->pth->sid);
 
-								SEAP_msg_free(pair->pth->msg);
 								oscap_free(pair->pth);
 								oscap_free(pair);
 
@@ -246,6 +234,5 @@ void *probe_input_handler(void *arg)
 		SEAP_msg_free(seap_request);
 	} /* main loop */
 
-        pthread_cleanup_pop(1);
         return (NULL);
 }
@@ -27,6 +27,9 @@
 # endif
 #endif
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
 #include <string.h>
 #include <signal.h>
 #include <pthread.h>
@@ -38,11 +41,13 @@
 #include "ncache.h"
 #include "rcache.h"
 #include "icache.h"
+#include "pcache.h"
 #include "worker.h"
 #include "signal_handler.h"
 #include "input_handler.h"
 #include "probe-api.h"
 #include "option.h"
+#include "../oval_fts_walk.h"
 
 static int fail(int err, const char *who, int line)
 {
@@ -62,6 +67,32 @@ pthread_barrier_t OSCAP_GSYM(th_barrier);
 
 extern probe_ncache_t *OSCAP_GSYM(ncache);
 
+probe_pcache_t *OSCAP_GSYM(pcache) = NULL;
+
+/*
+ * Read a positive number from the environment; use `defval' if the
+ * variable isn't set or its value isn't valid.
+ */
+static uint32_t probe_getenv_u32(const char *name, uint32_t defval)
+{
+	const char *str = getenv(name);
+	char *end;
+	unsigned long val;
+
+	if (str == NULL)
+		return (defval);
+
+	errno = 0;
+	val = strtoul(str, &end, 10);
+
+	if (errno != 0 || *end != '\0' || end == str || val == 0 || val > UINT32_MAX) {
+		fprintf(stderr, "Ignoring invalid value of %s: %s\n", name, str);
+		return (defval);
+	}
+
+	return ((uint32_t)val);
+}
+
 static int probe_optecmp(char **a, char **b)
 {
 	return strcmp(*a, *b);
@@ -152,20 +183,32 @@ static int probe_opthandler_offlinemode(int option, int op, va_list args)
 	return 0;
 }
 
+static int probe_opthandler_pcache(int option, int op, va_list args)
+{
+	uint32_t o_flags;
+
+	if (op == PROBE_OPTION_GET)
+		return -1;
+
+	o_flags = va_arg(args, unsigned int);
+
+	return probe_pcache_setdeps(OSCAP_GSYM(pcache), o_flags, args);
+}
+
 int main(int argc, char *argv[])
 {
 	pthread_attr_t th_attr;
 	sigset_t       sigmask;
 	probe_t        probe;
 	char *rootdir = NULL;
+	char *cachedir = NULL;
 
 	if ((errno = pthread_barrier_init(&OSCAP_GSYM(th_barrier), NULL,
 	                                  1 + // signal thread
 	                                  1 + // input thread
-	                                  1 + // icache thread
 	                                  0)) != 0)
 	{
-		fail(errno, "pthread_barrier_init", __LINE__ - 6);
+		fail(errno, "pthread_barrier_init", __LINE__ - 5);
 	}
 
 	/*
@@ -210,10 +253,25 @@ int main(int argc, char *argv[])
 
         OSCAP_GSYM(ncache) = probe.ncache;
 
+	/*
+	 * Open the persistent cache before changing the root directory
+	 */
+	probe.pcache = NULL;
+
+	if ((cachedir = getenv("OSCAP_PROBE_CACHE_DIR")) != NULL && strlen(cachedir) > 0) {
+		const char *strict = getenv("OSCAP_PROBE_CACHE_STRICT");
+
+		probe.pcache = probe_pcache_new(cachedir, probe.name,
+		                                strict != NULL && strcmp(strict, "0") != 0,
+		                                probe_getenv_u32("OSCAP_PROBE_CACHE_TTL", PROBE_PCACHE_DEFAULT_TTL));
+	}
+
+	OSCAP_GSYM(pcache) = probe.pcache;
+
 	/*
 	 * Initialize probe option handlers
 	 */
-#define PROBE_OPTION_INITCOUNT 3
+#define PROBE_OPTION_INITCOUNT 4
 
 	probe.option = oscap_alloc(sizeof(probe_option_t) * PROBE_OPTION_INITCOUNT);
 	probe.optcnt = PROBE_OPTION_INITCOUNT;
@@ -224,6 +282,8 @@ int main(int argc, char *argv[])
 	probe.option[1].handler = &probe_opthandler_rcache;
 	probe.option[2].option  = PROBEOPT_OFFLINE_MODE_SUPPORTED;
 	probe.option[2].handler = &probe_opthandler_offlinemode;
+	probe.option[3].option  = PROBEOPT_PERSISTENT_CACHE;
+	probe.option[3].handler = &probe_opthandler_pcache;
 
 	OSCAP_GSYM(probe_optdef) = probe.option;
 	OSCAP_GSYM(probe_optdef_count) = probe.optcnt;
@@ -266,6 +326,27 @@ int main(int argc, char *argv[])
 		OSCAP_GSYM(offline_mode) |= PROBE_OFFLINE_RPMDB;
 	}
 
+	/*
+	 * Setup the worker thread pool. By default, use twice as many
+	 * threads as there are online CPUs because the probes spend a lot
+	 * of time waiting for I/O.
+	 */
+	{
+		long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		uint32_t max_threads, max_queue;
+
+		max_threads = ncpu > 0 ? 2 * (uint32_t)ncpu : 2;
+
+		if (max_threads > PROBE_WORKER_DEFAULT_MAX_THREADS)
+			max_threads = PROBE_WORKER_DEFAULT_MAX_THREADS;
+
+		probe.max_threads = probe_getenv_u32("OSCAP_PROBE_MAX_THREADS", max_threads);
+		probe.max_chdepth = PROBE_WORKER_DEFAULT_MAX_CHDEPTH;
+		max_queue = probe_getenv_u32("OSCAP_PROBE_MAX_QUEUE", PROBE_WORKER_DEFAULT_MAX_QUEUE);
+
+		probe.wpool = probe_wpool_new(probe.max_threads, max_queue);
+	}
+
 	/*
 	 * Create input handler (detached)
 	 */
@@ -312,7 +393,10 @@ int main(int argc, char *argv[])
 	probe_ncache_free(probe.ncache);
 	probe_rcache_free(probe.rcache);
         probe_icache_free(probe.icache);
+        probe_pcache_free(probe.pcache);
+        oval_fts_cache_reset();
 
+        probe_wpool_free(probe.wpool);
         rbt_i32_free(probe.workers);
 
         if (probe.sd != -1)
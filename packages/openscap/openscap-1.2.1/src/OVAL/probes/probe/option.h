@@ -4,6 +4,15 @@
 #define PROBEOPT_VARREF_HANDLING 0
 #define PROBEOPT_RESULT_CACHING  1
 #define PROBEOPT_OFFLINE_MODE_SUPPORTED 2
+#define PROBEOPT_PERSISTENT_CACHE 3
+
+/*
+ * Dependencies of collected objects stored in the persistent cache
+ * (PROBEOPT_PERSISTENT_CACHE). The flags are followed by a NULL
+ * terminated list of paths the probe always depends on.
+ */
+#define PROBE_PCACHE_DEP_NONE    0x00 /* only the boot ID and the entry age */
+#define PROBE_PCACHE_DEP_OBJPATH 0x01 /* the file given by the object (filepath or path + filename) */
 
 #define PROBE_OPTION_SET 0
 #define PROBE_OPTION_GET 1
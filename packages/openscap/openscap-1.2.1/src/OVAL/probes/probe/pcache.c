@@ -0,0 +1,763 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <seap.h>
+#include <strbuf.h>
+
+#include "probe-api.h"
+#include "common/alloc.h"
+#include "common/debug_priv.h"
+#include "option.h"
+#include "pcache.h"
+
+#define PROBE_PCACHE_STRBUF_MAX 4096
+#define PROBE_PCACHE_BOOTID     "/proc/sys/kernel/random/boot_id"
+
+static void probe_pcache_count(probe_pcache_t *cache, uint64_t *counter)
+{
+	pthread_mutex_lock(&cache->mutex);
+	++(*counter);
+	pthread_mutex_unlock(&cache->mutex);
+}
+
+static char *probe_pcache_bootid(void)
+{
+	char  buf[64];
+	FILE *fp;
+
+	if ((fp = fopen(PROBE_PCACHE_BOOTID, "r")) == NULL)
+		return (strdup("unknown"));
+
+	if (fgets(buf, sizeof buf, fp) == NULL)
+		strcpy(buf, "unknown");
+
+	fclose(fp);
+	buf[strcspn(buf, "\n")] = '\0';
+
+	return (strdup(buf));
+}
+
+/*
+ * Open a cache directory. Other users must not be able to plant or
+ * modify entries, so the directory has to be a real directory owned
+ * by the effective user and not writable by the group or others.
+ */
+static int probe_pcache_opendir(int atfd, const char *path)
+{
+	struct stat st;
+	int fd;
+
+	if ((fd = openat(atfd, path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW)) < 0)
+		return (-1);
+
+	if (fstat(fd, &st) != 0) {
+		protect_errno {
+			close(fd);
+		}
+		return (-1);
+	}
+
+	if (st.st_uid != geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		close(fd);
+		errno = EPERM;
+		return (-1);
+	}
+
+	return (fd);
+}
+
+probe_pcache_t *probe_pcache_new(const char *dir, const char *probe_name, bool strict, uint32_t ttl)
+{
+	probe_pcache_t *cache;
+	const char *root, *rpmdb;
+	char *bootid;
+	int   dfd, pfd;
+	size_t len;
+
+	if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+		dE("Can't create the cache directory %s: %u, %s.\n", dir, errno, strerror(errno));
+		return (NULL);
+	}
+
+	if ((dfd = probe_pcache_opendir(AT_FDCWD, dir)) < 0) {
+		dE("Can't use the cache directory %s: %u, %s.\n", dir, errno, strerror(errno));
+		return (NULL);
+	}
+
+	if (mkdirat(dfd, probe_name, 0700) != 0 && errno != EEXIST) {
+		dE("Can't create the cache directory %s/%s: %u, %s.\n", dir, probe_name, errno, strerror(errno));
+		close(dfd);
+		return (NULL);
+	}
+
+	pfd = probe_pcache_opendir(dfd, probe_name);
+	close(dfd);
+
+	if (pfd < 0) {
+		dE("Can't use the cache directory %s/%s: %u, %s.\n", dir, probe_name, errno, strerror(errno));
+		return (NULL);
+	}
+
+	/*
+	 * Everything which changes the meaning of an object but isn't
+	 * part of the object itself.
+	 */
+	root   = getenv("OSCAP_PROBE_ROOT");
+	rpmdb  = getenv("OSCAP_PROBE_RPMDB_PATH");
+	bootid = probe_pcache_bootid();
+
+	cache = oscap_talloc(probe_pcache_t);
+	cache->dirfd = pfd;
+	cache->name  = strdup(probe_name);
+
+	len = strlen(probe_name) + strlen(bootid)
+		+ (root  != NULL ? strlen(root)  : 0)
+		+ (rpmdb != NULL ? strlen(rpmdb) : 0) + 64;
+
+	cache->context = oscap_alloc(len);
+	snprintf(cache->context, len, "probe %s\nversion %s\nboot %s\nroot %s\nrpmdb %s\n",
+	         probe_name, VERSION, bootid,
+	         root  != NULL ? root  : "",
+	         rpmdb != NULL ? rpmdb : "");
+	oscap_free(bootid);
+
+	cache->strict   = strict;
+	cache->ttl      = ttl;
+	cache->enabled  = false;
+	cache->depflags = PROBE_PCACHE_DEP_NONE;
+	cache->deppath  = NULL;
+	cache->depcnt   = 0;
+
+	cache->tmp_seq  = 0;
+
+	pthread_mutex_init(&cache->mutex, NULL);
+	memset(&cache->stats, 0, sizeof cache->stats);
+
+	return (cache);
+}
+
+void probe_pcache_stats(probe_pcache_t *cache, probe_pcache_stats_t *stats)
+{
+	pthread_mutex_lock(&cache->mutex);
+	memcpy(stats, &cache->stats, sizeof(probe_pcache_stats_t));
+	pthread_mutex_unlock(&cache->mutex);
+}
+
+void probe_pcache_free(probe_pcache_t *cache)
+{
+	probe_pcache_stats_t stats;
+	size_t i;
+
+	if (cache == NULL)
+		return;
+
+	probe_pcache_stats(cache, &stats);
+
+	if (cache->enabled) {
+		FILE *fp;
+		int   fd;
+
+		dI("pcache stats: lookups=%"PRIu64", hits=%"PRIu64", misses=%"PRIu64", stale=%"PRIu64
+		   ", bypassed=%"PRIu64", stores=%"PRIu64", errors=%"PRIu64"\n",
+		   stats.lookups, stats.hits, stats.misses, stats.stale,
+		   stats.bypassed, stats.stores, stats.errors);
+
+		fd = openat(cache->dirfd, "stats", O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+		if (fd >= 0 && (fp = fdopen(fd, "w")) != NULL) {
+			fprintf(fp,
+			        "lookups %"PRIu64"\n"
+			        "hits %"PRIu64"\n"
+			        "misses %"PRIu64"\n"
+			        "stale %"PRIu64"\n"
+			        "bypassed %"PRIu64"\n"
+			        "stores %"PRIu64"\n"
+			        "errors %"PRIu64"\n",
+			        stats.lookups, stats.hits, stats.misses, stats.stale,
+			        stats.bypassed, stats.stores, stats.errors);
+			fclose(fp);
+		} else {
+			dE("Can't write the cache statistics: %u, %s.\n", errno, strerror(errno));
+
+			if (fd >= 0)
+				close(fd);
+		}
+	}
+
+	for (i = 0; i < cache->depcnt; ++i)
+		oscap_free(cache->deppath[i]);
+
+	pthread_mutex_destroy(&cache->mutex);
+	close(cache->dirfd);
+
+	oscap_free(cache->deppath);
+	oscap_free(cache->context);
+	oscap_free(cache->name);
+	oscap_free(cache);
+}
+
+int probe_pcache_setdeps(probe_pcache_t *cache, uint32_t flags, va_list ap)
+{
+	const char *path;
+
+	if (cache == NULL)
+		return (0);
+
+	cache->depflags = flags;
+
+	while ((path = va_arg(ap, const char *)) != NULL) {
+		cache->deppath = oscap_realloc(cache->deppath, sizeof(char *) * (cache->depcnt + 1));
+		cache->deppath[cache->depcnt++] = strdup(path);
+	}
+
+	cache->enabled = true;
+
+	return (0);
+}
+
+void probe_pcache_key_free(probe_pcache_key_t *key)
+{
+	if (key == NULL)
+		return;
+
+	free(key->key);
+	free(key->deps);
+	oscap_free(key);
+}
+
+static void probe_pcache_addrec(strbuf_t *sb, char type, const struct stat *st, const char *path)
+{
+	char buf[160];
+
+	if (st == NULL) {
+		snprintf(buf, sizeof buf, "%c - ", type);
+	} else {
+		snprintf(buf, sizeof buf, "%c %ju %ju %jd %jd.%09ld %jd.%09ld ", type,
+		         (uintmax_t)st->st_dev, (uintmax_t)st->st_ino, (intmax_t)st->st_size,
+		         (intmax_t)st->st_mtim.tv_sec, (long)st->st_mtim.tv_nsec,
+		         (intmax_t)st->st_ctim.tv_sec, (long)st->st_ctim.tv_nsec);
+	}
+
+	strbuf_add0(sb, buf);
+	strbuf_add0(sb, path);
+	strbuf_addc(sb, '\n');
+}
+
+/*
+ * Record the state of a file. A change of the inode (e.g. permissions,
+ * owner, extended attributes), content or of the file type shows in
+ * the change time, the modification time or the inode number. Symbolic
+ * links are recorded together with their target.
+ */
+static void probe_pcache_addstat(strbuf_t *sb, const char *path)
+{
+	struct stat st;
+
+	if (lstat(path, &st) != 0) {
+		probe_pcache_addrec(sb, 'L', NULL, path);
+		return;
+	}
+
+	probe_pcache_addrec(sb, 'L', &st, path);
+
+	if (S_ISLNK(st.st_mode))
+		probe_pcache_addrec(sb, 'S', stat(path, &st) == 0 ? &st : NULL, path);
+}
+
+/*
+ * Get the value of an entity if the entity selects exactly one value.
+ */
+static char *probe_pcache_entstr(SEXP_t *ent)
+{
+	SEXP_t *val;
+	char   *str;
+
+	if (probe_ent_attrexists(ent, "var_ref"))
+		return (NULL);
+	if (probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS) != OVAL_OPERATION_EQUALS)
+		return (NULL);
+	if ((val = probe_ent_getval(ent)) == NULL)
+		return (NULL);
+
+	str = SEXP_stringp(val) ? SEXP_string_cstr(val) : NULL;
+	SEXP_free(val);
+
+	return (str);
+}
+
+/*
+ * Add the state of the file selected by the object to the dependencies.
+ * Only objects which select a single file without recursion are handled
+ * because new files matching a pattern can't be detected cheaply.
+ */
+static int probe_pcache_objpath(const SEXP_t *obj, strbuf_t *sb)
+{
+	SEXP_t *ent, *r0;
+	char   *path, *file;
+	bool    ok;
+
+	if ((ent = probe_obj_getent(obj, "behaviors", 1)) != NULL) {
+		r0 = probe_ent_getattrval(ent, "recurse_direction");
+		ok = (r0 == NULL || SEXP_strcmp(r0, "none") == 0);
+		SEXP_vfree(r0, ent, NULL);
+
+		if (!ok)
+			return (-1);
+	}
+
+	if ((ent = probe_obj_getent(obj, "filepath", 1)) != NULL) {
+		path = probe_pcache_entstr(ent);
+		SEXP_free(ent);
+
+		if (path == NULL)
+			return (-1);
+
+		probe_pcache_addstat(sb, path);
+		oscap_free(path);
+
+		return (0);
+	}
+
+	if ((ent = probe_obj_getent(obj, "path", 1)) == NULL)
+		return (-1);
+
+	path = probe_pcache_entstr(ent);
+	SEXP_free(ent);
+
+	if (path == NULL)
+		return (-1);
+
+	if ((ent = probe_obj_getent(obj, "filename", 1)) == NULL ||
+	    probe_ent_getvals(ent, NULL) == 0) {
+		/* nil filename, the object selects the directory */
+		probe_pcache_addstat(sb, path);
+	} else {
+		char  *full;
+		size_t len;
+
+		if ((file = probe_pcache_entstr(ent)) == NULL) {
+			SEXP_free(ent);
+			oscap_free(path);
+			return (-1);
+		}
+
+		len  = strlen(path) + strlen(file) + 2;
+		full = oscap_alloc(len);
+		snprintf(full, len, "%s/%s", path, file);
+
+		probe_pcache_addstat(sb, full);
+
+		oscap_free(full);
+		oscap_free(file);
+	}
+
+	SEXP_free(ent);
+	oscap_free(path);
+
+	return (0);
+}
+
+#define FNV1A_64_PRIME 0x100000001b3ULL
+
+static uint64_t probe_pcache_fnv1a(uint64_t h, const char *str, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; ++i) {
+		h ^= (uint8_t)str[i];
+		h *= FNV1A_64_PRIME;
+	}
+
+	return (h);
+}
+
+static char *probe_pcache_sbstr(strbuf_t *sb, size_t *len)
+{
+	char *str;
+
+	*len = strbuf_length(sb);
+	str  = *len > 0 ? strbuf_cstr(sb) : strdup("");
+
+	return (str);
+}
+
+static probe_pcache_key_t *probe_pcache_key_new(probe_pcache_t *cache, const SEXP_t *probe_in, const SEXP_t *filters)
+{
+	probe_pcache_key_t *key;
+	strbuf_t *sb;
+	SEXP_t   *r0;
+	char     *name;
+	size_t    i;
+
+	/*
+	 * Dependencies. Checked first because they decide
+	 * whether the object can be cached at all.
+	 */
+	sb = strbuf_new(PROBE_PCACHE_STRBUF_MAX);
+
+	for (i = 0; i < cache->depcnt; ++i)
+		probe_pcache_addstat(sb, cache->deppath[i]);
+
+	if (cache->depflags & PROBE_PCACHE_DEP_OBJPATH) {
+		if (probe_pcache_objpath(probe_in, sb) != 0) {
+			strbuf_free(sb);
+			return (NULL);
+		}
+	}
+
+	key = oscap_talloc(probe_pcache_key_t);
+	key->time = time(NULL);
+	key->deps = probe_pcache_sbstr(sb, &key->deps_len);
+	strbuf_free(sb);
+
+	/*
+	 * Key: the object without its id and the filters
+	 */
+	sb   = strbuf_new(PROBE_PCACHE_STRBUF_MAX);
+	name = probe_obj_getname(probe_in);
+
+	strbuf_add0(sb, cache->context);
+	strbuf_add0(sb, "object ");
+	strbuf_add0(sb, name != NULL ? name : "");
+	strbuf_addc(sb, '\n');
+	oscap_free(name);
+
+	if ((r0 = probe_obj_getattrval(probe_in, "oval_version")) != NULL) {
+		SEXP_sbprintf_t(r0, sb);
+		SEXP_free(r0);
+	}
+
+	strbuf_addc(sb, '\n');
+	r0 = SEXP_list_rest(probe_in);
+	SEXP_sbprintf_t(r0, sb);
+	SEXP_free(r0);
+
+	strbuf_add0(sb, "\nfilters\n");
+
+	if (filters != NULL)
+		SEXP_sbprintf_t((SEXP_t *)filters, sb);
+
+	key->key = probe_pcache_sbstr(sb, &key->key_len);
+	strbuf_free(sb);
+
+	snprintf(key->name, sizeof key->name, "%016"PRIx64"%016"PRIx64,
+	         probe_pcache_fnv1a(0xcbf29ce484222325ULL, key->key, key->key_len),
+	         probe_pcache_fnv1a(0x84222325cbf29ce4ULL, key->key, key->key_len));
+
+	return (key);
+}
+
+static char *probe_pcache_read(int dirfd, const char *name, size_t *len)
+{
+	struct stat st;
+	char   *buf;
+	size_t  off;
+	ssize_t ret;
+	int     fd;
+
+	if ((fd = openat(dirfd, name, O_RDONLY)) < 0)
+		return (NULL);
+
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		errno = EINVAL;
+		return (NULL);
+	}
+
+	buf = oscap_alloc((size_t)st.st_size);
+
+	for (off = 0; off < (size_t)st.st_size; off += (size_t)ret) {
+		ret = read(fd, buf + off, (size_t)st.st_size - off);
+
+		if (ret <= 0) {
+			if (ret < 0 && errno == EINTR) {
+				ret = 0;
+				continue;
+			}
+
+			oscap_free(buf);
+			close(fd);
+			errno = EINVAL;
+			return (NULL);
+		}
+	}
+
+	close(fd);
+	*len = off;
+
+	return (buf);
+}
+
+/*
+ * Make a collected object from the cached one. The item IDs are
+ * reset so that the item cache assigns new ones.
+ */
+static SEXP_t *probe_pcache_restore(probe_icache_t *icache, const SEXP_t *cached)
+{
+	SEXP_t *cobj, *msgs, *mask, *items, *item, *name_ref, *prev_id;
+	SEXP_t  empty_id;
+
+	msgs  = probe_cobj_get_msgs(cached);
+	mask  = probe_cobj_get_mask(cached);
+	items = probe_cobj_get_items(cached);
+	cobj  = probe_cobj_new(probe_cobj_get_flag(cached), msgs, NULL, mask);
+
+	SEXP_string_new_r(&empty_id, "", 0);
+
+	if (items != NULL) {
+		SEXP_list_foreach(item, items) {
+			name_ref = SEXP_listref_first(item);
+			prev_id  = SEXP_list_replace(name_ref, 3, &empty_id);
+			SEXP_vfree(prev_id, name_ref, NULL);
+
+			if (probe_icache_add(icache, cobj, SEXP_ref(item)) != 0) {
+				SEXP_vfree(item, cobj, NULL);
+				cobj = NULL;
+				break;
+			}
+		}
+	}
+
+	SEXP_free_r(&empty_id);
+	SEXP_vfree(msgs, mask, items, NULL);
+
+	return (cobj);
+}
+
+SEXP_t *probe_pcache_get(probe_pcache_t *cache, probe_icache_t *icache,
+                         const SEXP_t *probe_in, const SEXP_t *filters,
+                         probe_pcache_key_t **keyp)
+{
+	probe_pcache_key_t *key;
+	SEXP_bpstate_t *pstate;
+	SEXP_t *list, *cached, *cobj;
+	char   *buf, *p, *e;
+	size_t  len, key_len, deps_len;
+	long long ctime;
+	int     n;
+
+	*keyp = NULL;
+
+	if (cache == NULL || !cache->enabled)
+		return (NULL);
+
+	probe_pcache_count(cache, &cache->stats.lookups);
+
+	if ((key = probe_pcache_key_new(cache, probe_in, filters)) == NULL) {
+		probe_pcache_count(cache, &cache->stats.bypassed);
+		return (NULL);
+	}
+
+	*keyp = key;
+
+	if (cache->strict) {
+		probe_pcache_count(cache, &cache->stats.bypassed);
+		return (NULL);
+	}
+
+	if ((buf = probe_pcache_read(cache->dirfd, key->name, &len)) == NULL) {
+		probe_pcache_count(cache, errno == ENOENT ? &cache->stats.misses : &cache->stats.errors);
+		return (NULL);
+	}
+
+	p = buf;
+	e = buf + len;
+
+	/*
+	 * Header: magic, creation time, key length, dependencies length
+	 */
+	if (len < sizeof PROBE_PCACHE_MAGIC ||
+	    memcmp(p, PROBE_PCACHE_MAGIC, sizeof PROBE_PCACHE_MAGIC - 1) != 0)
+		goto fail;
+
+	p += sizeof PROBE_PCACHE_MAGIC - 1;
+
+	if (memchr(p, '\n', e - p) == NULL ||
+	    sscanf(p, "%lld %zu %zu\n%n", &ctime, &key_len, &deps_len, &n) != 3)
+		goto fail;
+
+	p += n;
+
+	if ((size_t)(e - p) < key_len || (size_t)(e - p) - key_len < deps_len)
+		goto fail;
+
+	if (key_len != key->key_len || memcmp(p, key->key, key_len) != 0) {
+		/* different object with the same hash */
+		probe_pcache_count(cache, &cache->stats.misses);
+		oscap_free(buf);
+		return (NULL);
+	}
+
+	p += key_len;
+
+	if (deps_len != key->deps_len || memcmp(p, key->deps, deps_len) != 0 ||
+	    (long long)key->time < ctime || (long long)key->time - ctime > (long long)cache->ttl) {
+		dI("pcache: entry %s is stale\n", key->name);
+		probe_pcache_count(cache, &cache->stats.stale);
+		oscap_free(buf);
+		return (NULL);
+	}
+
+	p += deps_len;
+
+	/*
+	 * Collected object
+	 */
+	pstate = SEXP_bpstate_new();
+	list   = SEXP_parse_b(pstate, p, e - p);
+	cached = NULL;
+
+	if (list != NULL && !SEXP_bpstate_pending(pstate))
+		cached = SEXP_list_first(list);
+
+	SEXP_free(list);
+	SEXP_bpstate_free(pstate);
+	oscap_free(buf);
+
+	if (cached == NULL || !SEXP_listp(cached)) {
+		SEXP_free(cached);
+		goto fail_nobuf;
+	}
+
+	cobj = probe_pcache_restore(icache, cached);
+	SEXP_free(cached);
+
+	if (cobj == NULL)
+		goto fail_nobuf;
+
+	dI("pcache: using entry %s\n", key->name);
+	probe_pcache_count(cache, &cache->stats.hits);
+
+	return (cobj);
+fail:
+	oscap_free(buf);
+fail_nobuf:
+	dW("pcache: ignoring invalid entry %s\n", key->name);
+	probe_pcache_count(cache, &cache->stats.errors);
+
+	return (NULL);
+}
+
+static int probe_pcache_write(int fd, const char *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0) {
+		if ((ret = write(fd, buf, len)) < 0) {
+			if (errno == EINTR)
+				continue;
+			return (-1);
+		}
+
+		buf += ret;
+		len -= (size_t)ret;
+	}
+
+	return (0);
+}
+
+void probe_pcache_put(probe_pcache_t *cache, probe_pcache_key_t *key, const SEXP_t *cobj)
+{
+	SEXP_bostate_t *ostate;
+	strbuf_t *sb;
+	char      hdr[128], tmp[64], *buf;
+	size_t    len;
+	uint32_t  seq;
+	bool      ok;
+	int       fd;
+
+	if (cache == NULL || key == NULL)
+		goto out;
+
+	/*
+	 * Don't keep errors, they may be caused by a temporary condition
+	 */
+	switch (probe_cobj_get_flag(cobj)) {
+	case SYSCHAR_FLAG_COMPLETE:
+	case SYSCHAR_FLAG_DOES_NOT_EXIST:
+	case SYSCHAR_FLAG_NOT_APPLICABLE:
+		break;
+	default:
+		goto out;
+	}
+
+	snprintf(hdr, sizeof hdr, PROBE_PCACHE_MAGIC "%lld %zu %zu\n",
+	         (long long)key->time, key->key_len, key->deps_len);
+
+	sb = strbuf_new(PROBE_PCACHE_STRBUF_MAX);
+	strbuf_add0(sb, hdr);
+	strbuf_add(sb, key->key, key->key_len);
+	strbuf_add(sb, key->deps, key->deps_len);
+
+	ostate = SEXP_bostate_new();
+
+	if (SEXP_sbprintf_b((SEXP_t *)cobj, sb, ostate) != 0) {
+		SEXP_bostate_free(ostate);
+		strbuf_free(sb);
+		probe_pcache_count(cache, &cache->stats.errors);
+		goto out;
+	}
+
+	SEXP_bostate_free(ostate);
+	buf = probe_pcache_sbstr(sb, &len);
+	strbuf_free(sb);
+
+	/*
+	 * Write a temporary file and rename it so that other probe
+	 * processes never see a partially written entry.
+	 */
+	pthread_mutex_lock(&cache->mutex);
+	seq = cache->tmp_seq++;
+	pthread_mutex_unlock(&cache->mutex);
+
+	snprintf(tmp, sizeof tmp, ".%s.%u.%u", key->name, (unsigned int)getpid(), seq);
+
+	if ((fd = openat(cache->dirfd, tmp, O_WRONLY | O_CREAT | O_EXCL, 0600)) < 0) {
+		dE("Can't create a cache entry: %u, %s.\n", errno, strerror(errno));
+		probe_pcache_count(cache, &cache->stats.errors);
+		free(buf);
+		goto out;
+	}
+
+	ok = probe_pcache_write(fd, buf, len) == 0;
+
+	if (close(fd) != 0)
+		ok = false;
+
+	if (!ok || renameat(cache->dirfd, tmp, cache->dirfd, key->name) != 0) {
+		dE("Can't write a cache entry: %u, %s.\n", errno, strerror(errno));
+		unlinkat(cache->dirfd, tmp, 0);
+		probe_pcache_count(cache, &cache->stats.errors);
+	} else
+		probe_pcache_count(cache, &cache->stats.stores);
+
+	free(buf);
+out:
+	probe_pcache_key_free(key);
+}
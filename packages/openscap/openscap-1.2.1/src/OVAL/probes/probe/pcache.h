@@ -0,0 +1,125 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PCACHE_H
+#define PCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <time.h>
+#include <sexp.h>
+#include "icache.h"
+
+/*
+ * Persistent collected object cache. Collected objects are stored in
+ * a directory given by the user (OSCAP_PROBE_CACHE_DIR) so that they
+ * can be reused by the next scan of the same system. The cache is not
+ * used unless the directory is owned by the effective user and is not
+ * writable by the group or others.
+ *
+ * An entry is keyed by the probe name, the boot ID, the offline mode
+ * settings and the object (without its id) together with the states
+ * used as filters. Each entry records the state of the files it
+ * depends on when the object was collected and is valid only while
+ * these files don't change and for at most `ttl' seconds.
+ *
+ * Probes have to opt in using the PROBEOPT_PERSISTENT_CACHE option
+ * and declare what the collected objects depend on.
+ */
+
+#ifndef PROBE_PCACHE_DEFAULT_TTL
+#define PROBE_PCACHE_DEFAULT_TTL 3600 /* seconds */
+#endif
+
+#define PROBE_PCACHE_MAGIC "OSCAP-PCACHE 1\n"
+
+typedef struct {
+        uint64_t lookups;  /* objects the cache was asked for */
+        uint64_t hits;     /* valid entries used */
+        uint64_t misses;   /* no entry */
+        uint64_t stale;    /* entries invalidated by a dependency change or age */
+        uint64_t bypassed; /* objects which can't be cached or strict mode */
+        uint64_t stores;   /* entries written */
+        uint64_t errors;   /* unreadable entries and failed writes */
+} probe_pcache_stats_t;
+
+typedef struct {
+        int      dirfd;    /* per-probe cache directory */
+        char    *name;     /* probe name */
+        char    *context;  /* key prefix: probe, boot ID, offline mode */
+        bool     strict;   /* don't use cached entries, just refresh them */
+        uint32_t ttl;
+
+        bool     enabled;  /* set by the probe through probe_setoption() */
+        uint32_t depflags; /* PROBE_PCACHE_DEP_* */
+        char   **deppath;  /* static dependencies */
+        size_t   depcnt;
+
+        pthread_mutex_t      mutex; /* protects stats and tmp_seq */
+        probe_pcache_stats_t stats;
+        uint32_t             tmp_seq; /* temporary file names */
+} probe_pcache_t;
+
+typedef struct {
+        char   name[33]; /* file name: hex encoded 128-bit hash of the key */
+        time_t time;     /* when the dependencies were checked */
+        char  *key;
+        size_t key_len;
+        char  *deps;     /* state of the dependencies before collection */
+        size_t deps_len;
+} probe_pcache_key_t;
+
+/**
+ * Open the cache directory. The directory is created if it doesn't
+ * exist. Called before the probe changes its root directory.
+ * @return cache pointer or NULL if the directory can't be used
+ */
+probe_pcache_t *probe_pcache_new(const char *dir, const char *probe_name, bool strict, uint32_t ttl);
+
+/**
+ * Write the statistics to `<dir>/<probe>/stats' and free the cache.
+ */
+void probe_pcache_free(probe_pcache_t *cache);
+
+/**
+ * Handle the PROBEOPT_PERSISTENT_CACHE option: (uint32_t flags, const char *path, ..., NULL).
+ */
+int probe_pcache_setdeps(probe_pcache_t *cache, uint32_t flags, va_list ap);
+
+/**
+ * Look up a collected object. The items of a cached object are added
+ * through the item cache so that they get IDs unique in this process.
+ * @param key set to a key which can be passed to probe_pcache_put()
+ *            after the object is collected, or NULL if the object
+ *            can't be cached
+ * @return collected object or NULL
+ */
+SEXP_t *probe_pcache_get(probe_pcache_t *cache, probe_icache_t *icache,
+                         const SEXP_t *probe_in, const SEXP_t *filters,
+                         probe_pcache_key_t **key);
+
+/**
+ * Store a collected object and free the key.
+ */
+void probe_pcache_put(probe_pcache_t *cache, probe_pcache_key_t *key, const SEXP_t *cobj);
+
+void probe_pcache_key_free(probe_pcache_key_t *key);
+
+void probe_pcache_stats(probe_pcache_t *cache, probe_pcache_stats_t *stats);
+
+#endif /* PCACHE_H */
@@ -32,10 +32,13 @@
 #include "ncache.h"
 #include "rcache.h"
 #include "icache.h"
+#include "pcache.h"
 #include "probe-common.h"
 #include "option.h"
 #include "common/util.h"
 
+typedef struct probe_wpool probe_wpool_t;
+
 typedef struct {
 	pthread_rwlock_t rwlock;
 	uint32_t         flags;
@@ -52,25 +55,46 @@ typedef struct {
 	pthread_t th_input;
 	pthread_t th_signal;
 
-        rbt_t    *workers;
+        rbt_t    *workers; /**< requests being handled, keyed by SEAP message ID */
+        probe_wpool_t *wpool; /**< worker thread pool */
         uint32_t  max_threads;
         uint32_t  max_chdepth;
 
 	probe_rcache_t *rcache; /**< probe result cache */
 	probe_ncache_t *ncache; /**< probe name cache */
         probe_icache_t *icache; /**< probe item cache */
+        probe_pcache_t *pcache; /**< persistent collected object cache */
 
 	probe_option_t *option; /**< probe option handlers */
 	size_t          optcnt; /**< number of defined options */
 } probe_t;
 
+#ifndef PROBE_CHUNK_ITEMS
+#define PROBE_CHUNK_ITEMS 4096 /* items sent to the library in one chunk */
+#endif
+
 struct probe_ctx {
         SEXP_t         *probe_in;  /**< S-exp representation of the input object */
         SEXP_t         *probe_out; /**< collected object */
         SEXP_t         *filters;   /**< object filters (OVAL 5.8 and higher) */
         probe_icache_t *icache;    /**< item cache */
+
+        probe_t        *probe;     /**< probe which evaluates the object */
+        SEAP_msg_t     *msg;       /**< request, NULL if the items aren't sent in chunks */
+        SEXP_t         *chunk;     /**< items collected since the last chunk was sent */
+        size_t          chunk_len; /**< number of items in `chunk' */
+        size_t          chunks;    /**< number of chunks sent */
 };
 
+/*
+ * Send the items collected since the last chunk to the library ahead
+ * of the reply. Only done if the library asked for it by setting the
+ * "chunked" attribute in the request; the items are kept in the
+ * collected object too.
+ * @return 0 on success, -1 if the chunk couldn't be sent
+ */
+int probe_chunk_send(struct probe_ctx *ctx);
+
 typedef enum {
 	PROBE_OFFLINE_NONE = 0x00,
 	PROBE_OFFLINE_CHROOT = 0x01,
@@ -29,6 +29,7 @@
 #include <string.h>
 #include <pthread.h>
 #include <errno.h>
+#include <time.h>
 
 #include "probe-api.h"
 #include "common/debug_priv.h"
@@ -40,12 +41,16 @@
 extern bool  OSCAP_GSYM(varref_handling);
 extern void *OSCAP_GSYM(probe_arg);
 
-void *probe_worker_runfn(void *arg)
+/*
+ * Handle one request taken from the worker pool queue. The request
+ * is freed by this function. Cancelation is disabled once the handler
+ * returns so that the request is either completely handled or left
+ * to the signal handler to free.
+ */
+void probe_worker_runfn(probe_pwpair_t *pair)
 {
-	probe_pwpair_t *pair = (probe_pwpair_t *)arg;
-
 	SEXP_t *probe_res, *obj, *oid;
-	int     probe_ret;
+	int     probe_ret, cstate;
 
 	dI("handling SEAP message ID %u\n", pair->pth->sid);
 	//
@@ -54,6 +59,8 @@ void *probe_worker_runfn(void *arg)
 	//
 	dI("handler result = %p, return code = %d\n", probe_res, probe_ret);
 
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cstate);
+
 	/* Assuming that the red-black tree API is doing locking for us... */
 	if (rbt_i32_del(pair->probe->workers, pair->pth->sid, NULL) != 0) {
 		dW("thread not found in the probe thread tree, probably canceled by an external signal\n");
@@ -61,13 +68,12 @@ void *probe_worker_runfn(void *arg)
 		 * XXX: this is a possible deadlock; we can't send anything from
 		 * here because the signal handler replied to the message
 		 */
-		arg = NULL;
-
                 SEAP_msg_free(pair->pth->msg);
                 SEXP_free(probe_res);
+                oscap_free(pair->pth);
                 oscap_free(pair);
 
-                return (NULL);
+                return;
 	} else {
                 SEXP_t *items;
 
@@ -111,7 +117,21 @@ void *probe_worker_runfn(void *arg)
 		 * OK, the probe actually returned something, let's send it to the library.
 		 */
 		seap_reply = SEAP_msg_new();
-		SEAP_msg_set(seap_reply, probe_res);
+
+		if (SEAP_msgattr_exists(pair->pth->msg, "chunks-sent")) {
+			SEXP_t *msgs, *mask, *r0;
+			/*
+			 * The items were sent in chunks, reply with the
+			 * flag and the messages only.
+			 */
+			msgs = probe_cobj_get_msgs(probe_res);
+			mask = probe_cobj_get_mask(probe_res);
+			r0   = probe_cobj_new(probe_cobj_get_flag(probe_res), msgs, NULL, mask);
+
+			SEAP_msg_set(seap_reply, r0);
+			SEXP_vfree(msgs, mask, r0, NULL);
+		} else
+			SEAP_msg_set(seap_reply, probe_res);
 
 		if (SEAP_reply(pair->probe->SEAP_ctx, pair->probe->sd, seap_reply, pair->pth->msg) == -1) {
 			int ret = errno;
@@ -129,9 +149,6 @@ void *probe_worker_runfn(void *arg)
         SEAP_msg_free(pair->pth->msg);
         oscap_free(pair->pth);
 	oscap_free(pair);
-	pthread_detach(pthread_self());
-
-	return (NULL);
 }
 
 probe_worker_t *probe_worker_new(void)
@@ -146,6 +163,275 @@ probe_worker_t *probe_worker_new(void)
 	return (pth);
 }
 
+static void probe_wpool_unlock(void *arg)
+{
+	probe_wpool_t *pool = (probe_wpool_t *)arg;
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+static void *probe_wpool_thread(void *arg)
+{
+	probe_wthread_t *self = (probe_wthread_t *)arg;
+	probe_wpool_t   *pool = self->pool;
+	probe_pwpair_t  *pair;
+	int cstate;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->mutex);
+		pthread_cleanup_push(probe_wpool_unlock, pool);
+
+		++pool->idle;
+
+		while (pool->q_len == 0 && !pool->abort)
+			pthread_cond_wait(&pool->q_cond, &pool->mutex);
+
+		--pool->idle;
+
+		if (pool->abort) {
+			pair = NULL;
+		} else {
+			pair = pool->queue[pool->q_head];
+			pool->q_head = (pool->q_head + 1) % pool->q_size;
+			pool->q_len -= 1;
+			self->job = pair;
+
+			pthread_cond_signal(&pool->f_cond);
+		}
+
+		pthread_cleanup_pop(1);
+
+		if (pair == NULL)
+			break;
+
+		probe_worker_runfn(pair);
+		/* cancelation was disabled by probe_worker_runfn */
+		pthread_mutex_lock(&pool->mutex);
+		self->job = NULL;
+		pthread_mutex_unlock(&pool->mutex);
+
+		pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &cstate);
+		pthread_testcancel();
+	}
+
+	return (NULL);
+}
+
+/*
+ * Start a new thread if there are more queued requests than idle threads
+ * and the limit allows it. Must be called with the pool mutex locked.
+ */
+static int probe_wpool_spawn(probe_wpool_t *pool)
+{
+	probe_wthread_t *thr;
+
+	if (pool->q_len <= pool->idle ||
+	    pool->thr_cnt >= pool->thr_max + pool->blocked)
+		return (0);
+
+	thr = oscap_talloc(probe_wthread_t);
+	thr->job  = NULL;
+	thr->pool = pool;
+
+	if ((errno = pthread_create(&thr->tid, NULL, &probe_wpool_thread, thr)) != 0) {
+		dE("Cannot start a new worker thread: %d, %s.\n", errno, strerror(errno));
+		oscap_free(thr);
+		return (-1);
+	}
+
+	pool->thr = oscap_realloc(pool->thr, sizeof(probe_wthread_t *) * (pool->thr_cnt + 1));
+	pool->thr[pool->thr_cnt++] = thr;
+
+	dI("worker thread started, %u threads in the pool\n", pool->thr_cnt);
+
+	return (0);
+}
+
+probe_wpool_t *probe_wpool_new(uint32_t max_threads, uint32_t max_queue)
+{
+	probe_wpool_t *pool = oscap_talloc(probe_wpool_t);
+
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->q_cond, NULL);
+	pthread_cond_init(&pool->f_cond, NULL);
+
+	pool->q_max   = max_queue > 0 ? max_queue : 1;
+	pool->q_size  = pool->q_max;
+	pool->queue   = oscap_alloc(sizeof(probe_pwpair_t *) * pool->q_size);
+	pool->q_head  = 0;
+	pool->q_len   = 0;
+	pool->thr     = NULL;
+	pool->thr_cnt = 0;
+	pool->thr_max = max_threads > 0 ? max_threads : 1;
+	pool->idle    = 0;
+	pool->blocked = 0;
+	pool->abort   = false;
+
+	return (pool);
+}
+
+void probe_wpool_free(probe_wpool_t *pool)
+{
+	if (pool == NULL)
+		return;
+	/*
+	 * Threads which didn't terminate in probe_wpool_abort() may still
+	 * use the pool. Leave it alone, the process is exiting anyway.
+	 */
+	if (pool->thr_cnt > 0)
+		return;
+
+	pthread_cond_destroy(&pool->f_cond);
+	pthread_cond_destroy(&pool->q_cond);
+	pthread_mutex_destroy(&pool->mutex);
+
+	oscap_free(pool->queue);
+	oscap_free(pool->thr);
+	oscap_free(pool);
+}
+
+/*
+ * Queue a request for evaluation. If the queue is full, wait until a
+ * worker thread takes a request from it. The input handler doesn't read
+ * new requests in the meantime, which makes the library wait too.
+ */
+int probe_wpool_dispatch(probe_wpool_t *pool, probe_pwpair_t *pair)
+{
+	pthread_mutex_lock(&pool->mutex);
+
+	while (pool->q_len >= pool->q_max && pool->blocked == 0 && !pool->abort)
+		pthread_cond_wait(&pool->f_cond, &pool->mutex);
+
+	if (pool->abort) {
+		pthread_mutex_unlock(&pool->mutex);
+		errno = ECANCELED;
+		return (-1);
+	}
+
+	if (pool->q_len == pool->q_size) {
+		/*
+		 * Over the limit because some threads are blocked. Grow the
+		 * ring buffer and move the wrapped part behind the old end.
+		 */
+		pool->queue = oscap_realloc(pool->queue, sizeof(probe_pwpair_t *) * pool->q_size * 2);
+		memcpy(pool->queue + pool->q_size, pool->queue, sizeof(probe_pwpair_t *) * pool->q_head);
+		pool->q_size *= 2;
+	}
+
+	pool->queue[(pool->q_head + pool->q_len) % pool->q_size] = pair;
+	pool->q_len += 1;
+
+	if (probe_wpool_spawn(pool) != 0 && pool->thr_cnt == 0) {
+		pool->q_len -= 1;
+		pthread_mutex_unlock(&pool->mutex);
+		return (-1);
+	}
+
+	pthread_cond_signal(&pool->q_cond);
+	pthread_mutex_unlock(&pool->mutex);
+
+	return (0);
+}
+
+/*
+ * Called by a worker thread before it starts waiting for the library.
+ * Its place in the pool is given to another thread for the time being.
+ */
+void probe_wpool_block(probe_wpool_t *pool)
+{
+	pthread_mutex_lock(&pool->mutex);
+	pool->blocked += 1;
+	probe_wpool_spawn(pool);
+	pthread_cond_broadcast(&pool->f_cond);
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+void probe_wpool_unblock(probe_wpool_t *pool)
+{
+	pthread_mutex_lock(&pool->mutex);
+	pool->blocked -= 1;
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+static void probe_wpool_jobfree(probe_pwpair_t *pair)
+{
+	SEAP_msg_free(pair->pth->msg);
+	oscap_free(pair->pth);
+	oscap_free(pair);
+}
+
+/*
+ * Cancel all worker threads and drop queued requests. Wait till the
+ * threads terminate (they may temporarily disable cancelability), but
+ * at most 60 seconds per thread.
+ */
+void probe_wpool_abort(probe_wpool_t *pool)
+{
+	probe_wthread_t **thr;
+	uint32_t i, cnt, left;
+
+	pthread_mutex_lock(&pool->mutex);
+
+	pool->abort = true;
+	pthread_cond_broadcast(&pool->q_cond);
+	pthread_cond_broadcast(&pool->f_cond);
+
+	for (; pool->q_len > 0; --pool->q_len) {
+		probe_wpool_jobfree(pool->queue[pool->q_head]);
+		pool->q_head = (pool->q_head + 1) % pool->q_size;
+	}
+
+	thr = pool->thr;
+	cnt = pool->thr_cnt;
+
+	for (i = 0; i < cnt; ++i)
+		pthread_cancel(thr[i]->tid);
+
+	pool->thr = NULL;
+	pool->thr_cnt = 0;
+
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (i = 0, left = 0; i < cnt; ++i) {
+#if defined(HAVE_PTHREAD_TIMEDJOIN_NP) && defined(HAVE_CLOCK_GETTIME)
+		struct timespec j_tm;
+
+		if (clock_gettime(CLOCK_REALTIME, &j_tm) == -1) {
+			dE("clock_gettime(CLOCK_REALTIME): %d, %s.\n", errno, strerror(errno));
+			thr[left++] = thr[i];
+			continue;
+		}
+
+		j_tm.tv_sec += 60;
+
+		if ((errno = pthread_timedjoin_np(thr[i]->tid, NULL, &j_tm)) != 0) {
+			dE("pthread_timedjoin_np: %d, %s.\n", errno, strerror(errno));
+			/*
+			 * Memory will be leaked here by continuing to the next thread. However, we are in the
+			 * process of shutting down the whole probe. We're just nice and gave the probe_main()
+			 * thread a chance to finish it's critical section which shouldn't take that long...
+			 */
+			thr[left++] = thr[i];
+			continue;
+		}
+#else
+		if ((errno = pthread_join(thr[i]->tid, NULL)) != 0) {
+			dE("pthread_join: %d, %s.\n", errno, strerror(errno));
+			thr[left++] = thr[i];
+			continue;
+		}
+#endif
+		if (thr[i]->job != NULL)
+			probe_wpool_jobfree(thr[i]->job);
+
+		oscap_free(thr[i]);
+	}
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->thr = thr;
+	pool->thr_cnt = left;
+	pthread_mutex_unlock(&pool->mutex);
+}
+
 struct probe_varref_ctx {
 	SEXP_t *pi2;
 	unsigned int ent_cnt;
@@ -317,7 +603,9 @@ static SEXP_t *probe_ste_fetch(probe_t *probe, SEXP_t *id_list)
 	if (i_len == 0)
 		return SEXP_list_new(NULL);
 
+	probe_wpool_block(probe->wpool);
 	res = SEAP_cmd_exec(probe->SEAP_ctx, probe->sd, 0, PROBECMD_STE_FETCH, id_list, SEAP_CMDTYPE_SYNC, NULL, NULL);
+	probe_wpool_unblock(probe->wpool);
 
 	r_len = SEXP_list_length(res);
 
@@ -365,7 +653,9 @@ static SEXP_t *probe_obj_eval(probe_t *probe, SEXP_t *id)
 {
 	SEXP_t *res, *rid;
 
+	probe_wpool_block(probe->wpool);
 	res = SEAP_cmd_exec(probe->SEAP_ctx, probe->sd, 0, PROBECMD_OBJ_EVAL, id, SEAP_CMDTYPE_SYNC, NULL, NULL);
+	probe_wpool_unblock(probe->wpool);
 
 	rid = SEXP_list_first(res);
 	assume_r(SEXP_string_cmp(id, rid) == 0, NULL);
@@ -918,11 +1208,26 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 		*ret = 0;
 	} else {
                 struct probe_ctx pctx;
+		probe_pcache_key_t *pkey;
 		SEXP_t *varrefs, *mask;
 
 		/* simple object */
                 pctx.icache  = probe->icache;
 		pctx.filters = probe_prepare_filters(probe, probe_in);
+		pctx.probe   = probe;
+		pctx.msg     = NULL;
+		pctx.chunk   = NULL;
+		pctx.chunk_len = 0;
+		pctx.chunks    = 0;
+
+		probe_out = probe_pcache_get(probe->pcache, probe->icache, probe_in, pctx.filters, &pkey);
+
+		if (probe_out != NULL) {
+			SEXP_vfree(pctx.filters, probe_in, NULL);
+			*ret = 0;
+			return (probe_out);
+		}
+
                 mask = probe_obj_getmask(probe_in);
 
 		if (OSCAP_GSYM(varref_handling))
@@ -940,6 +1245,13 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
                         pctx.probe_in  = probe_in;
                         pctx.probe_out = probe_out;
 
+			/*
+			 * Send the items to the library in chunks while they
+			 * are being collected if it asked for that.
+			 */
+			if (SEAP_msgattr_exists(msg_in, "chunked"))
+				pctx.msg = msg_in;
+
                         /*
                          * Run the main function of the probe implementation. Set thread
 			 * cancelation type to ASYNC to prevent the code in probe_main to
@@ -955,6 +1267,19 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
                          */
                         probe_icache_nop(probe->icache);
 
+			/*
+			 * If some chunks were sent, send the rest of the items
+			 * too and let probe_worker_runfn() know that the reply
+			 * doesn't have to contain them. Small objects are sent
+			 * in the reply only.
+			 */
+			if (pctx.chunks > 0) {
+				if (probe_chunk_send(&pctx) != 0
+				    || SEAP_msgattr_set(msg_in, "chunks-sent", NULL) != 0)
+					*ret = PROBE_EUNKNOWN;
+			} else
+				SEXP_free(pctx.chunk);
+
 			probe_cobj_compute_flag(probe_out);
 		} else {
 			/*
@@ -967,6 +1292,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 
 			if (probe_varref_create_ctx(probe_in, varrefs, &ctx) != 0) {
 				SEXP_vfree(varrefs, pctx.filters, probe_in, mask, NULL);
+				probe_pcache_key_free(pkey);
 				*ret = PROBE_EUNKNOWN;
 				return (NULL);
 			}
@@ -1003,6 +1329,11 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 			probe_varref_destroy_ctx(ctx);
 		}
 
+		if (*ret == 0 && probe_out != NULL)
+			probe_pcache_put(probe->pcache, pkey, probe_out);
+		else
+			probe_pcache_key_free(pkey);
+
                 SEXP_free(pctx.filters);
 	}
 
@@ -25,6 +25,7 @@
 #include <seap.h>
 #include <sexp.h>
 #include <pthread.h>
+#include <stdbool.h>
 #include "probe.h"
 
 #ifndef PROBE_WORKER_DEFAULT_MAX_THREADS
@@ -35,6 +36,10 @@
 # define PROBE_WORKER_DEFAULT_MAX_CHDEPTH 8 /**< maximum depth of a worker thread chain */
 #endif
 
+#ifndef PROBE_WORKER_DEFAULT_MAX_QUEUE
+# define PROBE_WORKER_DEFAULT_MAX_QUEUE 256 /**< number of queued requests after which the input handler stops reading */
+#endif
+
 typedef struct {
 	SEAP_msgid_t sid; /**< SEAP message handled by this thread */
 	pthread_t    tid; /**< thread ID */
@@ -47,8 +52,49 @@ typedef struct {
 	probe_worker_t *pth;
 } probe_pwpair_t;
 
+typedef struct {
+	pthread_t       tid;
+	probe_pwpair_t *job;  /**< request being handled by the thread or NULL */
+	probe_wpool_t  *pool;
+} probe_wthread_t;
+
+/*
+ * Pool of worker threads. Requests are queued by the input handler and
+ * taken by the first idle thread. A new thread is started only if there
+ * is no idle one and the limit wasn't reached yet. Threads which wait
+ * for a reply from the library (nested object evaluation, state fetch)
+ * don't count against the limit, otherwise requests needed to complete
+ * them could be stuck in the queue. For the same reason the input handler
+ * waits for room in the queue only while no thread is blocked.
+ */
+struct probe_wpool {
+	pthread_mutex_t   mutex;
+	pthread_cond_t    q_cond;  /**< signaled when a request is queued */
+	pthread_cond_t    f_cond;  /**< signaled when the queue has room again */
+
+	probe_pwpair_t  **queue;   /**< request ring buffer */
+	uint32_t          q_head;
+	uint32_t          q_len;
+	uint32_t          q_size;  /**< allocated size of the ring buffer */
+	uint32_t          q_max;   /**< back-pressure threshold */
+
+	probe_wthread_t **thr;
+	uint32_t          thr_cnt;
+	uint32_t          thr_max; /**< maximum number of working (not blocked) threads */
+	uint32_t          idle;
+	uint32_t          blocked;
+	bool              abort;
+};
+
+probe_wpool_t *probe_wpool_new(uint32_t max_threads, uint32_t max_queue);
+void probe_wpool_free(probe_wpool_t *pool);
+int probe_wpool_dispatch(probe_wpool_t *pool, probe_pwpair_t *pair);
+void probe_wpool_block(probe_wpool_t *pool);
+void probe_wpool_unblock(probe_wpool_t *pool);
+void probe_wpool_abort(probe_wpool_t *pool);
+
 probe_worker_t *probe_worker_new(void);
-void *probe_worker_runfn(void *arg);
+void probe_worker_runfn(probe_pwpair_t *pair);
 SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret);
 
 #endif /* WORKER_H */
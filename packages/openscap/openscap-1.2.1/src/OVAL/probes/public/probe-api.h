@@ -280,6 +280,7 @@ int probe_cobj_add_msg(SEXP_t *cobj, const SEXP_t *msg);
 SEXP_t *probe_cobj_get_msgs(const SEXP_t *cobj);
 SEXP_t *probe_cobj_get_mask(const SEXP_t *cobj);
 int probe_cobj_add_item(SEXP_t *cobj, const SEXP_t *item);
+int probe_cobj_add_items(SEXP_t *cobj, SEXP_t *items[], size_t count);
 SEXP_t *probe_cobj_get_items(const SEXP_t *cobj);
 void probe_cobj_set_flag(SEXP_t *cobj, oval_syschar_collection_flag_t flag);
 oval_syschar_collection_flag_t probe_cobj_get_flag(const SEXP_t *cobj);
@@ -488,6 +489,16 @@ int probe_result_additem(SEXP_t *result, SEXP_t *item);
  */
 int probe_item_collect(probe_ctx *ctx, SEXP_t *item);
 
+/**
+ * Collect `count' generated items at once. Cheaper than calling
+ * probe_item_collect for each of them when a probe generates a lot
+ * of items. The function takes ownership of the item references and
+ * returns the same values as probe_item_collect; 1 means that all the
+ * items were filtered out. The implementation of this function is
+ * placed in the `probe/icache.c' file.
+ */
+int probe_item_collect_batch(probe_ctx *ctx, SEXP_t *items[], size_t count);
+
 /**
  * Return reference to the input object. The reference counter
  * is NOT incremented by this operation (i.e. don't call SEXP_free
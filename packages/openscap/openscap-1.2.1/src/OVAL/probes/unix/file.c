@@ -115,9 +115,15 @@ static SEXP_t *se_filetype (mode_t mode)
         return (NULL);
 }
 
+#ifndef FILE_ITEM_BATCH
+#define FILE_ITEM_BATCH 256 /* items collected at once */
+#endif
+
 struct cbargs {
         probe_ctx *ctx;
 	int     error;
+	SEXP_t *items[FILE_ITEM_BATCH]; /* not collected yet */
+	size_t  count;
 };
 
 static rbt_t   *g_ID_cache     = NULL;
@@ -267,6 +273,19 @@ static SEXP_t *has_extended_acl(const char *path)
 #endif
 }
 
+/*
+ * Collect the pending items. Returns 1 if we hit the memory usage
+ * limit, 0 otherwise.
+ */
+static int file_flush (struct cbargs *args)
+{
+	size_t count = args->count;
+
+	args->count = 0;
+
+	return probe_item_collect_batch(args->ctx, args->items, count) == 2 ? 1 : 0;
+}
+
 static int file_cb (const char *p, const char *f, void *ptr)
 {
         char path_buffer[PATH_MAX];
@@ -356,7 +375,9 @@ static int file_cb (const char *p, const char *f, void *ptr)
 		 * Stop collecting if we hit the memory usage limit
 		 * (return code == 2)
 		 */
-                return probe_item_collect(args->ctx, item) == 2 ? 1 : 0;
+		args->items[args->count++] = item;
+
+		return args->count == FILE_ITEM_BATCH ? file_flush(args) : 0;
         }
 
         return (0);
@@ -408,6 +429,8 @@ void *probe_init (void)
 	 */
 	ID_cache_init(10000);
 
+	probe_setoption(PROBEOPT_PERSISTENT_CACHE, PROBE_PCACHE_DEP_OBJPATH, NULL);
+
         /*
          * Initialize mutex.
          */
@@ -503,6 +526,7 @@ int probe_main (probe_ctx *ctx, void *mutex)
 
         cbargs.ctx     = ctx;
 	cbargs.error   = 0;
+	cbargs.count   = 0;
 
 	if ((ofts = oval_fts_open(path, filename, filepath, behaviors)) != NULL) {
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
@@ -515,6 +539,7 @@ int probe_main (probe_ctx *ctx, void *mutex)
 		oval_fts_close(ofts);
 	}
 
+	file_flush(&cbargs);
 	err = 0;
 
 	SEXP_free(path);
@@ -197,6 +197,8 @@ void *probe_init (void)
 {
 	SEXP_init(&gr_lastpath);
 
+	probe_setoption(PROBEOPT_PERSISTENT_CACHE, PROBE_PCACHE_DEP_OBJPATH, NULL);
+
         /*
          * Initialize mutex.
          */
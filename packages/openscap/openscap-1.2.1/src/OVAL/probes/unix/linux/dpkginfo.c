@@ -53,6 +53,8 @@
 /* SEAP */
 #include <seap.h>
 #include <probe-api.h>
+#include <probe/probe.h>
+#include <probe/option.h>
 #include <alloc.h>
 
 
@@ -71,6 +73,9 @@ void *probe_init(void)
         pthread_mutex_init (&(g_dpkg.mutex), NULL);
         dpkginfo_init();
 
+        probe_setoption(PROBEOPT_PERSISTENT_CACHE, PROBE_PCACHE_DEP_NONE,
+                        "/var/lib/dpkg", "/var/lib/dpkg/status", NULL);
+
         return ((void *)&g_dpkg);
 }
 
@@ -59,12 +59,24 @@
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <regex.h>
+#include <unistd.h>
+#include <linux/version.h>
+
+/* sock_diag and the version 2 inet_diag requests are in Linux 3.3 */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,3,0)
+#define HAVE_SOCK_DIAG 1
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#endif
 
 #include "seap.h"
 #include "probe-api.h"
 #include "probe/entcmp.h"
 #include "alloc.h"
 #include "common/debug_priv.h"
+#include "proc-snapshot.h"
 
 /* This structure contains the information OVAL is asking or requesting */
 struct server_info {
@@ -82,222 +94,9 @@ struct result_info {
 	unsigned rport;
 };
 
-/* This structure is used to store information from scanning all runnning
- * processes. It will be used later to augment server info */
-typedef struct _lnode {
-  pid_t pid;            // process ID
-  uid_t uid;            // effective user ID
-  char *cmd;            // command run by user
-  unsigned long inode;  // inode of socket
-  struct _lnode* next;  // Next node pointer
-} lnode;
-
-/* This is the linked list head. Only data elements go here. */
-typedef struct {
-  lnode *head;          // List head
-  lnode *cur;           // Pointer to current node
-} llist;
-
 /* Local data */
 static struct server_info req;
 
-/* Function prototypes */
-static inline lnode *list_get_cur(llist *l) { return l->cur; }
-static void list_create(llist *l);
-static void list_append(llist *l, lnode *node);
-static void list_clear(llist* l);
-static lnode *list_find_inode(llist *l, unsigned long i);
-
-
-static void list_create(llist *l)
-{
-	l->head = NULL;
-	l->cur = NULL;
-}
-
-static void list_append(llist *l, lnode *node)
-{
-	lnode* newnode;
-
-	if (node == NULL || l == NULL)
-		return;
-
-	newnode = malloc(sizeof(lnode));
-	if (newnode == NULL)
-		return;
-
-	newnode->pid = node->pid;
-	newnode->uid = node->uid;
-	newnode->inode = node->inode;
-	// Take custody of the memory
-	newnode->cmd = node->cmd;
-	newnode->next = NULL;
-
-	// if we are at top, fix this up
-	if (l->head == NULL)
-		l->head = newnode;
-	else	// Otherwise add pointer to newnode
-		l->cur->next = newnode;
-
-	// make newnode current
-	l->cur = newnode;
-}
-
-static void list_clear(llist* l)
-{
-	lnode* nextnode;
-	register lnode* cur;
-
-	cur = l->head;
-	while (cur) {
-		nextnode=cur->next;
-		free(cur->cmd);
-		free(cur);
-		cur=nextnode;
-	}
-	l->head = NULL;
-	l->cur = NULL;
-}
-
-static lnode *list_find_inode(llist *l, unsigned long i)
-{
-        register lnode* cur;
-
-       	cur = l->head;	/* start at the beginning */
-	while (cur) {
-		if (cur->inode == i) {
-			l->cur = cur;
-			return cur;
-		} else
-			cur = cur->next;
-	}
-	return NULL;
-}
-
-static int collect_process_info(llist *l)
-{
-	DIR *d, *f;
-	struct dirent *ent;
-
-	d = opendir("/proc");
-	if (d == NULL)
-		return 1;
-
-	while (( ent = readdir(d) )) {
-		FILE *sf;
-		int pid, ppid;
-		char buf[100];
-		char *tmp, cmd[16], state, *text = NULL;
-		int fd, len, euid = 0;
-
-		// Skip non-process dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno)
-			continue;
-
-		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
-			continue;
-		memset(cmd, 0, sizeof(cmd));
-		sscanf(buf, "%d (%15c", &ppid, cmd);
-		sscanf(tmp+2, "%c %d", &state, &ppid);
-
-		// Skip kthreads
-		if (pid == 2 || ppid == 2)
-			continue;
-
-		// Get the effective uid
-		snprintf(buf, 32, "/proc/%d/status", pid);
-		sf = fopen(buf, "rt");
-		if (sf) {
-			int line = 0;
-			__fsetlocking(sf, FSETLOCKING_BYCALLER);
-			while (fgets(buf, sizeof(buf), sf)) {
-				if (line == 0) {
-					line++;
-					continue;
-				}
-				if (memcmp(buf, "Uid:", 4) == 0) {
-					int id;
-					sscanf(buf, "Uid: %d %d",
-						&id, &euid);
-					break;
-				}
-			}
-			fclose(sf);
-		}
-
-		// Now lets get the inodes each process has open
-		snprintf(buf, 32, "/proc/%d/fd", pid);
-		f = opendir(buf);
-		if (f == NULL) {
-			// Process might have ended or we don;t have access - ignore it
-			free(text);
-			continue;
-		}
-		// For each file in the fd dir...
-		while (( ent = readdir(f) )) {
-			char line[256], ln[256], *s, *e;
-			unsigned long inode;
-			lnode node;
-			int lnlen;
-
-			if (ent->d_name[0] == '.')
-				continue;
-			snprintf(ln, 256, "%s/%s", buf, ent->d_name);
-			if ((lnlen = readlink(ln, line, sizeof(line)-1)) < 0)
-				continue;
-			line[lnlen] = 0;
-
-			// Only look at the socket entries
-			if (memcmp(line, "socket:", 7) == 0) {
-				// Type 1 sockets
-				s = strchr(line+7, '[');
-				if (s == NULL)
-					continue;
-				s++;
-				e = strchr(s, ']');
-				if (e == NULL)
-					continue;
-				*e = 0;
-			} else if (memcmp(line, "[0000]:", 7) == 0) {
-				// Type 2 sockets
-				s = line + 8;
-			} else
-				continue;
-			errno = 0;
-			inode = strtoul(s, NULL, 10);
-			if (errno)
-				continue;
-			node.pid = pid;
-			node.uid = euid;
-			node.cmd = strdup(cmd);
-			node.inode = inode;
-			// We make one entry for each socket inode
-			list_append(l, &node);
-		}
-		closedir(f);
-		free(text);
-	}
-	closedir(d);
-	return 0;
-}
-
 static int eval_data(const char *type, const char *local_address,
 	unsigned int local_port)
 {
@@ -327,17 +126,15 @@ static int eval_data(const char *type, const char *local_address,
 	return 1;
 }
 
-static void report_finding(struct result_info *res, llist *l, probe_ctx *ctx)
+static void report_finding(struct result_info *res, const struct proc_entry *n, probe_ctx *ctx)
 {
         SEXP_t *item;
         SEXP_t se_lport_mem, se_rport_mem, se_lfull_mem, se_ffull_mem, *se_uid_mem = NULL;
-	lnode *n = NULL;
-
-	if (l) {
-		n = list_get_cur(l);
-	}
 
 	if (n) {
+		// The effective uid defaults to 0 if it couldn't be read
+		uid_t uid = n->euid != -1 ? n->euid : 0;
+
                 item = probe_item_create(OVAL_LINUX_INET_LISTENING_SERVER, NULL,
                                  "protocol",             OVAL_DATATYPE_STRING,  res->proto,
                                  "local_address",        OVAL_DATATYPE_STRING,  res->laddr,
@@ -350,7 +147,7 @@ static void report_finding(struct result_info *res, llist *l, probe_ctx *ctx)
                                  "foreign_full_address", OVAL_DATATYPE_SEXP,    SEXP_string_newf_r(&se_ffull_mem,
                                                                                                    "%s:%u", res->raddr, res->rport),
                                  "pid",                  OVAL_DATATYPE_INTEGER, (int64_t)n->pid,
-				 "user_id",              OVAL_DATATYPE_SEXP, se_uid_mem = SEXP_number_newu_64(n->uid),
+				 "user_id",              OVAL_DATATYPE_SEXP, se_uid_mem = SEXP_number_newu_64(uid),
                                  NULL);
 	} else {
                 item = probe_item_create(OVAL_LINUX_INET_LISTENING_SERVER, NULL,
@@ -390,8 +187,113 @@ static void addr_convert(const char *src, char *dest, int size)
 	}
 }
 
+static void check_socket(const char *type, const char *laddr, unsigned lport,
+	const char *raddr, unsigned rport, unsigned long inode,
+	struct proc_snapshot *snap, probe_ctx *ctx)
+{
+	if (eval_data(type, laddr, lport)) {
+		struct result_info r;
+		r.proto = type;
+		r.laddr = laddr;
+		r.lport = lport;
+		r.raddr = raddr;
+		r.rport = rport;
+		report_finding(&r, proc_snapshot_socket(snap, inode), ctx);
+	}
+}
 
-static int read_tcp(const char *proc, const char *type, llist *l, probe_ctx *ctx)
+#ifdef HAVE_SOCK_DIAG
+/*
+ * Dump the sockets of `family' and `protocol' through NETLINK_SOCK_DIAG.
+ * The kernel sends the binary socket records, which is a lot cheaper than
+ * formatting and parsing /proc/net/{tcp,udp}{,6} on hosts with many
+ * sockets.
+ * @return 0 on success, -1 if the kernel can't dump these sockets and
+ * nothing was reported (the /proc/net files have to be read instead),
+ * 1 on other errors
+ */
+static int read_diag(int family, int protocol, const char *type, struct proc_snapshot *snap, probe_ctx *ctx)
+{
+	struct sockaddr_nl nladdr;
+	struct {
+		struct nlmsghdr nlh;
+		struct inet_diag_req_v2 req;
+	} msg;
+	long buf[8192 / sizeof(long)];
+	int fd, len, ret = -1;
+	size_t count = 0;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+	if (fd == -1)
+		return -1;
+
+	memset(&nladdr, 0, sizeof nladdr);
+	nladdr.nl_family = AF_NETLINK;
+
+	memset(&msg, 0, sizeof msg);
+	msg.nlh.nlmsg_len = sizeof msg;
+	msg.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+	msg.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	msg.nlh.nlmsg_seq = 1;
+	msg.req.sdiag_family = family;
+	msg.req.sdiag_protocol = protocol;
+	msg.req.idiag_states = ~0U; /* all the states, like /proc/net */
+
+	if (sendto(fd, &msg, sizeof msg, 0, (struct sockaddr *)&nladdr, sizeof nladdr) == -1)
+		goto out;
+
+	for (;;) {
+		struct nlmsghdr *nlh;
+
+		len = recv(fd, buf, sizeof buf, 0);
+		if (len == -1) {
+			if (errno == EINTR)
+				continue;
+			goto out;
+		}
+		if (len == 0)
+			goto out;
+
+		for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+			struct inet_diag_msg *diag;
+			char src[NI_MAXHOST], dest[NI_MAXHOST];
+
+			if (nlh->nlmsg_type == NLMSG_DONE) {
+				/* errors of the dump, e.g. a missing diag module, are in the payload */
+				if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(int)) || *(int *)NLMSG_DATA(nlh) >= 0)
+					ret = 0;
+				goto out;
+			}
+			if (nlh->nlmsg_type == NLMSG_ERROR)
+				goto out;
+			if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY ||
+			    nlh->nlmsg_len < NLMSG_LENGTH(sizeof *diag))
+				continue;
+
+			diag = NLMSG_DATA(nlh);
+			++count;
+
+			inet_ntop(family, diag->id.idiag_src, src, NI_MAXHOST);
+			inet_ntop(family, diag->id.idiag_dst, dest, NI_MAXHOST);
+			dI("Have %s port: %s:%u\n", type, src, ntohs(diag->id.idiag_sport));
+			check_socket(type, src, ntohs(diag->id.idiag_sport),
+				     dest, ntohs(diag->id.idiag_dport), diag->idiag_inode, snap, ctx);
+		}
+	}
+ out:
+	close(fd);
+	if (ret == -1 && count > 0)
+		ret = 1;
+	return ret;
+}
+#else
+static int read_diag(int family, int protocol, const char *type, struct proc_snapshot *snap, probe_ctx *ctx)
+{
+	return -1;
+}
+#endif
+
+static int read_tcp(const char *proc, const char *type, struct proc_snapshot *snap, probe_ctx *ctx)
 {
 	int line = 0;
 	FILE *f;
@@ -425,25 +327,13 @@ static int read_tcp(const char *proc, const char *type, llist *l, probe_ctx *ctx
 		addr_convert(local_addr, src, NI_MAXHOST);
 		addr_convert(rem_addr, dest, NI_MAXHOST);
 		dI("Have tcp port: %s:%u\n", src, local_port);
-		if (eval_data(type, src, local_port)) {
-			struct result_info r;
-			r.proto = type;
-			r.laddr = src;
-			r.lport = local_port;
-			r.raddr = dest;
-			r.rport = rem_port;
-			if (list_find_inode(l, inode)) {
-				report_finding(&r, l, ctx);
-			} else {
-				report_finding(&r, NULL, ctx);
-			}
-		}
+		check_socket(type, src, local_port, dest, rem_port, inode, snap, ctx);
 	}
 	fclose(f);
 	return 0;
 }
 
-static int read_udp(const char *proc, const char *type, llist *l, probe_ctx *ctx)
+static int read_udp(const char *proc, const char *type, struct proc_snapshot *snap, probe_ctx *ctx)
 {
 	int line = 0;
 	FILE *f;
@@ -476,25 +366,13 @@ static int read_udp(const char *proc, const char *type, llist *l, probe_ctx *ctx
 		addr_convert(local_addr, src, NI_MAXHOST);
 		addr_convert(rem_addr, dest, NI_MAXHOST);
 		dI("Have udp port: %s:%u\n", src, local_port);
-		if (eval_data(type, src, local_port)) {
-			struct result_info r;
-			r.proto = type;
-			r.laddr = src;
-			r.lport = local_port;
-			r.raddr = dest;
-			r.rport = rem_port;
-			if (list_find_inode(l, inode)) {
-				report_finding(&r, l, ctx);
-			} else {
-				report_finding(&r, NULL, ctx);
-			}
-		}
+		check_socket(type, src, local_port, dest, rem_port, inode, snap, ctx);
 	}
 	fclose(f);
 	return 0;
 }
 
-static int read_raw(const char *proc, const char *type, llist *l, probe_ctx *ctx)
+static int read_raw(const char *proc, const char *type, struct proc_snapshot *snap, probe_ctx *ctx)
 {
 	int line = 0;
 	FILE *f;
@@ -527,19 +405,7 @@ static int read_raw(const char *proc, const char *type, llist *l, probe_ctx *ctx
 		addr_convert(local_addr, src, NI_MAXHOST);
 		addr_convert(rem_addr, dest, NI_MAXHOST);
 		dI("Have raw port: %s:%u\n", src, local_port);
-		if (eval_data(type, src, local_port)) {
-			struct result_info r;
-			r.proto = type;
-			r.laddr = src;
-			r.lport = local_port;
-			r.raddr = dest;
-			r.rport = rem_port;
-			if (list_find_inode(l, inode)) {
-				report_finding(&r, l, ctx);
-			} else {
-				report_finding(&r, NULL, ctx);
-			}
-		}
+		check_socket(type, src, local_port, dest, rem_port, inode, snap, ctx);
 	}
 	fclose(f);
 	return 0;
@@ -549,7 +415,7 @@ int probe_main(probe_ctx *ctx, void *arg)
 {
         SEXP_t *object;
 	int err;
-	llist ll;
+	struct proc_snapshot *snap;
 
         object = probe_ctx_getobject(ctx);
 
@@ -572,8 +438,8 @@ int probe_main(probe_ctx *ctx, void *arg)
 	}
 
 	// Now start collecting the info
-	list_create(&ll);
-	if (collect_process_info(&ll)) {
+	snap = proc_snapshot_get(PROC_SNAPSHOT_UIDS | PROC_SNAPSHOT_SOCKETS);
+	if (snap == NULL) {
 		SEXP_t *msg;
 
 		msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_ERROR, "Permission error.");
@@ -585,20 +451,26 @@ int probe_main(probe_ctx *ctx, void *arg)
 		goto cleanup;
 	}
 
-	// Now we check the tcp socket list...
-	read_tcp("/proc/net/tcp", "tcp", &ll, ctx);
-	read_tcp("/proc/net/tcp6", "tcp", &ll, ctx);
+	// Now we check the tcp socket list, the /proc/net files are
+	// only read if the kernel can't send it through netlink...
+	if (read_diag(AF_INET, IPPROTO_TCP, "tcp", snap, ctx) == -1)
+		read_tcp("/proc/net/tcp", "tcp", snap, ctx);
+	if (read_diag(AF_INET6, IPPROTO_TCP, "tcp", snap, ctx) == -1)
+		read_tcp("/proc/net/tcp6", "tcp", snap, ctx);
 
 	// Next udp sockets...
-	read_udp("/proc/net/udp", "udp", &ll, ctx);
-	read_udp("/proc/net/udp6", "udp", &ll, ctx);
+	if (read_diag(AF_INET, IPPROTO_UDP, "udp", snap, ctx) == -1)
+		read_udp("/proc/net/udp", "udp", snap, ctx);
+	if (read_diag(AF_INET6, IPPROTO_UDP, "udp", snap, ctx) == -1)
+		read_udp("/proc/net/udp6", "udp", snap, ctx);
 
 	// Next, raw sockets...not exactly part of standard yet. They
-	// can be used to send datagrams, so we will pretend they are udp
-	read_raw("/proc/net/raw", "udp", &ll, ctx);
-	read_raw("/proc/net/raw6", "udp", &ll, ctx);
+	// can be used to send datagrams, so we will pretend they are udp.
+	// They are always read from /proc/net, raw_diag is too recent.
+	read_raw("/proc/net/raw", "udp", snap, ctx);
+	read_raw("/proc/net/raw6", "udp", snap, ctx);
 
-	list_clear(&ll);
+	proc_snapshot_put(snap);
 
 	err = 0;
  cleanup:
@@ -606,3 +478,8 @@ int probe_main(probe_ctx *ctx, void *arg)
 
 	return err;
 }
+
+void probe_fini(void *arg)
+{
+	proc_snapshot_cleanup();
+}
@@ -0,0 +1,595 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if defined(__linux__)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#ifdef HAVE_STDIO_EXT_H
+# include <stdio_ext.h>
+#endif
+
+#include <alloc.h>
+#include "common/debug_priv.h"
+#include "proc-snapshot.h"
+
+#define PROC_SNAPSHOT_MAX_THREADS 8
+/* Don't start a thread for less processes than this */
+#define PROC_SNAPSHOT_MIN_PER_THREAD 256
+
+static struct proc_snapshot *g_snapshot = NULL;
+static pthread_mutex_t       g_snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+
+struct proc_reader {
+	struct proc_snapshot *snap;
+	const char *root;
+	bool *valid;
+	size_t first;
+	size_t step;
+};
+
+/*
+ * Parse /proc/<pid>/stat the same way as ps does.
+ * @return 0 or -1 if the process is gone or is a kernel thread
+ */
+static int proc_read_stat(const char *root, struct proc_entry *p)
+{
+	char path[PATH_MAX], buf[256], *tmp;
+	int fd, len;
+
+	snprintf(path, sizeof path, "%s/%d/stat", root, p->pid);
+	fd = open(path, O_RDONLY, 0);
+	if (fd < 0)
+		return (-1);
+	len = read(fd, buf, sizeof buf - 1);
+	close(fd);
+	if (len < 40)
+		return (-1);
+	buf[len] = 0;
+	tmp = strrchr(buf, ')');
+	if (tmp)
+		*tmp = 0;
+	else
+		return (-1);
+	memset(p->cmd, 0, sizeof(p->cmd));
+	sscanf(buf, "%d (%15c", &p->ppid, p->cmd);
+	sscanf(tmp+2,	"%c %d %d %d %d %d "
+			"%u %*u %*u %*u %*u "
+			"%lu %lu %*u %*d %ld "
+			"%*d %*d %*d %llu",
+		&p->state, &p->ppid, &p->pgrp, &p->session, &p->tty_nr, &p->tpgid,
+		&p->flags, &p->utime, &p->stime, &p->priority, &p->start
+	);
+
+	// Skip kthreads
+	if (p->ppid == 2)
+		return (-1);
+
+	return (0);
+}
+
+static void proc_read_uids(const char *root, struct proc_entry *p)
+{
+	char path[PATH_MAX], buf[100];
+	FILE *sf;
+	int line = 0;
+
+	snprintf(path, sizeof path, "%s/%d/status", root, p->pid);
+	sf = fopen(path, "rt");
+	if (sf == NULL)
+		return;
+
+	__fsetlocking(sf, FSETLOCKING_BYCALLER);
+	while (fgets(buf, sizeof(buf), sf)) {
+		if (line == 0) {
+			line++;
+			continue;
+		}
+		if (memcmp(buf, "Uid:", 4) == 0) {
+			sscanf(buf, "Uid: %d %d", &p->ruid, &p->euid);
+			break;
+		}
+	}
+	fclose(sf);
+}
+
+static void proc_read_loginuid(const char *root, struct proc_entry *p)
+{
+	char path[PATH_MAX];
+	FILE *sf;
+
+	snprintf(path, sizeof path, "%s/%d/loginuid", root, p->pid);
+	sf = fopen(path, "rt");
+	if (sf == NULL)
+		return;
+
+	if (fscanf(sf, "%u", &p->loginuid) < 1) {
+		dW("fscanf failed from %s\n", path);
+	}
+	fclose(sf);
+}
+
+static void proc_read_sockets(const char *root, struct proc_entry *p)
+{
+	char path[PATH_MAX];
+	struct dirent *ent;
+	size_t size = 0;
+	DIR *f;
+
+	snprintf(path, sizeof path, "%s/%d/fd", root, p->pid);
+	f = opendir(path);
+	if (f == NULL) {
+		// Process might have ended or we don't have access - ignore it
+		return;
+	}
+	// For each file in the fd dir...
+	while (( ent = readdir(f) )) {
+		char line[256], *s, *e;
+		unsigned long inode;
+		int lnlen;
+
+		if (ent->d_name[0] == '.')
+			continue;
+		if ((lnlen = readlinkat(dirfd(f), ent->d_name, line, sizeof(line)-1)) < 0)
+			continue;
+		line[lnlen] = 0;
+
+		// Only look at the socket entries
+		if (memcmp(line, "socket:", 7) == 0) {
+			// Type 1 sockets
+			s = strchr(line+7, '[');
+			if (s == NULL)
+				continue;
+			s++;
+			e = strchr(s, ']');
+			if (e == NULL)
+				continue;
+			*e = 0;
+		} else if (memcmp(line, "[0000]:", 7) == 0) {
+			// Type 2 sockets
+			s = line + 8;
+		} else
+			continue;
+		errno = 0;
+		inode = strtoul(s, NULL, 10);
+		if (errno)
+			continue;
+
+		if (p->socket_count == size) {
+			size = size > 0 ? size * 2 : 8;
+			p->sockets = oscap_realloc(p->sockets, sizeof(unsigned long) * size);
+		}
+		p->sockets[p->socket_count++] = inode;
+	}
+	closedir(f);
+}
+
+static void *proc_reader_run(void *arg)
+{
+	struct proc_reader *r = arg;
+	struct proc_snapshot *snap = r->snap;
+	size_t i;
+
+	for (i = r->first; i < snap->count; i += r->step) {
+		struct proc_entry *p = snap->proc + i;
+
+		if (proc_read_stat(r->root, p) != 0)
+			continue;
+		if (snap->flags & PROC_SNAPSHOT_UIDS)
+			proc_read_uids(r->root, p);
+		if (snap->flags & PROC_SNAPSHOT_LOGINUID)
+			proc_read_loginuid(r->root, p);
+		if (snap->flags & PROC_SNAPSHOT_SOCKETS)
+			proc_read_sockets(r->root, p);
+
+		r->valid[i] = true;
+	}
+
+	return (NULL);
+}
+
+static unsigned long proc_read_boot_time(const char *root)
+{
+	char path[PATH_MAX], buf[100];
+	unsigned long boot = 0;
+	FILE *sf;
+	int line;
+
+	snprintf(path, sizeof path, "%s/stat", root);
+	sf = fopen(path, "rt");
+	if (sf == NULL)
+		return (0);
+
+	line = 0;
+	__fsetlocking(sf, FSETLOCKING_BYCALLER);
+	while (fgets(buf, sizeof(buf), sf)) {
+		if (line == 0) {
+			line++;
+			continue;
+		}
+		if (memcmp(buf, "btime", 5) == 0) {
+			sscanf(buf, "btime %lu", &boot);
+			break;
+		}
+	}
+	fclose(sf);
+
+	return (boot);
+}
+
+/*
+ * List the process directories. The entries are filled in later, the
+ * ones which turn out not to be processes are then dropped.
+ */
+static int proc_list(const char *root, struct proc_snapshot *snap)
+{
+	struct dirent *ent;
+	size_t size = 0;
+	DIR *d;
+
+	d = opendir(root);
+	if (d == NULL)
+		return (-1);
+
+	while (( ent = readdir(d) )) {
+		struct proc_entry *p;
+		int pid;
+
+		// Skip non-process dir entries
+		if(*ent->d_name<'0' || *ent->d_name>'9')
+			continue;
+		errno = 0;
+		pid = strtol(ent->d_name, NULL, 10);
+		if (errno || pid == 2) // skip err & kthreads
+			continue;
+
+		if (snap->count == size) {
+			size = size > 0 ? size * 2 : 512;
+			snap->proc = oscap_realloc(snap->proc, sizeof(struct proc_entry) * size);
+		}
+
+		p = snap->proc + snap->count++;
+		memset(p, 0, sizeof *p);
+		p->pid = pid;
+		p->ruid = -1;
+		p->euid = -1;
+		p->loginuid = -1;
+	}
+	closedir(d);
+
+	return (0);
+}
+
+static void proc_index_sockets(struct proc_snapshot *snap)
+{
+	size_t total = 0, mask, i, j;
+
+	for (i = 0; i < snap->count; ++i)
+		total += snap->proc[i].socket_count;
+
+	for (snap->socket_size = 16; snap->socket_size < 2 * total; snap->socket_size *= 2)
+		;
+	snap->sockets = oscap_calloc(snap->socket_size, sizeof(struct proc_socket));
+	mask = snap->socket_size - 1;
+
+	/* the first process which has the socket open wins */
+	for (i = 0; i < snap->count; ++i) {
+		struct proc_entry *p = snap->proc + i;
+
+		for (j = 0; j < p->socket_count; ++j) {
+			size_t h = (p->sockets[j] * 2654435761UL) & mask;
+
+			while (snap->sockets[h].proc != NULL && snap->sockets[h].inode != p->sockets[j])
+				h = (h + 1) & mask;
+
+			if (snap->sockets[h].proc == NULL) {
+				snap->sockets[h].inode = p->sockets[j];
+				snap->sockets[h].proc  = p;
+			}
+		}
+	}
+}
+
+struct proc_snapshot *proc_snapshot_new(const char *root, int flags, unsigned int threads)
+{
+	struct proc_snapshot *snap;
+	struct proc_reader *reader;
+	pthread_t *tid;
+	unsigned int started = 1;
+	size_t i, j;
+	bool *valid;
+
+	snap = oscap_talloc(struct proc_snapshot);
+	memset(snap, 0, sizeof *snap);
+	snap->flags = flags;
+	snap->time  = time(NULL);
+	snap->refs  = 1;
+	pthread_mutex_init(&snap->data_lock, NULL);
+
+	if (proc_list(root, snap) != 0) {
+		proc_snapshot_free(snap);
+		return (NULL);
+	}
+
+	// Get the time tick hertz
+	snap->ticks = (unsigned long)sysconf(_SC_CLK_TCK);
+	snap->boot  = proc_read_boot_time(root);
+
+	if (threads > snap->count / PROC_SNAPSHOT_MIN_PER_THREAD)
+		threads = snap->count / PROC_SNAPSHOT_MIN_PER_THREAD;
+	if (threads < 1)
+		threads = 1;
+
+	valid  = oscap_calloc(snap->count > 0 ? snap->count : 1, sizeof(bool));
+	reader = oscap_alloc(sizeof(struct proc_reader) * threads);
+	tid    = oscap_alloc(sizeof(pthread_t) * threads);
+
+	for (i = 0; i < threads; ++i) {
+		reader[i].snap  = snap;
+		reader[i].root  = root;
+		reader[i].valid = valid;
+		reader[i].first = i;
+		reader[i].step  = threads;
+	}
+
+	/* the calling thread reads its share too */
+	for (i = 1; i < threads; ++i) {
+		int ret = pthread_create(tid + i, NULL, proc_reader_run, reader + i);
+
+		if (ret != 0) {
+			dW("Can't start a thread: %s\n", strerror(ret));
+			break;
+		}
+		++started;
+	}
+
+	/* read what the threads which didn't start would have read */
+	for (i = started; i < threads; ++i)
+		proc_reader_run(reader + i);
+
+	proc_reader_run(reader);
+
+	for (i = 1; i < started; ++i)
+		pthread_join(tid[i], NULL);
+
+	oscap_free(reader);
+	oscap_free(tid);
+
+	/* Drop the entries which aren't processes, keep the order */
+	for (i = j = 0; i < snap->count; ++i) {
+		if (!valid[i]) {
+			oscap_free(snap->proc[i].sockets);
+			continue;
+		}
+		if (i != j)
+			snap->proc[j] = snap->proc[i];
+		++j;
+	}
+	snap->count = j;
+	oscap_free(valid);
+
+	if (flags & PROC_SNAPSHOT_SOCKETS)
+		proc_index_sockets(snap);
+
+	dI("Read %zu processes from %s using %u threads\n", snap->count, root, threads);
+
+	return (snap);
+}
+
+void proc_snapshot_free(struct proc_snapshot *snap)
+{
+	size_t i;
+
+	if (snap == NULL)
+		return;
+
+	for (i = 0; i < snap->count; ++i) {
+		oscap_free(snap->proc[i].sockets);
+		if (snap->proc[i].data != NULL)
+			snap->data_free(snap->proc[i].data);
+	}
+
+	oscap_free(snap->proc);
+	oscap_free(snap->sockets);
+	pthread_mutex_destroy(&snap->data_lock);
+	oscap_free(snap);
+}
+
+struct proc_entry *proc_snapshot_socket(const struct proc_snapshot *snap, unsigned long inode)
+{
+	size_t h, mask;
+
+	if (snap->sockets == NULL)
+		return (NULL);
+
+	mask = snap->socket_size - 1;
+	h = (inode * 2654435761UL) & mask;
+
+	while (snap->sockets[h].proc != NULL) {
+		if (snap->sockets[h].inode == inode)
+			return (snap->sockets[h].proc);
+		h = (h + 1) & mask;
+	}
+
+	return (NULL);
+}
+
+static time_t proc_snapshot_ttl(void)
+{
+	const char *str = getenv("OSCAP_PROBE_PROC_SNAPSHOT_TTL");
+	char *end;
+	unsigned long val;
+
+	if (str == NULL)
+		return (PROC_SNAPSHOT_DEFAULT_TTL);
+
+	errno = 0;
+	val = strtoul(str, &end, 10);
+
+	if (errno != 0 || *end != '\0' || end == str) {
+		dW("Ignoring invalid value of OSCAP_PROBE_PROC_SNAPSHOT_TTL: %s\n", str);
+		return (PROC_SNAPSHOT_DEFAULT_TTL);
+	}
+
+	return ((time_t)val);
+}
+
+static unsigned int proc_snapshot_threads(void)
+{
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (ncpu < 1)
+		return (1);
+	if (ncpu > PROC_SNAPSHOT_MAX_THREADS)
+		return (PROC_SNAPSHOT_MAX_THREADS);
+
+	return ((unsigned int)ncpu);
+}
+
+static void proc_snapshot_lock(pthread_mutex_t *lock, int *prev_cancel_state)
+{
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, prev_cancel_state);
+
+	if (pthread_mutex_lock(lock) != 0) {
+		dE("Can't lock mutex\n");
+		abort();
+	}
+}
+
+static void proc_snapshot_unlock(pthread_mutex_t *lock, int prev_cancel_state)
+{
+	if (pthread_mutex_unlock(lock) != 0) {
+		dE("Can't unlock mutex\n");
+		abort();
+	}
+
+	pthread_setcancelstate(prev_cancel_state, NULL);
+}
+
+/* Called with g_snapshot_lock held */
+static void proc_snapshot_release(struct proc_snapshot *snap)
+{
+	if (--snap->refs == 0)
+		proc_snapshot_free(snap);
+}
+
+struct proc_snapshot *proc_snapshot_get(int flags)
+{
+	struct proc_snapshot *snap;
+	int prev_cancel_state = -1;
+	time_t now = time(NULL);
+
+	/*
+	 * The snapshot is taken with the lock held so that the objects
+	 * evaluated at the same time don't read /proc each on their own.
+	 */
+	proc_snapshot_lock(&g_snapshot_lock, &prev_cancel_state);
+
+	snap = g_snapshot;
+
+	if (snap != NULL &&
+	    ((snap->flags & flags) != flags || now < snap->time ||
+	     now - snap->time >= proc_snapshot_ttl()))
+	{
+		flags |= snap->flags;
+		g_snapshot = NULL;
+		proc_snapshot_release(snap);
+		snap = NULL;
+	}
+
+	if (snap == NULL)
+		snap = g_snapshot = proc_snapshot_new("/proc", flags, proc_snapshot_threads());
+
+	if (snap != NULL)
+		++snap->refs;
+
+	proc_snapshot_unlock(&g_snapshot_lock, prev_cancel_state);
+
+	return (snap);
+}
+
+void proc_snapshot_put(struct proc_snapshot *snap)
+{
+	int prev_cancel_state = -1;
+
+	if (snap == NULL)
+		return;
+
+	proc_snapshot_lock(&g_snapshot_lock, &prev_cancel_state);
+	proc_snapshot_release(snap);
+	proc_snapshot_unlock(&g_snapshot_lock, prev_cancel_state);
+}
+
+void proc_snapshot_cleanup(void)
+{
+	int prev_cancel_state = -1;
+
+	proc_snapshot_lock(&g_snapshot_lock, &prev_cancel_state);
+
+	if (g_snapshot != NULL) {
+		proc_snapshot_release(g_snapshot);
+		g_snapshot = NULL;
+	}
+
+	proc_snapshot_unlock(&g_snapshot_lock, prev_cancel_state);
+}
+
+void *proc_snapshot_data(struct proc_snapshot *snap, struct proc_entry *proc,
+			 void *(*get)(const struct proc_entry *), void (*data_free)(void *))
+{
+	int prev_cancel_state = -1;
+	void *data;
+
+	proc_snapshot_lock(&snap->data_lock, &prev_cancel_state);
+	data = proc->data;
+	proc_snapshot_unlock(&snap->data_lock, prev_cancel_state);
+
+	if (data != NULL)
+		return (data);
+
+	data = get(proc);
+
+	proc_snapshot_lock(&snap->data_lock, &prev_cancel_state);
+
+	if (proc->data == NULL) {
+		proc->data = data;
+		snap->data_free = data_free;
+	} else {
+		/* computed by another thread in the meantime */
+		if (data != NULL)
+			data_free(data);
+		data = proc->data;
+	}
+
+	proc_snapshot_unlock(&snap->data_lock, prev_cancel_state);
+
+	return (data);
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,130 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef PROC_SNAPSHOT_H
+#define PROC_SNAPSHOT_H
+
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+
+/*
+ * Snapshot of the processes in /proc shared by the process, process58
+ * and inetlisteningservers probes.
+ *
+ * Every /proc/<pid> directory is read once, by several threads if there
+ * are many processes, and the snapshot is then shared by all objects
+ * evaluated by the probe until it is older than
+ * OSCAP_PROBE_PROC_SNAPSHOT_TTL seconds (PROC_SNAPSHOT_DEFAULT_TTL by
+ * default). Kernel threads are not part of the snapshot.
+ *
+ * Fields which are expensive to read and only needed for the matching
+ * processes (SELinux label, capabilities, ...) are not read by the
+ * snapshot; probes attach them to the entries with proc_snapshot_data().
+ */
+
+#ifndef PROC_SNAPSHOT_DEFAULT_TTL
+#define PROC_SNAPSHOT_DEFAULT_TTL 60 /* seconds */
+#endif
+
+/* What is read besides /proc/<pid>/stat */
+#define PROC_SNAPSHOT_UIDS     0x01 /* real and effective uid from status */
+#define PROC_SNAPSHOT_LOGINUID 0x02 /* loginuid */
+#define PROC_SNAPSHOT_SOCKETS  0x04 /* socket inodes of the open files */
+
+struct proc_entry {
+	int pid;
+	int ppid;
+	char cmd[16];               /* command name, at most 15 characters */
+	char state;
+	int pgrp;
+	int session;
+	int tty_nr;
+	int tpgid;
+	unsigned flags;
+	unsigned long utime;        /* in clock ticks */
+	unsigned long stime;
+	long priority;
+	unsigned long long start;   /* in clock ticks after the boot */
+	int ruid;                   /* -1 if unknown */
+	int euid;                   /* -1 if unknown */
+	unsigned loginuid;          /* -1 if unknown */
+	unsigned long *sockets;     /* in the fd directory order */
+	size_t socket_count;
+	void *data;                 /* see proc_snapshot_data() */
+};
+
+struct proc_socket {
+	unsigned long      inode;
+	struct proc_entry *proc;    /* NULL if the slot is empty */
+};
+
+struct proc_snapshot {
+	struct proc_entry *proc;    /* in the /proc directory order */
+	size_t count;
+	unsigned long ticks;        /* clock ticks per second */
+	unsigned long boot;         /* boot time, seconds since the epoch */
+	int flags;
+
+	struct proc_socket *sockets; /* socket inode -> first process which has it open */
+	size_t socket_size;          /* power of two */
+
+	time_t time;                 /* when the snapshot was taken */
+	unsigned int refs;
+	pthread_mutex_t data_lock;
+	void (*data_free)(void *);
+};
+
+/**
+ * Read the processes in `root' (normally "/proc") using at most
+ * `threads' threads.
+ * @return snapshot or NULL if `root' can't be read
+ */
+struct proc_snapshot *proc_snapshot_new(const char *root, int flags, unsigned int threads);
+
+void proc_snapshot_free(struct proc_snapshot *snap);
+
+/**
+ * Return the shared snapshot of /proc which has at least `flags', take
+ * a new one if there is none or if it has expired. The snapshot has to
+ * be released with proc_snapshot_put().
+ * @return snapshot or NULL if /proc can't be read
+ */
+struct proc_snapshot *proc_snapshot_get(int flags);
+
+void proc_snapshot_put(struct proc_snapshot *snap);
+
+/**
+ * Free the shared snapshot. Called from probe_fini().
+ */
+void proc_snapshot_cleanup(void);
+
+/**
+ * Find the process which has the socket `inode' open. If several do,
+ * the first one found in /proc is returned.
+ * @return process or NULL
+ */
+struct proc_entry *proc_snapshot_socket(const struct proc_snapshot *snap, unsigned long inode);
+
+/**
+ * Return the data of `proc', compute it with `get' on the first call.
+ * `get' is called without any lock held. The data is freed together
+ * with the snapshot using `data_free'.
+ */
+void *proc_snapshot_data(struct proc_snapshot *snap, struct proc_entry *proc,
+			 void *(*get)(const struct proc_entry *), void (*data_free)(void *));
+
+#endif /* PROC_SNAPSHOT_H */
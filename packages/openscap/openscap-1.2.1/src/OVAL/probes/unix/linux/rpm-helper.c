@@ -0,0 +1,452 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <regex.h>
+#include <errno.h>
+
+#include <rpm/rpmfi.h>
+#include <rpm/rpmmacro.h>
+
+#ifndef HAVE_HEADERFORMAT
+# define headerFormat(_h, _fmt, _emsg) headerSprintf((_h),( _fmt), rpmTagTable, rpmHeaderFormats, (_emsg))
+#endif
+
+#include <alloc.h>
+#include <common/assume.h>
+#include "common/debug_priv.h"
+#include "common/util.h"
+#include "rpm-helper.h"
+
+static const char g_keyid_regex_string[] = "Key ID [a-fA-F0-9]{16}";
+
+static struct rpm_index g_index;
+static bool             g_index_ready = false;
+
+/* files of the supported database backends, missing ones are recorded too */
+static const char *g_dbfiles[RPM_INDEX_DBFILES] = {
+	"%{_dbpath}/Packages",
+	"%{_dbpath}/Packages.db",
+	"%{_dbpath}/rpmdb.sqlite",
+	"%{_dbpath}/rpmdb.sqlite-wal"
+};
+
+static void rpm_index_stamp(struct rpm_dbstamp stamp[RPM_INDEX_DBFILES])
+{
+	struct stat st;
+	char *path;
+	int i;
+
+	memset(stamp, 0, sizeof(struct rpm_dbstamp) * RPM_INDEX_DBFILES);
+
+	for (i = 0; i < RPM_INDEX_DBFILES; ++i) {
+		path = rpmExpand(g_dbfiles[i], NULL);
+
+		if (stat(path, &st) != 0) {
+			stamp[i].err = errno;
+		} else {
+			stamp[i].dev  = st.st_dev;
+			stamp[i].ino  = st.st_ino;
+			stamp[i].size = st.st_size;
+			stamp[i].mtim = st.st_mtim;
+			stamp[i].ctim = st.st_ctim;
+		}
+
+		free(path);
+	}
+}
+
+static char *rpm_index_keyid(Header h, regex_t *keyid_regex)
+{
+	errmsg_t rpmerr;
+	regmatch_t keyid_match[1];
+	char *str, *sid = NULL;
+
+	str = headerFormat(h, "%|SIGGPG?{%{SIGGPG:pgpsig}}:{%{SIGPGP:pgpsig}}|", &rpmerr);
+
+	if (str == NULL)
+		return strdup("0");
+
+	if (regexec(keyid_regex, str, 1, keyid_match, 0) != 0) {
+		dW("Failed to extract the Key ID value: regex=\"%s\", string=\"%s\"\n",
+		   g_keyid_regex_string, str);
+	} else if (keyid_match[0].rm_so >= 0 && keyid_match[0].rm_eo >= 0) {
+		size_t keyid_start, keyid_length;
+
+		keyid_start  = keyid_match[0].rm_so + strlen("Key ID ");
+		keyid_length = keyid_match[0].rm_eo - keyid_start;
+		sid = str + keyid_start;
+		sid[keyid_length] = '\0';
+	}
+
+	sid = strdup(sid != NULL ? sid : "0");
+	free(str);
+
+	return sid;
+}
+
+static void rpm_index_pkg(Header h, unsigned int offset, regex_t *keyid_regex, struct rpm_pkg *pkg)
+{
+	errmsg_t rpmerr;
+	const char *epoch;
+	size_t len;
+
+	pkg->name    = headerFormat(h, "%{NAME}", &rpmerr);
+	pkg->epoch   = headerFormat(h, "%{EPOCH}", &rpmerr);
+	pkg->version = headerFormat(h, "%{VERSION}", &rpmerr);
+	pkg->release = headerFormat(h, "%{RELEASE}", &rpmerr);
+	pkg->arch    = headerFormat(h, "%{ARCH}", &rpmerr);
+
+	epoch = oscap_streq(pkg->epoch, "(none)") ? "0" : pkg->epoch;
+
+	len = strlen(epoch) + strlen(pkg->version) + strlen(pkg->release) + 3;
+	pkg->evr = oscap_alloc(len);
+	snprintf(pkg->evr, len, "%s:%s-%s", epoch, pkg->version, pkg->release);
+
+	len += strlen(pkg->name) + strlen(pkg->arch) + 2;
+	pkg->extended_name = oscap_alloc(len);
+	snprintf(pkg->extended_name, len, "%s-%s:%s-%s.%s",
+		 pkg->name, epoch, pkg->version, pkg->release, pkg->arch);
+
+	pkg->signature_keyid = rpm_index_keyid(h, keyid_regex);
+	pkg->offset    = offset;
+	pkg->next_name = NULL;
+}
+
+static void rpm_index_pkg_free(struct rpm_pkg *pkg)
+{
+	/* allocated by headerFormat() */
+	free(pkg->name);
+	free(pkg->epoch);
+	free(pkg->version);
+	free(pkg->release);
+	free(pkg->arch);
+	free(pkg->signature_keyid);
+
+	oscap_free(pkg->evr);
+	oscap_free(pkg->extended_name);
+}
+
+static int rpm_index_build(rpmts ts)
+{
+	rpmdbMatchIterator match;
+	Header pkgh;
+	regex_t keyid_regex;
+	size_t size = 0, i;
+
+	if (regcomp(&keyid_regex, g_keyid_regex_string, REG_EXTENDED) != 0) {
+		dE("regcomp(%s) failed.\n", g_keyid_regex_string);
+		return (-1);
+	}
+
+	/* taken before reading, a change made meanwhile causes a rebuild */
+	rpm_index_stamp(g_index.stamp);
+
+	match = rpmtsInitIterator(ts, RPMDBI_PACKAGES, NULL, 0);
+
+	g_index.pkg   = NULL;
+	g_index.count = 0;
+	g_index.names = rbt_str_new();
+	g_index.files = NULL;
+
+	if (match != NULL) {
+		while ((pkgh = rpmdbNextIterator(match)) != NULL) {
+			if (g_index.count == size) {
+				size = size > 0 ? size * 2 : 512;
+				g_index.pkg = oscap_realloc(g_index.pkg, sizeof(struct rpm_pkg) * size);
+			}
+
+			rpm_index_pkg(pkgh, rpmdbGetIteratorOffset(match), &keyid_regex,
+				      g_index.pkg + g_index.count);
+			++g_index.count;
+		}
+
+		match = rpmdbFreeIterator(match);
+	}
+
+	regfree(&keyid_regex);
+
+	/*
+	 * Link the packages with the same name in the database order. The
+	 * array doesn't move from now on.
+	 */
+	for (i = g_index.count; i > 0; --i) {
+		struct rpm_pkg *pkg = g_index.pkg + (i - 1);
+		struct rbt_str_node *node = NULL;
+
+		if (rbt_str_getnode(g_index.names, pkg->name, &node) == 0) {
+			pkg->next_name = node->data;
+			node->data = pkg;
+		} else
+			rbt_str_add(g_index.names, pkg->name, pkg);
+	}
+
+	dI("Indexed %zu packages\n", g_index.count);
+	g_index_ready = true;
+
+	return (0);
+}
+
+/*
+ * Replace the index. The packages of the old one may still be used by
+ * the callers, so it's kept until rpm_index_free().
+ */
+static void rpm_index_retire(void)
+{
+	struct rpm_index *old;
+
+	old = oscap_talloc(struct rpm_index);
+	memcpy(old, &g_index, sizeof g_index);
+
+	memset(&g_index, 0, sizeof g_index);
+	g_index.retired = old;
+	g_index_ready = false;
+}
+
+const struct rpm_index *rpm_index_get(rpmts ts)
+{
+	if (g_index_ready) {
+		struct rpm_dbstamp stamp[RPM_INDEX_DBFILES];
+
+		rpm_index_stamp(stamp);
+
+		if (memcmp(stamp, g_index.stamp, sizeof stamp) != 0) {
+			dI("The package database changed, rebuilding the index\n");
+			rpm_index_retire();
+		}
+	}
+
+	if (!g_index_ready && rpm_index_build(ts) != 0)
+		return (NULL);
+
+	return (&g_index);
+}
+
+const struct rpm_pkg *rpm_index_name(rpmts ts, const char *name)
+{
+	struct rpm_pkg *pkg = NULL;
+
+	if (rpm_index_get(ts) == NULL)
+		return (NULL);
+
+	if (rbt_str_get(g_index.names, name, (void **)&pkg) != 0)
+		return (NULL);
+
+	return (pkg);
+}
+
+Header rpm_index_header(rpmts ts, const struct rpm_pkg *pkg, rpmdbMatchIterator *match)
+{
+	unsigned int offset = pkg->offset;
+
+	*match = rpmtsInitIterator(ts, RPMDBI_PACKAGES, &offset, sizeof offset);
+
+	if (*match == NULL)
+		return (NULL);
+
+	return (rpmdbNextIterator(*match));
+}
+
+static void rpm_index_file_add(const char *path, struct rpm_pkg *pkg)
+{
+	struct rpm_file_owner *owner;
+	struct rbt_str_node *node = NULL;
+
+	if (rbt_str_getnode(g_index.files, path, &node) == 0) {
+		owner = node->data;
+
+		/* the packages are added one by one */
+		if (owner->pkg == pkg)
+			return;
+
+		owner = oscap_talloc(struct rpm_file_owner);
+		owner->pkg  = pkg;
+		owner->next = node->data;
+		node->data  = owner;
+	} else {
+		owner = oscap_talloc(struct rpm_file_owner);
+		owner->pkg  = pkg;
+		owner->next = NULL;
+
+		rbt_str_add(g_index.files, strdup(path), owner);
+	}
+}
+
+static int rpm_index_build_files(rpmts ts)
+{
+	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
+	rpmdbMatchIterator match;
+	Header pkgh;
+	size_t i = 0;
+	int t;
+
+	g_index.files = rbt_str_new();
+
+	match = rpmtsInitIterator(ts, RPMDBI_PACKAGES, NULL, 0);
+
+	if (match == NULL)
+		return (0);
+
+	/*
+	 * The database is read in the same order as when it was indexed,
+	 * packages installed since then are skipped.
+	 */
+	while ((pkgh = rpmdbNextIterator(match)) != NULL) {
+		unsigned int offset = rpmdbGetIteratorOffset(match);
+		struct rpm_pkg *pkg;
+		size_t j;
+
+		for (j = i; j < g_index.count; ++j)
+			if (g_index.pkg[j].offset == offset)
+				break;
+
+		if (j == g_index.count)
+			continue;
+
+		pkg = g_index.pkg + j;
+		i = j;
+
+		for (t = 0; t < 2; ++t) {
+			rpmfi fi = rpmfiNew(ts, pkgh, tag[t], 1);
+
+			while (rpmfiNext(fi) != -1)
+				rpm_index_file_add(rpmfiFN(fi), pkg);
+
+			rpmfiFree(fi);
+		}
+
+		++i;
+	}
+
+	rpmdbFreeIterator(match);
+	dI("Indexed %zu files\n", rbt_str_size(g_index.files));
+
+	return (0);
+}
+
+const struct rpm_file_owner *rpm_index_file(rpmts ts, const char *path)
+{
+	struct rpm_file_owner *owner = NULL;
+
+	if (rpm_index_get(ts) == NULL)
+		return (NULL);
+
+	if (g_index.files == NULL && rpm_index_build_files(ts) != 0)
+		return (NULL);
+
+	if (rbt_str_get(g_index.files, path, (void **)&owner) != 0)
+		return (NULL);
+
+	return (owner);
+}
+
+int rpm_index_select(rpmts ts, const char *name, const char *file, const struct rpm_pkg ***pkgs)
+{
+	const struct rpm_file_owner *owner;
+	const struct rpm_pkg *pkg;
+	size_t i, count = 0;
+
+	*pkgs = NULL;
+
+	if (rpm_index_get(ts) == NULL)
+		return (-1);
+
+	if (file != NULL) {
+		/* the owners are linked in the reverse database order */
+		for (owner = rpm_index_file(ts, file); owner != NULL; owner = owner->next) {
+			if (name != NULL && strcmp(owner->pkg->name, name) != 0)
+				continue;
+
+			*pkgs = oscap_realloc(*pkgs, sizeof(struct rpm_pkg *) * (count + 1));
+			(*pkgs)[count++] = owner->pkg;
+		}
+
+		for (i = 0; i < count / 2; ++i) {
+			pkg = (*pkgs)[i];
+			(*pkgs)[i] = (*pkgs)[count - i - 1];
+			(*pkgs)[count - i - 1] = pkg;
+		}
+	} else if (name != NULL) {
+		for (pkg = rpm_index_name(ts, name); pkg != NULL; pkg = pkg->next_name) {
+			*pkgs = oscap_realloc(*pkgs, sizeof(struct rpm_pkg *) * (count + 1));
+			(*pkgs)[count++] = pkg;
+		}
+	} else if (g_index.count > 0) {
+		*pkgs = oscap_alloc(sizeof(struct rpm_pkg *) * g_index.count);
+
+		for (count = 0; count < g_index.count; ++count)
+			(*pkgs)[count] = g_index.pkg + count;
+	}
+
+	return (count);
+}
+
+static void rpm_index_name_free(struct rbt_str_node *n)
+{
+	/* the key is owned by the package */
+	return;
+}
+
+static void rpm_index_file_free(struct rbt_str_node *n)
+{
+	struct rpm_file_owner *owner = n->data, *next;
+
+	while (owner != NULL) {
+		next = owner->next;
+		oscap_free(owner);
+		owner = next;
+	}
+
+	free(n->key);
+}
+
+static void rpm_index_destroy(struct rpm_index *index)
+{
+	size_t i;
+
+	if (index->files != NULL)
+		rbt_str_free_cb(index->files, rpm_index_file_free);
+
+	if (index->names != NULL)
+		rbt_str_free_cb(index->names, rpm_index_name_free);
+
+	for (i = 0; i < index->count; ++i)
+		rpm_index_pkg_free(index->pkg + i);
+
+	oscap_free(index->pkg);
+}
+
+void rpm_index_free(void)
+{
+	struct rpm_index *old, *next;
+
+	for (old = g_index.retired; old != NULL; old = next) {
+		next = old->retired;
+		rpm_index_destroy(old);
+		oscap_free(old);
+	}
+
+	rpm_index_destroy(&g_index);
+	memset(&g_index, 0, sizeof g_index);
+	g_index_ready = false;
+}
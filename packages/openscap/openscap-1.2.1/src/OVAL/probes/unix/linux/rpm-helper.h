@@ -0,0 +1,125 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef RPM_HELPER_H
+#define RPM_HELPER_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <rpm/rpmdb.h>
+#include <rpm/rpmlib.h>
+#include <rpm/rpmts.h>
+#include <rpm/header.h>
+#include "SEAP/generic/rbt/rbt.h"
+
+/*
+ * In-memory index of the installed packages shared by the rpminfo,
+ * rpmverify, rpmverifyfile and rpmverifypackage probes.
+ *
+ * The package database is read on the first lookup, and again after
+ * the database files change, and the formatted header fields of every
+ * package are kept together with the package's header instance. Objects are then matched against
+ * the index and only the headers of the matching packages are read
+ * from the database again (to list or verify their files).
+ *
+ * The file index (path -> owning packages) is built on the first
+ * lookup of a file path.
+ *
+ * The index is not locked. Callers serialize all rpm_index_*() calls
+ * with the lock which protects the transaction set.
+ */
+
+struct rpm_pkg {
+	char *name;
+	char *epoch;            /* "(none)" if the package has no epoch */
+	char *version;
+	char *release;
+	char *arch;
+	char *evr;              /* epoch:version-release, the epoch defaults to 0 */
+	char *signature_keyid;  /* "0" if the package isn't signed */
+	char *extended_name;    /* name-epoch:version-release.arch */
+
+	unsigned int    offset;    /* header instance in the database */
+	struct rpm_pkg *next_name; /* next package with the same name */
+};
+
+struct rpm_file_owner {
+	struct rpm_pkg        *pkg;
+	struct rpm_file_owner *next;
+};
+
+/* identity of a database file, see rpm_index_get() */
+struct rpm_dbstamp {
+	int             err;
+	dev_t           dev;
+	ino_t           ino;
+	off_t           size;
+	struct timespec mtim;
+	struct timespec ctim;
+};
+
+#define RPM_INDEX_DBFILES 4
+
+struct rpm_index {
+	struct rpm_pkg *pkg;   /* in the database order */
+	size_t          count;
+	rbt_t          *names; /* name -> first package with the name */
+	rbt_t          *files; /* path -> struct rpm_file_owner list */
+
+	struct rpm_dbstamp stamp[RPM_INDEX_DBFILES]; /* the database when indexed */
+	struct rpm_index  *retired; /* replaced indexes, see rpm_index_get() */
+};
+
+/**
+ * Return the package index. The database is read on the first call
+ * and again when one of its files changed since it was indexed. The
+ * packages of a replaced index stay valid until rpm_index_free(),
+ * callers may still use them.
+ * @return index or NULL on error
+ */
+const struct rpm_index *rpm_index_get(rpmts ts);
+
+/**
+ * Look up the packages with the name `name'. Further packages with
+ * the same name are linked through next_name.
+ * @return first package or NULL
+ */
+const struct rpm_pkg *rpm_index_name(rpmts ts, const char *name);
+
+/**
+ * Look up the packages which own the file or directory `path'.
+ * @return list of owners or NULL
+ */
+const struct rpm_file_owner *rpm_index_file(rpmts ts, const char *path);
+
+/**
+ * Select the packages with the name `name' which own the file or
+ * directory `file'. NULL matches any name or file. The packages are
+ * returned in the database order in an array allocated here.
+ * @return number of packages or -1 on error
+ */
+int rpm_index_select(rpmts ts, const char *name, const char *file, const struct rpm_pkg ***pkgs);
+
+/**
+ * Read the header of `pkg' from the database. The header is valid
+ * until `*match' is freed with rpmdbFreeIterator().
+ * @return header or NULL if the package is no longer installed
+ */
+Header rpm_index_header(rpmts ts, const struct rpm_pkg *pkg, rpmdbMatchIterator *match);
+
+void rpm_index_free(void);
+
+#endif /* RPM_HELPER_H */
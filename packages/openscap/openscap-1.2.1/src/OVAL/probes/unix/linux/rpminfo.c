@@ -57,7 +57,6 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <regex.h>
 
 /* RPM headers */
 #include <rpm/rpmdb.h>
@@ -89,6 +88,7 @@
 #include <alloc.h>
 #include <common/assume.h>
 #include "common/debug_priv.h"
+#include "rpm-helper.h"
 
 
 struct rpminfo_req {
@@ -96,17 +96,6 @@ struct rpminfo_req {
         oval_operation_t op;
 };
 
-struct rpminfo_rep {
-        char *name;
-        char *arch;
-        char *epoch;
-        char *release;
-        char *version;
-        char *evr;
-        char *signature_keyid;
-	char extended_name[1024];
-};
-
 struct rpminfo_global {
         rpmts           rpmts;
         pthread_mutex_t mutex;
@@ -133,170 +122,38 @@ struct rpminfo_global {
 	} while(0)
 
 static struct rpminfo_global g_rpm;
-static const char g_keyid_regex_string[] = "Key ID [a-fA-F0-9]{16}";
-static regex_t g_keyid_regex;
-
-static void __rpminfo_rep_free (struct rpminfo_rep *ptr)
-{
-        oscap_free (ptr->name);
-        oscap_free (ptr->arch);
-        oscap_free (ptr->epoch);
-        oscap_free (ptr->release);
-        oscap_free (ptr->version);
-        oscap_free (ptr->evr);
-        oscap_free (ptr->signature_keyid);
-}
-
-static void pkgh2rep (Header h, struct rpminfo_rep *r)
-{
-        errmsg_t rpmerr;
-        char *str, *sid;
-	char *epoch_override = NULL;
-        size_t len;
-	regmatch_t keyid_match[1];
-
-        assume_d (h != NULL, /* void */);
-        assume_d (r != NULL, /* void */);
-
-        r->name = headerFormat (h, "%{NAME}", &rpmerr);
-        r->arch = headerFormat (h, "%{ARCH}", &rpmerr);
-        r->epoch = headerFormat (h, "%{EPOCH}", &rpmerr);
-        r->release = headerFormat (h, "%{RELEASE}", &rpmerr);
-        r->version = headerFormat (h, "%{VERSION}", &rpmerr);
-	epoch_override = oscap_streq(r->epoch, "(none)") ? "0" : r->epoch;
-	snprintf(r->extended_name, 1024, "%s-%s:%s-%s.%s", r->name, epoch_override, r->version, r->release, r->arch);
-
-	len = (strlen(epoch_override) +
-               strlen (r->release) +
-               strlen (r->version) + 2);
-
-        str = oscap_alloc (sizeof (char) * (len + 1));
-        snprintf (str, len + 1, "%s:%s-%s",
-		epoch_override,
-                  r->version,
-                  r->release);
-
-        r->evr = str;
-
-        str = headerFormat (h, "%|SIGGPG?{%{SIGGPG:pgpsig}}:{%{SIGPGP:pgpsig}}|", &rpmerr);
-
-	if (regexec(&g_keyid_regex, str, 1, keyid_match, 0) != 0) {
-		sid = NULL;
-		dW("Failed to extract the Key ID value: regex=\"%s\", string=\"%s\"\n",
-		   g_keyid_regex_string, str);
-	} else {
-		size_t keyid_start, keyid_length;
-
-		if (keyid_match[0].rm_so < 0 || keyid_match[0].rm_eo < 0)
-			sid = NULL;
-		else {
-			keyid_start = keyid_match[0].rm_so + strlen("Key ID ");
-			keyid_length = keyid_match[0].rm_eo - keyid_start;
-			sid = str + keyid_start;
-			sid[keyid_length] = '\0';
-		}
-	}
-
-        r->signature_keyid = strdup(sid != NULL ? sid : "0");
-        oscap_free (str);
-}
-
 /*
  * req - Structure containing the name of the package.
- * rep - Pointer to rpminfo_rep structure pointer. An
- *       array of rpminfo_rep structures will be allocated
- *       here.
+ * rep - Pointer to an array of package pointers. The array
+ *       is allocated here, the packages belong to the
+ *       package index.
  *
  * The return value on error is -1. Otherwise the number of
- * rpminfo_rep structures allocated in *rep is returned.
+ * packages stored in *rep is returned.
  */
-static int get_rpminfo (struct rpminfo_req *req, struct rpminfo_rep **rep)
+static int get_rpminfo (struct rpminfo_req *req, const struct rpm_pkg ***rep)
 {
-	rpmdbMatchIterator match;
-	Header pkgh;
-	int ret = 0, i;
+	int ret;
 
         RPMINFO_LOCK;
 
-        ret = -1;
-
         switch (req->op) {
         case OVAL_OPERATION_EQUALS:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMTAG_NAME, (const void *)req->name, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                ret = rpmdbGetIteratorCount (match);
-
+		ret = rpm_index_select(g_rpm.rpmts, req->name, NULL, rep);
                 break;
 	case OVAL_OPERATION_NOT_EQUAL:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_GLOB, "*") != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
         case OVAL_OPERATION_PATTERN_MATCH:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_REGEX,
-                                        (const char *)req->name) != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
+		/*
+		 * All packages are returned, the names are compared by
+		 * the caller.
+		 */
+		ret = rpm_index_select(g_rpm.rpmts, NULL, NULL, rep);
                 break;
         default:
                 /* not supported */
                 ret = -1;
-                goto ret;
-        }
-
-        if (ret != -1) {
-                /*
-                 * We can allocate all memory needed now because we know the number
-                 * of results.
-                 */
-                (*rep) = oscap_realloc (*rep, sizeof (struct rpminfo_rep) * ret);
-
-                for (i = 0; i < ret; ++i) {
-                        pkgh = rpmdbNextIterator (match);
-
-                        if (pkgh != NULL)
-                                pkgh2rep (pkgh, (*rep) + i);
-                        else {
-                                /* XXX: emit warning */
-                                break;
-                        }
-                }
-        } else {
-                ret = 0;
-
-                while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-                        (*rep) = oscap_realloc (*rep, sizeof (struct rpminfo_rep) * ++ret);
-                        assume_r (*rep != NULL, -1);
-                        pkgh2rep (pkgh, (*rep) + (ret - 1));
-                }
         }
 
-	match = rpmdbFreeIterator (match);
-ret:
         RPMINFO_UNLOCK;
         return (ret);
 }
@@ -318,13 +175,27 @@ void *probe_init (void)
         g_rpm.rpmts = rpmtsCreate();
         pthread_mutex_init (&(g_rpm.mutex), NULL);
 
-	if (regcomp(&g_keyid_regex, g_keyid_regex_string, REG_EXTENDED) != 0) {
-		dE("regcomp(%s) failed.\n");
-		return NULL;
-	}
-
 	probe_setoption(PROBEOPT_OFFLINE_MODE_SUPPORTED, PROBE_OFFLINE_CHROOT|PROBE_OFFLINE_RPMDB);
 
+	/*
+	 * Collected objects depend only on the package database. Record
+	 * the directory as well to catch a rebuild of the database.
+	 */
+	{
+		char *dbpath, *packages, *sqlite;
+
+		dbpath   = rpmExpand("%{_dbpath}", NULL);
+		packages = rpmExpand("%{_dbpath}/Packages", NULL);
+		sqlite   = rpmExpand("%{_dbpath}/rpmdb.sqlite", NULL);
+
+		probe_setoption(PROBEOPT_PERSISTENT_CACHE, PROBE_PCACHE_DEP_NONE,
+		                dbpath, packages, sqlite, NULL);
+
+		free(dbpath);
+		free(packages);
+		free(sqlite);
+	}
+
         return ((void *)&g_rpm);
 }
 
@@ -332,77 +203,60 @@ void probe_fini (void *ptr)
 {
         struct rpminfo_global *r = (struct rpminfo_global *)ptr;
 
+        rpm_index_free();
         rpmtsFree(r->rpmts);
 	rpmFreeCrypto();
         rpmFreeRpmrc();
         rpmFreeMacros(NULL);
         rpmlogClose();
         pthread_mutex_destroy (&(r->mutex));
-	regfree(&g_keyid_regex);
 
         return;
 }
 
-static int collect_rpm_files(SEXP_t *item, const struct rpminfo_rep *rep) {
+static int collect_rpm_files(SEXP_t *item, const struct rpm_pkg *pkg) {
 	SEXP_t *value;
-	rpmdbMatchIterator ts;
+	rpmdbMatchIterator match;
 	Header pkgh;
 	rpmfi fi;
 	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
 	int i, ret = 0;
 
-	ts = rpmtsInitIterator(g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-	if (ts == NULL) {
-		return -1;
-	}
+	RPMINFO_LOCK;
 
-	if (rpmdbSetIteratorRE(ts, RPMTAG_NAME, RPMMIRE_STRCMP, rep->name) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_EPOCH, RPMMIRE_STRCMP, rep->epoch) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_VERSION, RPMMIRE_STRCMP, rep->version) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_RELEASE, RPMMIRE_STRCMP, rep->release) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_ARCH, RPMMIRE_STRCMP, rep->arch) != 0) {
+	pkgh = rpm_index_header(g_rpm.rpmts, pkg, &match);
+
+	if (pkgh == NULL) {
 		ret = -1;
 		goto cleanup;
 	}
 
-	while ((pkgh = rpmdbNextIterator(ts)) != NULL) {
-		/*
-		 * Inspect package files & directories
-		 */
-		for (i = 0; i < 2; ++i) {
-			fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
-
-			while (rpmfiNext(fi) != -1) {
-				const char *filepath;
-				filepath = rpmfiFN(fi);
-				value = probe_entval_from_cstr(
-						OVAL_DATATYPE_STRING,
-						filepath,
-						strlen(filepath)
-						);
-				if (value != NULL) {
-					probe_item_ent_add(item, "filepath", NULL, value);
-					SEXP_free(value);
-				}
+	/*
+	 * Inspect package files & directories
+	 */
+	for (i = 0; i < 2; ++i) {
+		fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
+
+		while (rpmfiNext(fi) != -1) {
+			const char *filepath;
+			filepath = rpmfiFN(fi);
+			value = probe_entval_from_cstr(
+					OVAL_DATATYPE_STRING,
+					filepath,
+					strlen(filepath)
+					);
+			if (value != NULL) {
+				probe_item_ent_add(item, "filepath", NULL, value);
+				SEXP_free(value);
 			}
-			rpmfiFree(fi);
 		}
-
+		rpmfiFree(fi);
 	}
 cleanup:
-	ts = rpmdbFreeIterator(ts);
+	if (match != NULL)
+		rpmdbFreeIterator(match);
+
+	RPMINFO_UNLOCK;
 	return ret;
 }
 
@@ -413,7 +267,7 @@ int probe_main (probe_ctx *ctx, void *arg)
 	int rpmret, i;
 
         struct rpminfo_req request_st;
-        struct rpminfo_rep *reply_st;
+        const struct rpm_pkg **reply_st;
 
 	probe_in = probe_ctx_getobject(ctx);
 	if (probe_in == NULL)
@@ -500,7 +354,7 @@ int probe_main (probe_ctx *ctx, void *arg)
                         SEXP_t *name;
 
                         for (i = 0; i < rpmret; ++i) {
-				name = SEXP_string_newf("%s", reply_st[i].name);
+				name = SEXP_string_newf("%s", reply_st[i]->name);
 
 				if (probe_entobj_cmp(ent, name) != OVAL_RESULT_TRUE) {
 					SEXP_free(name);
@@ -509,12 +363,12 @@ int probe_main (probe_ctx *ctx, void *arg)
 
                                 item = probe_item_create(OVAL_LINUX_RPM_INFO, NULL,
                                                          "name",    OVAL_DATATYPE_SEXP, name,
-                                                         "arch",    OVAL_DATATYPE_STRING, reply_st[i].arch,
-                                                         "epoch",   OVAL_DATATYPE_STRING, reply_st[i].epoch,
-                                                         "release", OVAL_DATATYPE_STRING, reply_st[i].release,
-                                                         "version", OVAL_DATATYPE_STRING, reply_st[i].version,
-                                                         "evr",     OVAL_DATATYPE_EVR_STRING, reply_st[i].evr,
-                                                         "signature_keyid", OVAL_DATATYPE_STRING, reply_st[i].signature_keyid,
+                                                         "arch",    OVAL_DATATYPE_STRING, reply_st[i]->arch,
+                                                         "epoch",   OVAL_DATATYPE_STRING, reply_st[i]->epoch,
+                                                         "release", OVAL_DATATYPE_STRING, reply_st[i]->release,
+                                                         "version", OVAL_DATATYPE_STRING, reply_st[i]->version,
+                                                         "evr",     OVAL_DATATYPE_EVR_STRING, reply_st[i]->evr,
+                                                         "signature_keyid", OVAL_DATATYPE_STRING, reply_st[i]->signature_keyid,
                                                          NULL);
 
 				/* OVAL 5.10 added extended_name and filepaths behavior */
@@ -522,8 +376,8 @@ int probe_main (probe_ctx *ctx, void *arg)
 					SEXP_t *value, *bh_value;
 					value = probe_entval_from_cstr(
 							OVAL_DATATYPE_STRING,
-							reply_st[i].extended_name,
-							strlen(reply_st[i].extended_name)
+							reply_st[i]->extended_name,
+							strlen(reply_st[i]->extended_name)
 					);
 					probe_item_ent_add(item, "extended_name", NULL, value);
 					SEXP_free(value);
@@ -537,7 +391,7 @@ int probe_main (probe_ctx *ctx, void *arg)
 						if (bh_value != NULL) {
 							if (SEXP_strcmp(bh_value, "true") == 0) {
 								/* collect package files */
-								collect_rpm_files(item, &reply_st[i]);
+								collect_rpm_files(item, reply_st[i]);
 
 							}
 							SEXP_free(bh_value);
@@ -549,9 +403,10 @@ int probe_main (probe_ctx *ctx, void *arg)
 
 
 				SEXP_free(name);
-                                __rpminfo_rep_free (&(reply_st[i]));
 
 				if (probe_item_collect(ctx, item)) {
+					oscap_free(reply_st);
+					oscap_free(request_st.name);
 					SEXP_vfree(ent, NULL);
 					return 1;
 				}
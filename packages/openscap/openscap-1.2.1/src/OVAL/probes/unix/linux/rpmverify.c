@@ -70,9 +70,10 @@
 #include <common/assume.h>
 #include "debug_priv.h"
 #include "probe/entcmp.h"
+#include "rpm-helper.h"
 
 struct rpmverify_res {
-        char *name;  /**< package name */
+        const char *name;  /**< package name */
         char *file;  /**< filepath */
         rpmVerifyAttrs vflags; /**< rpm verify flags */
         rpmVerifyAttrs oflags; /**< rpm verify omit flags */
@@ -117,11 +118,11 @@ static int rpmverify_collect(probe_ctx *ctx,
                              uint64_t flags,
                              void (*callback)(probe_ctx *, struct rpmverify_res *))
 {
-	rpmdbMatchIterator match;
+	const struct rpm_pkg **pkgs = NULL;
+        const char *owned = NULL;
         rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
-	Header pkgh;
         pcre *re = NULL;
-	int  ret = -1;
+	int  ret = -1, count, p;
 
         /* pre-compile regex if needed */
         if (file_op == OVAL_OPERATION_PATTERN_MATCH) {
@@ -138,48 +139,21 @@ static int rpmverify_collect(probe_ctx *ctx,
 
         RPMVERIFY_LOCK;
 
+        /*
+         * Select the candidate packages from the package index, the
+         * names and file paths are compared below. A filepath with
+         * a variable reference may have more than one value.
+         */
+        if (file_op == OVAL_OPERATION_EQUALS && !probe_ent_attrexists(filepath_ent, "var_ref"))
+                owned = file;
+
         switch (name_op) {
         case OVAL_OPERATION_EQUALS:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMTAG_NAME, (const void *)name, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                ret = rpmdbGetIteratorCount (match);
-
+                count = rpm_index_select(g_rpm.rpmts, name, owned, &pkgs);
                 break;
 	case OVAL_OPERATION_NOT_EQUAL:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_GLOB, "*") != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
         case OVAL_OPERATION_PATTERN_MATCH:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_REGEX,
-                                        (const char *)name) != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
+                count = rpm_index_select(g_rpm.rpmts, NULL, owned, &pkgs);
                 break;
         default:
                 /* not supported */
@@ -188,18 +162,24 @@ static int rpmverify_collect(probe_ctx *ctx,
                 goto ret;
         }
 
+        if (count < 0) {
+                ret = -1;
+                goto ret;
+        }
+
 	assume_d(RPMTAG_BASENAMES != 0, -1);
 	assume_d(RPMTAG_DIRNAMES  != 0, -1);
 
-        while ((pkgh = rpmdbNextIterator (match)) != NULL) {
+        for (p = 0; p < count; ++p) {
+                rpmdbMatchIterator match;
+                Header pkgh;
                 rpmfi  fi;
 		rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
                 struct rpmverify_res res;
-                errmsg_t rpmerr;
 		int i;
 		SEXP_t *name_sexp;
 
-                res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
+                res.name = pkgs[p]->name;
 
 		name_sexp = SEXP_string_newf("%s", res.name);
 		if (probe_entobj_cmp(name_ent, name_sexp) != OVAL_RESULT_TRUE) {
@@ -208,6 +188,14 @@ static int rpmverify_collect(probe_ctx *ctx,
 		}
 		SEXP_free(name_sexp);
 
+                pkgh = rpm_index_header(g_rpm.rpmts, pkgs[p], &match);
+
+                if (pkgh == NULL) {
+                        if (match != NULL)
+                                rpmdbFreeIterator(match);
+                        continue;
+                }
+
                 /*
                  * Inspect package files & directories
                  */
@@ -243,11 +231,14 @@ static int rpmverify_collect(probe_ctx *ctx,
 
 		  rpmfiFree(fi);
 		}
+
+                rpmdbFreeIterator(match);
 	}
 
-	match = rpmdbFreeIterator (match);
         ret   = 0;
 ret:
+        oscap_free(pkgs);
+
         if (re != NULL)
                 pcre_free(re);
 
@@ -273,6 +264,7 @@ void probe_fini (void *ptr)
 {
         struct rpmverify_global *r = (struct rpmverify_global *)ptr;
 
+        rpm_index_free();
         rpmtsFree(r->rpmts);
 	rpmFreeCrypto();
         rpmFreeRpmrc();
@@ -72,15 +72,16 @@
 #include <common/assume.h>
 #include "debug_priv.h"
 #include "probe/entcmp.h"
+#include "rpm-helper.h"
 
 struct rpmverify_res {
-	char *name;  /**< package name */
+	const char *name;  /**< package name */
 	const char *epoch;
 	const char *version;
 	const char *release;
 	const char *arch;
 	const char *file;  /**< filepath */
-	char extended_name[1024];
+	const char *extended_name;
 	rpmVerifyAttrs vflags; /**< rpm verify flags */
 	rpmVerifyAttrs oflags; /**< rpm verify omit flags */
 	rpmfileAttrs   fflags; /**< rpm file flags */
@@ -117,33 +118,17 @@ static struct rpmverify_global g_rpm;
 		pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &prev_cancel_state); \
 	} while(0)
 
-/* modify passed-in iterator to test also given entity */
-static int adjust_filter(rpmdbMatchIterator iterator, SEXP_t *ent, rpmTag rpm_tag) {
-	oval_operation_t ent_op;
-	char ent_str[1024];
-	int ret = 0;
-
-	if (ent) {
-		ent_op = probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS);
-		PROBE_ENT_STRVAL(ent, ent_str, sizeof ent_str, /* void */, strcpy(ent_str, ""););
-
-		switch (ent_op) {
-		case OVAL_OPERATION_EQUALS:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_STRCMP, ent_str) != 0)
-				ret = -1;
+/* value of an entity which can be looked up in the package index */
+static const char *lookup_value(SEXP_t *ent, char *buf, size_t buflen)
+{
+	if (ent == NULL ||
+	    probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS) != OVAL_OPERATION_EQUALS ||
+	    probe_ent_attrexists(ent, "var_ref"))
+		return (NULL);
 
-			break;
-		case OVAL_OPERATION_PATTERN_MATCH:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_REGEX,
-						(const char *)ent_str) != 0)
-				ret = -1;
+	PROBE_ENT_STRVAL(ent, buf, buflen, return (NULL);, return (NULL););
 
-			break;
-		default:
-			ret = 0;
-		}
-	}
-	return ret;
+	return (buf);
 }
 
 static int rpmverify_collect(probe_ctx *ctx,
@@ -152,11 +137,11 @@ static int rpmverify_collect(probe_ctx *ctx,
 			     uint64_t flags,
 			     int (*callback)(probe_ctx *, struct rpmverify_res *))
 {
-	rpmdbMatchIterator match;
 	rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
-	Header pkgh;
+	const struct rpm_pkg **pkgs = NULL;
+	char name_str[1024];
 	pcre *re = NULL;
-	int  ret = -1;
+	int  ret = -1, count, p;
 
 	/* pre-compile regex if needed */
 	if (file_op == OVAL_OPERATION_PATTERN_MATCH) {
@@ -173,49 +158,33 @@ static int rpmverify_collect(probe_ctx *ctx,
 
 	RPMVERIFY_LOCK;
 
-	match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-	if (match == NULL) {
-		ret = 0;
-		goto ret;
-	}
-
-	if ((ret = adjust_filter(match, name_ent, RPMTAG_NAME)) == -1) {
-		dE("can't adjust filter with name");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, epoch_ent, RPMTAG_EPOCH)) == -1) {
-		dE("can't adjust filter with epoch");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, version_ent, RPMTAG_VERSION)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, release_ent, RPMTAG_RELEASE)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, arch_ent, RPMTAG_ARCH)) == -1) {
-		dE("can't adjust filter with version");
+	/*
+	 * Select the candidate packages from the package index, all
+	 * entities are compared below.
+	 */
+	count = rpm_index_select(g_rpm.rpmts,
+				 lookup_value(name_ent, name_str, sizeof name_str),
+				 file_op == OVAL_OPERATION_EQUALS ? file : NULL,
+				 &pkgs);
+
+	if (count < 0) {
+		dE("can't read the package index\n");
+		ret = -1;
 		goto ret;
 	}
 
 	assume_d(RPMTAG_BASENAMES != 0, -1);
 	assume_d(RPMTAG_DIRNAMES  != 0, -1);
 
-	while ((pkgh = rpmdbNextIterator (match)) != NULL) {
+	for (p = 0; p < count; ++p) {
 		SEXP_t *ent;
+		rpmdbMatchIterator match;
+		Header pkgh;
 		rpmfi  fi;
 		rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
 		struct rpmverify_res res;
-		errmsg_t rpmerr;
 		int i;
 
-		/*
-+SEXP_t *probe_ent_from_cstr(const char *name, oval_datatype_t type,
-+                            const char *value, size_t vallen)
-		 */
-
 #define COMPARE_ENT(XXX) \
 		if (XXX ## _ent != NULL) { \
 			ent = probe_entval_from_cstr( \
@@ -228,21 +197,25 @@ static int rpmverify_collect(probe_ctx *ctx,
 			SEXP_free(ent); \
 		}
 
-		res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
+		res.name = pkgs[p]->name;
 		COMPARE_ENT(name);
-
-		res.epoch = headerFormat(pkgh, "%{EPOCH}", &rpmerr);
+		res.epoch = pkgs[p]->epoch;
 		COMPARE_ENT(epoch);
-
-		res.version = headerFormat(pkgh, "%{VERSION}", &rpmerr);
+		res.version = pkgs[p]->version;
 		COMPARE_ENT(version);
-		res.release = headerFormat(pkgh, "%{RELEASE}", &rpmerr);
+		res.release = pkgs[p]->release;
 		COMPARE_ENT(release);
-		res.arch = headerFormat(pkgh, "%{ARCH}", &rpmerr);
+		res.arch = pkgs[p]->arch;
 		COMPARE_ENT(arch);
-		snprintf(res.extended_name, 1024, "%s-%s:%s-%s.%s", res.name,
-			oscap_streq(res.epoch, "(none)") ? "0" : res.epoch,
-			res.version, res.release, res.arch);
+		res.extended_name = pkgs[p]->extended_name;
+
+		pkgh = rpm_index_header(g_rpm.rpmts, pkgs[p], &match);
+
+		if (pkgh == NULL) {
+			if (match != NULL)
+				rpmdbFreeIterator(match);
+			continue;
+		}
 
 		/*
 		 * Inspect package files & directories
@@ -281,6 +254,8 @@ static int rpmverify_collect(probe_ctx *ctx,
 		      default:
 			dE("pcre_exec() failed!\n");
 			ret = -1;
+			rpmfiFree(fi);
+			rpmdbFreeIterator(match);
 			goto ret;
 		      }
 		      break;
@@ -288,6 +263,8 @@ static int rpmverify_collect(probe_ctx *ctx,
 		      /* unsupported operation */
 		      dE("Operation \"%d\" on `filepath' not supported\n", file_op);
 		      ret = -1;
+		      rpmfiFree(fi);
+		      rpmdbFreeIterator(match);
 		      goto ret;
 		    }
 
@@ -296,17 +273,22 @@ static int rpmverify_collect(probe_ctx *ctx,
 
 		    if (callback(ctx, &res) != 0) {
 			    ret = 0;
+			    rpmfiFree(fi);
+			    rpmdbFreeIterator(match);
 			    goto ret;
 		    }
 		  }
 
 		  rpmfiFree(fi);
 		}
+
+		rpmdbFreeIterator(match);
 	}
 
-	match = rpmdbFreeIterator (match);
 	ret   = 0;
 ret:
+	oscap_free(pkgs);
+
 	if (re != NULL)
 		pcre_free(re);
 
@@ -332,6 +314,7 @@ void probe_fini (void *ptr)
 {
 	struct rpmverify_global *r = (struct rpmverify_global *)ptr;
 
+	rpm_index_free();
 	rpmtsFree(r->rpmts);
 	rpmFreeCrypto();
 	rpmFreeRpmrc();
@@ -73,6 +73,7 @@
 #include <common/assume.h>
 #include "debug_priv.h"
 #include "probe/entcmp.h"
+#include "rpm-helper.h"
 
 typedef struct {
 	const char *a_name;
@@ -88,12 +89,12 @@ const rpmverifypackage_bhmap_t rpmverifypackage_bhmap[] = {
 };
 
 struct rpmverify_res {
-	char *name;  /**< package name */
-	char *epoch;
-	char *version;
-	char *release;
-	char *arch;
-	char extended_name[1024];
+	const char *name;  /**< package name */
+	const char *epoch;
+	const char *version;
+	const char *release;
+	const char *arch;
+	const char *extended_name;
 	uint64_t vflags; /**< rpm verify flags */
 	uint64_t vresults;
 };
@@ -139,33 +140,17 @@ static struct poptOption optionsTable[] = {
 		pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &prev_cancel_state); \
 	} while(0)
 
-/* modify passed-in iterator to test also given entity */
-static int adjust_filter(rpmdbMatchIterator iterator, SEXP_t *ent, rpmTag rpm_tag) {
-	oval_operation_t ent_op;
-	char ent_str[1024];
-	int ret = 0;
-
-	if (ent) {
-		ent_op = probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS);
-		PROBE_ENT_STRVAL(ent, ent_str, sizeof ent_str, /* void */, strcpy(ent_str, ""););
-
-		switch (ent_op) {
-		case OVAL_OPERATION_EQUALS:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_STRCMP, ent_str) != 0)
-				ret = -1;
-
-			break;
-		case OVAL_OPERATION_PATTERN_MATCH:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_REGEX,
-						(const char *)ent_str) != 0)
-				ret = -1;
-
-			break;
-		default:
-			ret = 0;
-		}
-	}
-	return ret;
+/* value of an entity which can be looked up in the package index */
+static const char *lookup_value(SEXP_t *ent, char *buf, size_t buflen)
+{
+	if (ent == NULL ||
+	    probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS) != OVAL_OPERATION_EQUALS ||
+	    probe_ent_attrexists(ent, "var_ref"))
+		return (NULL);
+
+	PROBE_ENT_STRVAL(ent, buf, buflen, return (NULL);, return (NULL););
+
+	return (buf);
 }
 
 static int rpmverify_collect(probe_ctx *ctx,
@@ -173,9 +158,9 @@ static int rpmverify_collect(probe_ctx *ctx,
 			     uint64_t flags,
 			     int (*callback)(probe_ctx *, struct rpmverify_res *))
 {
-	rpmdbMatchIterator match;
-	Header pkgh;
-	int  ret = -1;
+	const struct rpm_pkg **pkgs = NULL;
+	char name_str[1024];
+	int  ret = -1, count, p;
 	unsigned int i, j, rpmcli_argc = 0;
 	const char * rpmcli_argv[10];
 	poptContext rpmcli_context;
@@ -183,44 +168,26 @@ static int rpmverify_collect(probe_ctx *ctx,
 
 	RPMVERIFY_LOCK;
 
-	match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-	if (match == NULL) {
-		ret = 0;
-		goto ret;
-	}
+	/*
+	 * Select the candidate packages from the package index, all
+	 * entities are compared below.
+	 */
+	count = rpm_index_select(g_rpm.rpmts, lookup_value(name_ent, name_str, sizeof name_str),
+				 NULL, &pkgs);
 
-	if ((ret = adjust_filter(match, name_ent, RPMTAG_NAME)) == -1) {
-		dE("can't adjust filter with name");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, epoch_ent, RPMTAG_EPOCH)) == -1) {
-		dE("can't adjust filter with epoch");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, version_ent, RPMTAG_VERSION)) == -1) {
-		dE("can't adjust filter with version");
+	if (count < 0) {
+		dE("can't read the package index\n");
+		ret = -1;
 		goto ret;
 	}
-	if ((ret = adjust_filter(match, release_ent, RPMTAG_RELEASE)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, arch_ent, RPMTAG_ARCH)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-
-	assume_d(RPMTAG_BASENAMES != 0, -1);
-	assume_d(RPMTAG_DIRNAMES  != 0, -1);
 
 	rpmcli_argv[0] = "probe_rpmverifypackage";
 	rpmcli_argv[1] = "--quiet";
 	rpmcli_argv[2] = "--nofiles";
 
-	while ((pkgh = rpmdbNextIterator (match)) != NULL) {
+	for (p = 0; p < count; ++p) {
 		SEXP_t *ent;
 		struct rpmverify_res res;
-		errmsg_t rpmerr;
 
 #define COMPARE_ENT(XXX) \
 		if (XXX ## _ent != NULL) { \
@@ -234,21 +201,17 @@ static int rpmverify_collect(probe_ctx *ctx,
 			SEXP_free(ent); \
 		}
 
-		res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
+		res.name = pkgs[p]->name;
 		COMPARE_ENT(name);
-
-		res.epoch = headerFormat(pkgh, "%{EPOCH}", &rpmerr);
+		res.epoch = pkgs[p]->epoch;
 		COMPARE_ENT(epoch);
-
-		res.version = headerFormat(pkgh, "%{VERSION}", &rpmerr);
+		res.version = pkgs[p]->version;
 		COMPARE_ENT(version);
-		res.release = headerFormat(pkgh, "%{RELEASE}", &rpmerr);
+		res.release = pkgs[p]->release;
 		COMPARE_ENT(release);
-		res.arch = headerFormat(pkgh, "%{ARCH}", &rpmerr);
+		res.arch = pkgs[p]->arch;
 		COMPARE_ENT(arch);
-		snprintf(res.extended_name, 1024, "%s-%s:%s-%s.%s", res.name,
-			oscap_streq(res.epoch, "(none)") ? "0" : res.epoch,
-			res.version, res.release, res.arch);
+		res.extended_name = pkgs[p]->extended_name;
 
 		/*
 		 * Verify package
@@ -293,16 +256,12 @@ static int rpmverify_collect(probe_ctx *ctx,
 			ret = 1;
 			goto ret;
 		}
-		free(res.name);
-		free(res.epoch);
-		free(res.version);
-		free(res.release);
-		free(res.arch);
 	}
 
-	match = rpmdbFreeIterator (match);
 	ret   = 0;
 ret:
+	oscap_free(pkgs);
+
 	RPMVERIFY_UNLOCK;
 	return (ret);
 }
@@ -325,6 +284,7 @@ void probe_fini (void *ptr)
 {
 	struct rpmverify_global *r = (struct rpmverify_global *)ptr;
 
+	rpm_index_free();
 	rpmtsFree(r->rpmts);
 	rpmFreeCrypto();
 	rpmFreeRpmrc();
@@ -149,72 +149,7 @@ static void report_finding(struct result_info *res, probe_ctx *ctx)
 
 #if defined(__linux__)
 
-unsigned long ticks, boot;
-
-static void get_boot_time(void)
-{
-	char buf[100];
-	FILE *sf;
-	int line;
-
-	boot = 0;
-	sf = fopen("/proc/stat", "rt");
-	if (sf == NULL)
-		return;
-
-	line = 0;
-	__fsetlocking(sf, FSETLOCKING_BYCALLER);
-	while (fgets(buf, sizeof(buf), sf)) {
-		if (line == 0) {
-			line++;
-			continue;
-		}
-		if (memcmp(buf, "btime", 5) == 0) {
-			sscanf(buf, "btime %lu", &boot);
-			break;
-		}
-	}
-	fclose(sf);
-}
-
-static int get_uids(int pid, struct result_info *r)
-{
-	char buf[100];
-	FILE *sf;
-
-	r->ruid = -1;
-	r->user_id = -1;
-	r->loginuid = -1;
-
-	snprintf(buf, sizeof(buf), "/proc/%d/status", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		int line = 0;
-		__fsetlocking(sf, FSETLOCKING_BYCALLER);
-		while (fgets(buf, sizeof(buf), sf)) {
-			if (line == 0) {
-				line++;
-				continue;
-			}
-			if (memcmp(buf, "Uid:", 4) == 0) {
-				sscanf(buf, "Uid: %d %d", &r->ruid, &r->user_id);
-				break;
-			}
-		}
-		fclose(sf);
-	}
-
-	snprintf(buf, sizeof(buf), "/proc/%d/loginuid", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		if (fscanf(sf, "%u", &r->loginuid) < 1) {
-			dW("fscanf failed from %s\n", buf);
-		}
-		fclose(sf);
-	}
-
-	return 0;
-}
+#include "linux/proc-snapshot.h"
 
 static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
 {
@@ -351,88 +286,77 @@ static int get_exec_shield_status(int pid) {
 	return ret;
 }
 
-static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
+/* Fields read only for the matching processes, kept in the snapshot */
+struct process58_data {
+	int exec_shield;
+	char *selinux_domain_label;
+	char **posix_capability;
+};
+
+static void *process58_data_get(const struct proc_entry *p)
 {
-	int err = 1;
-	DIR *d;
-	struct dirent *ent;
+	struct process58_data *data = oscap_talloc(struct process58_data);
 
-	d = opendir("/proc");
-	if (d == NULL)
-		return err;
+	data->exec_shield = (get_exec_shield_status(p->pid) > 0);
+	data->selinux_domain_label = get_selinux_label(p->pid);
+	data->posix_capability = get_posix_capability(p->pid);
 
-	// Get the time tick hertz
-	ticks = (unsigned long)sysconf(_SC_CLK_TCK);
-	get_boot_time();
+	return data;
+}
 
-	// Scan the directories
-	while (( ent = readdir(d) )) {
-		int fd, len;
-		char buf[256];
-		char *tmp, cmd[16], state, tty_dev[128];
-		int pid, ppid, pgrp, session, tty_nr, tpgid;
-		unsigned flags, sched_policy;
-		unsigned long minflt, cminflt, majflt, cmajflt, uutime, ustime;
-		long cutime, cstime, priority, cnice, nthreads, itrealvalue;
-		unsigned long long start;
-		SEXP_t *cmd_sexp = NULL, *pid_sexp = NULL;
+static void process58_data_free(void *ptr)
+{
+	struct process58_data *data = ptr;
 
-		// Skip non-process58 dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno || pid == 2) // skip err & kthreads
-			continue;
+	if (data->selinux_domain_label != NULL)
+		free(data->selinux_domain_label);
 
-		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
-			continue;
-		memset(cmd, 0, sizeof(cmd));
-		sscanf(buf, "%d (%15c", &ppid, cmd);
-		sscanf(tmp+2,	"%c %d %d %d %d %d "
-				"%u %lu %lu %lu %lu "
-				"%lu %lu %lu %ld %ld "
-				"%ld %ld %ld %llu",
-			&state, &ppid, &pgrp, &session, &tty_nr, &tpgid,
-			&flags, &minflt, &cminflt, &majflt, &cmajflt,
-			&uutime, &ustime, &cutime, &cstime, &priority,
-			&cnice, &nthreads, &itrealvalue, &start
-		);
-
-		// Skip kthreads
-		if (ppid == 2)
-			continue;
+	if (data->posix_capability != NULL) {
+		char **posix_capabilities_p = data->posix_capability;
+		while (*posix_capabilities_p)
+			free(*posix_capabilities_p++);
+		free(data->posix_capability);
+	}
 
-		err = 0; // If we get this far, no permission problems
-		dI("Have command: %s\n", cmd);
-		cmd_sexp = SEXP_string_newf("%s", cmd);
-		pid_sexp = SEXP_number_newu_32(pid);
+	oscap_free(data);
+}
+
+static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
+{
+	int err;
+	size_t i;
+	struct proc_snapshot *snap;
+
+	snap = proc_snapshot_get(PROC_SNAPSHOT_UIDS | PROC_SNAPSHOT_LOGINUID);
+	if (snap == NULL)
+		return 1;
+
+	// If there's no process, we have permission problems
+	err = (snap->count == 0);
+
+	for (i = 0; i < snap->count; ++i) {
+		struct proc_entry *p = snap->proc + i;
+		unsigned sched_policy;
+		char tty_dev[128];
+		SEXP_t *cmd_sexp = NULL, *pid_sexp = NULL;
+
+		dI("Have command: %s\n", p->cmd);
+		cmd_sexp = SEXP_string_newf("%s", p->cmd);
+		pid_sexp = SEXP_number_newu_32(p->pid);
 		if ((cmd_sexp == NULL || probe_entobj_cmp(cmd_ent, cmd_sexp) == OVAL_RESULT_TRUE) &&
 		    (pid_sexp == NULL || probe_entobj_cmp(pid_ent, pid_sexp) == OVAL_RESULT_TRUE)
 		) {
 			struct result_info r;
-			unsigned long t = uutime/ticks + ustime/ticks;
-			char tbuf[32], sbuf[32], *selinux_domain_label, **posix_capabilities;
+			struct process58_data *data;
+			unsigned long t = p->utime/snap->ticks + p->stime/snap->ticks;
+			char tbuf[32], sbuf[32];
 			int tday,tyear;
 			time_t s_time;
 			struct tm *proc, *now;
 			const char *fmt;
 
 			// Now get scheduler policy
-			sched_policy = sched_getscheduler(pid);
+			sched_policy = sched_getscheduler(p->pid);
 			switch (sched_policy) {
 				case SCHED_OTHER:
 					r.scheduling_class = "TS";
@@ -461,7 +385,7 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 			now = localtime(&s_time);
 			tyear = now->tm_year;
 			tday = now->tm_yday;
-			s_time = boot + (start / ticks);
+			s_time = snap->boot + (p->start / snap->ticks);
 			proc = localtime(&s_time);
 
 			// Select format based on how long we've been running
@@ -477,43 +401,32 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 				fmt = "%H:%M:%S";
 			strftime(sbuf, sizeof(sbuf), fmt, proc);
 
-			r.command_line = cmd;
+			r.command_line = p->cmd;
 			r.exec_time = convert_time(t, tbuf, sizeof(tbuf));
-			r.pid = pid;
-			r.ppid = ppid;
-			r.priority = priority;
+			r.pid = p->pid;
+			r.ppid = p->ppid;
+			r.priority = p->priority;
 			r.start_time = sbuf;
 
-			dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) tty_nr, pid, ABBREV_DEV);
+			dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) p->tty_nr, p->pid, ABBREV_DEV);
 			r.tty = tty_dev;
 
-			r.exec_shield = (get_exec_shield_status(pid) > 0);
-
-			selinux_domain_label = get_selinux_label(pid);
-			r.selinux_domain_label = selinux_domain_label;
-
-			posix_capabilities = get_posix_capability(pid);
-			r.posix_capability = posix_capabilities;
+			data = proc_snapshot_data(snap, p, process58_data_get, process58_data_free);
+			r.exec_shield = data->exec_shield;
+			r.selinux_domain_label = data->selinux_domain_label;
+			r.posix_capability = data->posix_capability;
 
-			r.session_id = session;
+			r.session_id = p->session;
 
-			get_uids(pid, &r);
+			r.ruid = p->ruid;
+			r.user_id = p->euid;
+			r.loginuid = p->loginuid;
 			report_finding(&r, ctx);
-
-			if (selinux_domain_label != NULL)
-				free(selinux_domain_label);
-
-			if (posix_capabilities != NULL) {
-				char **posix_capabilities_p = posix_capabilities;
-				while (*posix_capabilities_p)
-					free(*posix_capabilities_p++);
-				free(posix_capabilities);
-			}
 		}
 		SEXP_free(cmd_sexp);
 		SEXP_free(pid_sexp);
 	}
-        closedir(d);
+	proc_snapshot_put(snap);
 
 	return err;
 }
@@ -539,6 +452,11 @@ int probe_main(probe_ctx *ctx, void *arg)
 
 	return 0;
 }
+
+void probe_fini(void *arg)
+{
+	proc_snapshot_cleanup();
+}
 #elif defined (__SVR4) && defined (__sun)
 
 #include <procfs.h>
@@ -36,37 +36,270 @@
 #if defined(__linux__)
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
 #include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include "oval_fts.h"
+#include "alloc.h"
 #include "common/debug_priv.h"
 #include "common/assume.h"
 
 #define PROC_SYS_DIR "/proc/sys"
 #define PROC_SYS_MAXDEPTH 7
 
-int probe_main(probe_ctx *ctx, void *probe_arg)
+#ifndef SYSCTL_SNAPSHOT_DEFAULT_TTL
+#define SYSCTL_SNAPSHOT_DEFAULT_TTL 60 /* seconds */
+#endif
+
+/*
+ * Snapshot of the kernel parameters under /proc/sys. Objects which don't
+ * name a single parameter are compared with the names in the snapshot
+ * instead of walking the tree each time. The snapshot is shared by all
+ * the objects evaluated by the probe until it is older than
+ * OSCAP_PROBE_SYSCTL_SNAPSHOT_TTL seconds. Values are read when a
+ * parameter is first matched and then reused too.
+ */
+struct sysctl_param {
+        char *name;
+        char *path;
+        bool  read;
+        char *value;  /* NULL if it couldn't be read */
+        long  length;
+};
+
+static struct {
+        struct sysctl_param *param;
+        size_t               count;
+        time_t               time;
+        bool                 valid;
+        pthread_mutex_t      mutex;
+} g_sysctl = { NULL, 0, 0, false, PTHREAD_MUTEX_INITIALIZER };
+
+#define SYSCTL_LOCK(prev_cancel_state) \
+	do { \
+		pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &(prev_cancel_state)); \
+		if (pthread_mutex_lock(&g_sysctl.mutex) != 0) { \
+			dE("Can't lock mutex\n"); \
+			abort(); \
+		} \
+	} while(0)
+
+#define SYSCTL_UNLOCK(prev_cancel_state) \
+	do { \
+		if (pthread_mutex_unlock(&g_sysctl.mutex) != 0) { \
+			dE("Can't unlock mutex. Aborting...\n"); \
+			abort(); \
+		} \
+		pthread_setcancelstate((prev_cancel_state), NULL); \
+	} while(0)
+
+static void sysctl_snapshot_free(void)
+{
+        size_t i;
+
+        for (i = 0; i < g_sysctl.count; ++i) {
+                oscap_free(g_sysctl.param[i].name);
+                oscap_free(g_sysctl.param[i].path);
+                oscap_free(g_sysctl.param[i].value);
+        }
+
+        oscap_free(g_sysctl.param);
+        g_sysctl.param = NULL;
+        g_sysctl.count = 0;
+        g_sysctl.valid = false;
+}
+
+void probe_fini(void *arg)
+{
+        int prev_cancel_state = -1;
+
+        SYSCTL_LOCK(prev_cancel_state);
+        sysctl_snapshot_free();
+        SYSCTL_UNLOCK(prev_cancel_state);
+}
+
+static time_t sysctl_snapshot_ttl(void)
+{
+        const char *str = getenv("OSCAP_PROBE_SYSCTL_SNAPSHOT_TTL");
+        char *end;
+        unsigned long val;
+
+        if (str == NULL)
+                return (SYSCTL_SNAPSHOT_DEFAULT_TTL);
+
+        errno = 0;
+        val = strtoul(str, &end, 10);
+
+        if (errno != 0 || *end != '\0' || end == str) {
+                dW("Ignoring invalid value of OSCAP_PROBE_SYSCTL_SNAPSHOT_TTL: %s\n", str);
+                return (SYSCTL_SNAPSHOT_DEFAULT_TTL);
+        }
+
+        return ((time_t)val);
+}
+
+/*
+ * Read the value of the parameter at `path' into `sysval', which has
+ * room for at least `size' bytes.
+ * @return length of the value or -1 on error
+ */
+static long sysctl_read(const char *path, char *sysval, size_t size)
+{
+        FILE *fp;
+        long  l;
+
+        fp = fopen(path, "r");
+
+        if (fp == NULL) {
+                dE("Can't read sysctl value from \"%s\": %u, %s\n",
+                   path, errno, strerror(errno));
+                return (-1);
+        }
+
+        l = fread(sysval, 1, size - 1, fp);
+
+        if (ferror(fp)) {
+                dE("An error ocured when reading from \"%s\" (fp=%p): l=%ld, %u, %s\n",
+                   path, fp, l, errno, strerror(errno));
+                fclose(fp);
+                return (-1);
+        }
+
+        fclose(fp);
+
+        return (l);
+}
+
+/*
+ * Create the item of the parameter `mib' from its value in `sysval' of
+ * length `l' (-1 if it couldn't be read). `sysval' is modified and has
+ * to have room for at least `l' + 1 bytes.
+ */
+static SEXP_t *sysctl_item(const char *mib, char *sysval, long l, int over_cmp)
+{
+        SEXP_t *item, *se_mib;
+        char   *sysvals[512];
+        long i;
+        size_t s;
+
+        if (l < 0) {
+                item = probe_item_creat("sysctl_item", NULL, NULL);
+                probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
+
+                return (item);
+        }
+
+        /*
+         * sanitize the value
+         *  - only printable and whitespace chars allowed
+         *  - remove the last '\n'
+         */
+        sysvals[0] = sysval;
+
+        for(s = 0, i = 0; i < l && s < sizeof sysvals/sizeof(char *) - 1; ++i) {
+                if ((!isprint(sysval[i]) && !isspace(sysval[i]))
+                    || (over_cmp >= 0 && sysval[i] == '\n' /* OVAL 5.10 and above */))
+                {
+                        sysval[i] = '\0';
+                        sysvals[++s] = sysval + i + 1;
+                }
+        }
+
+        if (l > 0 && sysval[l - 1] == '\n')
+                sysval[l - 1] = '\0';
+        else
+                sysval[l] = '\0';
+
+        if (strlen(sysvals[s]) == 0)
+                sysvals[s] = NULL;
+        else
+                sysvals[++s] = NULL;
+
+        se_mib = SEXP_string_new(mib, strlen(mib));
+
+        if (over_cmp >= 0) {
+                /* Only in OVAL 5.10 and above */
+                item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
+                                         "name",  OVAL_DATATYPE_SEXP,   se_mib,
+                                         "value", OVAL_DATATYPE_STRING_M, sysvals,
+                                         NULL);
+        } else {
+                item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
+                                         "name",  OVAL_DATATYPE_SEXP,   se_mib,
+                                         "value", OVAL_DATATYPE_STRING, sysval,
+                                         NULL);
+        }
+
+        SEXP_free(se_mib);
+
+        return (item);
+}
+
+/*
+ * Path of the parameter named by an "equals" name entity, if it can be
+ * accessed directly. Otherwise, e.g. if a directory on the path has
+ * a dot in its name (net.ipv4.conf.eth0.1.rp_filter), the name has to be
+ * looked up in the snapshot.
+ */
+static const char *sysctl_direct_path(SEXP_t *name_entity, char *mibpath, size_t size)
+{
+        char mib[PATH_MAX], *p;
+        size_t n, depth;
+        struct stat st, st_dir;
+
+        if (probe_ent_getoperation(name_entity, OVAL_OPERATION_EQUALS) != OVAL_OPERATION_EQUALS ||
+            probe_ent_attrexists(name_entity, "var_ref"))
+                return (NULL);
+
+        PROBE_ENT_STRVAL(name_entity, mib, sizeof mib, return (NULL);, return (NULL););
+
+        n = snprintf(mibpath, size, "%s/%s", PROC_SYS_DIR, mib);
+        if (n >= size)
+                return (NULL);
+
+        /* no empty components, at most as deep as the tree is walked */
+        for (p = mibpath + strlen(PROC_SYS_DIR) + 1, depth = 1; *p != '\0'; ++p) {
+                if (*p == '/')
+                        return (NULL);
+                if (*p == '.') {
+                        if (p[-1] == '/' || p[1] == '.' || p[1] == '\0')
+                                return (NULL);
+                        *p = '/';
+                        ++depth;
+                }
+        }
+
+        if (depth > PROC_SYS_MAXDEPTH)
+                return (NULL);
+
+        /* the walk doesn't leave the /proc/sys filesystem */
+        if (stat(mibpath, &st) != 0 || !S_ISREG(st.st_mode) ||
+            stat(PROC_SYS_DIR, &st_dir) != 0 || st.st_dev != st_dir.st_dev)
+                return (NULL);
+
+        return (mibpath);
+}
+
+/* Called with g_sysctl.mutex held */
+static int sysctl_snapshot_update(void)
 {
         OVAL_FTS    *ofts;
         OVAL_FTSENT *ofts_ent;
-
-        SEXP_t *name_entity, *probe_in;
         SEXP_t *r0, *r1, *r2, *r3;
         SEXP_t *ent_attrs, *bh_entity, *path_entity, *filename_entity;
-        oval_version_t over;
-        int over_cmp;
+        size_t  alloc = 0;
+        time_t  now = time(NULL);
 
-        probe_in    = probe_ctx_getobject(ctx);
-        name_entity = probe_obj_getent(probe_in, "name", 1);
-        over        = probe_obj_get_schema_version(probe_in);
-        over_cmp    = oval_version_cmp(over, OVAL_VERSION(5.10));
+        if (g_sysctl.valid && now >= g_sysctl.time && now - g_sysctl.time < sysctl_snapshot_ttl())
+                return (0);
 
-        if (name_entity == NULL) {
-                dE("Missing \"name\" entity in the input object\n");
-                return (PROBE_ENOENT);
-        }
+        sysctl_snapshot_free();
 
         /*
          * prepare behaviors
@@ -94,19 +327,18 @@ int probe_main(probe_ctx *ctx, void *probe_arg)
 
         /*
          * collect sysctls
-         *  XXX: use direct access for the "equals" op
          */
         ofts = oval_fts_open(path_entity, filename_entity, NULL, bh_entity);
 
         if (ofts == NULL) {
                 dE("oval_ftp_open(%s, %s) failed\n", PROC_SYS_DIR, ".\\+");
-                SEXP_vfree(path_entity, filename_entity, bh_entity, name_entity, NULL);
+                SEXP_vfree(path_entity, filename_entity, bh_entity, NULL);
 
-                return (PROBE_EFATAL);
+                return (-1);
         }
 
         while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-                SEXP_t *se_mib;
+                struct sysctl_param *param;
                 char    mibpath[PATH_MAX], *mib;
                 size_t  miblen;
 
@@ -122,96 +354,137 @@ int probe_main(probe_ctx *ctx, void *probe_arg)
                 }
 
                 dI("MIB: %s\n", mib);
-                se_mib = SEXP_string_new(mib, strlen(mib));
-                oscap_free(mib);
 
-                if (probe_entobj_cmp(name_entity, se_mib) == OVAL_RESULT_TRUE) {
-                        FILE   *fp;
-                        SEXP_t *item;
-                        char    sysval[8192];
-                        char   *sysvals[512];
-                        long i, l;
-                        size_t s;
-
-                        dI("MIB match\n");
-
-                        /*
-                         * read sysctl value
-                         */
-                        fp = fopen(mibpath, "r");
-
-                        if (fp == NULL) {
-                                dE("Can't read sysctl value from \"%s\": %u, %s\n",
-                                   mibpath, errno, strerror(errno));
-                                goto fail_item;
-                        }
+                if (g_sysctl.count == alloc) {
+                        alloc = alloc == 0 ? 1024 : alloc * 2;
+                        g_sysctl.param = oscap_realloc(g_sysctl.param, alloc * sizeof(struct sysctl_param));
+                }
 
-                        l = fread(sysval, 1, sizeof sysval - 1, fp);
+                param = g_sysctl.param + g_sysctl.count++;
+                param->name   = mib;
+                param->path   = strdup(mibpath);
+                param->read   = false;
+                param->value  = NULL;
+                param->length = -1;
 
-                        if (ferror(fp)) {
-                                dE("An error ocured when reading from \"%s\" (fp=%p): l=%ld, %u, %s\n",
-                                    mibpath, fp, l, errno, strerror(errno));
-                                goto fail_item;
-                        }
+                oval_ftsent_free(ofts_ent);
+        }
 
-                        fclose(fp);
-
-                        /*
-                         * sanitize the value
-                         *  - only printable and whitespace chars allowed
-                         *  - remove the last '\n'
-                         */
-                        sysvals[0] = sysval;
-
-                        for(s = 0, i = 0; i < l && s < sizeof sysvals/sizeof(char *) - 1; ++i) {
-	                        if ((!isprint(sysval[i]) && !isspace(sysval[i]))
-	                            || (over_cmp >= 0 && sysval[i] == '\n' /* OVAL 5.10 and above */))
-                                {
-                                        sysval[i] = '\0';
-                                        sysvals[++s] = sysval + i + 1;
-                                }
-                        }
+        oval_fts_close(ofts);
+	SEXP_vfree(path_entity, filename_entity, bh_entity, NULL);
+
+        g_sysctl.time  = now;
+        g_sysctl.valid = true;
+
+        return (0);
+}
+
+/*
+ * Create the items of the parameters matching `name_entity' from the
+ * snapshot. The items are returned in `items' so that they can be
+ * collected with the lock released.
+ * @return number of items or -1 on error
+ */
+static long sysctl_snapshot_items(SEXP_t *name_entity, int over_cmp, SEXP_t ***items)
+{
+        int    prev_cancel_state = -1;
+        long   count = 0;
+        size_t i;
+
+        *items = NULL;
+
+        SYSCTL_LOCK(prev_cancel_state);
+
+        if (sysctl_snapshot_update() != 0) {
+                SYSCTL_UNLOCK(prev_cancel_state);
+                return (-1);
+        }
+
+        for (i = 0; i < g_sysctl.count; ++i) {
+                struct sysctl_param *param = g_sysctl.param + i;
+                SEXP_t *se_mib;
+                char    sysval[8192];
+                int     match;
+
+                se_mib = SEXP_string_new(param->name, strlen(param->name));
+                match  = probe_entobj_cmp(name_entity, se_mib) == OVAL_RESULT_TRUE;
+                SEXP_free(se_mib);
+
+                if (!match)
+                        continue;
+
+                dI("MIB match: %s\n", param->name);
+
+                if (!param->read) {
+                        param->length = sysctl_read(param->path, sysval, sizeof sysval);
+                        param->read   = true;
 
-                        if (sysval[l - 1] == '\n')
-                                sysval[l - 1] = '\0';
-                        else
-                                sysval[l] = '\0';
-
-                        if (strlen(sysvals[s]) == 0)
-                                sysvals[s] = NULL;
-                        else
-                                sysvals[++s] = NULL;
-
-                        if (over_cmp >= 0) {
-	                        /* Only in OVAL 5.10 and above */
-	                        item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
-	                                                 "name",  OVAL_DATATYPE_SEXP,   se_mib,
-	                                                 "value", OVAL_DATATYPE_STRING_M, sysvals,
-	                                                 NULL);
-                        } else {
-	                        item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
-	                                                 "name",  OVAL_DATATYPE_SEXP,   se_mib,
-	                                                 "value", OVAL_DATATYPE_STRING, sysval,
-	                                                 NULL);
+                        if (param->length >= 0) {
+                                param->value = oscap_alloc(param->length + 1);
+                                memcpy(param->value, sysval, param->length);
                         }
+                } else if (param->length >= 0) {
+                        memcpy(sysval, param->value, param->length);
+                }
+
+                *items = oscap_realloc(*items, (count + 1) * sizeof(SEXP_t *));
+                (*items)[count++] = sysctl_item(param->name, sysval, param->length, over_cmp);
+        }
+
+        SYSCTL_UNLOCK(prev_cancel_state);
+
+        return (count);
+}
+
+int probe_main(probe_ctx *ctx, void *probe_arg)
+{
+        SEXP_t *name_entity, *probe_in, **items;
+        oval_version_t over;
+        int over_cmp;
+        char mibpath[PATH_MAX], sysval[8192];
+        long count, i;
+
+        probe_in    = probe_ctx_getobject(ctx);
+        name_entity = probe_obj_getent(probe_in, "name", 1);
+        over        = probe_obj_get_schema_version(probe_in);
+        over_cmp    = oval_version_cmp(over, OVAL_VERSION(5.10));
+
+        if (name_entity == NULL) {
+                dE("Missing \"name\" entity in the input object\n");
+                return (PROBE_ENOENT);
+        }
 
-                        goto add_item;
-                fail_item:
-                        if (fp != NULL)
-                                fclose(fp);
+        /*
+         * A single parameter is read directly
+         */
+        if (sysctl_direct_path(name_entity, mibpath, sizeof mibpath) != NULL) {
+                char *mib;
 
-                        item = probe_item_creat("sysctl_item", NULL, NULL);
-                        probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
-                add_item:
-                        probe_item_collect(ctx, item);
+                mib = strdup(mibpath + strlen(PROC_SYS_DIR) + 1);
+                for (i = 0; mib[i] != '\0'; ++i) {
+                        if (mib[i] == '/')
+                                mib[i] = '.';
                 }
 
-                oval_ftsent_free(ofts_ent);
-                SEXP_free(se_mib);
+                dI("MIB: %s\n", mib);
+                probe_item_collect(ctx, sysctl_item(mib, sysval, sysctl_read(mibpath, sysval, sizeof sysval), over_cmp));
+
+                oscap_free(mib);
+                SEXP_free(name_entity);
+
+                return (0);
         }
 
-        oval_fts_close(ofts);
-	SEXP_vfree(path_entity, filename_entity, bh_entity, name_entity);
+        count = sysctl_snapshot_items(name_entity, over_cmp, &items);
+        SEXP_free(name_entity);
+
+        if (count < 0)
+                return (PROBE_EFATAL);
+
+        for (i = 0; i < count; ++i)
+                probe_item_collect(ctx, items[i]);
+
+        oscap_free(items);
 
         return (0);
 }
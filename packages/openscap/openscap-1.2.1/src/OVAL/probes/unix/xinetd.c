@@ -54,6 +54,7 @@
 #include <bfind.h>
 #include <common/debug_priv.h>
 #include <netdb.h>
+#include <pthread.h>
 #include "../SEAP/generic/rbt/rbt.h"
 
 #define PATH_SEPARATOR '/'
@@ -172,6 +173,9 @@ typedef struct {
 	int             fd;    /**< file descriptor */
 	char           *cpath; /**< path to the configuration file */
 	time_t          mtime; /**< modification time of the file */
+	dev_t           dev;   /**< device of the file */
+	ino_t           ino;   /**< inode of the file */
+	off_t           size;  /**< size of the file */
 	rbt_str_node_t *nodes; /**< node pointers in the service tree that belong to this file; */
 	size_t          count; /**< number of node pointers */
 	char           *inmem; /**< contents of the file mmaped or copied into memory */
@@ -185,9 +189,20 @@ typedef struct {
 #define XICONF_FILE_PERSIST 0x00000002 /**< keep the file open/mmaped */
 #define XICONF_FILE_DEAD    0x00000004 /**< this item can be skipped/deleted/reused for a different file */
 
+typedef struct {
+	char           *cpath; /**< path to the included directory */
+	time_t          mtime; /**< modification time of the directory */
+	dev_t           dev;   /**< device of the directory */
+	ino_t           ino;   /**< inode of the directory */
+} xiconf_dir_t;
+
 typedef struct {
 	xiconf_file_t   **cfile; /**< */
 	size_t            count; /**< */
+	xiconf_dir_t     *cdir;  /**< included directories */
+	size_t            dcount; /**< number of included directories */
+	char             *path;  /**< path to the main configuration file */
+	unsigned int      max_depth; /**< include depth limit */
 	rbt_t            *stree; /**< service tree */
 	rbt_t            *ttree; /**< service name & protocol to ID(s) tree */
 	xiconf_service_t *defaults; /**< parsed defaults for services */
@@ -365,6 +380,10 @@ static xiconf_t *xiconf_new(void)
 	xiconf = oscap_talloc(xiconf_t);
 	xiconf->cfile = oscap_alloc(sizeof(xiconf_file_t *));
 	xiconf->count = 0;
+	xiconf->cdir  = NULL;
+	xiconf->dcount = 0;
+	xiconf->path  = NULL;
+	xiconf->max_depth = 0;
 	xiconf->stree = rbt_str_new();
 	xiconf->ttree = rbt_str_new();
 	xiconf->defaults = NULL;
@@ -462,6 +481,12 @@ void xiconf_free(xiconf_t *xiconf)
 
 	oscap_free(xiconf->cfile);
 
+	for (i = 0; i < xiconf->dcount; ++i)
+		oscap_free(xiconf->cdir[i].cpath);
+
+	oscap_free(xiconf->cdir);
+	oscap_free(xiconf->path);
+
         rbt_str_free_cb(xiconf->stree, xiconf_stree_free_cb);
         rbt_str_free_cb(xiconf->ttree, xiconf_ttree_free_cb);
 
@@ -511,6 +536,9 @@ static xiconf_file_t *xiconf_read(const char *path, int flags)
 	file->inlen = (size_t)st.st_size;
 	file->inoff = 0;
 	file->mtime = st.st_mtime;
+	file->dev   = st.st_dev;
+	file->ino   = st.st_ino;
+	file->size  = st.st_size;
 	file->nodes = NULL;
 	file->count = 0;
 	file->flags = flags;
@@ -575,6 +603,28 @@ static int xiconf_add_cfile(xiconf_t *xiconf, const char *path, int depth)
 	return (0);
 }
 
+/*
+ * Remember an included directory so that xiconf_update() notices when
+ * files are added to or removed from it.
+ */
+static void xiconf_add_cdir(xiconf_t *xiconf, const char *path, DIR *dirfp)
+{
+	struct stat st;
+	xiconf_dir_t *xidir;
+
+	if (fstat(dirfd(dirfp), &st) != 0) {
+		dW("Can't stat includedir: %s; %d, %s.\n", path, errno, strerror (errno));
+		return;
+	}
+
+	xiconf->cdir = oscap_realloc(xiconf->cdir, sizeof(xiconf_dir_t) * ++xiconf->dcount);
+	xidir = xiconf->cdir + xiconf->dcount - 1;
+	xidir->cpath = strdup(path);
+	xidir->mtime = st.st_mtime;
+	xidir->dev   = st.st_dev;
+	xidir->ino   = st.st_ino;
+}
+
 #define tmpbuf_def(size) char __tmpbuf[size]
 #define tmpbuf_get(size) (((sizeof __tmpbuf)/sizeof(char))<(size)?oscap_alloc(sizeof(char)*(size)):__tmpbuf)
 #define tmpbuf_free(ptr) do { if ((ptr) != __tmpbuf) oscap_free(ptr); (ptr) = NULL; } while(0)
@@ -605,6 +655,8 @@ xiconf_t *xiconf_parse(const char *path, unsigned int max_depth)
 	xifile->depth = 0;
 	xiconf->cfile[0] = xifile;
 	xiconf->count = 1;
+	xiconf->path  = strdup(path);
+	xiconf->max_depth = max_depth;
 
 	for (findex = 0; findex < xiconf->count; ++findex) {
 		char  *buffer;
@@ -754,6 +806,7 @@ xiconf_t *xiconf_parse(const char *path, unsigned int max_depth)
 						break;
 					}
 
+					xiconf_add_cdir(xiconf, inclarg, dirfp);
 					strcpy (pathbuf, inclarg);
 					incllen = strlen(inclarg);
 
@@ -811,9 +864,63 @@ xiconf_t *xiconf_parse(const char *path, unsigned int max_depth)
 	return (xiconf);
 }
 
+static bool xiconf_changed(xiconf_t *xiconf)
+{
+	struct stat st;
+	size_t i;
+
+	for (i = 0; i < xiconf->count; ++i) {
+		xiconf_file_t *xifile = xiconf->cfile[i];
+
+		if (stat(xifile->cpath, &st) != 0 ||
+		    st.st_dev != xifile->dev || st.st_ino != xifile->ino ||
+		    st.st_mtime != xifile->mtime || st.st_size != xifile->size)
+		{
+			dI("Configuration file changed: %s\n", xifile->cpath);
+			return (true);
+		}
+	}
+
+	for (i = 0; i < xiconf->dcount; ++i) {
+		xiconf_dir_t *xidir = xiconf->cdir + i;
+
+		if (stat(xidir->cpath, &st) != 0 ||
+		    st.st_dev != xidir->dev || st.st_ino != xidir->ino ||
+		    st.st_mtime != xidir->mtime)
+		{
+			dI("Included directory changed: %s\n", xidir->cpath);
+			return (true);
+		}
+	}
+
+	return (false);
+}
+
+/*
+ * Parse the configuration again if any of the parsed files or included
+ * directories was modified, replaced or removed. The structure is
+ * updated in place, so it must not be used by anyone else meanwhile.
+ */
 int xiconf_update(xiconf_t *xiconf)
 {
-	dI("Not implemented yet.\n");
+	xiconf_t *update, tmp;
+
+	if (!xiconf_changed(xiconf))
+		return (0);
+
+	update = xiconf_parse(xiconf->path, xiconf->max_depth);
+
+	if (update == NULL) {
+		dE("Can't parse the updated configuration: %s\n", xiconf->path);
+		return (-1);
+	}
+
+	tmp     = *xiconf;
+	*xiconf = *update;
+	*update = tmp;
+
+	xiconf_free(update);
+
 	return (0);
 }
 
@@ -1557,6 +1664,12 @@ int op_assign_enabled(void *var, char *val)
 #endif
 
 #ifndef XINETD_TEST
+/*
+ * The configuration is parsed once in probe_init() and shared by all the
+ * objects, xiconf_update() parses it again only if it has changed.
+ */
+static pthread_mutex_t g_xiconf_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static void xiservice_process_query(probe_ctx *ctx, SEXP_t *service_name, SEXP_t *protocol, const xiconf_service_t *xsrv)
 {
 	SEXP_t *xres_service_name, *xres_protocol, *item;
@@ -1605,7 +1718,7 @@ int probe_main(probe_ctx *ctx, void *arg)
 	SEXP_t *service_name, *protocol, *eval, *object;
 	char    srv_name[256];
 	char    srv_prot[256];
-	int     err;
+	int     err, prev_cancel_state = -1;
 
 	xiconf_service_t *xsrv;
 	xiconf_strans_t  *xres;
@@ -1658,7 +1771,17 @@ int probe_main(probe_ctx *ctx, void *arg)
 
 	dI("Updating xinetd configuration cache");
 
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &prev_cancel_state);
+
+	if (pthread_mutex_lock(&g_xiconf_mutex) != 0) {
+		dE("Can't lock mutex\n");
+		abort();
+	}
+
 	if (xiconf_update(arg) != 0) {
+		pthread_mutex_unlock(&g_xiconf_mutex);
+		pthread_setcancelstate(prev_cancel_state, NULL);
+		SEXP_vfree(service_name, protocol, NULL);
 		err = PROBE_EUNKNOWN;
 		goto fail;
 	}
@@ -1679,6 +1802,13 @@ int probe_main(probe_ctx *ctx, void *arg)
 		oscap_free(xres);
 
 	}
+
+	if (pthread_mutex_unlock(&g_xiconf_mutex) != 0) {
+		dE("Can't unlock mutex. Aborting...\n");
+		abort();
+	}
+
+	pthread_setcancelstate(prev_cancel_state, NULL);
 	SEXP_vfree(service_name, protocol, NULL);
 
 	return (0);
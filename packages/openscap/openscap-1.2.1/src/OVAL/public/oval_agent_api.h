@@ -72,6 +72,14 @@ struct oval_definition_model* oval_agent_get_definition_model(oval_agent_session
  */
 void oval_agent_set_product_name(oval_agent_session_t *, char *);
 
+/**
+ * Set the number of threads used to collect system characteristics
+ * by oval_agent_eval_system. Objects handled by different probes are
+ * collected concurrently when more than one thread is set. The results
+ * do not depend on the number of threads. The default is 1.
+ */
+void oval_agent_set_eval_threads(oval_agent_session_t *ag_sess, unsigned int threads);
+
 /**
  * Probe the system and evaluate specified definition
  * @return 0 on success; -1 error; 1 warning
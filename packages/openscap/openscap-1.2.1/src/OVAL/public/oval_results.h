@@ -154,7 +154,8 @@ struct oval_results_model *oval_results_model_clone(struct oval_results_model *)
  */
 void oval_results_model_free(struct oval_results_model *model);
 /**
- * Export oval results into file.
+ * Export oval results into file. The document is written while it is
+ * being built, so the memory used doesn't grow with its size.
  * @param model the oval_results_model
  * @param model the oval_directives_model
  * @param file filename
@@ -156,3 +156,105 @@ oval_result_t oval_ent_cmp_str(char *state_data, oval_datatype_t state_data_type
 	oscap_seterr(OSCAP_EFAMILY_OVAL, "Invalid OVAL data type: %d.", state_data_type);
 	return OVAL_RESULT_ERROR;
 }
+
+void oval_cmp_value_init(struct oval_cmp_value *value, char *text, oval_datatype_t datatype, oval_operation_t operation)
+{
+	value->text = text;
+	value->datatype = datatype;
+	value->operation = operation;
+	value->parsed = false;
+
+	switch (datatype) {
+	case OVAL_DATATYPE_STRING:
+		if (operation == OVAL_OPERATION_PATTERN_MATCH) {
+			value->u.regex = oval_regex_get(text);
+			value->parsed = (value->u.regex != NULL);
+		}
+		break;
+	case OVAL_DATATYPE_INTEGER:
+		value->parsed = cstr_to_intmax(text, &value->u.integer);
+		break;
+	case OVAL_DATATYPE_FLOAT:
+		value->parsed = cstr_to_double(text, &value->u.real);
+		break;
+	case OVAL_DATATYPE_BOOLEAN:
+		value->u.boolean = strcmp(text, "true") == 0 || strcmp(text, "1") == 0;
+		value->parsed = true;
+		break;
+	case OVAL_DATATYPE_EVR_STRING:
+		oval_evr_parse(text, &value->u.evr);
+		value->parsed = true;
+		break;
+	case OVAL_DATATYPE_IPV4ADDR:
+		value->parsed = (oval_ipaddr_parse(AF_INET, text, &value->u.ipaddr) == 0);
+		break;
+	case OVAL_DATATYPE_IPV6ADDR:
+		value->parsed = (oval_ipaddr_parse(AF_INET6, text, &value->u.ipaddr) == 0);
+		break;
+	default:
+		break;
+	}
+}
+
+void oval_cmp_value_clear(struct oval_cmp_value *value)
+{
+	if (!value->parsed)
+		return;
+
+	if (value->datatype == OVAL_DATATYPE_STRING)
+		oval_regex_put(value->u.regex);
+	else if (value->datatype == OVAL_DATATYPE_EVR_STRING)
+		oval_evr_clear(&value->u.evr);
+	value->parsed = false;
+}
+
+oval_result_t oval_ent_cmp_value(const struct oval_cmp_value *value, struct oval_sysent *sysent)
+{
+	const char *sys_data;
+
+	/* the state value could not be parsed, let the comparison report it */
+	if (!value->parsed)
+		return oval_ent_cmp_str(value->text, value->datatype, sysent, value->operation);
+
+	sys_data = oval_sysent_get_value(sysent);
+
+	switch (value->datatype) {
+	case OVAL_DATATYPE_STRING:
+		return oval_regex_match(value->u.regex, sys_data ? sys_data : "");
+	case OVAL_DATATYPE_INTEGER: {
+		intmax_t syschar_val;
+
+		if (!cstr_to_intmax(sys_data, &syschar_val)) {
+			oscap_seterr(OSCAP_EFAMILY_OVAL,
+				"Conversion of the string \"%s\" to an integer (%u bits) failed: %s",
+				sys_data, sizeof(intmax_t)*8, strerror(errno));
+			return OVAL_RESULT_ERROR;
+		}
+		return oval_int_cmp(value->u.integer, syschar_val, value->operation);
+	}
+	case OVAL_DATATYPE_FLOAT: {
+		double sys_val;
+
+		if (!cstr_to_double(sys_data, &sys_val)) {
+			oscap_seterr(OSCAP_EFAMILY_OVAL,
+				"Conversion of the string \"%s\" to a floating type (double) failed: %s",
+				sys_data, strerror(errno));
+			return OVAL_RESULT_ERROR;
+		}
+		return oval_float_cmp(value->u.real, sys_val, value->operation);
+	}
+	case OVAL_DATATYPE_BOOLEAN: {
+		int sys_int;
+
+		sys_int = (((strcmp(sys_data, "true")) == 0) || ((strcmp(sys_data, "1")) == 0)) ? 1 : 0;
+		return oval_boolean_cmp(value->u.boolean, sys_int, value->operation);
+	}
+	case OVAL_DATATYPE_EVR_STRING:
+		return oval_evr_string_cmp_parsed(&value->u.evr, sys_data, value->operation);
+	case OVAL_DATATYPE_IPV4ADDR:
+	case OVAL_DATATYPE_IPV6ADDR:
+		return oval_ipaddr_cmp_parsed(&value->u.ipaddr, sys_data, value->operation);
+	default:
+		return oval_ent_cmp_str(value->text, value->datatype, sysent, value->operation);
+	}
+}
@@ -26,6 +26,8 @@
 #endif
 
 #include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #if defined USE_REGEX_PCRE
 #include <pcre.h>
@@ -124,23 +126,215 @@ static int istrcmp(const char *st1, const char *st2)
 	return strcasecmp(st1, st2);
 }
 
-static oval_result_t strregcomp(const char *pattern, const char *test_str)
+/*
+ * Compiled regular expressions are cached for the lifetime of the process
+ * because the same pattern is usually matched against a lot of items. The
+ * cache has a fixed number of buckets and stops growing once it holds
+ * OVAL_REGEX_CACHE_MAX patterns; other patterns are compiled on each use.
+ */
+#define OVAL_REGEX_CACHE_BUCKETS 256
+#define OVAL_REGEX_CACHE_MAX     4096
+
+struct oval_regex {
+	char              *pattern;
+	int                flags;
+	uint32_t           hash;
+#if defined USE_REGEX_PCRE
+	pcre              *re;
+	pcre_extra        *extra;
+#elif defined USE_REGEX_POSIX
+	regex_t            re;
+#endif
+	bool               cached;
+	struct oval_regex *next;
+};
+
+static struct oval_regex *__regex_cache[OVAL_REGEX_CACHE_BUCKETS];
+static unsigned int       __regex_cache_count = 0;
+static bool               __regex_cache_atexit = false;
+
+#if defined(OSCAP_THREAD_SAFE)
+# include <pthread.h>
+static pthread_rwlock_t __regex_cache_lock = PTHREAD_RWLOCK_INITIALIZER;
+# define __RDLOCK_RC  do { if (pthread_rwlock_rdlock (&__regex_cache_lock) != 0) abort(); } while(0)
+# define __WRLOCK_RC  do { if (pthread_rwlock_wrlock (&__regex_cache_lock) != 0) abort(); } while(0)
+# define __UNLOCK_RC  do { if (pthread_rwlock_unlock (&__regex_cache_lock) != 0) abort(); } while(0)
+#else
+# define __RDLOCK_RC while(0)
+# define __WRLOCK_RC while(0)
+# define __UNLOCK_RC while(0)
+#endif
+
+static uint32_t oval_regex_hash(const char *pattern, int flags)
+{
+	uint32_t h = 2166136261U ^ (uint32_t)flags;
+
+	while (*pattern != '\0') {
+		h ^= (unsigned char)*pattern++;
+		h *= 16777619U;
+	}
+
+	return h;
+}
+
+static struct oval_regex *oval_regex_lookup(const char *pattern, int flags, uint32_t hash)
+{
+	struct oval_regex *rx;
+
+	for (rx = __regex_cache[hash % OVAL_REGEX_CACHE_BUCKETS]; rx != NULL; rx = rx->next) {
+		if (rx->hash == hash && rx->flags == flags && strcmp(rx->pattern, pattern) == 0)
+			return rx;
+	}
+
+	return NULL;
+}
+
+static void oval_regex_free(struct oval_regex *rx)
 {
-	int ret;
-	oval_result_t result = OVAL_RESULT_ERROR;
 #if defined USE_REGEX_PCRE
-	pcre *re;
-	const char *err;
-	int errofs;
-
-	re = pcre_compile(pattern, PCRE_UTF8, &err, &errofs, NULL);
-	if (re == NULL) {
-		oscap_dlprintf(DBG_E, "Unable to compile regex pattern, "
-			       "pcre_compile() returned error (offset: %d): '%s'.\n", errofs, err);
-		return OVAL_RESULT_ERROR;
+# if defined PCRE_STUDY_JIT_COMPILE
+	if (rx->extra != NULL)
+		pcre_free_study(rx->extra);
+# else
+	if (rx->extra != NULL)
+		pcre_free(rx->extra);
+# endif
+	pcre_free(rx->re);
+#elif defined USE_REGEX_POSIX
+	regfree(&rx->re);
+#endif
+	free(rx->pattern);
+	free(rx);
+}
+
+/*
+ * Cache exit hook. It's registered using atexit(3) when the first pattern
+ * is cached and frees the compiled patterns before exit.
+ */
+static void oval_regex_cleanup(void)
+{
+	struct oval_regex *rx;
+	unsigned int i;
+
+	__WRLOCK_RC;
+	for (i = 0; i < OVAL_REGEX_CACHE_BUCKETS; ++i) {
+		while ((rx = __regex_cache[i]) != NULL) {
+			__regex_cache[i] = rx->next;
+			oval_regex_free(rx);
+		}
 	}
+	__regex_cache_count = 0;
+	__UNLOCK_RC;
+}
+
+static struct oval_regex *oval_regex_compile(const char *pattern, int flags)
+{
+	struct oval_regex *rx, *cached;
+	uint32_t hash;
+
+	hash = oval_regex_hash(pattern, flags);
+
+	__RDLOCK_RC;
+	rx = oval_regex_lookup(pattern, flags, hash);
+	__UNLOCK_RC;
 
-	ret = pcre_exec(re, NULL, test_str, strlen(test_str), 0, 0, NULL, 0);
+	if (rx != NULL)
+		return rx;
+
+	rx = malloc(sizeof(struct oval_regex));
+	if (rx == NULL)
+		return NULL;
+
+	rx->pattern = strdup(pattern);
+	if (rx->pattern == NULL) {
+		free(rx);
+		return NULL;
+	}
+
+	rx->flags = flags;
+	rx->hash = hash;
+	rx->cached = false;
+	rx->next = NULL;
+#if defined USE_REGEX_PCRE
+	{
+		const char *err;
+		int errofs;
+
+		rx->re = pcre_compile(pattern, flags, &err, &errofs, NULL);
+		if (rx->re == NULL) {
+			oscap_dlprintf(DBG_E, "Unable to compile regex pattern, "
+				       "pcre_compile() returned error (offset: %d): '%s'.\n", errofs, err);
+			free(rx->pattern);
+			free(rx);
+			return NULL;
+		}
+# if defined PCRE_STUDY_JIT_COMPILE
+		rx->extra = pcre_study(rx->re, PCRE_STUDY_JIT_COMPILE, &err);
+# else
+		rx->extra = pcre_study(rx->re, 0, &err);
+# endif
+	}
+#elif defined USE_REGEX_POSIX
+	{
+		int ret;
+
+		ret = regcomp(&rx->re, pattern, flags);
+		if (ret != 0) {
+			oscap_dlprintf(DBG_E, "Unable to compile regex pattern, "
+				       "regcomp() returned error: %d.\n", ret);
+			free(rx->pattern);
+			free(rx);
+			return NULL;
+		}
+	}
+#endif
+
+	__WRLOCK_RC;
+	/* another thread might have compiled the same pattern meanwhile */
+	cached = oval_regex_lookup(pattern, flags, hash);
+
+	if (cached == NULL && __regex_cache_count < OVAL_REGEX_CACHE_MAX) {
+		rx->cached = true;
+		rx->next = __regex_cache[hash % OVAL_REGEX_CACHE_BUCKETS];
+		__regex_cache[hash % OVAL_REGEX_CACHE_BUCKETS] = rx;
+		++__regex_cache_count;
+
+		if (!__regex_cache_atexit) {
+			atexit(oval_regex_cleanup);
+			__regex_cache_atexit = true;
+		}
+	}
+	__UNLOCK_RC;
+
+	if (cached != NULL) {
+		oval_regex_free(rx);
+		return cached;
+	}
+
+	return rx;
+}
+
+struct oval_regex *oval_regex_get(const char *pattern)
+{
+#if defined USE_REGEX_PCRE
+	return oval_regex_compile(pattern, PCRE_UTF8);
+#elif defined USE_REGEX_POSIX
+	return oval_regex_compile(pattern, REG_EXTENDED);
+#endif
+}
+
+void oval_regex_put(struct oval_regex *rx)
+{
+	if (rx != NULL && !rx->cached)
+		oval_regex_free(rx);
+}
+
+oval_result_t oval_regex_match(struct oval_regex *rx, const char *test_str)
+{
+	int ret;
+	oval_result_t result = OVAL_RESULT_ERROR;
+#if defined USE_REGEX_PCRE
+	ret = pcre_exec(rx->re, rx->extra, test_str, strlen(test_str), 0, 0, NULL, 0);
 	if (ret > -1 ) {
 		result = OVAL_RESULT_TRUE;
 	} else if (ret == -1) {
@@ -150,19 +344,8 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 			       "pcre_exec() returned error: %d.\n", ret);
 		result = OVAL_RESULT_ERROR;
 	}
-
-	pcre_free(re);
 #elif defined USE_REGEX_POSIX
-	regex_t re;
-
-	ret = regcomp(&re, pattern, REG_EXTENDED);
-	if (ret != 0) {
-		oscap_dlprintf(DBG_E, "Unable to compile regex pattern, "
-			       "regcomp() returned error: %d.\n", ret);
-		return OVAL_RESULT_ERROR;
-	}
-
-	ret = regexec(&re, test_str, 0, NULL, 0);
+	ret = regexec(&rx->re, test_str, 0, NULL, 0);
 	if (ret == 0) {
 		result = OVAL_RESULT_TRUE;
 	} else if (ret == REG_NOMATCH) {
@@ -171,12 +354,25 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 		oscap_dlprintf(DBG_E, "Unable to match regex pattern: %d.\n", ret);
 		result = OVAL_RESULT_ERROR;
 	}
-
-	regfree(&re);
 #endif
 	return result;
 }
 
+static oval_result_t strregcomp(const char *pattern, const char *test_str)
+{
+	oval_result_t result;
+	struct oval_regex *rx;
+
+	rx = oval_regex_get(pattern);
+	if (rx == NULL)
+		return OVAL_RESULT_ERROR;
+
+	result = oval_regex_match(rx, test_str);
+	oval_regex_put(rx);
+
+	return result;
+}
+
 oval_result_t oval_string_cmp(const char *state, const char *syschar, oval_operation_t operation)
 {
 	syschar = syschar ? syschar : "";
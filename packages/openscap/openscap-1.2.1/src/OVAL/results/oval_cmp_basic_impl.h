@@ -39,6 +39,22 @@ oval_result_t oval_string_cmp(const char *state, const char *syschar, oval_opera
 
 oval_result_t oval_binary_cmp(const char *state, const char *syschar, oval_operation_t operation);
 
+struct oval_regex;
+
+/**
+ * Compile the pattern of the pattern match operation, or get it from the
+ * cache of compiled patterns. Release it with oval_regex_put().
+ * @returns the compiled pattern or NULL if it is not valid
+ */
+struct oval_regex *oval_regex_get(const char *pattern);
+
+/**
+ * Match `test_str' against the pattern compiled by oval_regex_get().
+ */
+oval_result_t oval_regex_match(struct oval_regex *rx, const char *test_str);
+
+void oval_regex_put(struct oval_regex *rx);
+
 OSCAP_HIDDEN_END;
 
 #endif
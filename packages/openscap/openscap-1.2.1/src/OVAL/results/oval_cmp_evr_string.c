@@ -49,13 +49,42 @@ static int risdigit(int c) {
 }
 #endif
 
-static inline int rpmevrcmp(const char *a, const char *b);
+static inline int rpmevrcmp(const struct oval_evr *a, const struct oval_evr *b);
 static int compare_values(const char *str1, const char *str2);
 static void parseEVR(char *evr, const char **ep, const char **vp, const char **rp);
 
+void oval_evr_parse(const char *evr, struct oval_evr *out)
+{
+	out->buf = oscap_strdup(evr);
+	parseEVR(out->buf, &out->epoch, &out->version, &out->release);
+}
+
+void oval_evr_clear(struct oval_evr *evr)
+{
+	oscap_free(evr->buf);
+	evr->buf = NULL;
+}
+
 oval_result_t oval_evr_string_cmp(const char *state, const char *sys, oval_operation_t operation)
 {
-	int result = rpmevrcmp(sys, state);
+	struct oval_evr state_evr;
+	oval_result_t result;
+
+	oval_evr_parse(state, &state_evr);
+	result = oval_evr_string_cmp_parsed(&state_evr, sys, operation);
+	oval_evr_clear(&state_evr);
+
+	return result;
+}
+
+oval_result_t oval_evr_string_cmp_parsed(const struct oval_evr *state, const char *sys, oval_operation_t operation)
+{
+	struct oval_evr sys_evr;
+	int result;
+
+	oval_evr_parse(sys, &sys_evr);
+	result = rpmevrcmp(&sys_evr, state);
+	oval_evr_clear(&sys_evr);
 
 	if (operation == OVAL_OPERATION_EQUALS) {
 		return ((result == 0) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE);
@@ -75,30 +104,20 @@ oval_result_t oval_evr_string_cmp(const char *state, const char *sys, oval_opera
 	return OVAL_RESULT_ERROR;
 }
 
-static inline int rpmevrcmp(const char *a, const char *b)
+static inline int rpmevrcmp(const struct oval_evr *a, const struct oval_evr *b)
 {
 	/* This mimics rpmevrcmp which is not exported by rpmlib version 4.
 	 * Code inspired by rpm.labelCompare() from rpm4/python/header-py.c
 	 */
-	const char *a_epoch, *a_version, *a_release;
-	const char *b_epoch, *b_version, *b_release;
-	char *a_copy, *b_copy;
 	int result;
 
-	a_copy = oscap_strdup(a);
-	b_copy = oscap_strdup(b);
-	parseEVR(a_copy, &a_epoch, &a_version, &a_release);
-	parseEVR(b_copy, &b_epoch, &b_version, &b_release);
-
-	result = compare_values(a_epoch, b_epoch);
+	result = compare_values(a->epoch, b->epoch);
 	if (!result) {
-		result = compare_values(a_version, b_version);
+		result = compare_values(a->version, b->version);
 		if (!result)
-			result = compare_values(a_release, b_release);
+			result = compare_values(a->release, b->release);
 	}
 
-	oscap_free(a_copy);
-	oscap_free(b_copy);
 	return result;
 }
 
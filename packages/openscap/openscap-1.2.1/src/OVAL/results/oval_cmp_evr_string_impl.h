@@ -48,6 +48,29 @@ OSCAP_HIDDEN_START;
  */
 oval_result_t oval_evr_string_cmp(const char *state, const char *sys, oval_operation_t operation);
 
+/**
+ * EVR string split into its parts, see oval_evr_parse()
+ */
+struct oval_evr {
+	char *buf;
+	const char *epoch;   /* NULL if the string has no epoch */
+	const char *version;
+	const char *release; /* NULL if the string has no release */
+};
+
+/**
+ * Split the EVR string `evr' for repeated comparisons. Free the parts
+ * with oval_evr_clear().
+ */
+void oval_evr_parse(const char *evr, struct oval_evr *out);
+
+void oval_evr_clear(struct oval_evr *evr);
+
+/**
+ * Same as oval_evr_string_cmp() with the state EVR string already split.
+ */
+oval_result_t oval_evr_string_cmp_parsed(const struct oval_evr *state, const char *sys, oval_operation_t operation);
+
 oval_result_t oval_versiontype_cmp(const char *state, const char *syschar, oval_operation_t operation);
 
 OSCAP_HIDDEN_END;
@@ -27,6 +27,9 @@
 #include "oval_definitions.h"
 #include "oval_types.h"
 #include "oval_system_characteristics.h"
+#include "oval_cmp_basic_impl.h"
+#include "oval_cmp_evr_string_impl.h"
+#include "oval_cmp_ip_address_impl.h"
 
 OSCAP_HIDDEN_START;
 
@@ -40,6 +43,39 @@ OSCAP_HIDDEN_START;
  */
 oval_result_t oval_ent_cmp_str(char *state_data, oval_datatype_t state_data_type, struct oval_sysent *sysent, oval_operation_t operation);
 
+/**
+ * State value prepared for comparisons with many sysents: numbers,
+ * booleans, EVR strings and IP addresses are parsed and patterns are
+ * compiled only once.
+ */
+struct oval_cmp_value {
+	char *text;
+	oval_datatype_t datatype;
+	oval_operation_t operation;
+	bool parsed;                /* false if the comparison uses the text */
+	union {
+		intmax_t integer;
+		double real;
+		int boolean;
+		struct oval_evr evr;
+		struct oval_ipaddr ipaddr;
+		struct oval_regex *regex;
+	} u;
+};
+
+/**
+ * Prepare the state value `text' for the comparisons. The text is not
+ * copied. Free the value with oval_cmp_value_clear().
+ */
+void oval_cmp_value_init(struct oval_cmp_value *value, char *text, oval_datatype_t datatype, oval_operation_t operation);
+
+void oval_cmp_value_clear(struct oval_cmp_value *value);
+
+/**
+ * Same as oval_ent_cmp_str() with a prepared state value.
+ */
+oval_result_t oval_ent_cmp_value(const struct oval_cmp_value *value, struct oval_sysent *sysent);
+
 OSCAP_HIDDEN_END;
 
 #endif
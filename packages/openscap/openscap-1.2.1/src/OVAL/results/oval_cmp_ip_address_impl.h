@@ -31,6 +31,7 @@
 #ifndef OSCAP_OVAL_IP_ADDRESS_IMPL_H_
 #define OSCAP_OVAL_IP_ADDRESS_IMPL_H_
 
+#include <netinet/in.h>
 #include "common/util.h"
 
 #include "oval_definitions.h"
@@ -50,6 +51,26 @@ OSCAP_HIDDEN_START;
  */
 oval_result_t oval_ipaddr_cmp(int af, const char *s1, const char *s2, oval_operation_t op);
 
+/**
+ * IP address or address set parsed by oval_ipaddr_parse()
+ */
+struct oval_ipaddr {
+	int af;
+	uint32_t mask;      /* netmask (IPv4) or prefix length (IPv6) */
+	char addr[sizeof(struct in6_addr)];
+};
+
+/**
+ * Parse the IP address `s' for repeated comparisons.
+ * @returns zero on success
+ */
+int oval_ipaddr_parse(int af, const char *s, struct oval_ipaddr *ip);
+
+/**
+ * Same as oval_ipaddr_cmp() with the address of the state already parsed.
+ */
+oval_result_t oval_ipaddr_cmp_parsed(const struct oval_ipaddr *ip1, const char *s2, oval_operation_t op);
+
 OSCAP_HIDDEN_END;
 
 #endif
@@ -220,9 +220,40 @@ int oval_results_model_eval(struct oval_results_model *res_model)
 	return 0;
 }
 
+/*
+ * oval_state_content_to_dom() declares the prefix of the definitions
+ * namespace on the root element when it writes the first record field.
+ * The start tag of a streamed root is written before that, so the
+ * declaration has to be made upfront.
+ */
+static void _oval_results_declare_record_field_ns(struct oval_definition_model *definition_model, xmlDocPtr doc)
+{
+	bool found = false;
+	struct oval_state_iterator *states = oval_definition_model_get_states(definition_model);
+
+	while (!found && oval_state_iterator_has_more(states)) {
+		struct oval_state *state = oval_state_iterator_next(states);
+		struct oval_state_content_iterator *contents = oval_state_get_contents(state);
+
+		while (!found && oval_state_content_iterator_has_more(contents)) {
+			struct oval_state_content *content = oval_state_content_iterator_next(contents);
+			struct oval_record_field_iterator *rf_itr = oval_state_content_get_record_fields(content);
+
+			found = oval_record_field_iterator_has_more(rf_itr);
+			oval_record_field_iterator_free(rf_itr);
+		}
+		oval_state_content_iterator_free(contents);
+	}
+	oval_state_iterator_free(states);
+
+	if (found && xmlSearchNsByHref(doc, xmlDocGetRootElement(doc), OVAL_DEFINITIONS_NAMESPACE) == NULL)
+		xmlNewNs(xmlDocGetRootElement(doc), OVAL_DEFINITIONS_NAMESPACE, BAD_CAST "oval-def");
+}
+
 static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
 				    struct oval_directives_model *directives_model, 
-				    xmlDocPtr doc, xmlNode * parent)
+				    xmlDocPtr doc, xmlNode * parent,
+				    struct oscap_xml_stream *stream)
 {
 	xmlNode *root_node;
 	struct oval_result_directives * dirs;
@@ -242,29 +273,37 @@ static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
 	xmlSetNs(root_node, ns_common);
 	xmlSetNs(root_node, ns_results);
 
+	dirs_model = (directives_model) ? directives_model : results_model->directives_model;
+	dirs = oval_directives_model_get_defdirs(dirs_model);
+
+	if (stream != NULL && oval_result_directives_get_included(dirs))
+		_oval_results_declare_record_field_ns(oval_results_model_get_definition_model(results_model), doc);
+	oscap_xml_stream_push(stream, root_node);
+
 	/* Report generator */
 	oval_generator_to_dom(results_model->generator, doc, root_node);
 
 	/* Report default directives and class directives from internal or external
 	 * directives model(if provided) */
-	dirs_model = (directives_model) ? directives_model : results_model->directives_model;
 	oval_directives_model_to_dom(dirs_model, doc, root_node);
-
-	dirs = oval_directives_model_get_defdirs(dirs_model);
+	oscap_xml_stream_flush(stream);
 
 	/* Report definitions */
 	if(oval_result_directives_get_included(dirs)) {
 		struct oval_definition_model *definition_model = oval_results_model_get_definition_model(results_model);
-		oval_definition_model_to_dom(definition_model, doc, root_node);
+		oval_definition_model_to_dom(definition_model, doc, root_node, stream);
 	}
 
 	xmlNode *results_node = xmlNewTextChild(root_node, ns_results, BAD_CAST "results", NULL);
+	oscap_xml_stream_push(stream, results_node);
 	struct oval_result_system_iterator *systems = oval_results_model_get_systems(results_model);
 	while (oval_result_system_iterator_has_more(systems)) {
 		struct oval_result_system *sys = oval_result_system_iterator_next(systems);
-		oval_result_system_to_dom(sys, results_model, dirs_model, doc, results_node);
+		oval_result_system_to_dom(sys, results_model, dirs_model, doc, results_node, stream);
 	}
 	oval_result_system_iterator_free(systems);
+	oscap_xml_stream_pop(stream);
+	oscap_xml_stream_pop(stream);
 
 	return root_node;
 }
@@ -279,7 +318,7 @@ struct oscap_source *oval_results_model_export_source(struct oval_results_model
 		return NULL;
 	}
 
-	oval_results_to_dom(results_model, directives_model, doc, NULL);
+	oval_results_to_dom(results_model, directives_model, doc, NULL, NULL);
 	return oscap_source_new_from_xmlDoc(doc, name);
 }
 
@@ -287,12 +326,25 @@ int oval_results_model_export(struct oval_results_model *results_model,
 			      struct oval_directives_model *directives_model,
 			      const char *file)
 {
-	struct oscap_source *source = oval_results_model_export_source(results_model, directives_model, file);
-	if (source == NULL) {
+	__attribute__nonnull__(results_model);
+
+	/* Write the document while it is being built, only the path from
+	 * the root to the current element is kept in memory. */
+	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
+	if (doc == NULL) {
+		oscap_setxmlerr(xmlGetLastError());
 		return -1;
 	}
-	int ret = oscap_source_save_as(source, NULL);
-	oscap_source_free(source);
+
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(file, doc);
+	if (stream == NULL) {
+		xmlFreeDoc(doc);
+		return -1;
+	}
+
+	oval_results_to_dom(results_model, directives_model, doc, NULL, stream);
+	int ret = oscap_xml_stream_close(stream);
+	xmlFreeDoc(doc);
 	return ret;
 }
 
@@ -406,7 +406,8 @@ static void _oval_result_definition_to_dom_based_on_directives(struct oval_resul
 xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 				   struct oval_results_model * results_model,
 				   struct oval_directives_model * directives_model, 
-				   xmlDocPtr doc, xmlNode * parent) {
+				   xmlDocPtr doc, xmlNode * parent,
+				   struct oscap_xml_stream *stream) {
 
 	struct oval_result_directives * directives;
 	struct oval_result_directives * class_dirs;
@@ -414,10 +415,12 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 
 	xmlNs *ns_results = xmlSearchNsByHref(doc, parent, OVAL_RESULTS_NAMESPACE);
 	xmlNode *system_node = xmlNewTextChild(parent, ns_results, BAD_CAST "system", NULL);
+	oscap_xml_stream_push(stream, system_node);
 
 	struct oval_smc *tstmap = oval_smc_new();
 
 	xmlNode *definitions_node = xmlNewTextChild(system_node, ns_results, BAD_CAST "definitions", NULL);
+	oscap_xml_stream_push(stream, definitions_node);
 	struct oval_definition_model *definition_model = oval_results_model_get_definition_model(results_model);
 	struct oval_definition_iterator *oval_definitions = oval_definition_model_get_definitions(definition_model);
 	while(oval_definition_iterator_has_more(oval_definitions)) {
@@ -443,8 +446,10 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 				_oval_result_definition_to_dom_based_on_directives(rslt_definition, directives, doc, definitions_node, tstmap);
 			}
 		}
+		oscap_xml_stream_flush(stream);
 	}
 	oval_definition_iterator_free(oval_definitions);
+	oscap_xml_stream_pop(stream);
 
 	struct oval_syschar_model *syschar_model = oval_result_system_get_syschar_model(sys);
 	struct oval_string_map *sysmap = oval_string_map_new();
@@ -455,11 +460,13 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 	struct oval_smc_iterator *result_tests = oval_smc_iterator_new(tstmap);
 	if (oval_smc_iterator_has_more(result_tests)) {
 		xmlNode *tests_node = xmlNewTextChild(system_node, ns_results, BAD_CAST "tests", NULL);
+		oscap_xml_stream_push(stream, tests_node);
 		while (oval_smc_iterator_has_more(result_tests)) {
 			struct oval_state_iterator *ste_itr;
 			struct oval_result_test *result_test = oval_smc_iterator_next(result_tests);
 			/* report the test */
 			oval_result_test_to_dom(result_test, doc, tests_node);
+			oscap_xml_stream_flush(stream);
 			struct oval_test *oval_test = oval_result_test_get_test(result_test);
 			/* collect the objects that are referenced from reported test */
 			/* look for objects in path: test->object ...  */
@@ -494,11 +501,13 @@ xmlNode *oval_result_system_to_dom(struct oval_result_system * sys,
 			}
 			oval_state_iterator_free(ste_itr);
 		}
+		oscap_xml_stream_pop(stream);
 	}
 	oval_smc_iterator_free(result_tests);
 
 	oval_syschar_model_to_dom(syschar_model, doc, system_node, 
-				  (oval_syschar_resolver *) _oval_result_system_resolve_syschar, sysmap);
+				  (oval_syschar_resolver *) _oval_result_system_resolve_syschar, sysmap, stream);
+	oscap_xml_stream_pop(stream);
 
 	oval_string_map_free(sysmap, NULL);
 	oval_string_map_free(objmap, NULL);
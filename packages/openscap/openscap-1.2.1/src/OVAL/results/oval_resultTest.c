@@ -45,6 +45,7 @@
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "common/_error.h"
+#include "common/intern_priv.h"
 
 typedef struct oval_result_test {
 	struct oval_result_system *system;
@@ -465,41 +466,162 @@ static inline oval_result_t _evaluate_sysent(struct oval_syschar_model *syschar_
 	}
 }
 
-static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct oval_sysitem *cur_sysitem, struct oval_state *state)
+/*
+ * State compiled for the evaluation of all the items of a test. The
+ * entity names, operations and checks are resolved once and the values
+ * of the entities, or of the variables they refer to, are prepared for
+ * the comparisons when the first item needs them. The results are the
+ * same as if the state was interpreted for every item.
+ */
+typedef enum {
+	OVAL_COMPILED_ENT_PENDING,     /* the values are not prepared yet */
+	OVAL_COMPILED_ENT_VALUES,      /* compare with the prepared values */
+	OVAL_COMPILED_ENT_RESULT,      /* fixed result for all the items */
+	OVAL_COMPILED_ENT_INTERPRET    /* error path, interpret the entity for each item */
+} oval_compiled_ent_mode_t;
+
+struct oval_compiled_entity {
+	const char *error;                  /* the state is broken here */
+	struct oval_state_content *content;
+	struct oval_entity *entity;
+	char *name;                         /* interned */
+	oval_operation_t operation;
+	oval_check_t entity_check;
+	bool mask;
+	oval_compiled_ent_mode_t mode;
+	oval_result_t result;               /* OVAL_COMPILED_ENT_RESULT */
+	bool variable;
+	bool value_error;                   /* a value of the variable has no text */
+	size_t value_count;
+	struct oval_cmp_value *values;
+};
+
+struct oval_compiled_state {
+	struct oval_state *state;
+	oval_operator_t operator;
+	size_t count;
+	struct oval_compiled_entity *entities;
+};
+
+static void _oval_compiled_entity_values(struct oval_syschar_model *syschar_model, struct oval_compiled_entity *ce)
 {
+	ce->mode = OVAL_COMPILED_ENT_INTERPRET;
+
+	if (!ce->variable) {
+		struct oval_value *val = oval_entity_get_value(ce->entity);
+
+		if (val == NULL || oval_value_get_text(val) == NULL)
+			return;
+
+		ce->values = oscap_alloc(sizeof(struct oval_cmp_value));
+		oval_cmp_value_init(ce->values, oval_value_get_text(val), oval_value_get_datatype(val), ce->operation);
+		ce->value_count = 1;
+	} else {
+		struct oval_variable *var = oval_entity_get_variable(ce->entity);
+		struct oval_value_iterator *val_itr;
+		size_t size;
+
+		if (var == NULL || oval_syschar_model_compute_variable(syschar_model, var) != 0)
+			return;
+
+		switch (oval_variable_get_collection_flag(var)) {
+		case SYSCHAR_FLAG_COMPLETE:
+		case SYSCHAR_FLAG_INCOMPLETE:
+			break;
+		case SYSCHAR_FLAG_ERROR:
+		case SYSCHAR_FLAG_DOES_NOT_EXIST:
+		case SYSCHAR_FLAG_NOT_COLLECTED:
+		case SYSCHAR_FLAG_NOT_APPLICABLE:
+			ce->result = OVAL_RESULT_ERROR;
+			ce->mode = OVAL_COMPILED_ENT_RESULT;
+			return;
+		default:
+			return;
+		}
+
+		val_itr = oval_variable_get_values(var);
+		size = oval_collection_iterator_remaining((struct oval_iterator *) val_itr);
+		ce->values = oscap_alloc((size > 0 ? size : 1) * sizeof(struct oval_cmp_value));
+		while (oval_value_iterator_has_more(val_itr)) {
+			struct oval_value *val = oval_value_iterator_next(val_itr);
+
+			if (oval_value_get_text(val) == NULL) {
+				ce->value_error = true;
+				break;
+			}
+			oval_cmp_value_init(&ce->values[ce->value_count++], oval_value_get_text(val),
+					oval_value_get_datatype(val), ce->operation);
+		}
+		oval_value_iterator_free(val_itr);
+	}
+
+	ce->mode = OVAL_COMPILED_ENT_VALUES;
+}
+
+static oval_result_t _oval_compiled_entity_eval(struct oval_syschar_model *syschar_model, struct oval_compiled_entity *ce, struct oval_sysent *item_entity)
+{
+	struct oresults var_ores;
+	size_t i;
+
+	if (oval_sysent_get_status(item_entity) == SYSCHAR_STATUS_DOES_NOT_EXIST)
+		return OVAL_RESULT_FALSE;
+
+	if (ce->mode == OVAL_COMPILED_ENT_PENDING)
+		_oval_compiled_entity_values(syschar_model, ce);
+
+	switch (ce->mode) {
+	case OVAL_COMPILED_ENT_VALUES:
+		if (!ce->variable)
+			return oval_ent_cmp_value(&ce->values[0], item_entity);
+
+		ores_clear(&var_ores);
+		for (i = 0; i < ce->value_count; ++i)
+			ores_add_res(&var_ores, oval_ent_cmp_value(&ce->values[i], item_entity));
+		if (ce->value_error) {
+			dE("Found NULL variable value text.\n");
+			ores_add_res(&var_ores, OVAL_RESULT_ERROR);
+		}
+		return ores_get_result_bychk(&var_ores, oval_state_content_get_var_check(ce->content));
+	case OVAL_COMPILED_ENT_RESULT:
+		return ce->result;
+	default:
+		return _evaluate_sysent(syschar_model, item_entity, ce->entity, ce->operation, ce->content);
+	}
+}
+
+static struct oval_compiled_state *oval_compiled_state_new(struct oval_state *state)
+{
+	struct oval_compiled_state *cs;
 	struct oval_state_content_iterator *state_contents_itr;
-	struct oresults ste_ores;
-	oval_operator_t operator;
-	oval_result_t result = OVAL_RESULT_ERROR;
+	size_t size;
 
-	ores_clear(&ste_ores);
+	cs = oscap_talloc(struct oval_compiled_state);
+	cs->state = state;
+	cs->count = 0;
 
 	state_contents_itr = oval_state_get_contents(state);
+	size = oval_collection_iterator_remaining((struct oval_iterator *) state_contents_itr);
+	cs->entities = oscap_calloc(size > 0 ? size : 1, sizeof(struct oval_compiled_entity));
+
 	while (oval_state_content_iterator_has_more(state_contents_itr)) {
-		struct oval_state_content *content;
-		struct oval_entity *state_entity;
-		char *state_entity_name;
-		oval_operation_t state_entity_operation;
-		oval_check_t entity_check;
-		oval_result_t ste_ent_res;
-		struct oval_sysent_iterator *item_entities_itr;
-		struct oresults ent_ores;
-		bool found_matching_item;
+		struct oval_compiled_entity *ce = &cs->entities[cs->count++];
+
+		ce->mode = OVAL_COMPILED_ENT_PENDING;
 
-		if ((content = oval_state_content_iterator_next(state_contents_itr)) == NULL) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL state content");
-			goto fail;
+		if ((ce->content = oval_state_content_iterator_next(state_contents_itr)) == NULL) {
+			ce->error = "OVAL internal error: found NULL state content";
+			break;
 		}
-		if ((state_entity = oval_state_content_get_entity(content)) == NULL) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity");
-			goto fail;
+		if ((ce->entity = oval_state_content_get_entity(ce->content)) == NULL) {
+			ce->error = "OVAL internal error: found NULL entity";
+			break;
 		}
-		if ((state_entity_name = oval_entity_get_name(state_entity)) == NULL) {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity name");
-			goto fail;
+		if ((ce->name = oval_entity_get_name(ce->entity)) == NULL) {
+			ce->error = "OVAL internal error: found NULL entity name";
+			break;
 		}
 
-		if (oscap_streq(state_entity_name, "line") &&
+		if (oscap_streq(ce->name, "line") &&
 			oval_state_get_subtype(state) == (oval_subtype_t) OVAL_INDEPENDENT_TEXT_FILE_CONTENT) {
 			/* Hack: textfilecontent_state/line shall be compared against textfilecontent_item/text.
 			 *
@@ -510,68 +632,95 @@ static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct
 			oval_version_t over = oval_state_get_schema_version(state);
 			if (oval_version_cmp(over, OVAL_VERSION(5.4)) >= 0) {
 				/* The OVAL-5.3 does not have textfilecontent_item/text */
-				state_entity_name = "text";
+				ce->name = (char *) oscap_intern("text");
 			}
 		}
 
-		entity_check = oval_state_content_get_ent_check(content);
-		state_entity_operation = oval_entity_get_operation(state_entity);
+		ce->entity_check = oval_state_content_get_ent_check(ce->content);
+		ce->operation = oval_entity_get_operation(ce->entity);
+		ce->mask = oval_entity_get_mask(ce->entity);
+		ce->variable = (oval_entity_get_varref_type(ce->entity) == OVAL_ENTITY_VARREF_ATTRIBUTE);
+	}
+	oval_state_content_iterator_free(state_contents_itr);
+
+	cs->operator = oval_state_get_operator(state);
+
+	return cs;
+}
+
+static void oval_compiled_state_free(struct oval_compiled_state *cs)
+{
+	size_t i, j;
+
+	if (cs == NULL)
+		return;
+
+	for (i = 0; i < cs->count; ++i) {
+		for (j = 0; j < cs->entities[i].value_count; ++j)
+			oval_cmp_value_clear(&cs->entities[i].values[j]);
+		oscap_free(cs->entities[i].values);
+	}
+	oscap_free(cs->entities);
+	oscap_free(cs);
+}
+
+static oval_result_t eval_item(struct oval_syschar_model *syschar_model, struct oval_sysitem *cur_sysitem,
+		struct oval_sysent **sysents, size_t sysent_cnt, struct oval_compiled_state *cs)
+{
+	struct oresults ste_ores;
+	size_t i, j;
+
+	ores_clear(&ste_ores);
+
+	for (i = 0; i < cs->count; ++i) {
+		struct oval_compiled_entity *ce = &cs->entities[i];
+		oval_result_t ste_ent_res;
+		struct oresults ent_ores;
+		bool found_matching_item;
+
+		if (ce->error != NULL) {
+			oscap_seterr(OSCAP_EFAMILY_OVAL, "%s", ce->error);
+			return OVAL_RESULT_ERROR;
+		}
 
 		ores_clear(&ent_ores);
 		found_matching_item = false;
 
-		item_entities_itr = oval_sysitem_get_sysents(cur_sysitem);
-		while (oval_sysent_iterator_has_more(item_entities_itr)) {
-			struct oval_sysent *item_entity;
+		for (j = 0; j < sysent_cnt; ++j) {
+			struct oval_sysent *item_entity = sysents[j];
 			oval_result_t ent_val_res;
-			char *item_entity_name;
 
-			item_entity = oval_sysent_iterator_next(item_entities_itr);
 			if (item_entity == NULL) {
 				oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL sysent");
-				oval_sysent_iterator_free(item_entities_itr);
-				goto fail;
+				return OVAL_RESULT_ERROR;
 			}
 
-			item_entity_name = oval_sysent_get_name(item_entity);
-			if (strcmp(item_entity_name, state_entity_name))
+			/* both names are interned */
+			if (oval_sysent_get_name(item_entity) != ce->name)
 				continue;
 
 			found_matching_item = true;
 
 			/* copy mask attribute from state to item */
-			if (oval_entity_get_mask(state_entity))
+			if (ce->mask)
 				oval_sysent_set_mask(item_entity,1);
 
-			ent_val_res = _evaluate_sysent(syschar_model, item_entity, state_entity,
-					state_entity_operation, content);
-			if (((signed) ent_val_res) == -1) {
-				oval_sysent_iterator_free(item_entities_itr);
-				goto fail;
-			}
+			ent_val_res = _oval_compiled_entity_eval(syschar_model, ce, item_entity);
+			if (((signed) ent_val_res) == -1)
+				return OVAL_RESULT_ERROR;
 
 			ores_add_res(&ent_ores, ent_val_res);
 		}
-		oval_sysent_iterator_free(item_entities_itr);
 
 		if (!found_matching_item)
 			dW("Entity name '%s' from state (id: '%s') not found in item (id: '%s').\n",
-			   state_entity_name, oval_state_get_id(state), oval_sysitem_get_id(cur_sysitem));
+			   ce->name, oval_state_get_id(cs->state), oval_sysitem_get_id(cur_sysitem));
 
-		ste_ent_res = ores_get_result_bychk(&ent_ores, entity_check);
+		ste_ent_res = ores_get_result_bychk(&ent_ores, ce->entity_check);
 		ores_add_res(&ste_ores, ste_ent_res);
 	}
-	oval_state_content_iterator_free(state_contents_itr);
-
-	operator = oval_state_get_operator(state);
-	result = ores_get_result_byopr(&ste_ores, operator);
-
-	return result;
-
- fail:
-	oval_state_content_iterator_free(state_contents_itr);
 
-	return OVAL_RESULT_ERROR;
+	return ores_get_result_byopr(&ste_ores, cs->operator);
 }
 
 #define ITEMMAP (struct oval_string_map    *)args[2]
@@ -598,19 +747,31 @@ static oval_result_t eval_check_state(struct oval_test *test, void **args)
 	oval_result_t result;
 	oval_check_t ste_check;
 	oval_operator_t ste_opr;
+	struct oval_state_iterator *ste_itr;
+	struct oval_compiled_state **states;
+	struct oval_sysent **sysents = NULL;
+	size_t ste_cnt, sysent_cnt, sysent_size = 0, i;
 
 	ste_check = oval_test_get_check(test);
 	ste_opr = oval_test_get_state_operator(test);
 	syschar_model = oval_result_system_get_syschar_model(SYSTEM);
 	ores_clear(&item_ores);
 
+	/* compile the states once for all the items */
+	ste_itr = oval_test_get_states(test);
+	ste_cnt = oval_collection_iterator_remaining((struct oval_iterator *) ste_itr);
+	states = oscap_alloc((ste_cnt > 0 ? ste_cnt : 1) * sizeof(struct oval_compiled_state *));
+	for (i = 0; i < ste_cnt; ++i)
+		states[i] = oval_compiled_state_new(oval_state_iterator_next(ste_itr));
+	oval_state_iterator_free(ste_itr);
+
 	ritems_itr = oval_result_test_get_items(TEST);
 	while (oval_result_item_iterator_has_more(ritems_itr)) {
 		struct oval_result_item *ritem;
 		struct oval_sysitem *item;
 		oval_syschar_status_t item_status;
 		struct oresults ste_ores;
-		struct oval_state_iterator *ste_itr;
+		struct oval_sysent_iterator *sysent_itr;
 		oval_result_t item_res;
 
 		ritem = oval_result_item_iterator_next(ritems_itr);
@@ -635,16 +796,24 @@ static oval_result_t eval_check_state(struct oval_test *test, void **args)
 
 		ores_clear(&ste_ores);
 
-		ste_itr = oval_test_get_states(test);
-		while (oval_state_iterator_has_more(ste_itr)) {
-			struct oval_state *ste;
+		/* the entities of the item are matched against each entity of the states */
+		sysent_cnt = 0;
+		sysent_itr = oval_sysitem_get_sysents(item);
+		while (oval_sysent_iterator_has_more(sysent_itr)) {
+			if (sysent_cnt == sysent_size) {
+				sysent_size = sysent_size > 0 ? sysent_size * 2 : 16;
+				sysents = oscap_realloc(sysents, sysent_size * sizeof(struct oval_sysent *));
+			}
+			sysents[sysent_cnt++] = oval_sysent_iterator_next(sysent_itr);
+		}
+		oval_sysent_iterator_free(sysent_itr);
+
+		for (i = 0; i < ste_cnt; ++i) {
 			oval_result_t ste_res;
 
-			ste = oval_state_iterator_next(ste_itr);
-			ste_res = eval_item(syschar_model, item, ste);
+			ste_res = eval_item(syschar_model, item, sysents, sysent_cnt, states[i]);
 			ores_add_res(&ste_ores, ste_res);
 		}
-		oval_state_iterator_free(ste_itr);
 
 		item_res = ores_get_result_byopr(&ste_ores, ste_opr);
 		ores_add_res(&item_ores, item_res);
@@ -652,6 +821,11 @@ static oval_result_t eval_check_state(struct oval_test *test, void **args)
 	}
 	oval_result_item_iterator_free(ritems_itr);
 
+	for (i = 0; i < ste_cnt; ++i)
+		oval_compiled_state_free(states[i]);
+	oscap_free(states);
+	oscap_free(sysents);
+
 	result = ores_get_result_bychk(&item_ores, ste_check);
 
 	return result;
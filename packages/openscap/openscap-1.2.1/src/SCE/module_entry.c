@@ -31,10 +31,36 @@
 
 #include "sce_engine_api.h"
 #include "XCCDF_POLICY/public/check_engine_plugin.h"
+#include "common/debug_priv.h"
 
+#include <errno.h>
 #include <libgen.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 
+static bool sce_engine_getenv_uint(const char *name, unsigned int *value)
+{
+	const char *str = getenv(name);
+	char *end;
+	unsigned long val;
+
+	if (str == NULL)
+		return false;
+
+	errno = 0;
+	val = strtoul(str, &end, 10);
+
+	if (errno != 0 || *end != '\0' || end == str || val > UINT_MAX) {
+		dW("Ignoring invalid value of %s: %s\n", name, str);
+		return false;
+	}
+
+	*value = (unsigned int)val;
+	return true;
+}
+
 static int sce_engine_register(struct xccdf_policy_model *model, const char *path_hint, void **user_data)
 {
 	struct sce_parameters *parameters = (struct sce_parameters*) *user_data;
@@ -47,6 +73,14 @@ static int sce_engine_register(struct xccdf_policy_model *model, const char *pat
 	sce_parameters_allocate_session(parameters);
 	free(xccdf_pathcopy);
 
+	unsigned int value;
+
+	if (sce_engine_getenv_uint("OSCAP_SCE_JOBS", &value))
+		sce_parameters_set_max_jobs(parameters, value);
+
+	if (sce_engine_getenv_uint("OSCAP_SCE_TIMEOUT", &value))
+		sce_parameters_set_timeout(parameters, value);
+
 	*user_data = (void*)parameters; // This way the data will get freed later
 
 	return !xccdf_policy_model_register_engine_sce(model, parameters);
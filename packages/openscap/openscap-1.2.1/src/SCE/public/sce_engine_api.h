@@ -216,6 +216,34 @@ struct sce_session* sce_parameters_get_session(struct sce_parameters* v);
  */
 void sce_parameters_allocate_session(struct sce_parameters* v);
 
+/**
+ * Sets how many scripts may run at the same time
+ *
+ * With more than one, the scripts of the rules which are going to be evaluated
+ * are started ahead. Their results are still reported in the order of the rules.
+ * The default is 1, the scripts run one after another.
+ * @memberof sce_parameters
+ */
+void sce_parameters_set_max_jobs(struct sce_parameters* v, unsigned int value);
+
+/**
+ * @memberof sce_parameters
+ */
+unsigned int sce_parameters_get_max_jobs(struct sce_parameters* v);
+
+/**
+ * Sets how many seconds a script may run, 0 (the default) means no limit
+ *
+ * Scripts which run out of time are killed and their result is error.
+ * @memberof sce_parameters
+ */
+void sce_parameters_set_timeout(struct sce_parameters* v, unsigned int value);
+
+/**
+ * @memberof sce_parameters
+ */
+unsigned int sce_parameters_get_timeout(struct sce_parameters* v);
+
 /**
  * Internal rule evaluation callback, don't use directly
  *
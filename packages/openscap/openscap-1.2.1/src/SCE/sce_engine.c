@@ -46,8 +46,13 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/prctl.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <pthread.h>
 #include <limits.h>
-#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
 
 struct sce_check_result
 {
@@ -242,10 +247,40 @@ void sce_session_export_to_directory(struct sce_session* s, const char* director
 	sce_check_result_iterator_free(it);
 }
 
+/*
+ * A script which is queued, running or finished. Scripts of the rules which
+ * are going to be evaluated are started ahead (see sce_engine_query), up to
+ * max_jobs at once, and picked up by sce_engine_eval_rule in the rule order.
+ */
+struct sce_job
+{
+	char* tmp_href;
+	char** env_values;          // NULL terminated, see sce_engine_env_new
+	size_t env_value_count;
+	pid_t pid;                  // 0 while queued
+	int fd;                     // read end of the stdout pipe, -1 when closed
+	char* std_out;              // with '&' escaped, see oscap_acquire_pipe_to_string
+	size_t std_out_len;
+	size_t std_out_size;
+	int exit_code;
+	bool done;
+	bool failed;                // the script couldn't be started at all
+	bool own_group;             // leads its own process group, killed as a whole
+	struct timespec deadline;
+	struct sce_job* next;
+};
+
 struct sce_parameters
 {
 	char* xccdf_directory;
 	struct sce_session* session;
+	unsigned int max_jobs;
+	unsigned int timeout;
+	struct sce_job* jobs;       // in the order of evaluation
+	unsigned int running;
+	int epfd;
+	int sigfd;                  // SIGCHLD of the scripts, in epfd
+	bool sigchld_blocked;       // by us, while scripts are running
 };
 
 struct sce_parameters* sce_parameters_new(void)
@@ -253,15 +288,30 @@ struct sce_parameters* sce_parameters_new(void)
 	struct sce_parameters *ret = oscap_alloc(sizeof(struct sce_parameters));
 	ret->xccdf_directory = NULL;
 	ret->session = NULL;
+	ret->max_jobs = 1;
+	ret->timeout = 0;
+	ret->jobs = NULL;
+	ret->running = 0;
+	ret->epfd = -1;
+	ret->sigfd = -1;
+	ret->sigchld_blocked = false;
 
 	return ret;
 }
 
+static void sce_engine_drop_jobs(struct sce_parameters* v);
+
 void sce_parameters_free(struct sce_parameters* v)
 {
 	if (!v)
 		return;
 
+	sce_engine_drop_jobs(v);
+	if (v->epfd >= 0)
+		close(v->epfd);
+	if (v->sigfd >= 0)
+		close(v->sigfd);
+
 	if (v->xccdf_directory)
 		oscap_free(v->xccdf_directory);
 	if (v->session)
@@ -304,53 +354,40 @@ void sce_parameters_allocate_session(struct sce_parameters* v)
 	sce_parameters_set_session(v, sce_session_new());
 }
 
-xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const char *rule_id, const char *id, const char *href,
-		struct xccdf_value_binding_iterator *value_binding_it,
-		struct xccdf_check_import_iterator *check_import_it,
-		void *usr)
+void sce_parameters_set_max_jobs(struct sce_parameters* v, unsigned int value)
 {
-	struct sce_parameters* parameters = (struct sce_parameters*)usr;
-	const char* xccdf_directory = parameters->xccdf_directory;
-
-	char* tmp_href = oscap_sprintf("%s/%s", xccdf_directory, href);
-
-	if (access(tmp_href, F_OK))
-	{
-		// we only do this check to provide helpful error message
-		// there is an inherent race condition, the file might
-		// not exist anymore at the time we execve it!
+	v->max_jobs = value > 0 ? value : 1;
+}
 
-		// the script hasn't been found, perhaps another sce instance
-		// with a different XCCDF directory can find it?
-		oscap_seterr(OSCAP_EFAMILY_SCE, "SCE couldn't find script file '%s'. "
-				"Expected location: '%s'.", href, tmp_href);
-		oscap_free(tmp_href);
-		return XCCDF_RESULT_NOT_CHECKED;
-	}
+unsigned int sce_parameters_get_max_jobs(struct sce_parameters* v)
+{
+	return v->max_jobs;
+}
 
-	if (access(tmp_href, F_OK | X_OK))
-	{
-		// again, only to provide helpful error message
-		oscap_seterr(OSCAP_EFAMILY_SCE, "SCE has found script file '%s' at '%s' "
-				"but it isn't executable!", href, tmp_href);
-		oscap_free(tmp_href);
-		return XCCDF_RESULT_ERROR;
-	}
+void sce_parameters_set_timeout(struct sce_parameters* v, unsigned int value)
+{
+	v->timeout = value;
+}
 
-	// all the result codes are shifted by 100, because otherwise syntax errors in scripts
-	// or even their nonexistence would cause XCCDF_RESULT_PASS to be the result
+unsigned int sce_parameters_get_timeout(struct sce_parameters* v)
+{
+	return v->timeout;
+}
 
-	char* argvp[1 + 1] = {
-		tmp_href,
-		NULL
-	};
+// the first SCE_ENV_STATIC_COUNT environment variables are compiled in
+#define SCE_ENV_STATIC_COUNT 10
 
-	// bound values in KEY=VALUE form, ready to be passed as environment variables
-	char ** env_values = oscap_alloc(10 * sizeof(char * ));
-	size_t env_value_count = 10;
+// bound values in KEY=VALUE form, ready to be passed as environment variables
+static char** sce_engine_env_new(struct xccdf_value_binding_iterator *value_binding_it, size_t *count)
+{
+	char ** env_values = oscap_alloc(SCE_ENV_STATIC_COUNT * sizeof(char * ));
+	size_t env_value_count = SCE_ENV_STATIC_COUNT;
 
 	env_values[0] = "PATH=/bin:/sbin:/usr/bin:/usr/sbin";
 
+	// all the result codes are shifted by 100, because otherwise syntax errors in scripts
+	// or even their nonexistence would cause XCCDF_RESULT_PASS to be the result
+
 	env_values[1] = "XCCDF_RESULT_PASS=101";
 	env_values[2] = "XCCDF_RESULT_FAIL=102";
 	env_values[3] = "XCCDF_RESULT_ERROR=103";
@@ -436,141 +473,559 @@ xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const
 	env_values = oscap_realloc(env_values, (env_value_count + 1) * sizeof(char*));
 	env_values[env_value_count] = NULL;
 
-	// We open a pipe for communication with the forked process
-	int pipefd[2];
-	if (pipe(pipefd) == -1)
+	*count = env_value_count;
+	return env_values;
+}
+
+static void sce_engine_env_free(char** env_values, size_t env_value_count)
+{
+	for (size_t i = SCE_ENV_STATIC_COUNT; i < env_value_count; ++i)
 	{
-		perror("pipe");
-		// the first 9 values (0 to 8) are compiled in
-		for (size_t i = 9; i < env_value_count; ++i)
+		oscap_free(env_values[i]);
+	}
+	oscap_free(env_values);
+}
+
+static struct sce_job* sce_job_new(char* tmp_href, char** env_values, size_t env_value_count)
+{
+	struct sce_job* job = oscap_calloc(1, sizeof(struct sce_job));
+	job->tmp_href = tmp_href;
+	job->env_values = env_values;
+	job->env_value_count = env_value_count;
+	job->fd = -1;
+
+	return job;
+}
+
+static void sce_job_free(struct sce_job* job)
+{
+	sce_engine_env_free(job->env_values, job->env_value_count);
+	oscap_free(job->tmp_href);
+	oscap_free(job->std_out);
+	oscap_free(job);
+}
+
+static bool sce_job_matches(struct sce_job* job, const char* tmp_href, char** env_values, size_t env_value_count)
+{
+	if (strcmp(job->tmp_href, tmp_href) != 0 || job->env_value_count != env_value_count)
+		return false;
+
+	for (size_t i = SCE_ENV_STATIC_COUNT; i < env_value_count; ++i)
+	{
+		if (strcmp(job->env_values[i], env_values[i]) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+static void sce_job_append(struct sce_job* job, const char* buf, size_t len)
+{
+	for (size_t i = 0; i < len; ++i)
+	{
+		// & is a special case, we have to "escape" it manually
+		// (all else will eventually get handled by libxml)
+		const char* str = buf[i] == '&' ? "&amp;" : buf + i;
+		size_t str_len = buf[i] == '&' ? 5 : 1;
+
+		// + 1 because we want to add \0 at the end
+		if (job->std_out_len + str_len + 1 > job->std_out_size)
 		{
-			oscap_free(env_values[i]);
+			job->std_out_size = job->std_out_size > 0 ? job->std_out_size * 2 : 128;
+			job->std_out = oscap_realloc(job->std_out, job->std_out_size);
+		}
+
+		memcpy(job->std_out + job->std_out_len, str, str_len);
+		job->std_out_len += str_len;
+	}
+}
+
+/*
+ * The exit of a script which has closed its output is noticed through
+ * SIGCHLD read from a signalfd in the epoll set. The signal is blocked in
+ * the evaluating thread while any script runs, so that it is kept pending
+ * for the signalfd instead of being discarded.
+ */
+static void sce_engine_sigchld_block(struct sce_parameters* parameters)
+{
+	sigset_t set, old;
+
+	sigemptyset(&set);
+	sigaddset(&set, SIGCHLD);
+
+	if (pthread_sigmask(SIG_BLOCK, &set, &old) != 0)
+		return;
+
+	// somebody else blocks it already, leave it blocked after us
+	parameters->sigchld_blocked = !sigismember(&old, SIGCHLD);
+
+	if (parameters->sigfd < 0)
+	{
+		parameters->sigfd = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+		if (parameters->sigfd >= 0)
+		{
+			struct epoll_event event = {
+				.events = EPOLLIN,
+				.data.ptr = NULL
+			};
+			epoll_ctl(parameters->epfd, EPOLL_CTL_ADD, parameters->sigfd, &event);
 		}
-		oscap_free(env_values);
-		return XCCDF_RESULT_ERROR;
+	}
+}
+
+static void sce_engine_sigchld_unblock(struct sce_parameters* parameters)
+{
+	sigset_t set;
+
+	if (!parameters->sigchld_blocked)
+		return;
+
+	sigemptyset(&set);
+	sigaddset(&set, SIGCHLD);
+	pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+	parameters->sigchld_blocked = false;
+}
+
+static void sce_engine_sigchld_read(struct sce_parameters* parameters)
+{
+	struct signalfd_siginfo info[8];
+
+	// the children are reaped by sce_engine_poll, just consume the signals
+	while (read(parameters->sigfd, info, sizeof info) > 0)
+		;
+}
+
+static void sce_job_finish(struct sce_parameters* parameters, struct sce_job* job, int exit_code)
+{
+	job->exit_code = exit_code;
+	job->done = true;
+	parameters->running--;
+
+	if (parameters->running == 0)
+		sce_engine_sigchld_unblock(parameters);
+
+	if (job->std_out == NULL)
+	{
+		job->std_out = oscap_alloc(1);
+		job->std_out_size = 1;
+	}
+	job->std_out[job->std_out_len] = '\0';
+}
+
+static void sce_job_close(struct sce_parameters* parameters, struct sce_job* job)
+{
+	if (job->fd < 0)
+		return;
+
+	epoll_ctl(parameters->epfd, EPOLL_CTL_DEL, job->fd, NULL);
+	close(job->fd);
+	job->fd = -1;
+}
+
+static void sce_job_start(struct sce_parameters* parameters, struct sce_job* job)
+{
+	// we open a pipe for communication with the forked process, no other
+	// script may inherit it, otherwise we would never see the end of its output
+	int pipefd[2];
+
+	if (parameters->epfd < 0)
+		parameters->epfd = epoll_create1(EPOLL_CLOEXEC);
+
+	parameters->running++;
+
+	if (parameters->running == 1 && parameters->epfd >= 0)
+		sce_engine_sigchld_block(parameters);
+
+	if (parameters->epfd < 0 || pipe2(pipefd, O_CLOEXEC) == -1)
+	{
+		perror("pipe");
+		job->failed = true;
+		sce_job_finish(parameters, job, 103);
+		return;
 	}
 
 	// FIXME: We definitely want to impose security restrictions in the forked child process in the future.
 	//        This would prevent scripts from writing to files or deleting them.
 
+	job->own_group = parameters->timeout > 0;
+
 	int fork_result = fork();
-	if (fork_result >= 0)
+	if (fork_result < 0)
 	{
-		// fork successful
+		close(pipefd[0]);
+		close(pipefd[1]);
+		job->failed = true;
+		sce_job_finish(parameters, job, 103);
+		return;
+	}
 
-		if (fork_result == 0)
-		{
-		    // we won't read from the pipe, so close the reading fd
-		    close(pipefd[0]);
+	if (fork_result == 0)
+	{
+		char* argvp[1 + 1] = {
+			job->tmp_href,
+			NULL
+		};
+
+		// forward stdout and stderr to the opened pipe, the duplicates
+		// don't have close-on-exec set
+		dup2(pipefd[1], fileno(stdout));
+		dup2(pipefd[1], fileno(stderr));
 
-		    // forward stdout and stderr to the opened pipe
-			dup2(pipefd[1], fileno(stdout));
-			dup2(pipefd[1], fileno(stderr));
+		// whatever the script starts is killed with it when it runs out of time
+		if (job->own_group)
+			setpgid(0, 0);
 
-			// we duplicated the file description twice, we can close the original
-			// one now, stdout and stderr will be closed properly after the execved
-			// script/executable finishes
-			close(pipefd[1]);
+		// the script gets the signal mask we were started with
+		sce_engine_sigchld_unblock(parameters);
 
-			// before we execute the script, lets make sure we get SIGTERM when
-			// oscap is killed, crashes or otherwise terminates
+		// before we execute the script, lets make sure we get SIGTERM when
+		// oscap is killed, crashes or otherwise terminates
 #ifdef PR_SET_PDEATHSIG
-			// requires Linux 2.1.57 or later
-			prctl(PR_SET_PDEATHSIG, SIGTERM);
+		// requires Linux 2.1.57 or later
+		prctl(PR_SET_PDEATHSIG, SIGTERM);
 #else
-			// TODO: Please provide alternatives
+		// TODO: Please provide alternatives
 #endif
 
-			// we are the child process
-			execve(tmp_href, argvp, env_values);
+		// we are the child process
+		execve(job->tmp_href, argvp, job->env_values);
+
+		// no need to check the return value of execve, if it returned at all we are in trouble
+		printf("Unexpected error when executing script '%s'. Error message follows.\n", job->tmp_href);
+		perror("execve");
+
+		// the parent process considers us a script check, we have to return a value that will mean XCCDF_RESULT_ERROR
+		exit(103);
+	}
+
+	// we won't write to the pipe, so close the writing fd
+	close(pipefd[1]);
+
+	if (job->own_group)
+		setpgid(fork_result, fork_result);
+
+	struct epoll_event event = {
+		.events = EPOLLIN,
+		.data.ptr = job
+	};
+	fcntl(pipefd[0], F_SETFL, fcntl(pipefd[0], F_GETFL) | O_NONBLOCK);
+	epoll_ctl(parameters->epfd, EPOLL_CTL_ADD, pipefd[0], &event);
+
+	job->pid = fork_result;
+	job->fd = pipefd[0];
+
+	if (parameters->timeout > 0)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &job->deadline);
+		job->deadline.tv_sec += parameters->timeout;
+	}
+}
+
+static void sce_job_read(struct sce_parameters* parameters, struct sce_job* job)
+{
+	char buf[4096];
+	ssize_t len;
+
+	while ((len = read(job->fd, buf, sizeof buf)) > 0)
+		sce_job_append(job, buf, len);
+
+	if (len < 0 && (errno == EAGAIN || errno == EINTR))
+		return;
+
+	// the script has closed its output, it is reaped by sce_engine_poll
+	sce_job_close(parameters, job);
+}
+
+static void sce_job_kill(struct sce_parameters* parameters, struct sce_job* job)
+{
+	int wstatus;
+
+	kill(job->own_group ? -job->pid : job->pid, SIGKILL);
+	sce_job_close(parameters, job);
+	waitpid(job->pid, &wstatus, 0);
+}
+
+/*
+ * Wait for the output of the running scripts for at most `timeout' ms, reap
+ * the finished ones and start the queued ones in their place.
+ */
+static void sce_engine_poll(struct sce_parameters* parameters, int timeout)
+{
+	struct epoll_event events[16];
+	struct timespec now;
+
+	if (parameters->running > 0)
+	{
+		int count = epoll_wait(parameters->epfd, events, sizeof(events) / sizeof(events[0]), timeout);
+		for (int i = 0; i < count; ++i)
+		{
+			if (events[i].data.ptr == NULL)
+				sce_engine_sigchld_read(parameters);
+			else
+				sce_job_read(parameters, (struct sce_job*) events[i].data.ptr);
+		}
+	}
 
-			// no need to check the return value of execve, if it returned at all we are in trouble
-			printf("Unexpected error when executing script '%s'. Error message follows.\n", href);
-			perror("execve");
+	clock_gettime(CLOCK_MONOTONIC, &now);
 
-			// the parent process considers us a script check, we have to return a value that will mean XCCDF_RESULT_ERROR
-			exit(103);
+	for (struct sce_job* job = parameters->jobs; job != NULL; job = job->next)
+	{
+		if (job->pid == 0 || job->done)
+			continue;
+
+		int wstatus;
+		if (job->fd < 0 && waitpid(job->pid, &wstatus, WNOHANG) == job->pid)
+		{
+			sce_job_finish(parameters, job, WEXITSTATUS(wstatus));
 		}
-		else
+		else if (parameters->timeout > 0 && (now.tv_sec > job->deadline.tv_sec ||
+				(now.tv_sec == job->deadline.tv_sec && now.tv_nsec >= job->deadline.tv_nsec)))
 		{
-			// we won't write to the pipe, so close the writing fd
-			close(pipefd[1]);
-
-			char* stdout_buffer = oscap_acquire_pipe_to_string(pipefd[0]);
-
-			// we are the parent process
-			int wstatus;
-			waitpid(fork_result, &wstatus, 0);
-
-			// we subtract 100 here to shift the exit code to xccdf_test_result_type_t enum range
-			int raw_result = WEXITSTATUS(wstatus) - 100;
-			if (raw_result <= 0 || raw_result > XCCDF_RESULT_FIXED)
-			{
-				// the script returned invalid exit code, we need to safeguard us against that
-				raw_result = XCCDF_RESULT_ERROR;
-			}
-
-			struct sce_session* session = sce_parameters_get_session(parameters);
-			if (session)
-			{
-				struct sce_check_result* check_result = sce_check_result_new();
-				sce_check_result_set_href(check_result, tmp_href);
-				sce_check_result_set_basename(check_result, basename(tmp_href));
-				sce_check_result_set_stdout(check_result, stdout_buffer);
-				sce_check_result_set_exit_code(check_result, WEXITSTATUS(wstatus));
-				sce_check_result_set_xccdf_result(check_result, (xccdf_test_result_type_t)raw_result);
-
-				for (size_t i = 0; i < env_value_count; ++i)
-				{
-					sce_check_result_add_environment_variable(check_result, env_values[i]);
-				}
-
-				sce_session_add_check_result(session, check_result);
-			}
-
-			// the first 10 values (0 to 9) are compiled in
-			for (size_t i = 10; i < env_value_count; ++i)
-			{
-				oscap_free(env_values[i]);
-			}
-			oscap_free(env_values);
-
-			// lets interpret the check imports passed to us
-			xccdf_check_import_iterator_reset(check_import_it);
-			while (xccdf_check_import_iterator_has_more(check_import_it))
-			{
-				struct xccdf_check_import * check_import = xccdf_check_import_iterator_next(check_import_it);
-				const char *name = xccdf_check_import_get_name(check_import);
-
-				if (strcmp(name, "stdout") == 0)
-				{
-					xccdf_check_import_set_content(check_import, stdout_buffer);
-				}
-			}
-
-			oscap_free(tmp_href);
-			oscap_free(stdout_buffer);
-
-			return (xccdf_test_result_type_t)raw_result;
+			sce_job_kill(parameters, job);
+
+			char* message = oscap_sprintf("\nScript '%s' has been killed after %u seconds.\n",
+					job->tmp_href, parameters->timeout);
+			sce_job_append(job, message, strlen(message));
+			oscap_free(message);
+
+			// the script didn't finish, that is an error
+			sce_job_finish(parameters, job, 103);
 		}
 	}
-	else
+
+	for (struct sce_job* job = parameters->jobs; job != NULL && parameters->running < parameters->max_jobs; job = job->next)
+	{
+		if (job->pid == 0 && !job->done)
+			sce_job_start(parameters, job);
+	}
+}
+
+/*
+ * How long sce_engine_poll may wait for output, in ms. A script which has
+ * closed its output wakes the poll up by its SIGCHLD. The signal doesn't
+ * come if it was delivered to another thread of the process, so such
+ * scripts are also checked once in a while.
+ */
+#define SCE_EXIT_CHECK_MS 1000
+
+static int sce_engine_poll_timeout(struct sce_parameters* parameters)
+{
+	struct timespec now;
+	long timeout = -1;
+	long exit_check = parameters->sigfd >= 0 ? SCE_EXIT_CHECK_MS : 1;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	for (struct sce_job* job = parameters->jobs; job != NULL; job = job->next)
 	{
-		// the first 9 values (0 to 8) are compiled in
-		for (size_t i = 9; i < env_value_count; ++i)
+		if (job->pid == 0 || job->done)
+			continue;
+
+		// output closed, waiting for the script to exit
+		if (job->fd < 0 && (timeout < 0 || timeout > exit_check))
+			timeout = exit_check;
+
+		if (parameters->timeout > 0)
 		{
-			oscap_free(env_values[i]);
+			long left = (job->deadline.tv_sec - now.tv_sec) * 1000 +
+				(job->deadline.tv_nsec - now.tv_nsec) / 1000000 + 1;
+			if (left < 0)
+				left = 0;
+			if (timeout < 0 || left < timeout)
+				timeout = left;
 		}
-		oscap_free(env_values);
+	}
 
-		close(pipefd[0]);
-		close(pipefd[1]);
+	return (int) timeout;
+}
+
+static void sce_engine_add_job(struct sce_parameters* parameters, struct sce_job* job)
+{
+	struct sce_job** last = &parameters->jobs;
+	while (*last != NULL)
+		last = &(*last)->next;
+	*last = job;
+}
+
+static void sce_engine_remove_job(struct sce_parameters* parameters, struct sce_job* job)
+{
+	struct sce_job** prev = &parameters->jobs;
+	while (*prev != job)
+		prev = &(*prev)->next;
+	*prev = job->next;
+}
+
+static void sce_engine_drop_jobs(struct sce_parameters* v)
+{
+	while (v->jobs != NULL)
+	{
+		struct sce_job* job = v->jobs;
+		v->jobs = job->next;
+
+		if (job->pid != 0 && !job->done)
+		{
+			sce_job_kill(v, job);
+			v->running--;
+		}
+		sce_job_free(job);
+	}
+
+	sce_engine_sigchld_unblock(v);
+}
+
+static char* sce_engine_script_path(struct sce_parameters* parameters, const char* href)
+{
+	return oscap_sprintf("%s/%s", parameters->xccdf_directory, href);
+}
+
+/*
+ * Start the script of a rule which is going to be evaluated. Scripts which
+ * can't be executed are left to sce_engine_eval_rule to report.
+ */
+static void* sce_engine_query(void* usr, xccdf_policy_engine_query_t query_type, void* query_data)
+{
+	struct sce_parameters* parameters = (struct sce_parameters*)usr;
+
+	if (query_type != POLICY_ENGINE_QUERY_PREFETCH || parameters->max_jobs <= 1)
+		return NULL;
+
+	if (query_data == NULL)
+	{
+		// a new evaluation starts
+		sce_engine_drop_jobs(parameters);
+		return parameters;
+	}
+
+	struct xccdf_policy_prefetch* prefetch = (struct xccdf_policy_prefetch*)query_data;
+	char* tmp_href = sce_engine_script_path(parameters, prefetch->href);
+	if (access(tmp_href, F_OK | X_OK))
+	{
+		oscap_free(tmp_href);
+		return NULL;
+	}
+
+	size_t env_value_count;
+	char** env_values = sce_engine_env_new(prefetch->value_binding_it, &env_value_count);
+	sce_engine_add_job(parameters, sce_job_new(tmp_href, env_values, env_value_count));
+
+	// starts what fits in max_jobs
+	sce_engine_poll(parameters, 0);
+
+	return parameters;
+}
+
+xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const char *rule_id, const char *id, const char *href,
+		struct xccdf_value_binding_iterator *value_binding_it,
+		struct xccdf_check_import_iterator *check_import_it,
+		void *usr)
+{
+	struct sce_parameters* parameters = (struct sce_parameters*)usr;
+
+	char* tmp_href = sce_engine_script_path(parameters, href);
+
+	if (access(tmp_href, F_OK))
+	{
+		// we only do this check to provide helpful error message
+		// there is an inherent race condition, the file might
+		// not exist anymore at the time we execve it!
+
+		// the script hasn't been found, perhaps another sce instance
+		// with a different XCCDF directory can find it?
+		oscap_seterr(OSCAP_EFAMILY_SCE, "SCE couldn't find script file '%s'. "
+				"Expected location: '%s'.", href, tmp_href);
+		oscap_free(tmp_href);
+		return XCCDF_RESULT_NOT_CHECKED;
+	}
+
+	if (access(tmp_href, F_OK | X_OK))
+	{
+		// again, only to provide helpful error message
+		oscap_seterr(OSCAP_EFAMILY_SCE, "SCE has found script file '%s' at '%s' "
+				"but it isn't executable!", href, tmp_href);
+		oscap_free(tmp_href);
+		return XCCDF_RESULT_ERROR;
+	}
+
+	size_t env_value_count;
+	char** env_values = sce_engine_env_new(value_binding_it, &env_value_count);
+
+	// the script may have been started ahead already
+	struct sce_job* job = parameters->jobs;
+	while (job != NULL && !sce_job_matches(job, tmp_href, env_values, env_value_count))
+		job = job->next;
+
+	if (job != NULL)
+	{
+		sce_engine_env_free(env_values, env_value_count);
+		oscap_free(tmp_href);
+	}
+	else
+	{
+		job = sce_job_new(tmp_href, env_values, env_value_count);
+		sce_engine_add_job(parameters, job);
+	}
+
+	// the rule is waiting for it, don't let it wait for a free slot
+	if (job->pid == 0 && !job->done)
+		sce_job_start(parameters, job);
+
+	while (!job->done)
+		sce_engine_poll(parameters, sce_engine_poll_timeout(parameters));
+
+	sce_engine_remove_job(parameters, job);
+
+	if (job->failed)
+	{
+		sce_job_free(job);
 		return XCCDF_RESULT_ERROR;
 	}
+
+	// we subtract 100 here to shift the exit code to xccdf_test_result_type_t enum range
+	int raw_result = job->exit_code - 100;
+	if (raw_result <= 0 || raw_result > XCCDF_RESULT_FIXED)
+	{
+		// the script returned invalid exit code, we need to safeguard us against that
+		raw_result = XCCDF_RESULT_ERROR;
+	}
+
+	struct sce_session* session = sce_parameters_get_session(parameters);
+	if (session)
+	{
+		struct sce_check_result* check_result = sce_check_result_new();
+		sce_check_result_set_href(check_result, job->tmp_href);
+		sce_check_result_set_basename(check_result, basename(job->tmp_href));
+		sce_check_result_set_stdout(check_result, job->std_out);
+		sce_check_result_set_exit_code(check_result, job->exit_code);
+		sce_check_result_set_xccdf_result(check_result, (xccdf_test_result_type_t)raw_result);
+
+		for (size_t i = 0; i < job->env_value_count; ++i)
+		{
+			sce_check_result_add_environment_variable(check_result, job->env_values[i]);
+		}
+
+		sce_session_add_check_result(session, check_result);
+	}
+
+	// lets interpret the check imports passed to us
+	xccdf_check_import_iterator_reset(check_import_it);
+	while (xccdf_check_import_iterator_has_more(check_import_it))
+	{
+		struct xccdf_check_import * check_import = xccdf_check_import_iterator_next(check_import_it);
+		const char *name = xccdf_check_import_get_name(check_import);
+
+		if (strcmp(name, "stdout") == 0)
+		{
+			xccdf_check_import_set_content(check_import, job->std_out);
+		}
+	}
+
+	sce_job_free(job);
+
+	return (xccdf_test_result_type_t)raw_result;
 }
 
 bool xccdf_policy_model_register_engine_sce(struct xccdf_policy_model * model, struct sce_parameters *parameters)
 {
 	return xccdf_policy_model_register_engine_and_query_callback(model,
-		"http://open-scap.org/page/SCE", sce_engine_eval_rule, (void*)parameters, NULL);
+		"http://open-scap.org/page/SCE", sce_engine_eval_rule, (void*)parameters, sce_engine_query);
 }
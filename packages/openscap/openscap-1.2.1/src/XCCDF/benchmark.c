@@ -716,6 +716,11 @@ xccdf_benchmark_get_member(const struct xccdf_benchmark *benchmark, xccdf_type_t
 	return (struct xccdf_item *)oscap_htable_get(xccdf_benchmark_find_target_htable(benchmark, type), key);
 }
 
+size_t xccdf_benchmark_get_item_count(const struct xccdf_benchmark *benchmark)
+{
+	return xccdf_benchmark_find_target_htable(benchmark, XCCDF_ITEM)->itemcount;
+}
+
 static inline bool
 _register_item_to_cluster(struct xccdf_benchmark *benchmark, struct xccdf_item *item)
 {
@@ -1287,25 +1287,22 @@ int xccdf_session_export_arf(struct xccdf_session *session)
 			free(sds_path);
 		}
 
-		struct oscap_source *arf_source = ds_rds_create_source(sds_source, session->xccdf.result_source, session->oval.result_sources, session->export.arf_file);
+		int ret = ds_rds_create_file(sds_source, session->xccdf.result_source, session->oval.result_sources, session->export.arf_file);
 		if (!xccdf_session_is_sds(session)) {
 			oscap_source_free(sds_source);
 		}
-		if (arf_source == NULL) {
+		if (ret != 0) {
 			return 1;
 		}
 
-		if (oscap_source_save_as(arf_source, NULL) != 0) {
-			oscap_source_free(arf_source);
-			return 1;
-		}
 		if (session->full_validation) {
+			struct oscap_source *arf_source = oscap_source_new_from_file(session->export.arf_file);
 			if (oscap_source_validate(arf_source, _reporter, NULL) != 0) {
 				oscap_source_free(arf_source);
 				return 1;
 			}
+			oscap_source_free(arf_source);
 		}
-		oscap_source_free(arf_source);
 	}
 	return 0;
 }
@@ -69,8 +69,25 @@ struct xccdf_policy_iterator;
  */
 typedef enum {
 	POLICY_ENGINE_QUERY_NAMES_FOR_HREF = 1,		/// Considering xccdf:check-content-ref, what are possible @name attributes for given href?
+	POLICY_ENGINE_QUERY_PREFETCH = 2,		/// Considering xccdf:check-content-ref which is going to be evaluated, may the engine start evaluating it ahead?
 } xccdf_policy_engine_query_t;
 
+/**
+ * Check announced to a checking engine by POLICY_ENGINE_QUERY_PREFETCH.
+ *
+ * Before the evaluation of a policy starts, the checks of the selected and
+ * applicable rules are announced in the order in which they are going to be
+ * evaluated. The engine may start evaluating them, but it has to return the
+ * results from its eval function only, once it is called with the same
+ * arguments. The structure is valid only during the query.
+ */
+struct xccdf_policy_prefetch {
+	struct xccdf_policy *policy;				///< Policy which is going to be evaluated
+	const char *definition_id;				///< The @name attribute of check-content-ref or NULL
+	const char *href;					///< The @href attribute of check-content-ref
+	struct xccdf_value_binding_iterator *value_binding_it;	///< Value bindings the check is going to be evaluated with
+};
+
 /**
  * Type of function which implements queries defined within xccdf_policy_engine_query_t.
  *
@@ -80,9 +97,14 @@ typedef enum {
  * is always user data as registered. Second argument defines the query. Third argument is
  * dependent on query and defined as follows:
  *  - (const char *)href -- for POLICY_ENGINE_QUERY_NAMES_FOR_HREF
+ *  - (struct xccdf_policy_prefetch *) -- for POLICY_ENGINE_QUERY_PREFETCH, or NULL
+ *    when the evaluation of a policy is about to start (the engine shall drop
+ *    checks which were prefetched before and not evaluated)
  *
  * Expected return type depends also on query as follows:
  *  - (struct oscap_stringlists *) -- for POLICY_ENGINE_QUERY_NAMES_FOR_HREF
+ *  - any non-NULL pointer if the engine prefetches the check (or any checks at
+ *    all, when asked with NULL) -- for POLICY_ENGINE_QUERY_PREFETCH
  *  - NULL shall be returned if the function doesn't understand the query.
  */
 typedef void *(*xccdf_policy_engine_query_fn) (void *, xccdf_policy_engine_query_t, void *);
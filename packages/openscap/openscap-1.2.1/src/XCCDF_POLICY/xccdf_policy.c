@@ -65,6 +65,7 @@ struct xccdf_policy_model {
 	struct oscap_list       * policies;     ///< List of xccdf_policy structures
 	struct oscap_list       * callbacks;    ///< Callbacks for output callbacks (see callback_out_t)
 	struct oscap_list       * engines;      ///< Callbacks for checking engines (see xccdf_policy_engine)
+	struct oscap_htable     * engine_systems; ///< Checking systems of the registered engines
 
 	struct cpe_session *cpe;
 };
@@ -80,6 +81,13 @@ OSCAP_IGETINS_GEN(xccdf_policy, xccdf_policy_model, policies, policy)
  * these lists from the benchmark file. Can be modified temporaly
  * so changes can be discarded or saved to the existing model.
  */
+/* State of a profile's list at the time it was indexed */
+struct xccdf_policy_index_stamp {
+	size_t itemcount;
+	const struct oscap_list_item *first;
+	const struct oscap_list_item *last;
+};
+
 struct xccdf_policy {
 
         struct xccdf_policy_model   * model;    ///< XCCDF Policy model
@@ -93,6 +101,13 @@ struct xccdf_policy {
 	struct oscap_htable		*selected_internal;
 	/** A hash which for given item defines final selection */
 	struct oscap_htable		*selected_final;
+	/** Indexes of the profile's set-values, refine-values and refine-rules
+	 * by the id of the item they refer to. Rebuilt on lookup whenever
+	 * the profile's lists differ from the state recorded in index_stamp. */
+	struct oscap_htable		*setvalues;
+	struct oscap_htable		*refine_values;
+	struct oscap_htable		*refine_rules;
+	struct xccdf_policy_index_stamp	index_stamp[3];
 };
 
 /* Macros to generate iterators, getters and setters */
@@ -131,6 +146,7 @@ OSCAP_GETTER(xccdf_operator_t, xccdf_value_binding, operator)
  * elements has to call parent element's 
  */
 static struct xccdf_refine_rule * xccdf_policy_get_refine_rules_by_rule(struct xccdf_policy * policy, struct xccdf_item * item);
+static void _xccdf_policy_index_refresh(struct xccdf_policy *policy);
 
 /**
  * Filter function returning true if the item is selected, false otherwise
@@ -208,30 +224,9 @@ static struct xccdf_setvalue * xccdf_policy_get_setvalue(struct xccdf_policy * p
     if (id == NULL) return NULL;
     if (policy == NULL) return NULL;
 
-    struct xccdf_setvalue_iterator  * s_value_it;
-    struct xccdf_setvalue           * s_value;
-    struct xccdf_profile            * profile = xccdf_policy_get_profile(policy);;
-
-    /* If profile is NULL we don't have setvalue's
-     * and we return NULL, otherwise we could cause SIGSEG
-     * with accessing NULL structure
-     */
-    if (profile == NULL) return NULL;
-
-    /* We need to return *LAST* setvalue in Profile.
-     * and iterate to the end of setvalue list
-     */
-    struct xccdf_setvalue * final = NULL;
-    s_value_it = xccdf_profile_get_setvalues(profile);
-    while (xccdf_setvalue_iterator_has_more(s_value_it)) {
-        s_value = xccdf_setvalue_iterator_next(s_value_it);
-        if (!strcmp(id, xccdf_setvalue_get_item(s_value))) {
-            final = s_value;
-        }
-    }
-    xccdf_setvalue_iterator_free(s_value_it);
-
-    return final;
+    /* The index holds the *LAST* setvalue in Profile */
+    _xccdf_policy_index_refresh(policy);
+    return oscap_htable_get(policy->setvalues, id);
 }
 
 static struct xccdf_refine_value * xccdf_policy_get_refine_value(struct xccdf_policy * policy, const char * id)
@@ -243,30 +238,9 @@ static struct xccdf_refine_value * xccdf_policy_get_refine_value(struct xccdf_po
     if (id == NULL) return NULL;
     if (policy == NULL) return NULL;
 
-    struct xccdf_refine_value_iterator  * r_value_it;
-    struct xccdf_refine_value           * r_value;
-    struct xccdf_profile            * profile = xccdf_policy_get_profile(policy);;
-
-    /* If profile is NULL we don't have setvalue's
-     * and we return NULL, otherwise we could cause SIGSEG
-     * with accessing NULL structure
-     */
-    if (profile == NULL) return NULL;
-
-    /* We need to return *LAST* setvalue in Profile.
-     * and iterate to the end of setvalue list
-     */
-    struct xccdf_refine_value * final = NULL;
-    r_value_it = xccdf_profile_get_refine_values(profile);
-    while (xccdf_refine_value_iterator_has_more(r_value_it)) {
-        r_value = xccdf_refine_value_iterator_next(r_value_it);
-        if (!strcmp(id, xccdf_refine_value_get_item(r_value))) {
-            final = r_value;
-        }
-    }
-    xccdf_refine_value_iterator_free(r_value_it);
-
-    return final;
+    /* The index holds the *LAST* refine-value in Profile */
+    _xccdf_policy_index_refresh(policy);
+    return oscap_htable_get(policy->refine_values, id);
 }
 
 /**
@@ -583,7 +557,7 @@ int xccdf_policy_check_evaluate(struct xccdf_policy * policy, struct xccdf_check
 static inline bool
 _xccdf_policy_is_engine_registered(struct xccdf_policy *policy, char *sysname)
 {
-	return oscap_list_contains(policy->model->engines, (void *) sysname, (oscap_cmp_func) xccdf_policy_engine_filter);
+	return oscap_htable_get(policy->model->engine_systems, sysname) != NULL;
 }
 
 static struct xccdf_check *
@@ -980,6 +954,94 @@ bool xccdf_policy_model_item_is_applicable(struct xccdf_policy_model *model, str
 	}
 }
 
+/**
+ * Announce the check of the rule to the checking engines which prefetch checks.
+ * Only the first check-content-ref of a simple check is announced, that is what
+ * gets evaluated unless the engine can't resolve it.
+ */
+static void _xccdf_policy_prefetch_rule(struct xccdf_policy *policy, struct xccdf_item *rule, struct oscap_list *engines)
+{
+	if (!xccdf_policy_is_item_selected(policy, xccdf_item_get_id(rule)))
+		return;
+
+	struct xccdf_check *check = _xccdf_policy_rule_get_applicable_check(policy, rule);
+	if (check == NULL || xccdf_check_get_complex(check))
+		return;
+
+	const char *system_name = xccdf_check_get_system(check);
+	if (!oscap_list_contains(engines, (void *) system_name, (oscap_cmp_func) xccdf_policy_engine_filter))
+		return;
+
+	struct xccdf_check_content_ref_iterator *content_it = xccdf_check_get_content_refs(check);
+	struct xccdf_check_content_ref *content = xccdf_check_content_ref_iterator_has_more(content_it) ?
+		xccdf_check_content_ref_iterator_next(content_it) : NULL;
+	xccdf_check_content_ref_iterator_free(content_it);
+
+	const char *content_name = content == NULL ? NULL : xccdf_check_content_ref_get_name(content);
+	if (content == NULL || (content_name == NULL && xccdf_check_get_multicheck(check)))
+		return;
+
+	if (!xccdf_policy_model_item_is_applicable(policy->model, rule))
+		return;
+
+	// The error is reported again when the rule is evaluated
+	bool had_error = oscap_err();
+	struct oscap_list *bindings = xccdf_policy_check_get_value_bindings(policy, xccdf_check_get_exports(check));
+	if (bindings == NULL) {
+		if (!had_error)
+			oscap_clearerr();
+		return;
+	}
+
+	struct oscap_iterator *engine_it = oscap_iterator_new_filter(engines, (oscap_filter_func) xccdf_policy_engine_filter, (void *) system_name);
+	while (oscap_iterator_has_more(engine_it)) {
+		struct xccdf_policy_engine *engine = (struct xccdf_policy_engine *) oscap_iterator_next(engine_it);
+		if (xccdf_policy_engine_prefetch(engine, policy, content_name, xccdf_check_content_ref_get_href(content), bindings))
+			break;
+	}
+	oscap_iterator_free(engine_it);
+	oscap_list_free(bindings, (oscap_destruct_func) xccdf_value_binding_free);
+}
+
+static void _xccdf_policy_prefetch_item(struct xccdf_policy *policy, struct xccdf_item *item, struct oscap_list *engines)
+{
+	if (xccdf_item_get_type(item) == XCCDF_RULE) {
+		_xccdf_policy_prefetch_rule(policy, item, engines);
+	}
+	else if (xccdf_item_get_type(item) == XCCDF_GROUP) {
+		struct xccdf_item_iterator *child_it = xccdf_group_get_content((const struct xccdf_group *) item);
+		while (xccdf_item_iterator_has_more(child_it))
+			_xccdf_policy_prefetch_item(policy, xccdf_item_iterator_next(child_it), engines);
+		xccdf_item_iterator_free(child_it);
+	}
+}
+
+/**
+ * Let the checking engines which are able to do so start evaluating the checks
+ * of the policy ahead (see POLICY_ENGINE_QUERY_PREFETCH). The checks are still
+ * evaluated one by one in the document order, the results don't change.
+ */
+static void _xccdf_policy_prefetch(struct xccdf_policy *policy)
+{
+	struct oscap_list *engines = oscap_list_new();
+	struct oscap_iterator *engine_it = oscap_iterator_new(policy->model->engines);
+	while (oscap_iterator_has_more(engine_it)) {
+		struct xccdf_policy_engine *engine = (struct xccdf_policy_engine *) oscap_iterator_next(engine_it);
+		if (xccdf_policy_engine_prefetch(engine, policy, NULL, NULL, NULL))
+			oscap_list_add(engines, engine);
+	}
+	oscap_iterator_free(engine_it);
+
+	if (oscap_list_get_itemcount(engines) > 0) {
+		struct xccdf_benchmark *benchmark = xccdf_policy_model_get_benchmark(policy->model);
+		struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+		while (xccdf_item_iterator_has_more(item_it))
+			_xccdf_policy_prefetch_item(policy, xccdf_item_iterator_next(item_it), engines);
+		xccdf_item_iterator_free(item_it);
+	}
+	oscap_list_free0(engines);
+}
+
 /**
  * Evaluate given check which is immediate child of the rule.
  * A possibe child checks will be evaluated by xccdf_policy_check_evaluate.
@@ -1571,15 +1633,22 @@ xccdf_policy_model_register_engine_and_query_callback(struct xccdf_policy_model
 {
         __attribute__nonnull__(model);
 	struct xccdf_policy_engine *engine = xccdf_policy_engine_new(sys, eval_fn, usr, query_fn);
+	if (sys != NULL)
+		oscap_htable_add(model->engine_systems, sys, engine);
 	return oscap_list_add(model->engines, engine);
 }
 
 void xccdf_policy_model_unregister_engines(struct xccdf_policy_model *model, const char *sys)
 {
 	__attribute__nonnull__(model);
-	if (sys == NULL)
+	if (sys == NULL) {
 		oscap_list_free(model->engines, (oscap_destruct_func) oscap_free);
+		oscap_htable_free0(model->engine_systems);
+		model->engines = oscap_list_new();
+		model->engine_systems = oscap_htable_new();
+	}
 	else {
+		oscap_htable_detach(model->engine_systems, sys);
 		struct oscap_list *rest = oscap_list_new();
 		struct oscap_iterator *cb_it = oscap_iterator_new(model->engines);
 		while (oscap_iterator_has_more(cb_it)) {
@@ -1655,6 +1724,7 @@ struct xccdf_policy_model * xccdf_policy_model_new(struct xccdf_benchmark * benc
 	model->policies  = oscap_list_new();
         model->callbacks = oscap_list_new();
 	model->engines = oscap_list_new();
+	model->engine_systems = oscap_htable_new();
 
 	model->cpe = cpe_session_new();
 
@@ -1766,6 +1836,115 @@ static void _xccdf_policy_add_profile_selectors(struct xccdf_policy* policy, str
 	xccdf_select_iterator_free(sel_it);
 }
 
+/**
+ * Index the items of a profile's list by the id of the item they refer to.
+ * If there are more of them for the same item, the first one or the last
+ * one is indexed.
+ */
+static struct oscap_htable *
+_xccdf_policy_index_new(struct oscap_iterator *it, const char *(*get_item)(const void *), bool last_wins)
+{
+	void **items = NULL;
+	size_t count = 0, size = 0, i;
+
+	while (oscap_iterator_has_more(it)) {
+		if (count == size) {
+			size = size > 0 ? size * 2 : 32;
+			items = oscap_realloc(items, sizeof(void *) * size);
+		}
+		items[count++] = oscap_iterator_next(it);
+	}
+	oscap_iterator_free(it);
+
+	/* oscap_htable_add() keeps the first item added with the key */
+	struct oscap_htable *index = oscap_htable_new_sized(count);
+	for (i = 0; i < count; ++i) {
+		void *item = items[last_wins ? count - i - 1 : i];
+		const char *id = get_item(item);
+		if (id != NULL)
+			oscap_htable_add(index, id, item);
+	}
+	oscap_free(items);
+
+	return index;
+}
+
+static const char *_xccdf_setvalue_item(const void *sv)
+{
+	return xccdf_setvalue_get_item(sv);
+}
+
+static const char *_xccdf_refine_value_item(const void *rv)
+{
+	return xccdf_refine_value_get_item(rv);
+}
+
+static const char *_xccdf_refine_rule_item(const void *rr)
+{
+	return xccdf_refine_rule_get_item(rr);
+}
+
+static void _xccdf_policy_indexed_lists(struct xccdf_profile *profile, struct oscap_list *lists[3])
+{
+	lists[0] = ((struct xccdf_item *) profile)->sub.profile.setvalues;
+	lists[1] = ((struct xccdf_item *) profile)->sub.profile.refine_values;
+	lists[2] = ((struct xccdf_item *) profile)->sub.profile.refine_rules;
+}
+
+static void _xccdf_policy_index_profile(struct xccdf_policy *policy, struct xccdf_profile *profile)
+{
+	struct oscap_list *lists[3];
+	size_t i;
+
+	oscap_htable_free0(policy->setvalues);
+	oscap_htable_free0(policy->refine_values);
+	oscap_htable_free0(policy->refine_rules);
+
+	if (profile == NULL) {
+		policy->setvalues = oscap_htable_new();
+		policy->refine_values = oscap_htable_new();
+		policy->refine_rules = oscap_htable_new();
+		return;
+	}
+
+	_xccdf_policy_indexed_lists(profile, lists);
+	for (i = 0; i < 3; ++i) {
+		policy->index_stamp[i].itemcount = lists[i]->itemcount;
+		policy->index_stamp[i].first = lists[i]->first;
+		policy->index_stamp[i].last = lists[i]->last;
+	}
+
+	policy->setvalues = _xccdf_policy_index_new((struct oscap_iterator *) xccdf_profile_get_setvalues(profile),
+			_xccdf_setvalue_item, true);
+	policy->refine_values = _xccdf_policy_index_new((struct oscap_iterator *) xccdf_profile_get_refine_values(profile),
+			_xccdf_refine_value_item, true);
+	policy->refine_rules = _xccdf_policy_index_new((struct oscap_iterator *) xccdf_profile_get_refine_rules(profile),
+			_xccdf_refine_rule_item, false);
+}
+
+/**
+ * Rebuild the indexes if the profile has been modified since they were built,
+ * e.g. by xccdf_profile_add_setvalue() after the policy had been created.
+ */
+static void _xccdf_policy_index_refresh(struct xccdf_policy *policy)
+{
+	struct oscap_list *lists[3];
+	size_t i;
+
+	if (policy->profile == NULL)
+		return;
+
+	_xccdf_policy_indexed_lists(policy->profile, lists);
+	for (i = 0; i < 3; ++i) {
+		if (policy->index_stamp[i].itemcount != lists[i]->itemcount ||
+		    policy->index_stamp[i].first != lists[i]->first ||
+		    policy->index_stamp[i].last != lists[i]->last) {
+			_xccdf_policy_index_profile(policy, policy->profile);
+			return;
+		}
+	}
+}
+
 /**
  * Constructor for structure XCCDF Policy. Create the structure and resolve all rules
  * from benchmark that are not present in selectors. This step is necessary because of 
@@ -1779,6 +1958,7 @@ struct xccdf_policy * xccdf_policy_new(struct xccdf_policy_model * model, struct
 	struct xccdf_benchmark          * benchmark;
 	struct xccdf_item_iterator      * item_it;
 	struct xccdf_item               * item;
+	size_t                            items_count;
 
 	policy = oscap_alloc(sizeof(struct xccdf_policy));
 	if (policy == NULL)
@@ -1790,11 +1970,14 @@ struct xccdf_policy * xccdf_policy_new(struct xccdf_policy_model * model, struct
 	policy->values  = oscap_list_new();
 	policy->results = oscap_list_new();
 
-	policy->selected_internal = oscap_htable_new();
-	policy->selected_final = oscap_htable_new();
+	benchmark = xccdf_policy_model_get_benchmark(model);
+
+	items_count = xccdf_benchmark_get_item_count(benchmark);
+	policy->selected_internal = oscap_htable_new_sized(items_count);
+	policy->selected_final = oscap_htable_new_sized(items_count);
 	policy->model = model;
 
-	benchmark = xccdf_policy_model_get_benchmark(model);
+	_xccdf_policy_index_profile(policy, profile);
 
 	if (profile)
 		_xccdf_policy_add_profile_selectors(policy, benchmark, profile);
@@ -2077,6 +2260,8 @@ struct xccdf_result * xccdf_policy_evaluate(struct xccdf_policy * policy)
 
     oscap_free(id);
 
+	_xccdf_policy_prefetch(policy);
+
 	/** We need to process document top-down order.
 	 * See conflicts/requires and Item Processing Algorithm */
 	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
@@ -2117,21 +2302,9 @@ struct xccdf_score * xccdf_policy_get_score(struct xccdf_policy * policy, struct
 
 static struct xccdf_refine_rule * xccdf_policy_get_refine_rules_by_rule(struct xccdf_policy * policy, struct xccdf_item * item)
 {
-    struct xccdf_refine_rule * r_rule = NULL;
-    struct xccdf_profile * profile = xccdf_policy_get_profile(policy);
-    if (profile == NULL) return NULL;
-
     /* Get refine-rule for this item */
-    struct xccdf_refine_rule_iterator * r_rule_it = xccdf_profile_get_refine_rules(profile);
-    while (xccdf_refine_rule_iterator_has_more(r_rule_it)) {
-        r_rule = xccdf_refine_rule_iterator_next(r_rule_it);
-        if (!strcmp(xccdf_refine_rule_get_item(r_rule), xccdf_rule_get_id((struct xccdf_rule *) item)))
-            break;
-        else r_rule = NULL;
-    }
-    xccdf_refine_rule_iterator_free(r_rule_it);
-
-    return r_rule;
+    _xccdf_policy_index_refresh(policy);
+    return oscap_htable_get(policy->refine_rules, xccdf_item_get_id(item));
 }
 
 const char *xccdf_policy_get_value_of_item(struct xccdf_policy * policy, struct xccdf_item * item)
@@ -2141,28 +2314,14 @@ const char *xccdf_policy_get_value_of_item(struct xccdf_policy * policy, struct
 
 	if (profile != NULL) {
 		/* Get set_value for this item */
-		struct xccdf_setvalue *s_value = NULL;
-		struct xccdf_setvalue *last_s_value = NULL;
-		struct xccdf_setvalue_iterator *s_value_it = xccdf_profile_get_setvalues(profile);
-		while (xccdf_setvalue_iterator_has_more(s_value_it)) {
-			s_value = xccdf_setvalue_iterator_next(s_value_it);
-			if (strcmp(xccdf_setvalue_get_item(s_value), xccdf_value_get_id((struct xccdf_value *) item)) == 0)
-				last_s_value = s_value;
-		}
-		xccdf_setvalue_iterator_free(s_value_it);
-		if (last_s_value != NULL)
-			return xccdf_setvalue_get_value(last_s_value);
+		struct xccdf_setvalue *s_value = xccdf_policy_get_setvalue(policy, xccdf_value_get_id((struct xccdf_value *) item));
+		if (s_value != NULL)
+			return xccdf_setvalue_get_value(s_value);
 
 		/* We don't have set-value in profile, look for refine-value */
-		struct xccdf_refine_value_iterator *r_value_it = xccdf_profile_get_refine_values(profile);
-		while (xccdf_refine_value_iterator_has_more(r_value_it)) {
-			struct xccdf_refine_value *r_value = xccdf_refine_value_iterator_next(r_value_it);
-			if (!strcmp(xccdf_refine_value_get_item(r_value), xccdf_value_get_id((struct xccdf_value *) item))) {
-				selector = xccdf_refine_value_get_selector(r_value);
-				break;
-			}
-		}
-		xccdf_refine_value_iterator_free(r_value_it);
+		struct xccdf_refine_value *r_value = xccdf_policy_get_refine_value(policy, xccdf_value_get_id((struct xccdf_value *) item));
+		if (r_value != NULL)
+			selector = xccdf_refine_value_get_selector(r_value);
 	}
 
 	struct xccdf_value_instance *instance = xccdf_value_get_instance_by_selector((struct xccdf_value *) item, selector);
@@ -2171,19 +2330,8 @@ const char *xccdf_policy_get_value_of_item(struct xccdf_policy * policy, struct
 
 static int xccdf_policy_get_refine_value_oper(struct xccdf_policy * policy, struct xccdf_item * item)
 {
-    struct xccdf_refine_value * r_value = NULL;
-    struct xccdf_profile * profile = xccdf_policy_get_profile(policy);
-    if (profile == NULL) return -1;
-
     /* We don't have set-value in profile, look for refine-value */
-    struct xccdf_refine_value_iterator * r_value_it = xccdf_profile_get_refine_values(profile);
-    while (xccdf_refine_value_iterator_has_more(r_value_it)) {
-        r_value = xccdf_refine_value_iterator_next(r_value_it);
-        if (!strcmp(xccdf_refine_value_get_item(r_value), xccdf_value_get_id((struct xccdf_value *) item)))
-            break;
-        else r_value = NULL;
-    }
-    xccdf_refine_value_iterator_free(r_value_it);
+    struct xccdf_refine_value * r_value = xccdf_policy_get_refine_value(policy, xccdf_value_get_id((struct xccdf_value *) item));
     if (r_value != NULL) {
         return xccdf_refine_value_get_oper(r_value);
     }
@@ -2284,7 +2432,8 @@ struct xccdf_benchmark *xccdf_policy_get_benchmark(const struct xccdf_policy *po
 void xccdf_policy_model_free(struct xccdf_policy_model * model) {
 
 	oscap_list_free(model->policies, (oscap_destruct_func) xccdf_policy_free);
-	xccdf_policy_model_unregister_engines(model, NULL);
+	oscap_list_free(model->engines, (oscap_destruct_func) oscap_free);
+	oscap_htable_free0(model->engine_systems);
 	oscap_list_free(model->callbacks, (oscap_destruct_func) oscap_free);
 	xccdf_tailoring_free(model->tailoring);
         xccdf_benchmark_free(model->benchmark);
@@ -2306,6 +2455,9 @@ void xccdf_policy_free(struct xccdf_policy * policy) {
 	oscap_list_free(policy->results, (oscap_destruct_func) xccdf_result_free);
 	oscap_htable_free0(policy->selected_internal);
 	oscap_htable_free0(policy->selected_final);
+	oscap_htable_free0(policy->setvalues);
+	oscap_htable_free0(policy->refine_values);
+	oscap_htable_free0(policy->refine_rules);
         oscap_free(policy);
 }
 
@@ -69,6 +69,24 @@ xccdf_test_result_type_t xccdf_policy_engine_eval(struct xccdf_policy_engine *en
 	return ret;
 }
 
+bool xccdf_policy_engine_prefetch(struct xccdf_policy_engine *engine, struct xccdf_policy *policy, const char *definition_id, const char *href_id, struct oscap_list *value_bindings)
+{
+	if (engine->query_fn == NULL)
+		return false;
+	if (href_id == NULL)
+		return engine->query_fn(engine->usr, POLICY_ENGINE_QUERY_PREFETCH, NULL) != NULL;
+
+	struct xccdf_policy_prefetch prefetch = {
+		.policy = policy,
+		.definition_id = definition_id,
+		.href = href_id,
+		.value_binding_it = (struct xccdf_value_binding_iterator *) oscap_iterator_new(value_bindings),
+	};
+	bool ret = engine->query_fn(engine->usr, POLICY_ENGINE_QUERY_PREFETCH, &prefetch) != NULL;
+	xccdf_value_binding_iterator_free(prefetch.value_binding_it);
+	return ret;
+}
+
 struct oscap_stringlist *xccdf_policy_engine_query(struct xccdf_policy_engine *engine, xccdf_policy_engine_query_t query_type, void *query_data)
 {
 	if (engine->query_fn == NULL)
@@ -77,6 +77,18 @@ xccdf_test_result_type_t xccdf_policy_engine_eval(struct xccdf_policy_engine *en
  */
 struct oscap_stringlist *xccdf_policy_engine_query(struct xccdf_policy_engine *engine, xccdf_policy_engine_query_t query_type, void *query_data);
 
+/**
+ * Announce the check which is going to be evaluated to the given checking engine
+ * @memberof xccdf_policy_engine
+ * @param engine Checking Engine
+ * @param policy XCCDF Policy
+ * @param definition_id ID of definition to evaluate
+ * @param href_id The @href attribute of check-content-ref, NULL when the evaluation starts
+ * @param value_bindings Value binding
+ * @returns true if the checking engine prefetches the check
+ */
+bool xccdf_policy_engine_prefetch(struct xccdf_policy_engine *engine, struct xccdf_policy *policy, const char *definition_id, const char *href_id, struct oscap_list *value_bindings);
+
 OSCAP_HIDDEN_END;
 
 #endif
@@ -0,0 +1,64 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "intern_priv.h"
+#include "strtab_priv.h"
+
+#define OSCAP_INTERN_MIN_SIZE 256
+#define OSCAP_INTERN_CHUNK    16384
+
+static struct oscap_strtab __intern_pool = {
+	.min_size   = OSCAP_INTERN_MIN_SIZE,
+	.chunk_size = OSCAP_INTERN_CHUNK,
+};
+
+static pthread_mutex_t __intern_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+const char *oscap_intern(const char *str)
+{
+	bool added;
+
+	if (str == NULL)
+		return NULL;
+
+	if (pthread_mutex_lock(&__intern_mutex) != 0)
+		abort();
+
+	str = oscap_strtab_insert(&__intern_pool, str, &added)->key;
+
+	if (pthread_mutex_unlock(&__intern_mutex) != 0)
+		abort();
+
+	return str;
+}
+
+void oscap_intern_cleanup(void)
+{
+	if (pthread_mutex_lock(&__intern_mutex) != 0)
+		abort();
+
+	oscap_strtab_clear(&__intern_pool);
+
+	if (pthread_mutex_unlock(&__intern_mutex) != 0)
+		abort();
+}
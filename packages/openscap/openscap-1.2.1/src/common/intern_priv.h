@@ -0,0 +1,62 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#pragma once
+#ifndef _OSCAP_INTERN_PRIV_H
+#define _OSCAP_INTERN_PRIV_H
+
+#include <stdbool.h>
+#include "util.h"
+
+OSCAP_HIDDEN_START;
+
+/*
+ * Global pool of strings which repeat a lot across the models, like the
+ * names of entities and item entities.
+ *
+ * Interning a string returns the one copy of it kept by the pool, so
+ * equal interned strings are equal pointers. The copies are never freed
+ * before oscap_cleanup(), they must not be modified or freed by the
+ * caller. Only strings of a bounded set should be interned, values read
+ * from the system are not.
+ *
+ * The pool is thread-safe.
+ */
+
+/**
+ * Intern the string `str'.
+ * @returns the pooled copy of `str' or NULL if `str' is NULL
+ */
+const char *oscap_intern(const char *str);
+
+/**
+ * Check whether two strings, of which at least one is interned, are equal.
+ * The pointers are compared first.
+ */
+static inline bool oscap_intern_eq(const char *interned, const char *str)
+{
+	return interned == str || oscap_streq(interned, str);
+}
+
+/**
+ * Free the pool. All the interned strings become invalid.
+ */
+void oscap_intern_cleanup(void);
+
+OSCAP_HIDDEN_END;
+
+#endif
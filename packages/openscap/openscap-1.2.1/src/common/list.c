@@ -433,6 +433,14 @@ struct oscap_htable *oscap_htable_new(void)
 	return oscap_htable_new1(oscap_htable_cmp, OSCAP_DEFAULT_HSIZE);
 }
 
+struct oscap_htable *oscap_htable_new_sized(size_t count)
+{
+	/* keep the chains short, the size should be odd */
+	if (count < OSCAP_DEFAULT_HSIZE)
+		return oscap_htable_new();
+	return oscap_htable_new1(oscap_htable_cmp, count | 1);
+}
+
 static struct oscap_htable_item *oscap_htable_lookup(struct oscap_htable *htable, const char *key)
 {
 	__attribute__nonnull__(htable);
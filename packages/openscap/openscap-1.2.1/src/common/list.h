@@ -205,6 +205,14 @@ struct oscap_htable *oscap_htable_new1(oscap_compare_func cmp, size_t hsize);
  */
 struct oscap_htable *oscap_htable_new(void);
 
+/*
+ * Create a new hash table for about `count' items.
+ *
+ * Same as oscap_htable_new(), but large tables get a bigger table size.
+ * @return new hash table
+ */
+struct oscap_htable *oscap_htable_new_sized(size_t count);
+
 /*
  * Do a Deep Copy of a hashtable and all of its items
  *
@@ -41,6 +41,7 @@
 #include "util.h"
 #include "list.h"
 #include "elements.h"
+#include "intern_priv.h"
 #include "assume.h"
 #include "debug_priv.h"
 #include "oscap_source.h"
@@ -112,6 +113,7 @@ void oscap_cleanup(void)
 	oscap_clearerr();
 	xsltCleanupGlobals();
 	xmlCleanupParser();
+	oscap_intern_cleanup();
 }
 
 const char *oscap_get_version(void) { return VERSION; }
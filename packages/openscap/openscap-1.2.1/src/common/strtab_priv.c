@@ -0,0 +1,157 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "alloc.h"
+#include "strtab_priv.h"
+
+struct oscap_strtab_chunk {
+	struct oscap_strtab_chunk *next;
+	size_t size;
+	size_t used;
+	char   data[];
+};
+
+static uint32_t _strtab_hash(const char *key)
+{
+	/* FNV-1a */
+	uint32_t h = 2166136261U;
+
+	for (; *key != '\0'; ++key) {
+		h ^= (unsigned char)*key;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static struct oscap_strtab_slot *_strtab_find(const struct oscap_strtab *tab, const char *key, uint32_t hash)
+{
+	size_t mask = tab->size - 1, i;
+
+	for (i = hash & mask; tab->slots[i].key != NULL; i = (i + 1) & mask) {
+		if (tab->slots[i].hash == hash && strcmp(tab->slots[i].key, key) == 0)
+			break;
+	}
+	return &tab->slots[i];
+}
+
+static void _strtab_grow(struct oscap_strtab *tab)
+{
+	struct oscap_strtab_slot *old = tab->slots;
+	size_t old_size = tab->size, i;
+
+	tab->size  = old_size > 0 ? old_size * 2 : tab->min_size;
+	tab->slots = oscap_calloc(tab->size, sizeof(struct oscap_strtab_slot));
+
+	for (i = 0; i < old_size; ++i) {
+		if (old[i].key != NULL)
+			*_strtab_find(tab, old[i].key, old[i].hash) = old[i];
+	}
+	oscap_free(old);
+}
+
+static const char *_strtab_keydup(struct oscap_strtab *tab, const char *key)
+{
+	struct oscap_strtab_chunk *chunk = tab->chunks;
+	size_t len;
+
+	if (tab->keydup != NULL)
+		return tab->keydup(tab->keydup_arg, key);
+
+	len = strlen(key) + 1;
+
+	if (chunk == NULL || chunk->size - chunk->used < len) {
+		size_t size = len > tab->chunk_size ? len : tab->chunk_size;
+
+		chunk = oscap_alloc(sizeof(struct oscap_strtab_chunk) + size);
+		chunk->size = size;
+		chunk->used = 0;
+		chunk->next = tab->chunks;
+		tab->chunks = chunk;
+	}
+
+	key = memcpy(chunk->data + chunk->used, key, len);
+	chunk->used += len;
+
+	return key;
+}
+
+void oscap_strtab_init(struct oscap_strtab *tab, size_t min_size, size_t chunk_size)
+{
+	tab->slots      = NULL;
+	tab->size       = 0;
+	tab->count      = 0;
+	tab->min_size   = min_size;
+	tab->chunk_size = chunk_size;
+	tab->chunks     = NULL;
+	tab->keydup     = NULL;
+	tab->keydup_arg = NULL;
+}
+
+void oscap_strtab_clear(struct oscap_strtab *tab)
+{
+	struct oscap_strtab_chunk *chunk, *next;
+
+	for (chunk = tab->chunks; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		oscap_free(chunk);
+	}
+	oscap_free(tab->slots);
+
+	tab->slots  = NULL;
+	tab->size   = 0;
+	tab->count  = 0;
+	tab->chunks = NULL;
+}
+
+struct oscap_strtab_slot *oscap_strtab_lookup(const struct oscap_strtab *tab, const char *key)
+{
+	struct oscap_strtab_slot *slot;
+
+	if (tab->count == 0)
+		return NULL;
+
+	slot = _strtab_find(tab, key, _strtab_hash(key));
+
+	return slot->key != NULL ? slot : NULL;
+}
+
+struct oscap_strtab_slot *oscap_strtab_insert(struct oscap_strtab *tab, const char *key, bool *added)
+{
+	struct oscap_strtab_slot *slot;
+	uint32_t hash = _strtab_hash(key);
+
+	/* keep the load factor under 3/4 */
+	if ((tab->count + 1) * 4 > tab->size * 3)
+		_strtab_grow(tab);
+
+	slot = _strtab_find(tab, key, hash);
+	*added = slot->key == NULL;
+
+	if (*added) {
+		slot->hash = hash;
+		slot->key  = _strtab_keydup(tab, key);
+		slot->data = NULL;
+		++tab->count;
+	}
+
+	return slot;
+}
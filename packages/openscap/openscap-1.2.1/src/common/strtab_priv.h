@@ -0,0 +1,87 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#pragma once
+#ifndef _OSCAP_STRTAB_PRIV_H
+#define _OSCAP_STRTAB_PRIV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "util.h"
+
+OSCAP_HIDDEN_START;
+
+/*
+ * Hash table keyed by strings. Open addressing with linear probing, the
+ * slots keep the hash of the key, so the keys are compared only when the
+ * hashes match. The keys are copied into chunks owned by the table
+ * instead of being allocated one by one, or by the `keydup' function
+ * the table was initialized with.
+ *
+ * The table is not thread-safe and it is embedded into the structures
+ * which use it (the string pool, oval_string_map).
+ */
+
+struct oscap_strtab_slot {
+	uint32_t    hash;
+	const char *key;   /* NULL if the slot is empty */
+	void       *data;
+};
+
+struct oscap_strtab_chunk;
+
+struct oscap_strtab {
+	struct oscap_strtab_slot  *slots;
+	size_t                     size;  /* power of two or zero */
+	size_t                     count;
+	size_t                     min_size;
+	size_t                     chunk_size;
+	struct oscap_strtab_chunk *chunks;
+	char *(*keydup)(void *arg, const char *key);
+	void  *keydup_arg;
+};
+
+/**
+ * Initialize an empty table. The slots are allocated by the first insert.
+ * @param min_size initial number of slots, a power of two
+ * @param chunk_size size of the chunks the keys are copied into
+ */
+void oscap_strtab_init(struct oscap_strtab *tab, size_t min_size, size_t chunk_size);
+
+/**
+ * Free the slots and the copies of the keys. The table is left empty.
+ */
+void oscap_strtab_clear(struct oscap_strtab *tab);
+
+/**
+ * Find the slot of `key'.
+ * @returns the slot or NULL if the key is not in the table
+ */
+struct oscap_strtab_slot *oscap_strtab_lookup(const struct oscap_strtab *tab, const char *key);
+
+/**
+ * Find the slot of `key' and add it if it is not in the table yet. The
+ * added slot has a copy of the key and NULL data. The slots may move,
+ * the returned one is valid until the next insert.
+ * @param added set to whether the key was added
+ */
+struct oscap_strtab_slot *oscap_strtab_insert(struct oscap_strtab *tab, const char *key, bool *added);
+
+OSCAP_HIDDEN_END;
+
+#endif
@@ -0,0 +1,288 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <libxml/xmlsave.h>
+#include <libxml/globals.h>
+
+#include "alloc.h"
+#include "_error.h"
+#include "debug_priv.h"
+#include "xmlstream_priv.h"
+
+/* Same limit of the indentation as in libxml2's xmlsave.c */
+#define XML_STREAM_MAX_INDENT 60
+
+struct oscap_xml_stream_elm {
+	xmlNode *node;
+	bool     started; /* start tag has been written */
+};
+
+struct oscap_xml_stream {
+	xmlDoc *doc;
+	xmlOutputBuffer *buf;
+	int fd;
+	struct oscap_xml_stream_elm *stack;
+	size_t depth;
+	size_t size;
+	int error;
+};
+
+static void _stream_write(struct oscap_xml_stream *stream, const char *str, int len)
+{
+	if (len > 0 && xmlOutputBufferWrite(stream->buf, len, str) < 0)
+		stream->error = 1;
+}
+
+static void _stream_indent(struct oscap_xml_stream *stream, size_t level)
+{
+	int len = xmlTreeIndentString != NULL ? strlen(xmlTreeIndentString) : 0;
+
+	if (!xmlIndentTreeOutput || len == 0)
+		return;
+
+	if (level > (size_t)(XML_STREAM_MAX_INDENT / len))
+		level = XML_STREAM_MAX_INDENT / len;
+
+	while (level-- > 0)
+		_stream_write(stream, xmlTreeIndentString, len);
+}
+
+/*
+ * While the whole document is being saved libxml2 sets its encoding,
+ * which changes how attributes are escaped. Do the same for the parts.
+ */
+static void _stream_dump(xmlOutputBuffer *buf, xmlDoc *doc, xmlNode *node, size_t level)
+{
+	const xmlChar *encoding = doc->encoding;
+
+	if (encoding == NULL)
+		doc->encoding = BAD_CAST "UTF-8";
+
+	xmlNodeDumpOutput(buf, doc, node, level, 1, "UTF-8");
+	doc->encoding = encoding;
+}
+
+static void _stream_start_tag(struct oscap_xml_stream *stream, size_t i)
+{
+	xmlNode *node = stream->stack[i].node;
+	xmlNode *children, *last;
+	xmlOutputBuffer *mem;
+	const xmlChar *tag;
+	size_t len;
+
+	mem = xmlAllocOutputBuffer(NULL);
+	if (mem == NULL) {
+		stream->error = 1;
+		return;
+	}
+
+	/* Dump the element without its children ("<name .../>") and reopen it */
+	children = node->children;
+	last = node->last;
+	node->children = node->last = NULL;
+
+	_stream_dump(mem, stream->doc, node, i);
+
+	node->children = children;
+	node->last = last;
+
+	tag = xmlOutputBufferGetContent(mem);
+	len = xmlOutputBufferGetSize(mem);
+
+	if (tag == NULL || len < 2 || strncmp((const char *)tag + len - 2, "/>", 2) != 0) {
+		dE("Unexpected start tag of element '%s'.\n", node->name);
+		stream->error = 1;
+	} else {
+		_stream_indent(stream, i);
+		_stream_write(stream, (const char *)tag, len - 2);
+		_stream_write(stream, ">\n", 2);
+	}
+
+	xmlOutputBufferClose(mem);
+	stream->stack[i].started = true;
+}
+
+static void _stream_start(struct oscap_xml_stream *stream, size_t depth)
+{
+	for (size_t i = 0; i < depth; ++i)
+		if (!stream->stack[i].started)
+			_stream_start_tag(stream, i);
+}
+
+struct oscap_xml_stream *oscap_xml_stream_new(const char *filename, xmlDoc *doc)
+{
+	struct oscap_xml_stream *stream;
+	xmlOutputBuffer *buf;
+	int fd = -1;
+
+	if (strcmp(filename, "-") == 0) {
+		buf = xmlOutputBufferCreateFilename(filename, NULL, 0);
+	} else {
+		fd = open(filename, O_CREAT|O_TRUNC|O_WRONLY,
+			S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH);
+		if (fd < 0) {
+			oscap_seterr(OSCAP_EFAMILY_GLIBC, "%s '%s'", strerror(errno), filename);
+			return NULL;
+		}
+		buf = xmlOutputBufferCreateFd(fd, NULL);
+	}
+
+	if (buf == NULL) {
+		oscap_setxmlerr(xmlGetLastError());
+		if (fd >= 0)
+			close(fd);
+		return NULL;
+	}
+
+	stream = oscap_talloc(struct oscap_xml_stream);
+	stream->doc   = doc;
+	stream->buf   = buf;
+	stream->fd    = fd;
+	stream->stack = NULL;
+	stream->depth = 0;
+	stream->size  = 0;
+	stream->error = 0;
+
+	_stream_write(stream, "<?xml version=\"", 15);
+	_stream_write(stream, (const char *)doc->version, strlen((const char *)doc->version));
+	_stream_write(stream, "\" encoding=\"UTF-8\"?>\n", 21);
+
+	return stream;
+}
+
+int oscap_xml_stream_push(struct oscap_xml_stream *stream, xmlNode *node)
+{
+	if (stream == NULL)
+		return 0;
+
+	if (stream->depth == stream->size) {
+		stream->size  = stream->size > 0 ? stream->size * 2 : 8;
+		stream->stack = oscap_realloc(stream->stack, sizeof(struct oscap_xml_stream_elm) * stream->size);
+	}
+
+	stream->stack[stream->depth].node    = node;
+	stream->stack[stream->depth].started = false;
+	++stream->depth;
+
+	return 0;
+}
+
+int oscap_xml_stream_flush(struct oscap_xml_stream *stream)
+{
+	xmlNode *parent, *child;
+
+	if (stream == NULL || stream->depth == 0)
+		return 0;
+
+	parent = stream->stack[stream->depth - 1].node;
+
+	while ((child = parent->children) != NULL) {
+		_stream_start(stream, stream->depth);
+		_stream_indent(stream, stream->depth);
+		_stream_dump(stream->buf, stream->doc, child, stream->depth);
+		_stream_write(stream, "\n", 1);
+
+		xmlUnlinkNode(child);
+		xmlFreeNode(child);
+	}
+
+	return stream->error ? -1 : 0;
+}
+
+int oscap_xml_stream_copy(struct oscap_xml_stream *stream, xmlDoc *doc, xmlNode *node)
+{
+	if (stream == NULL || stream->depth == 0)
+		return 0;
+
+	oscap_xml_stream_flush(stream);
+
+	_stream_start(stream, stream->depth);
+	_stream_indent(stream, stream->depth);
+	_stream_dump(stream->buf, doc, node, stream->depth);
+	_stream_write(stream, "\n", 1);
+
+	return stream->error ? -1 : 0;
+}
+
+int oscap_xml_stream_pop(struct oscap_xml_stream *stream)
+{
+	struct oscap_xml_stream_elm *elm;
+
+	if (stream == NULL || stream->depth == 0)
+		return 0;
+
+	oscap_xml_stream_flush(stream);
+	elm = &stream->stack[--stream->depth];
+
+	if (elm->started) {
+		_stream_indent(stream, stream->depth);
+		_stream_write(stream, "</", 2);
+		if (elm->node->ns != NULL && elm->node->ns->prefix != NULL) {
+			_stream_write(stream, (const char *)elm->node->ns->prefix, strlen((const char *)elm->node->ns->prefix));
+			_stream_write(stream, ":", 1);
+		}
+		_stream_write(stream, (const char *)elm->node->name, strlen((const char *)elm->node->name));
+		_stream_write(stream, ">\n", 2);
+	} else {
+		/* no children, written as an empty element */
+		_stream_start(stream, stream->depth);
+		_stream_indent(stream, stream->depth);
+		_stream_dump(stream->buf, stream->doc, elm->node, stream->depth);
+		_stream_write(stream, "\n", 1);
+	}
+
+	if (stream->depth > 0) {
+		xmlUnlinkNode(elm->node);
+		xmlFreeNode(elm->node);
+	}
+
+	return stream->error ? -1 : 0;
+}
+
+int oscap_xml_stream_close(struct oscap_xml_stream *stream)
+{
+	int ret;
+
+	if (stream == NULL)
+		return 0;
+
+	while (stream->depth > 0)
+		oscap_xml_stream_pop(stream);
+
+	ret = xmlOutputBufferClose(stream->buf);
+	if (stream->fd >= 0)
+		close(stream->fd);
+
+	if (ret < 0 || stream->error) {
+		oscap_seterr(OSCAP_EFAMILY_XML, "Failed to write the XML document.");
+		ret = -1;
+	} else
+		ret = 0;
+
+	oscap_free(stream->stack);
+	oscap_free(stream);
+
+	return ret;
+}
@@ -0,0 +1,90 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#pragma once
+#ifndef _OSCAP_XMLSTREAM_PRIV_H
+#define _OSCAP_XMLSTREAM_PRIV_H
+
+#include "util.h"
+#include <libxml/tree.h>
+
+OSCAP_HIDDEN_START;
+
+/*
+ * Incremental writer of documents built by the *_to_dom() functions.
+ *
+ * The document is still built as a DOM, but only the path from the root
+ * to the element which is being filled in (the open elements) is kept.
+ * Whenever a subtree is complete it is written out and freed, so the
+ * memory needed does not grow with the size of the document.
+ *
+ * The output is byte-identical to oscap_xml_save_filename() of the
+ * whole document (UTF-8, formatted), provided that the open elements
+ * don't get any text content and that their attributes and namespace
+ * declarations are complete when they are pushed.
+ *
+ * All functions accept a NULL stream and do nothing then, so the same
+ * code can build a complete DOM or stream it.
+ */
+struct oscap_xml_stream;
+
+/**
+ * Start writing the document `doc' to `filename' ("-" is stdout).
+ * @returns the stream or NULL on error
+ */
+struct oscap_xml_stream *oscap_xml_stream_new(const char *filename, xmlDoc *doc);
+
+/**
+ * Open the element `node', which has just been added to the innermost
+ * open element or as the root of the document. Its start tag is written
+ * together with its first child, children it already has are written
+ * by the next flush.
+ * @returns zero on success
+ */
+int oscap_xml_stream_push(struct oscap_xml_stream *stream, xmlNode *node);
+
+/**
+ * Write and free the children of the innermost open element.
+ * @returns zero on success
+ */
+int oscap_xml_stream_flush(struct oscap_xml_stream *stream);
+
+/**
+ * Write `node' of another document `doc' as the next child of the
+ * innermost open element. The node is neither copied nor modified, it
+ * has to declare all the namespaces it uses.
+ * @returns zero on success
+ */
+int oscap_xml_stream_copy(struct oscap_xml_stream *stream, xmlDoc *doc, xmlNode *node);
+
+/**
+ * Flush and close the innermost open element. Every element but the
+ * root is freed.
+ * @returns zero on success
+ */
+int oscap_xml_stream_pop(struct oscap_xml_stream *stream);
+
+/**
+ * Close all open elements, finish the output and free the stream.
+ * The document itself is not freed.
+ * @returns zero on success, -1 if anything failed to be written
+ */
+int oscap_xml_stream_close(struct oscap_xml_stream *stream);
+
+OSCAP_HIDDEN_END;
+
+#endif
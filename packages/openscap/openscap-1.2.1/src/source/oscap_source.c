@@ -192,6 +192,15 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 	return source->xml.doc;
 }
 
+void oscap_source_free_xmlDoc(struct oscap_source *source)
+{
+	if (source->origin.type == OSCAP_SRC_FROM_XML_DOM || source->xml.doc == NULL) {
+		return;
+	}
+	xmlFreeDoc(source->xml.doc);
+	source->xml.doc = NULL;
+}
+
 int oscap_source_validate(struct oscap_source *source, xml_reporter reporter, void *user)
 {
 	int ret = oscap_source_validate_priv(source, oscap_source_get_scap_type(source),
@@ -63,6 +63,15 @@ xmlTextReader *oscap_source_get_xmlTextReader(struct oscap_source *source);
  */
 xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source);
 
+/**
+ * Release the DOM representation of this resource if it can be built
+ * again from the file or memory the resource originated from. Resources
+ * built from xmlDoc keep their document.
+ * @memberof oscap_source
+ * @param source Resource to release the DOM of
+ */
+void oscap_source_free_xmlDoc(struct oscap_source *source);
+
 OSCAP_HIDDEN_END;
 
 #endif
@@ -26,8 +26,9 @@ function test_api_oval_syschar {
 }
 
 function test_api_oval_results {
-    ./test_api_results $srcdir/results.xml exported-results.xml
-    cmp $srcdir/results-good.xml exported-results.xml
+    ./test_api_results $srcdir/results.xml exported-results.xml exported-results-dom.xml
+    cmp $srcdir/results-good.xml exported-results.xml || return 1
+    cmp exported-results-dom.xml exported-results.xml
 }
 
 function test_api_oval_directives {
@@ -35,6 +36,10 @@ function test_api_oval_directives {
     cmp $srcdir/directives.xml exported-directives.xml
 }
 
+function test_oval_string_map {
+    ./test_oval_string_map
+}
+
 # Testing.
 
 test_init "test_api_oval.log"
@@ -43,5 +48,6 @@ test_run "test_api_oval_definition" test_api_oval_definition
 test_run "test_api_oval_syschar" test_api_oval_syschar
 test_run "test_api_oval_results" test_api_oval_results
 test_run "test_api_oval_directives" test_api_oval_directives
+test_run "test_oval_string_map" test_oval_string_map
 
 test_exit
@@ -0,0 +1,114 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "OVAL/adt/oval_string_map_impl.h"
+#include "../../assume.h"
+
+#define KEYS 1000
+
+static void _key(char *buf, size_t size, int i)
+{
+	/* not inserted in the order of the keys */
+	snprintf(buf, size, "oval:test:obj:%d", (i * 7919) % KEYS);
+}
+
+/* The keys and values are listed in the descending strcmp() order of the keys */
+static void _test_order_after_growth(void)
+{
+	struct oval_string_map *map = oval_string_map_new();
+	struct oval_iterator *it;
+	char key[64], *prev = NULL;
+	int i, count;
+
+	for (i = 0; i < KEYS; ++i) {
+		_key(key, sizeof key, i);
+		oval_string_map_put_string(map, key, key);
+	}
+
+	for (i = 0; i < KEYS; ++i) {
+		_key(key, sizeof key, i);
+		assume(strcmp(oval_string_map_get_value(map, key), key) == 0);
+	}
+	assume(oval_string_map_get_value(map, "oval:test:obj:missing") == NULL);
+
+	/* the second listing of keys must not differ from the first one */
+	for (int pass = 0; pass < 2; ++pass) {
+		it = oval_string_map_keys(map);
+		for (count = 0, prev = NULL; oval_collection_iterator_has_more(it); ++count) {
+			char *k = oval_collection_iterator_next(it);
+			assume(prev == NULL || strcmp(prev, k) > 0);
+			prev = k;
+		}
+		oval_collection_iterator_free(it);
+		assume(count == KEYS);
+	}
+
+	/* a put after a listing is listed too */
+	oval_string_map_put_string(map, "oval:test:obj:0000", "new");
+	it = oval_string_map_values(map);
+	for (count = 0; oval_collection_iterator_has_more(it); ++count) {
+		char *v = oval_collection_iterator_next(it);
+		/* "oval:test:obj:1" > "oval:test:obj:0000" > "oval:test:obj:0" */
+		assume((count == KEYS - 1) == (strcmp(v, "new") == 0));
+	}
+	oval_collection_iterator_free(it);
+	assume(count == KEYS + 1);
+
+	oval_string_map_free_string(map);
+}
+
+/* A put of an existing key keeps the first value */
+static void _test_duplicate_keys(void)
+{
+	struct oval_string_map *map = oval_string_map_new();
+	struct oval_collection *values;
+	struct oval_iterator *it;
+	static int first, second;
+	int count = 0;
+
+	oval_string_map_put(map, "oval:test:var:1", &first);
+	oval_string_map_put(map, "oval:test:var:1", &second);
+	oval_string_map_put_string(map, "oval:test:var:2", "first");
+	oval_string_map_put_string(map, "oval:test:var:2", "second");
+
+	assume(oval_string_map_get_value(map, "oval:test:var:1") == &first);
+	assume(strcmp(oval_string_map_get_value(map, "oval:test:var:2"), "first") == 0);
+
+	values = oval_string_map_collect_values(map, NULL);
+	it = oval_collection_iterator(values);
+	while (oval_collection_iterator_has_more(it)) {
+		oval_collection_iterator_next(it);
+		++count;
+	}
+	oval_collection_iterator_free(it);
+	oval_collection_free(values);
+	assume(count == 2);
+
+	free(oval_string_map_get_value(map, "oval:test:var:2"));
+	oval_string_map_free0(map);
+}
+
+int main(int argc, char *argv[])
+{
+	_test_order_after_growth();
+	_test_duplicate_keys();
+	return 0;
+}
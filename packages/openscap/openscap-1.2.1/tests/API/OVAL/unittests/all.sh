@@ -23,4 +23,10 @@ test_run "ipv4_address: 'subset of' operation" $srcdir/test_ipv4_subset_of.sh
 test_run "ipv4_address: comparison" $srcdir/test_ipv4_comparison.sh
 test_run "textfilecontent: 'line' comparison" $srcdir/test_filecontent_line.sh
 test_run "anyxml element" $srcdir/test_anyxml.sh
+test_run "parallel collection gives serial results" $srcdir/test_eval_threads.sh
+test_run "persistent probe cache" $srcdir/test_probe_cache.sh
+test_run "equal objects are collected once" $srcdir/test_object_dedup.sh
+test_run "compiled state: values of the entities" $srcdir/test_state_compiled.sh
+test_run "compiled state: var_ref entities" $srcdir/test_state_varref.sh
+test_run "compiled state: interpreted entities" $srcdir/test_state_interpret.sh
 test_exit
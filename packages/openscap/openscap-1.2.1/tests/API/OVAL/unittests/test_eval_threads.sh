@@ -0,0 +1,30 @@
+#!/bin/bash
+
+set -e
+set -o pipefail
+
+name=$(basename $0 .sh)
+result_serial=$(mktemp -t ${name}.res.XXXXXX)
+result_parallel=$(mktemp -t ${name}.res.XXXXXX)
+stderr=$(mktemp -t ${name}.err.XXXXXX)
+
+$OSCAP oval eval --results $result_serial $srcdir/$name.oval.xml 2> $stderr
+[ ! -s $stderr ]
+$OSCAP oval eval --threads 4 --results $result_parallel $srcdir/$name.oval.xml 2> $stderr
+[ ! -s $stderr ]
+rm $stderr
+
+for result in $result_serial $result_parallel; do
+	[ "$($XPATH $result 'string(/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1"]/@result)')" == "true" ]
+	[ "$($XPATH $result 'string(/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:2"]/@result)')" == "true" ]
+	[ "$($XPATH $result 'string(/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:3"]/@result)')" == "true" ]
+	for i in 1 2 3 4 5; do
+		[ "$($XPATH $result 'string(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:'$i'"]/@flag)')" == "complete" ]
+	done
+	[ "$($XPATH $result 'string(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:6"]/@flag)')" == "does not exist" ]
+done
+
+[ "$($XPATH $result_serial 'count(/oval_results/results/system/oval_system_characteristics/system_data/*)')" == \
+  "$($XPATH $result_parallel 'count(/oval_results/results/system/oval_system_characteristics/system_data/*)')" ]
+
+rm $result_serial $result_parallel
@@ -0,0 +1,51 @@
+#!/bin/bash
+
+set -e
+set -o pipefail
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -d -t ${name}.XXXXXX)
+result=$tmpdir/results.xml
+stderr=$tmpdir/stderr
+
+# the persistent probe cache counts the objects which reach the probe
+export OSCAP_PROBE_CACHE_DIR=$tmpdir/cache
+stats=$OSCAP_PROBE_CACHE_DIR/probe_textfilecontent54/stats
+
+function eval_def() {
+	rm -rf $OSCAP_PROBE_CACHE_DIR
+	$OSCAP oval eval --id $1 --results $result $tmpdir/$name.oval.xml 2> $stderr
+	[ ! -s $stderr ]
+	[ "$($XPATH $result 'string(/oval_results/results/system/definitions/definition[@definition_id="'$1'"]/@result)')" == "true" ]
+}
+
+function object_flag() {
+	$XPATH $result 'string(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="'$1'"]/@flag)'
+}
+
+function object_items() {
+	$XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="'$1'"]/reference)'
+}
+
+function stat_value() {
+	sed -n "s/^$1 //p" $stats
+}
+
+sed "s|@DIR@|$tmpdir|" $srcdir/$name.oval.xml > $tmpdir/$name.oval.xml
+echo "shared value" > $tmpdir/file
+
+# oval:x:obj:2 is equal to oval:x:obj:1 and doesn't reach the probe
+eval_def oval:x:def:1
+[ "$(stat_value lookups)" == "2" ]
+[ "$(stat_value hits)" == "0" ]
+[ "$(object_flag oval:x:obj:2)" == "complete" ]
+[ "$(object_items oval:x:obj:2)" == "1" ]
+[ "$(object_flag oval:x:obj:4)" == "does not exist" ]
+
+# but the probe collects it when a set refers to it
+eval_def oval:x:def:2
+[ "$(stat_value hits)" == "1" ]
+[ "$(object_flag oval:x:obj:3)" == "complete" ]
+[ "$(object_items oval:x:obj:3)" == "1" ]
+
+rm -rf $tmpdir
@@ -0,0 +1,49 @@
+#!/bin/bash
+
+set -e
+set -o pipefail
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -d -t ${name}.XXXXXX)
+result=$tmpdir/results.xml
+stderr=$tmpdir/stderr
+
+export OSCAP_PROBE_CACHE_DIR=$tmpdir/cache
+stats=$OSCAP_PROBE_CACHE_DIR/probe_textfilecontent54/stats
+
+function eval_def() {
+	$OSCAP oval eval --results $result $tmpdir/$name.oval.xml 2> $stderr
+	[ ! -s $stderr ]
+	[ "$($XPATH $result 'string(/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1"]/@result)')" == "$1" ]
+}
+
+function stat_value() {
+	sed -n "s/^$1 //p" $stats
+}
+
+sed "s|@DIR@|$tmpdir|" $srcdir/$name.oval.xml > $tmpdir/$name.oval.xml
+echo "cached value" > $tmpdir/file
+
+# the first scan fills the cache
+eval_def true
+[ "$(stat_value misses)" == "1" ]
+[ "$(stat_value stores)" == "1" ]
+
+# the second one uses the cached object
+eval_def true
+[ "$(stat_value hits)" == "1" ]
+[ "$(stat_value stores)" == "0" ]
+
+# a modified file invalidates the entry
+echo "modified value" > $tmpdir/file
+eval_def false
+[ "$(stat_value stale)" == "1" ]
+[ "$(stat_value stores)" == "1" ]
+
+# strict mode doesn't use the cache
+echo "cached value" > $tmpdir/file
+OSCAP_PROBE_CACHE_STRICT=1 eval_def true
+[ "$(stat_value bypassed)" == "1" ]
+[ "$(stat_value hits)" == "0" ]
+
+rm -rf $tmpdir
@@ -0,0 +1,42 @@
+#!/bin/bash
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+result=$(mktemp ${name}.out.XXXXXX)
+echo "result file: $result"
+stderr=$(mktemp ${name}.err.XXXXXX)
+echo "stderr file: $stderr"
+
+echo "Analysing syschar content."
+$OSCAP oval analyse --results $result $srcdir/$name.oval.xml $srcdir/$name.syschar.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]; rm $stderr
+[ -f $result ]
+
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:2"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:3"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:4"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:5"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/tested_item[@item_id="1"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/tested_item[@item_id="2"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/tested_item[@item_id="3"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:2"]/tested_item[@item_id="1"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:2"]/tested_item[@item_id="2"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:2"]/tested_item[@item_id="3"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:2"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:3"]/tested_item[@item_id="1"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:3"]/tested_item[@item_id="2"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:3"]/tested_item[@item_id="3"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:3"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:4"]/tested_item[@item_id="1"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:4"]/tested_item[@item_id="2"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:4"]/tested_item[@item_id="3"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:4"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:5"]/tested_item[@item_id="1"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:5"]/tested_item[@item_id="2"][@result="true"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:5"]/tested_item[@item_id="3"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:5"][@result="false"]'
+
+rm $result
@@ -0,0 +1,24 @@
+#!/bin/bash
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+result=$(mktemp ${name}.out.XXXXXX)
+echo "result file: $result"
+stderr=$(mktemp ${name}.err.XXXXXX)
+echo "stderr file: $stderr"
+
+# The state entity has no value, which the schema does not allow. The
+# compiled state has to fall back to the interpreter and give its results.
+echo "Analysing syschar content."
+$OSCAP oval analyse --skip-valid --results $result $srcdir/$name.oval.xml $srcdir/$name.syschar.xml 2> $stderr
+[ -f $stderr ]; grep -q "found NULL entity value" $stderr; rm $stderr
+[ -f $result ]
+
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/tested_item[@item_id="1"][@result="error"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/tested_item[@item_id="2"][@result="error"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/tested_item[@item_id="3"][@result="false"]'
+assert_exists 1 '/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"][@result="false"]'
+
+rm $result
@@ -476,6 +476,11 @@ function test_api_seap_concurency {
     return $ret_val
 }
 
+function test_api_seap_binary {
+    ./test_api_seap_binary || return 1
+    ./test_api_seap_binary bench 2000 2
+}
+
 function test_api_strto {
     ./test_api_strto
 }
@@ -493,6 +498,7 @@ test_run "test_api_seap_list"                 ./test_api_seap_list
 test_run "test_api_seap_number_expression"    ./test_api_seap_number
 test_run "test_api_seap_string_expression"    ./test_api_seap_string
 test_run "test_api_SEXP_deepcmp"              ./test_api_SEXP_deepcmp
+test_run "test_api_seap_binary"               test_api_seap_binary
 test_run "test_api_strto"                     ./test_api_strto
 
 test_exit
@@ -0,0 +1,496 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <strbuf.h>
+#include <sexp.h>
+#include <seap.h>
+
+/*
+ * Checks that S-exps encoded in the binary transport format decode to
+ * the same objects as when the textual format is used.
+ *
+ * It also checks that a receiver decodes a textual message followed by
+ * binary frames in the same chunk.
+ *
+ * Run with "bench [items] [rounds]" to compare the speed and the size
+ * of both formats on a collected object sized message.
+ */
+
+static bool same (const SEXP_t *a, const SEXP_t *b)
+{
+        const char *da, *db;
+
+        da = SEXP_datatype (a);
+        db = SEXP_datatype (b);
+
+        if ((da == NULL) != (db == NULL) || (da != NULL && strcmp (da, db) != 0))
+                return (false);
+
+        if (SEXP_listp (a)) {
+                uint32_t i, n;
+
+                if (!SEXP_listp (b) || (n = SEXP_list_length (a)) != SEXP_list_length (b))
+                        return (false);
+
+                for (i = 1; i <= n; ++i) {
+                        SEXP_t *ma, *mb;
+                        bool r;
+
+                        ma = SEXP_list_nth (a, i);
+                        mb = SEXP_list_nth (b, i);
+                        r  = same (ma, mb);
+
+                        SEXP_free (ma);
+                        SEXP_free (mb);
+
+                        if (!r)
+                                return (false);
+                }
+
+                return (true);
+        }
+
+        if (SEXP_numberp (a) &&
+            (!SEXP_numberp (b) || SEXP_number_type (a) != SEXP_number_type (b)))
+                return (false);
+
+        return SEXP_deepcmp (a, b);
+}
+
+static SEXP_t *parse_t (strbuf_t *sb)
+{
+        SEXP_psetup_t *psetup;
+        SEXP_pstate_t *pstate = NULL;
+        SEXP_t *list;
+        char   *buf;
+
+        buf    = strbuf_cstr (sb);
+        psetup = SEXP_psetup_new ();
+        list   = SEXP_parse (psetup, buf, strbuf_length (sb), &pstate);
+
+        SEXP_psetup_free (psetup);
+
+        if (pstate != NULL)
+                SEXP_pstate_free (pstate);
+
+        free (buf);
+
+        return (list);
+}
+
+static SEXP_t *sample (void)
+{
+        SEXP_t *s_exp, *a, *b, *c, *d, *e, *f;
+
+        a = SEXP_string_newf ("test_item");
+        b = SEXP_string_newf (":id");
+        c = SEXP_number_newu_32 (12345);
+        d = SEXP_list_new (a, b, c, NULL);
+        SEXP_vfree (a, b, c, NULL);
+
+        a = SEXP_string_newf ("path");
+        b = SEXP_string_new ("/etc/passwd", 11);
+        c = SEXP_list_new (a, b, NULL);
+        SEXP_vfree (a, b, NULL);
+
+        a = SEXP_string_new ("", 0);
+        b = SEXP_list_new (NULL);
+        e = SEXP_number_newb (true);
+        f = SEXP_number_newb (false);
+        s_exp = SEXP_list_new (d, c, a, b, e, f, NULL);
+        SEXP_vfree (a, b, c, d, e, f, NULL);
+
+        a = SEXP_number_newi_8 (-1);
+        b = SEXP_number_newi_16 (-300);
+        c = SEXP_number_newi_32 (-70000);
+        d = SEXP_number_newi_64 (-5000000000LL);
+        e = SEXP_number_newi_32 (42);
+        f = SEXP_number_newf (0.5);
+        SEXP_list_add (s_exp, a);
+        SEXP_list_add (s_exp, b);
+        SEXP_list_add (s_exp, c);
+        SEXP_list_add (s_exp, d);
+        SEXP_list_add (s_exp, e);
+        SEXP_list_add (s_exp, f);
+        SEXP_vfree (a, b, c, d, e, f, NULL);
+
+        a = SEXP_number_newu_8 (255);
+        b = SEXP_number_newu_16 (256);
+        c = SEXP_number_newu_32 (65536);
+        d = SEXP_number_newu_64 (UINT64_MAX);
+        e = SEXP_string_new ("a\0b", 3);
+        f = SEXP_string_newf ("evr");
+        SEXP_datatype_set (f, "evr_str");
+        SEXP_list_add (s_exp, a);
+        SEXP_list_add (s_exp, b);
+        SEXP_list_add (s_exp, c);
+        SEXP_list_add (s_exp, d);
+        SEXP_list_add (s_exp, e);
+        SEXP_list_add (s_exp, f);
+        SEXP_vfree (a, b, c, d, e, f, NULL);
+
+        /* doubles keep the precision and type of the textual format */
+        a = SEXP_number_newf (4.0);
+        b = SEXP_number_newf (-2.0);
+        c = SEXP_number_newf (1234567.891);
+        SEXP_list_add (s_exp, a);
+        SEXP_list_add (s_exp, b);
+        SEXP_list_add (s_exp, c);
+        SEXP_vfree (a, b, c, NULL);
+
+        return (s_exp);
+}
+
+static int test_roundtrip (void)
+{
+        SEXP_bostate_t *ostate;
+        SEXP_bpstate_t *pstate;
+        SEXP_t *s_exp, *s_bin, *s_txt, *m_bin, *m_txt;
+        strbuf_t *sb_b, *sb_t;
+        char  *buf;
+        size_t len, first = 0, i;
+        int    ret = 0;
+
+        s_exp  = sample ();
+        ostate = SEXP_bostate_new ();
+        sb_b   = strbuf_new (SEAP_STRBUF_MAX);
+        sb_t   = strbuf_new (SEAP_STRBUF_MAX);
+
+        /* the second and third frames use symbols defined by the first one */
+        for (i = 0; i < 3; ++i) {
+                if (SEXP_sbprintf_b (s_exp, sb_b, ostate) != 0 ||
+                    SEXP_sbprintf_t (s_exp, sb_t) != 0)
+                {
+                        printf ("encoding failed\n");
+                        return (1);
+                }
+
+                if (i == 0)
+                        first = strbuf_length (sb_b);
+        }
+
+        s_txt = parse_t (sb_t);
+        buf   = strbuf_cstr (sb_b);
+        len   = strbuf_length (sb_b);
+
+        printf ("text: %zu bytes, binary: %zu bytes\n", strbuf_length (sb_t), len);
+
+        /* whole stream at once and then byte by byte */
+        for (i = 0; i < 2; ++i) {
+                pstate = SEXP_bpstate_new ();
+
+                if (i == 0)
+                        s_bin = SEXP_parse_b (pstate, buf, len);
+                else {
+                        size_t j;
+
+                        s_bin = SEXP_list_new (NULL);
+
+                        for (j = 0; j < len; ++j) {
+                                SEXP_t *part = SEXP_parse_b (pstate, buf + j, 1);
+
+                                if (part == NULL)
+                                        break;
+
+                                while ((m_bin = SEXP_list_pop (part)) != NULL) {
+                                        SEXP_list_add (s_bin, m_bin);
+                                        SEXP_free (m_bin);
+                                }
+
+                                SEXP_free (part);
+                        }
+                }
+
+                if (s_bin == NULL || SEXP_list_length (s_bin) != 3 || SEXP_bpstate_pending (pstate)) {
+                        printf ("decoding failed (%zu)\n", i);
+                        ret = 1;
+                } else {
+                        uint32_t n;
+
+                        for (n = 1; n <= 3; ++n) {
+                                m_bin = SEXP_list_nth (s_bin, n);
+                                m_txt = SEXP_list_nth (s_txt, n);
+
+                                if (!same (m_bin, m_txt)) {
+                                        printf ("frame %u differs (%zu)\n", n, i);
+                                        ret = 1;
+                                }
+
+                                SEXP_free (m_bin);
+                                SEXP_free (m_txt);
+                        }
+                }
+
+                SEXP_free (s_bin);
+                SEXP_bpstate_free (pstate);
+        }
+
+        /* symbol references can't be resolved without the defining frame */
+        pstate = SEXP_bpstate_new ();
+        s_bin  = SEXP_parse_b (pstate, buf + first, len - first);
+
+        if (s_bin != NULL) {
+                printf ("undefined symbol accepted\n");
+                SEXP_free (s_bin);
+                ret = 1;
+        }
+
+        SEXP_bpstate_free (pstate);
+
+        free (buf);
+        strbuf_free (sb_b);
+        strbuf_free (sb_t);
+        SEXP_bostate_free (ostate);
+        SEXP_free (s_txt);
+        SEXP_free (s_exp);
+
+        return (ret);
+}
+
+static SEXP_t *seap_msg (uint32_t id, const char *data, size_t len)
+{
+        SEXP_t *msg, *a, *b, *c, *d;
+
+        a = SEXP_string_newf ("seap.msg");
+        b = SEXP_string_newf (":id");
+        c = SEXP_number_newu_32 (id);
+        d = SEXP_string_new (data, len);
+        msg = SEXP_list_new (a, b, c, d, NULL);
+        SEXP_vfree (a, b, c, d, NULL);
+
+        return (msg);
+}
+
+/*
+ * The sending side switches to binary frames right after a textual
+ * message. Both end up in the same chunk read by the receiver.
+ */
+static int test_mixed (void)
+{
+        static const char data_t[] = "(te)xt\xb5\"";
+        static const char data_b[] = "binary";
+        SEAP_CTX_t *ctx;
+        SEAP_msg_t *msg;
+        SEXP_bostate_t *ostate;
+        SEXP_t *s_exp, *m_t, *m_b;
+        strbuf_t *sb;
+        char  *buf;
+        size_t len;
+        int    fd[2], sd, ret = 0;
+        uint32_t i;
+
+        if (socketpair (AF_UNIX, SOCK_STREAM, 0, fd) != 0) {
+                printf ("socketpair failed\n");
+                return (1);
+        }
+
+        /* raw data of the textual message contains the frame magic and parens */
+        m_t    = seap_msg (1, data_t, sizeof data_t - 1);
+        m_b    = seap_msg (2, data_b, sizeof data_b - 1);
+        ostate = SEXP_bostate_new ();
+        sb     = strbuf_new (SEAP_STRBUF_MAX);
+
+        if (SEXP_sbprintf_t (m_t, sb) != 0 ||
+            SEXP_sbprintf_b (m_b, sb, ostate) != 0 ||
+            SEXP_sbprintf_b (m_b, sb, ostate) != 0)
+        {
+                printf ("encoding failed\n");
+                return (1);
+        }
+
+        buf = strbuf_cstr (sb);
+        len = strbuf_length (sb);
+
+        if (write (fd[1], buf, len) != (ssize_t)len) {
+                printf ("write failed\n");
+                return (1);
+        }
+
+        ctx = SEAP_CTX_new ();
+        sd  = SEAP_openfd2 (ctx, fd[0], fd[0], 0);
+
+        for (i = 1; i <= 3; ++i) {
+                const char *data = i == 1 ? data_t : data_b;
+                size_t      dlen = i == 1 ? sizeof data_t - 1 : sizeof data_b - 1;
+
+                if (SEAP_recvmsg (ctx, sd, &msg) != 0) {
+                        printf ("message %u not received: %s\n", i, strerror (errno));
+                        ret = 1;
+                        break;
+                }
+
+                s_exp = SEAP_msg_get (msg);
+
+                if (SEAP_msg_id (msg) != (i == 1 ? 1 : 2) ||
+                    SEXP_string_length (s_exp) != dlen ||
+                    SEXP_strncmp (s_exp, data, dlen) != 0)
+                {
+                        printf ("message %u differs\n", i);
+                        ret = 1;
+                }
+
+                SEXP_free (s_exp);
+                SEAP_msg_free (msg);
+        }
+
+        close (fd[1]);
+        SEAP_close (ctx, sd);
+        SEAP_CTX_free (ctx);
+        free (buf);
+        strbuf_free (sb);
+        SEXP_bostate_free (ostate);
+        SEXP_vfree (m_t, m_b, NULL);
+
+        return (ret);
+}
+
+/*
+ * A reply similar to what a file probe sends for a large object
+ */
+static SEXP_t *bench_message (unsigned int items)
+{
+        SEXP_t *msg, *item, *attr, *ent, *a, *b, *c;
+        unsigned int i;
+
+        msg = SEXP_list_new (NULL);
+
+        for (i = 0; i < items; ++i) {
+                a = SEXP_string_newf ("file_item");
+                b = SEXP_string_newf (":id");
+                c = SEXP_number_newu_32 (i);
+                attr = SEXP_list_new (a, b, c, NULL);
+                SEXP_vfree (a, b, c, NULL);
+
+                item = SEXP_list_new (attr, NULL);
+                SEXP_free (attr);
+
+#define BENCH_ENT(name, val) do {                               \
+                        a = SEXP_string_newf (name);            \
+                        ent = SEXP_list_new (a, val, NULL);     \
+                        SEXP_list_add (item, ent);              \
+                        SEXP_vfree (a, ent, val, NULL);         \
+                } while (0)
+
+                BENCH_ENT("path", SEXP_string_newf ("/usr/share/doc/package-%u", i / 16));
+                BENCH_ENT("filename", SEXP_string_newf ("file-%u.txt", i));
+                BENCH_ENT("type", SEXP_string_newf ("regular"));
+                BENCH_ENT("group_id", SEXP_number_newu_32 (0));
+                BENCH_ENT("user_id", SEXP_number_newu_32 (0));
+                BENCH_ENT("a_time", SEXP_number_newu_64 (1400000000 + i));
+                BENCH_ENT("c_time", SEXP_number_newu_64 (1400000000 + i));
+                BENCH_ENT("m_time", SEXP_number_newu_64 (1400000000 + i));
+                BENCH_ENT("size", SEXP_number_newu_64 (4096 + i));
+                BENCH_ENT("uread", SEXP_number_newb (true));
+                BENCH_ENT("uwrite", SEXP_number_newb (true));
+                BENCH_ENT("uexec", SEXP_number_newb (false));
+                BENCH_ENT("gread", SEXP_number_newb (true));
+                BENCH_ENT("oread", SEXP_number_newb (true));
+#undef BENCH_ENT
+                SEXP_list_add (msg, item);
+                SEXP_free (item);
+        }
+
+        return (msg);
+}
+
+static double now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+
+        return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static int bench (unsigned int items, unsigned int rounds)
+{
+        SEXP_t *msg, *res;
+        strbuf_t *sb;
+        unsigned int r;
+        size_t len_t = 0, len_b = 0;
+        double t, enc_t = 0, dec_t = 0, enc_b = 0, dec_b = 0;
+        char  *buf;
+
+        msg = bench_message (items);
+
+        for (r = 0; r < rounds; ++r) {
+                SEXP_psetup_t  *psetup;
+                SEXP_pstate_t  *pstate = NULL;
+                SEXP_bostate_t *bostate;
+                SEXP_bpstate_t *bpstate;
+
+                /* textual */
+                sb = strbuf_new (SEAP_STRBUF_MAX);
+                t  = now ();
+                SEXP_sbprintf_t (msg, sb);
+                enc_t += now () - t;
+
+                len_t  = strbuf_length (sb);
+                buf    = strbuf_cstr (sb);
+                psetup = SEXP_psetup_new ();
+                t   = now ();
+                res = SEXP_parse (psetup, buf, len_t, &pstate);
+                dec_t += now () - t;
+
+                if (res == NULL)
+                        return (1);
+
+                SEXP_free (res);
+                SEXP_psetup_free (psetup);
+                strbuf_free (sb);
+                free (buf);
+
+                /* binary */
+                bostate = SEXP_bostate_new ();
+                bpstate = SEXP_bpstate_new ();
+                sb = strbuf_new (SEAP_STRBUF_MAX);
+                t  = now ();
+                SEXP_sbprintf_b (msg, sb, bostate);
+                enc_b += now () - t;
+
+                len_b = strbuf_length (sb);
+                buf   = strbuf_cstr (sb);
+                t   = now ();
+                res = SEXP_parse_b (bpstate, buf, len_b);
+                dec_b += now () - t;
+
+                if (res == NULL || SEXP_list_length (res) != 1)
+                        return (1);
+
+                SEXP_free (res);
+                SEXP_bostate_free (bostate);
+                SEXP_bpstate_free (bpstate);
+                strbuf_free (sb);
+                free (buf);
+        }
+
+        printf ("%u items, %u rounds\n", items, rounds);
+        printf ("text:   %9zu bytes, encode %8.3f ms, decode %8.3f ms\n",
+                len_t, enc_t * 1000 / rounds, dec_t * 1000 / rounds);
+        printf ("binary: %9zu bytes, encode %8.3f ms, decode %8.3f ms\n",
+                len_b, enc_b * 1000 / rounds, dec_b * 1000 / rounds);
+
+        SEXP_free (msg);
+
+        return (0);
+}
+
+int main (int argc, char *argv[])
+{
+        setbuf (stdout, NULL);
+
+        if (argc > 1 && strcmp (argv[1], "bench") == 0)
+                return bench (argc > 2 ? strtoul (argv[2], NULL, 10) : 10000,
+                              argc > 3 ? strtoul (argv[3], NULL, 10) : 10);
+
+        return (test_roundtrip () | test_mixed ());
+}
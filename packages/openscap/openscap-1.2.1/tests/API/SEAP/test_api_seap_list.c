@@ -459,5 +459,47 @@ int main (void)
 		SEXP_vfree (r0, r1, r3, NULL);
         }
 
+        {
+                /* test SEXP_list_add_array() */
+                SEXP_t  *l1, *l2, *l3, *a[1000];
+                uint32_t i;
+
+                for (i = 0; i < 1000; ++i)
+                        a[i] = SEXP_number_newu_32 (i);
+
+                l1 = SEXP_list_new (NULL);
+                l2 = SEXP_list_new (NULL);
+
+                for (i = 0; i < 1000; ++i)
+                        SEXP_list_add (l1, a[i]);
+
+                SEXP_list_add_array (l2, a, 0);
+                SEXP_list_add_array (l2, a, 1);
+                SEXP_list_add_array (l2, a + 1, 300);
+                SEXP_list_add_array (l2, a + 301, 699);
+
+                if (SEXP_list_length (l2) != 1000 || !SEXP_deepcmp (l1, l2)) {
+                        printf ("SEXP_list_add_array: lists differ\n");
+                        return (1);
+                }
+
+                /* the elements are appended to a copy of a shared list */
+                l3 = SEXP_ref (l2);
+                SEXP_list_add_array (l3, a, 10);
+
+                if (SEXP_list_length (l2) != 1000 || !SEXP_deepcmp (l1, l2)
+                    || SEXP_list_length (l3) != 1010) {
+                        printf ("SEXP_list_add_array: shared list modified\n");
+                        return (1);
+                }
+
+                printf ("l=%zu\n", SEXP_list_length (l3));
+
+                for (i = 0; i < 1000; ++i)
+                        SEXP_free (a[i]);
+
+                SEXP_vfree (l1, l2, l3, NULL);
+        }
+
         return (0);
 }
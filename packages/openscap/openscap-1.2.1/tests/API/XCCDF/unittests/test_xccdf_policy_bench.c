@@ -0,0 +1,157 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <xccdf_benchmark.h>
+#include <xccdf_policy.h>
+
+#include "unit_helper.h"
+#include <../../../assume.h>
+
+#define BENCH_FILE "test_xccdf_policy_bench.xccdf.xml.out"
+
+static double elapsed(struct timeval *t0)
+{
+	struct timeval t1;
+
+	gettimeofday(&t1, NULL);
+	return (t1.tv_sec - t0->tv_sec) * 1000.0 + (t1.tv_usec - t0->tv_usec) / 1000.0;
+}
+
+/*
+ * Every rule of the profile is selected and refined, every value has
+ * a refine-value and every other value has a set-value too.
+ */
+static void generate(const char *filename, int rules, int values)
+{
+	FILE *f = fopen(filename, "w");
+	int i;
+
+	assume(f != NULL);
+	fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<Benchmark xmlns=\"http://checklists.nist.gov/xccdf/1.1\" id=\"bench\">\n"
+		"  <status>draft</status>\n"
+		"  <version>1.0</version>\n"
+		"  <Profile id=\"bench-profile\">\n"
+		"    <title>Synthetic profile</title>\n");
+	for (i = 0; i < rules; ++i)
+		fprintf(f, "    <select idref=\"rule-%d\" selected=\"true\"/>\n", i);
+	for (i = 0; i < values; i += 2)
+		fprintf(f, "    <set-value idref=\"value-%d\">set</set-value>\n", i);
+	for (i = 0; i < values; ++i)
+		fprintf(f, "    <refine-value idref=\"value-%d\" selector=\"alt\"/>\n", i);
+	for (i = 0; i < rules; ++i)
+		fprintf(f, "    <refine-rule idref=\"rule-%d\" severity=\"high\" selector=\"alt\"/>\n", i);
+	fprintf(f, "  </Profile>\n");
+	for (i = 0; i < values; ++i)
+		fprintf(f, "  <Value id=\"value-%d\" type=\"string\">\n"
+			"    <value>default</value>\n"
+			"    <value selector=\"alt\">alt</value>\n"
+			"  </Value>\n", i);
+	for (i = 0; i < rules; ++i)
+		fprintf(f, "  <Rule id=\"rule-%d\" selected=\"false\" severity=\"low\">\n"
+			"    <check system=\"http://check-engine.test/fail\">\n"
+			"      <check-content-ref href=\"file\" name=\"def-%d\"/>\n"
+			"    </check>\n"
+			"    <check system=\"http://check-engine.test/pass\" selector=\"alt\">\n"
+			"      <check-export value-id=\"value-%d\" export-name=\"var-%d\"/>\n"
+			"      <check-content-ref href=\"file\" name=\"def-%d\"/>\n"
+			"    </check>\n"
+			"  </Rule>\n", i, i, i % values, i, i);
+	fprintf(f, "</Benchmark>\n");
+	assume(fclose(f) == 0);
+}
+
+/*
+ * Measure the creation of the policy, its evaluation and tailoring of
+ * all items on a synthetic benchmark.
+ *
+ * Usage: test_xccdf_policy_bench <rules>
+ */
+int main(int argc, char *argv[])
+{
+	struct timeval t0;
+	double policy_ms, evaluate_ms, tailor_ms;
+	char id[32];
+	int rules, values, i, count = 0;
+
+	assume(argc == 2);
+	rules = atoi(argv[1]);
+	assume(rules > 0);
+	values = rules / 10 + 1;
+
+	generate(BENCH_FILE, rules, values);
+	struct xccdf_policy_model *model = uh_load_xccdf(BENCH_FILE);
+	struct xccdf_benchmark *benchmark = xccdf_policy_model_get_benchmark(model);
+	assume(benchmark != NULL);
+	uh_register_simple_engines(model);
+
+	gettimeofday(&t0, NULL);
+	struct xccdf_policy *policy = xccdf_policy_model_get_policy_by_id(model, "bench-profile");
+	policy_ms = elapsed(&t0);
+	assume(policy != NULL);
+
+	/* the refined selector picks the passing check */
+	gettimeofday(&t0, NULL);
+	struct xccdf_result *result = xccdf_policy_evaluate(policy);
+	evaluate_ms = elapsed(&t0);
+	assume(result != NULL);
+
+	struct xccdf_rule_result_iterator *rr_it = xccdf_result_get_rule_results(result);
+	while (xccdf_rule_result_iterator_has_more(rr_it)) {
+		struct xccdf_rule_result *rr = xccdf_rule_result_iterator_next(rr_it);
+		assume(xccdf_rule_result_get_result(rr) == XCCDF_RESULT_PASS);
+		++count;
+	}
+	xccdf_rule_result_iterator_free(rr_it);
+	assume(count == rules);
+
+	gettimeofday(&t0, NULL);
+	for (i = 0; i < rules; ++i) {
+		snprintf(id, sizeof id, "rule-%d", i);
+		struct xccdf_item *item = xccdf_benchmark_get_item(benchmark, id);
+		struct xccdf_item *tailored = xccdf_policy_tailor_item(policy, item);
+		assume(tailored != item);
+		assume(xccdf_rule_get_severity((struct xccdf_rule *) tailored) == XCCDF_HIGH);
+		xccdf_rule_free(tailored);
+	}
+	for (i = 0; i < values; ++i) {
+		snprintf(id, sizeof id, "value-%d", i);
+		struct xccdf_item *item = xccdf_benchmark_get_item(benchmark, id);
+		const char *value = xccdf_policy_get_value_of_item(policy, item);
+		assume(value != NULL && strcmp(value, (i % 2 == 0) ? "set" : "alt") == 0);
+	}
+	tailor_ms = elapsed(&t0);
+
+	/* set-values added to the profile later on take effect too */
+	struct xccdf_setvalue *sv = xccdf_setvalue_new();
+	assume(xccdf_setvalue_set_item(sv, "value-1"));
+	assume(xccdf_setvalue_set_value(sv, "added"));
+	assume(xccdf_profile_add_setvalue(xccdf_policy_get_profile(policy), sv));
+	const char *added = xccdf_policy_get_value_of_item(policy, xccdf_benchmark_get_item(benchmark, "value-1"));
+	assume(added != NULL && strcmp(added, "added") == 0);
+
+	printf("rules=%d values=%d policy_ms=%.0f evaluate_ms=%.0f tailor_ms=%.0f\n",
+		rules, values, policy_ms, evaluate_ms, tailor_ms);
+
+	xccdf_policy_model_free(model);
+	return 0;
+}
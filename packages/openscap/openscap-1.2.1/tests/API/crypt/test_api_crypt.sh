@@ -61,8 +61,9 @@ function test_crapi_mdigest {
     dd if=/dev/urandom of="${TEMPDIR}/d" count=321 bs=1  || return 2
     dd if=/dev/urandom of="${TEMPDIR}/e" count=1   bs=1024k || return 2
     dd if=/dev/urandom of="${TEMPDIR}/f" count=312 bs=1  || return 2
+    dd if=/dev/urandom of="${TEMPDIR}/g" count=3   bs=1000k || return 2
     
-    for file in a b c d e f; do
+    for file in a b c d e f g; do
         sum_md5=$((md5sum "${TEMPDIR}/${file}" || openssl md5 "${TEMPDIR}/${file}") | sed -n 's|^.*\([0-9a-f]\{32\}\).*$|\1|p')
         sum_sha1=$((sha1sum "${TEMPDIR}/${file}" || openssl sha1 "${TEMPDIR}/${file}") | sed -n 's|^.*\([0-9a-f]\{40\}\).*$|\1|p')
         sum_sha256=$((sha256sum "${TEMPDIR}/${file}" || openssl sha256 "${TEMPDIR}/${file}") | sed -n 's|^.*\([0-9a-f]\{64\}\).*$|\1|p')
@@ -80,11 +81,24 @@ function test_crapi_mdigest {
     return 0
 }
 
+function test_crapi_bench {
+    local TEMPDIR="$(mktemp -d -t -q tmp.XXXXXX)"
+
+    dd if=/dev/urandom of="${TEMPDIR}/a" count=16 bs=1024k || return 2
+
+    ./test_crapi_bench "${TEMPDIR}/a" 2 || return 1
+
+    rm -rf "$TEMPDIR"
+
+    return 0
+}
+
 # Testing.
 
 test_init "test_api_crypt.log"
 
 test_run "test_crapi_digest" test_crapi_digest
 test_run "test_crapi_mdigest" test_crapi_mdigest
+test_run "test_crapi_bench" test_crapi_bench
 
 test_exit
@@ -0,0 +1,155 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <crapi/crapi.h>
+#include <crapi/digest.h>
+
+static const struct {
+        crapi_alg_t alg;
+        const char *name;
+} algs[] = {
+        { CRAPI_DIGEST_MD5,    "MD5"     },
+        { CRAPI_DIGEST_SHA1,   "SHA-1"   },
+        { CRAPI_DIGEST_SHA224, "SHA-224" },
+        { CRAPI_DIGEST_SHA256, "SHA-256" },
+        { CRAPI_DIGEST_SHA384, "SHA-384" },
+        { CRAPI_DIGEST_SHA512, "SHA-512" },
+        { CRAPI_DIGEST_RMD160, "RMD-160" }
+};
+
+#define ALG_CNT (sizeof algs / sizeof algs[0])
+
+static double elapsed (struct timeval *t0)
+{
+        struct timeval t1;
+
+        gettimeofday (&t1, NULL);
+
+        return (t1.tv_sec - t0->tv_sec) + (t1.tv_usec - t0->tv_usec) / 1e6;
+}
+
+static int digest (const char *filename, int num, const crapi_alg_t alg[])
+{
+        uint8_t dst[ALG_CNT][64];
+        size_t  size[ALG_CNT];
+        void   *dstv[ALG_CNT];
+        size_t *sizev[ALG_CNT];
+        int     fd, i, ret;
+
+        for (i = 0; i < num; ++i) {
+                size[i]  = sizeof dst[i];
+                dstv[i]  = dst[i];
+                sizev[i] = &size[i];
+        }
+
+        fd = open (filename, O_RDONLY);
+
+        if (fd < 0) {
+                perror ("open");
+                return (-1);
+        }
+
+        ret = crapi_mdigest_fdv (fd, num, alg, dstv, sizev);
+        close (fd);
+
+        for (i = 0; i < num; ++i)
+                if (size[i] == 0)
+                        ret = -1;
+
+        return (ret);
+}
+
+/*
+ * Print the throughput of each algorithm and of all of them
+ * computed in one pass over the file.
+ *
+ * Usage: test_crapi_bench <file> [<rounds>]
+ */
+int main (int argc, char *argv[])
+{
+        crapi_alg_t all[ALG_CNT];
+        struct timeval t0;
+        struct stat st;
+        double mb, sum = 0, t;
+        int rounds = 1, r;
+        unsigned int i;
+
+        if (argc < 2) {
+                fprintf (stderr, "Usage: %s <file> [<rounds>]\n", argv[0]);
+                return (1);
+        }
+
+        if (argc > 2)
+                rounds = atoi (argv[2]);
+
+        if (stat (argv[1], &st) != 0) {
+                perror ("stat");
+                return (2);
+        }
+
+        if (crapi_init (NULL) != 0) {
+                fprintf (stderr, "crapi_init() != 0\n");
+                return (2);
+        }
+
+        mb = (double)st.st_size * rounds / (1024 * 1024);
+
+        for (i = 0; i < ALG_CNT; ++i) {
+                all[i] = algs[i].alg;
+                gettimeofday (&t0, NULL);
+
+                for (r = 0; r < rounds; ++r) {
+                        if (digest (argv[1], 1, &algs[i].alg) != 0) {
+                                fprintf (stderr, "%s: digest failed\n", algs[i].name);
+                                return (1);
+                        }
+                }
+
+                t = elapsed (&t0);
+                sum += t;
+                printf ("alg=%s size=%jd rounds=%d time_ms=%.0f MB/s=%.1f\n",
+                        algs[i].name, (intmax_t)st.st_size, rounds, t * 1000, t > 0 ? mb / t : 0);
+        }
+
+        gettimeofday (&t0, NULL);
+
+        for (r = 0; r < rounds; ++r) {
+                if (digest (argv[1], ALG_CNT, all) != 0) {
+                        fprintf (stderr, "all: digest failed\n");
+                        return (1);
+                }
+        }
+
+        t = elapsed (&t0);
+        printf ("alg=all size=%jd rounds=%d time_ms=%.0f MB/s=%.1f separate_ms=%.0f\n",
+                (intmax_t)st.st_size, rounds, t * 1000, t > 0 ? mb / t : 0, sum * 1000);
+
+        return (0);
+}
@@ -4,5 +4,6 @@
 
 test_init "test_api_probes.log"
 test_run "fts test" $srcdir/fts.sh
+test_run "fts cache benchmark" $srcdir/fts_bench.sh
 test_run "probe api smoke test" ./test_api_probes_smoke
 test_exit
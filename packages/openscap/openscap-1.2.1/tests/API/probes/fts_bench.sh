@@ -0,0 +1,77 @@
+#!/bin/bash
+#
+# Walk the same tree with many file objects with and without the
+# shared directory cache of oval_fts and compare the number of
+# directory reads and stat calls.
+#
+
+set -e -o pipefail
+
+OBJECTS=${OBJECTS:-40}
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -t -d "${name}.XXXXXX")
+ROOT=${tmpdir}/ftsroot
+echo "Temp dir: ${tmpdir}."
+
+echo "Generating tree for traversal" >&2
+for d1 in 0 1 2 3 4 5 6 7; do
+	for d2 in 0 1 2 3 4 5 6 7; do
+		for d3 in 0 1 2 3; do
+			mkdir -p $ROOT/$d1/$d2/$d3
+			touch $ROOT/$d1/$d2/$d3/f{0,1,2,3,4,5,6,7,8,9}
+		done
+	done
+done
+ln -s ../1 $ROOT/0/l1
+
+OSCAP_PROBE_FTS_CACHE_SIZE=0 ./oval_fts_bench $ROOT $OBJECTS | tee ${tmpdir}/nocache.out
+OSCAP_PROBE_FTS_THREADS=1 ./oval_fts_bench $ROOT $OBJECTS | tee ${tmpdir}/cache.out
+OSCAP_PROBE_FTS_THREADS=4 ./oval_fts_bench $ROOT $OBJECTS | tee ${tmpdir}/prefetch.out
+
+function field {
+	sed -n "s/.* $1=\([0-9]*\).*/\1/p" $2
+}
+
+for out in cache prefetch; do
+	if [ "$(field matched ${tmpdir}/nocache.out)" != "$(field matched ${tmpdir}/$out.out)" ]; then
+		echo "The number of matched entries differs ($out)"
+		exit 1
+	fi
+done
+
+# with the cache, each directory is read by the first object only
+reads=$(field dir_reads ${tmpdir}/cache.out)
+if [ $(field dir_hits ${tmpdir}/cache.out) -ne $(( reads * (OBJECTS - 1) )) ]; then
+	echo "Unexpected number of cached directory reads"
+	exit 1
+fi
+
+if [ $(field dir_reads ${tmpdir}/nocache.out) -ne $(( reads * OBJECTS )) ]; then
+	echo "Unexpected number of directory reads without the cache"
+	exit 1
+fi
+
+# the prefetch reads the directories instead of the first walk
+if [ $(field dir_reads ${tmpdir}/prefetch.out) -ne $reads ] ||
+   [ $(field prefetched ${tmpdir}/prefetch.out) -eq 0 ]; then
+	echo "Unexpected number of directory reads with the prefetch"
+	exit 1
+fi
+
+# a file created in a nested directory after the first walk has to be
+# found by the other walks, the listings cached for its parents are valid
+for threads in 1 4; do
+	rm -f $ROOT/3/4/2/new0
+	OSCAP_PROBE_FTS_CACHE_SIZE=0 ./oval_fts_bench $ROOT 20 -1 down $ROOT/3/4/2/new0 > ${tmpdir}/change-nocache.out
+	rm -f $ROOT/3/4/2/new0
+	OSCAP_PROBE_FTS_THREADS=$threads ./oval_fts_bench $ROOT 20 -1 down $ROOT/3/4/2/new0 > ${tmpdir}/change-cache.out
+
+	if [ "$(field matched ${tmpdir}/change-nocache.out)" != "$(field matched ${tmpdir}/change-cache.out)" ]; then
+		echo "A change in a nested directory wasn't noticed ($threads threads)"
+		cat ${tmpdir}/change-nocache.out ${tmpdir}/change-cache.out
+		exit 1
+	fi
+done
+
+rm -rf ${tmpdir}
@@ -0,0 +1,116 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/time.h>
+#include "sexp.h"
+#include "oval_fts.h"
+
+static SEXP_t *parse_ent(SEXP_psetup_t *psetup, char *str)
+{
+	SEXP_pstate_t *pstate = NULL;
+	SEXP_t *list, *ent;
+
+	list = SEXP_parse(psetup, str, strlen(str), &pstate);
+	ent  = SEXP_list_first(list);
+	SEXP_free(list);
+
+	return ent;
+}
+
+/*
+ * Walk a tree with `count' file objects which differ only in the
+ * filename pattern and print the number of matched entries and the
+ * directory reads and stat calls done by the walks. If `new_file' is
+ * given, it's created after the first walk.
+ *
+ * Usage: oval_fts_bench <root> <count> [<max_depth> [<direction> [<new_file>]]]
+ */
+int main(int argc, char *argv[])
+{
+	OVAL_FTS    *ofts;
+	OVAL_FTSENT *ofts_ent;
+
+	SEXP_t *path, *filename, *behaviors;
+	SEXP_psetup_t *psetup;
+	char buf[PATH_MAX + 128];
+	oval_fts_cache_stats_t st;
+	struct timeval t0, t1;
+	unsigned long matched = 0;
+	int i, count;
+	const char *max_depth = "-1", *direction = "down", *new_file = NULL;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <root> <count> [<max_depth> [<direction> [<new_file>]]]\n", argv[0]);
+		return 2;
+	}
+
+	count = atoi(argv[2]);
+	if (argc > 3)
+		max_depth = argv[3];
+	if (argc > 4)
+		direction = argv[4];
+	if (argc > 5)
+		new_file = argv[5];
+
+	psetup = SEXP_psetup_new();
+
+	snprintf(buf, sizeof buf, "((path :operation 5) \"%s\")", argv[1]);
+	path = parse_ent(psetup, buf);
+	snprintf(buf, sizeof buf, "((behaviors :max_depth \"%s\" :recurse \"symlinks and directories\""
+		 " :recurse_direction \"%s\" :recurse_file_system \"all\"))", max_depth, direction);
+	behaviors = parse_ent(psetup, buf);
+
+	gettimeofday(&t0, NULL);
+
+	for (i = 0; i < count; ++i) {
+		snprintf(buf, sizeof buf, "((filename :operation 11) \"^.*%d$\")", i % 10);
+		filename = parse_ent(psetup, buf);
+
+		ofts = oval_fts_open(path, filename, NULL, behaviors);
+
+		if (ofts != NULL) {
+			while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
+				++matched;
+				oval_ftsent_free(ofts_ent);
+			}
+
+			oval_fts_close(ofts);
+		}
+
+		SEXP_free(filename);
+
+		if (i == 0 && new_file != NULL) {
+			FILE *fp = fopen(new_file, "w");
+
+			if (fp == NULL) {
+				perror(new_file);
+				return 2;
+			}
+			fclose(fp);
+		}
+	}
+
+	gettimeofday(&t1, NULL);
+	oval_fts_cache_stats(&st);
+
+	printf("objects=%d matched=%lu dir_reads=%llu dir_hits=%llu lstat=%llu stat=%llu prefetched=%llu steals=%llu cached_dirs=%llu cache_size=%zu time_ms=%ld\n",
+	       count, matched,
+	       (unsigned long long)st.dir_reads, (unsigned long long)st.dir_hits,
+	       (unsigned long long)st.lstat, (unsigned long long)st.stat,
+	       (unsigned long long)st.prefetched, (unsigned long long)st.steals,
+	       (unsigned long long)st.dir_count, st.size,
+	       (long)((t1.tv_sec - t0.tv_sec) * 1000 + (t1.tv_usec - t0.tv_usec) / 1000));
+
+	oval_fts_cache_reset();
+
+	SEXP_free(path);
+	SEXP_free(behaviors);
+	SEXP_psetup_free(psetup);
+
+	return 0;
+}
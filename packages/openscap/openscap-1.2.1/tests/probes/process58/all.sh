@@ -7,4 +7,5 @@ test_run "Ensure that selinux_domain_label is collected" $srcdir/selinux_domain_
 test_run "Ensure that tty number is translated into name" $srcdir/dev_to_tty.sh
 test_run "Ensure loguid return unsighned int (cat /proc/ID/loginuid)" $srcdir/loginuid.sh
 test_run "Ensure sessionid is correct" $srcdir/sessionid.sh
+test_run "Read a synthetic /proc of 1000 processes" ./test_proc_snapshot 1000 16
 test_exit
@@ -0,0 +1,215 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <ftw.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <../../../../src/OVAL/probes/unix/linux/proc-snapshot.c>
+#include "../../assume.h"
+
+#define PROC_ROOT "test_proc_snapshot.proc"
+#define PID_FIRST 100
+#define SHARED_INODE 1
+
+static double elapsed(struct timeval *t0)
+{
+	struct timeval t1;
+
+	gettimeofday(&t1, NULL);
+	return (t1.tv_sec - t0->tv_sec) * 1000.0 + (t1.tv_usec - t0->tv_usec) / 1000.0;
+}
+
+static void write_file(const char *path, const char *content)
+{
+	FILE *f = fopen(path, "w");
+
+	assume(f != NULL);
+	fputs(content, f);
+	assume(fclose(f) == 0);
+}
+
+static void generate_proc(int pid, int ppid, const char *comm, int uid, int fds)
+{
+	char path[PATH_MAX], buf[512], link[64];
+	int i;
+
+	snprintf(path, sizeof path, PROC_ROOT "/%d", pid);
+	assume(mkdir(path, 0755) == 0);
+
+	snprintf(path, sizeof path, PROC_ROOT "/%d/stat", pid);
+	snprintf(buf, sizeof buf, "%d (%s) S %d %d %d 34816 %d 4202752 1000 0 0 0 "
+		 "%d %d 0 0 20 0 1 0 %d 1000000 100 18446744073709551615\n",
+		 pid, comm, ppid, pid, pid, pid, pid * 100, pid, pid * 10);
+	write_file(path, buf);
+
+	snprintf(path, sizeof path, PROC_ROOT "/%d/status", pid);
+	snprintf(buf, sizeof buf, "Name:\t%s\nUmask:\t0022\nState:\tS (sleeping)\n"
+		 "Tgid:\t%d\nPid:\t%d\nPPid:\t%d\nUid:\t%d\t%d\t%d\t%d\n",
+		 comm, pid, pid, ppid, uid, uid + 1, uid, uid);
+	write_file(path, buf);
+
+	snprintf(path, sizeof path, PROC_ROOT "/%d/loginuid", pid);
+	snprintf(buf, sizeof buf, "%u", pid % 2 ? 4294967295U : (unsigned)uid);
+	write_file(path, buf);
+
+	snprintf(path, sizeof path, PROC_ROOT "/%d/fd", pid);
+	assume(mkdir(path, 0755) == 0);
+
+	for (i = 0; i < fds; ++i) {
+		if (i == 0)
+			snprintf(link, sizeof link, "/dev/null");
+		else if (i == 1)
+			snprintf(link, sizeof link, "socket:[%d]", SHARED_INODE);
+		else if (i == 2)
+			snprintf(link, sizeof link, "pipe:[%d]", pid * 1000 + i);
+		else
+			snprintf(link, sizeof link, "socket:[%d]", pid * 1000 + i);
+
+		snprintf(path, sizeof path, PROC_ROOT "/%d/fd/%d", pid, i);
+		assume(symlink(link, path) == 0);
+	}
+}
+
+/*
+ * Besides `procs' processes, the tree has the kernel thread daemon, a
+ * kernel thread and a few entries which aren't processes.
+ */
+static void generate(int procs, int fds)
+{
+	char comm[16];
+	int i;
+
+	assume(mkdir(PROC_ROOT, 0755) == 0);
+	assume(mkdir(PROC_ROOT "/sys", 0755) == 0);
+	write_file(PROC_ROOT "/stat", "cpu  1 2 3 4\ncpu0 1 2 3 4\nbtime 1400000000\n");
+	write_file(PROC_ROOT "/uptime", "1.00 2.00\n");
+
+	generate_proc(2, 0, "kthreadd", 0, 0);
+	generate_proc(3, 2, "ksoftirqd/0", 0, 0);
+
+	for (i = 0; i < procs; ++i) {
+		if (i == 0)
+			snprintf(comm, sizeof comm, "a) b");
+		else
+			snprintf(comm, sizeof comm, "proc%d", i);
+		generate_proc(PID_FIRST + i, 1, comm, i % 1000, fds);
+	}
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+	return remove(path);
+}
+
+static void check(struct proc_snapshot *snap, int procs, int fds)
+{
+	size_t i, j;
+
+	assume(snap != NULL);
+	assume(snap->count == (size_t)procs);
+	assume(snap->boot == 1400000000);
+
+	for (i = 0; i < snap->count; ++i) {
+		struct proc_entry *p = snap->proc + i;
+		int n = p->pid - PID_FIRST;
+		char comm[16];
+
+		assume(n >= 0 && n < procs);
+		if (n == 0)
+			snprintf(comm, sizeof comm, "a) b");
+		else
+			snprintf(comm, sizeof comm, "proc%d", n);
+
+		assume(strcmp(p->cmd, comm) == 0);
+		assume(p->ppid == 1);
+		assume(p->session == p->pid);
+		assume(p->tty_nr == 34816);
+		assume(p->utime == (unsigned long)p->pid * 100);
+		assume(p->priority == 20);
+		assume(p->start == (unsigned long long)p->pid * 10);
+		assume(p->ruid == n % 1000 && p->euid == n % 1000 + 1);
+		assume(p->loginuid == (p->pid % 2 ? 4294967295U : (unsigned)(n % 1000)));
+		assume(p->socket_count == (size_t)(fds - 2));
+
+		assume(proc_snapshot_socket(snap, p->pid * 1000 + 2) == NULL);
+		for (j = 3; j < (size_t)fds; ++j)
+			assume(proc_snapshot_socket(snap, p->pid * 1000 + j) == p);
+	}
+
+	/* the first process found in the directory has the shared socket */
+	assume(proc_snapshot_socket(snap, SHARED_INODE) == snap->proc);
+	assume(proc_snapshot_socket(snap, 2) == NULL);
+}
+
+/*
+ * Read a synthetic /proc tree with one and several threads and compare
+ * the snapshots.
+ *
+ * Usage: test_proc_snapshot <processes> <open files per process>
+ */
+int main(int argc, char *argv[])
+{
+	struct proc_snapshot *serial, *parallel;
+	struct timeval t0;
+	double serial_ms, parallel_ms, lookup_ms;
+	int procs, fds, i;
+	size_t n;
+
+	assume(argc == 3);
+	procs = atoi(argv[1]);
+	fds = atoi(argv[2]);
+	assume(procs > 0 && fds > 3);
+
+	nftw(PROC_ROOT, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+	generate(procs, fds);
+
+	assume(proc_snapshot_new(PROC_ROOT "/missing", PROC_SNAPSHOT_UIDS, 1) == NULL);
+
+	gettimeofday(&t0, NULL);
+	serial = proc_snapshot_new(PROC_ROOT, PROC_SNAPSHOT_UIDS | PROC_SNAPSHOT_LOGINUID | PROC_SNAPSHOT_SOCKETS, 1);
+	serial_ms = elapsed(&t0);
+	check(serial, procs, fds);
+
+	gettimeofday(&t0, NULL);
+	parallel = proc_snapshot_new(PROC_ROOT, PROC_SNAPSHOT_UIDS | PROC_SNAPSHOT_LOGINUID | PROC_SNAPSHOT_SOCKETS,
+				     PROC_SNAPSHOT_MAX_THREADS);
+	parallel_ms = elapsed(&t0);
+	check(parallel, procs, fds);
+
+	/* the threads don't change the order */
+	for (n = 0; n < serial->count; ++n)
+		assume(serial->proc[n].pid == parallel->proc[n].pid);
+
+	gettimeofday(&t0, NULL);
+	for (i = 0; i < procs * fds; ++i)
+		assume(proc_snapshot_socket(parallel, (PID_FIRST + i % procs) * 1000 + 3 + i % (fds - 3)) != NULL);
+	lookup_ms = elapsed(&t0);
+
+	printf("processes=%d fds=%d serial_ms=%.0f parallel_ms=%.0f lookup_ms=%.0f\n",
+		procs, fds, serial_ms, parallel_ms, lookup_ms);
+
+	proc_snapshot_free(serial);
+	proc_snapshot_free(parallel);
+	nftw(PROC_ROOT, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+
+	return 0;
+}
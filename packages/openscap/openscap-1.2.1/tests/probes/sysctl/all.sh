@@ -0,0 +1,8 @@
+#!/bin/bash
+
+. ../../test_common.sh
+
+test_init "test_probes_sysctl.log"
+test_run "direct read and snapshot give the same item" $srcdir/test_sysctl_names.sh
+test_run "interface name with a dot" $srcdir/test_sysctl_names.sh interface
+test_exit
@@ -0,0 +1,69 @@
+#!/bin/bash
+
+# A parameter named with "equals" is read directly from its file under
+# /proc/sys, other names are matched against a snapshot of the tree.
+# Both have to give the same item. The second case uses an interface
+# with a dot in its name, which the direct read can't find and has to
+# leave to the snapshot; it is created in a new network namespace.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -t -d "${name}.XXXXXX")
+tpl=${srcdir}/${name}.xml.tpl
+input=${tmpdir}/${name}.xml
+result=${tmpdir}/${name}.results.xml
+echo "Temp dir: $tmpdir"
+
+case "$1" in
+	interface)
+		if ! unshare -rn true 2> /dev/null || ! ip -V > /dev/null 2>&1; then
+			echo "Can't create a network namespace, skipping."
+			rm -rf $tmpdir
+			exit 255
+		fi
+		param=net.ipv4.conf.oscap.1.rp_filter
+		regex='^net\.ipv4\.conf\.oscap\.1\.rp_filter$'
+		expected=2
+		;;
+	*)
+		param=kernel.ostype
+		regex='^kernel\.ostype$'
+		expected=$(cat /proc/sys/kernel/ostype)
+		;;
+esac
+
+# prepare the environment
+sed -e "s@%NAME%@${param}@" -e "s@%REGEX%@${regex}@" $tpl > $input
+
+echo "Evaluating content."
+if [ "$1" == "interface" ]; then
+	# system_info needs an address, so lo is brought up
+	unshare -rn bash -e -c "
+		ip link set lo up
+		ip link add name oscap.1 type veth peer name oscap.2
+		echo $expected > /proc/sys/net/ipv4/conf/oscap.1/rp_filter
+		$OSCAP oval eval --results $result $input || [ \$? == 2 ]"
+else
+	$OSCAP oval eval --results $result $input || [ $? == 2 ]
+fi
+echo "Validating results."
+$OSCAP oval validate-xml --results $result
+
+function refs {
+	$XPATH $result "count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id=\"oval:x:obj:$1\"]/reference)"
+}
+
+function item {
+	$XPATH $result "string(/oval_results/results/system/oval_system_characteristics/system_data/*[@id=/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id=\"oval:x:obj:$1\"]/reference/@item_ref]/*[local-name()=\"$2\"])"
+}
+
+echo "Testing collected items."
+[ "$(refs 1)" == "1" ]
+[ "$(refs 2)" == "1" ]
+[ "$(item 1 name)" == "$param" ]
+[ "$(item 2 name)" == "$param" ]
+[ "$(item 1 value)" == "$expected" ]
+[ "$(item 2 value)" == "$expected" ]
+
+rm -rf $tmpdir
@@ -0,0 +1,56 @@
+#!/bin/bash
+
+# Patterns which can't match a newline are matched over a window of
+# complete lines, the others over the whole file. Both have to collect
+# the same items from a file bigger than the window and with a line
+# longer than it.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -t -d "${name}.XXXXXX")
+tpl=${srcdir}/${name}.xml.tpl
+input=${tmpdir}/${name}.xml
+result=${tmpdir}/${name}.results.xml
+echo "Temp dir: $tmpdir"
+
+# prepare the environment
+sed "s@%PATH%@${tmpdir}@" $tpl > $input
+for i in $(seq 0 19999); do
+	echo "key${i}=value${i}"
+done > ${tmpdir}/data
+printf "long=%0200000d\n" 0 | tr 0 x >> ${tmpdir}/data
+printf "last=end" >> ${tmpdir}/data
+
+echo "Evaluating content."
+$OSCAP oval eval --results $result $input || [ $? == 2 ]
+echo "Validating results."
+$OSCAP oval validate-xml --results $result
+
+function refs {
+	$XPATH $result "count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id=\"oval:x:obj:$1\"]/reference)"
+}
+
+function subexp {
+	$XPATH $result "string(/oval_results/results/system/oval_system_characteristics/system_data/*[@id=/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id=\"oval:x:obj:$1\"]/reference/@item_ref][*[local-name()=\"instance\"]=1]/*[local-name()=\"subexpression\"][$2])"
+}
+
+echo "Testing collected items."
+[ "$(refs 1)" == "1000" ]
+[ "$(refs 3)" == "1000" ]
+[ "$(subexp 1 2)" == "value1000" ]
+[ "$(subexp 3 2)" == "value1000" ]
+[ "$(refs 2)" == "1" ]
+long=$(subexp 2 1)
+[ "${#long}" == "200000" ]
+[ "$(refs 4)" == "1" ]
+[ "$(subexp 4 1)" == "value19999" ]
+[ "$(refs 5)" == "1" ]
+[ "$(subexp 5 1)" == "end" ]
+# ranges with escaped end points can match a newline
+for obj in 6 7 8; do
+	[ "$(refs $obj)" == "1" ]
+	[ "$(subexp $obj 1)" == "value19999" ]
+done
+
+rm -rf $tmpdir
@@ -21,6 +21,26 @@ static char *string_array_cstr(char **string_array)
 	return strdup(buf);
 }
 
+static int copy_file(const char *src, const char *dst)
+{
+	char   buf[4096];
+	size_t len;
+	FILE  *in, *out;
+
+	if ((in = fopen(src, "r")) == NULL)
+		return (-1);
+	if ((out = fopen(dst, "w")) == NULL) {
+		fclose(in);
+		return (-1);
+	}
+
+	while ((len = fread(buf, 1, sizeof buf, in)) > 0)
+		fwrite(buf, 1, len, out);
+
+	fclose(in);
+	return (fclose(out) == 0 ? 0 : -1);
+}
+
 int main (int argc, char *argv[])
 {
 	xiconf_t         *xcfg;
@@ -28,8 +48,12 @@ int main (int argc, char *argv[])
 
 	char *path, *serv, *prot;
 
-	if (argc != 4) {
-		fprintf(stderr, "Usage: %s <path> <service> <protocol>\n", argv[0]);
+	/*
+	 * If <updated path> is given, it's copied over <path> after <path>
+	 * is parsed and the service is looked up in the updated configuration.
+	 */
+	if (argc != 4 && argc != 5) {
+		fprintf(stderr, "Usage: %s <path> <service> <protocol> [<updated path>]\n", argv[0]);
 		return (1);
 	}
 
@@ -44,6 +68,18 @@ int main (int argc, char *argv[])
 		return (2);
 	}
 
+	if (argc == 5) {
+		if (copy_file(argv[4], path) != 0) {
+			fprintf(stderr, "Can't copy %s to %s.\n", argv[4], path);
+			return (1);
+		}
+
+		if (xiconf_update(xcfg) != 0) {
+			fprintf(stderr, "Update error.\n");
+			return (2);
+		}
+	}
+
 	xres = xiconf_getservice (xcfg, serv, prot);
 
 	if (xres == NULL) {
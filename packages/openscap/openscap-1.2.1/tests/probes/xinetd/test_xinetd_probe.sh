@@ -80,6 +80,20 @@ function test_probe_xinetd_duplicates {
     return 1
 }
 
+function test_probe_xinetd_update {
+    local conf="test_probe_xinetd_update.out.conf"
+    local output
+
+    cp "${srcdir}/xinetd_B.conf" "$conf" || return 1
+    output=$(./test_probe_xinetd "$conf" foo tcp "${srcdir}/xinetd_E.conf")
+    rm -f "$conf"
+
+    echo "$output" | grep -q 'xiconf_service_t(foo0)' || return 1
+    echo "$output" | grep -q 'server: /sbin/foo' || return 1
+
+    return 0
+}
+
 # Testing.
 
 test_init "test_probe_xinetd.log"
@@ -87,5 +101,6 @@ test_init "test_probe_xinetd.log"
 test_run "test_probe_xinetd_parser" test_probe_xinetd_parser
 test_run "xinetd parser regression test: string list" test_probe_xinetd_regression_stringlist
 test_run "test_probe_xinetd_duplicates" test_probe_xinetd_duplicates
+test_run "test_probe_xinetd_update" test_probe_xinetd_update
 
 test_exit
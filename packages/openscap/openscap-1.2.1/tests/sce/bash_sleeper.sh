@@ -0,0 +1,9 @@
+#!/usr/bin/env bash
+
+# Sleeps for the number of seconds passed in, several of these are
+# supposed to run at the same time
+echo "sleeping $XCCDF_VALUE_seconds"
+sleep $XCCDF_VALUE_seconds
+echo "woke up"
+
+exit $XCCDF_RESULT_PASS
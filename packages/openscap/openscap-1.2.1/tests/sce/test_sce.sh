@@ -42,10 +42,69 @@ function test_sce {
     fi
 }
 
+# Several scripts run at once, the results have to come in the order
+# of the rules nonetheless. The long sleeper runs out of time.
+function test_sce_parallel {
+
+    local DEFFILE=${srcdir}/$1
+    local RESFILE=$1.results
+
+    [ -f $RESFILE ] && rm -f $RESFILE
+
+    OSCAP_SCE_JOBS=4 OSCAP_SCE_TIMEOUT=5 \
+        $OSCAP xccdf eval --results "$RESFILE" --profile "default" "$DEFFILE"
+
+    # catch error from oscap tool
+    if [ $? -eq 1 ]; then
+	return 1
+    fi
+
+    local EXPECTED="rule-2000 pass rule-2001 pass rule-2002 error rule-2003 pass rule-2004 pass"
+    local RESULTS=`grep -o 'rule-result idref="[^"]*"\|<result>[a-z]*' "$RESFILE" | \
+        sed 's/rule-result idref="\(.*\)"/\1/; s/<result>//' | tr '\n' ' '`
+
+    if [ "$RESULTS" != "$EXPECTED " ]; then
+	echo "Unexpected results: $RESULTS"
+	return 1
+    fi
+
+    # the stdout of each script belongs to its rule
+    [ `grep -c "sleeping 1" "$RESFILE"` -eq 3 ] || return 1
+    grep -q "sleeping 60" "$RESFILE" || return 1
+    grep -q "has been killed after 5 seconds" "$RESFILE" || return 1
+}
+
+# The three one second sleepers have to run at the same time, one after
+# another they would take three seconds.
+function test_sce_parallel_time {
+
+    local DEFFILE=${srcdir}/$1
+    local RESFILE=$1.short.results
+
+    [ -f $RESFILE ] && rm -f $RESFILE
+
+    local START=`date +%s%N`
+    OSCAP_SCE_JOBS=4 \
+        $OSCAP xccdf eval --results "$RESFILE" --profile "short" "$DEFFILE"
+
+    # catch error from oscap tool
+    if [ $? -eq 1 ]; then
+	return 1
+    fi
+
+    local ELAPSED=$(( (`date +%s%N` - START) / 1000000 ))
+    echo "Evaluated in $ELAPSED ms"
+
+    [ `grep -c "<result>pass</result>" "$RESFILE"` -eq 4 ] || return 1
+    [ $ELAPSED -lt 2500 ] || return 1
+}
+
 # Testing.
 test_init "test_sce.log"
 
 test_run "sce" test_sce sce_xccdf.xml 
+test_run "sce_parallel" test_sce_parallel sce_parallel_xccdf.xml
+test_run "sce_parallel_time" test_sce_parallel_time sce_parallel_xccdf.xml
 
 test_exit
 
@@ -114,7 +114,8 @@ static struct oscap_module OVAL_EVAL = {
         "                        \r\t\t\t\t   (only applicable for source datastreams)\n"
         "   --oval-id <id> \r\t\t\t\t - ID of the OVAL component ref in the datastream to use.\n"
         "                  \r\t\t\t\t   (only applicable for source datastreams)\n"
-	"   --probe-root <dir>\r\t\t\t\t - Change the root directory before scanning the system.\n",
+	"   --probe-root <dir>\r\t\t\t\t - Change the root directory before scanning the system.\n"
+	"   --threads <n>\r\t\t\t\t - Number of threads used to collect system characteristics.\n",
     .opt_parser = getopt_oval_eval,
     .func = app_evaluate_oval
 };
@@ -414,6 +415,7 @@ int app_evaluate_oval(const struct oscap_action *action)
 
 	/* set product name */
 	oval_agent_set_product_name(sess, OSCAP_PRODUCTNAME);
+	oval_agent_set_eval_threads(sess, action->threads);
 
 	/* Evaluation */
 	if (action->id) {
@@ -613,13 +615,15 @@ enum oval_opt {
     OVAL_OPT_DATASTREAM_ID,
     OVAL_OPT_OVAL_ID,
     OVAL_OPT_OUTPUT = 'o',
-    OVAL_OPT_PROBE_ROOT
+    OVAL_OPT_PROBE_ROOT,
+    OVAL_OPT_THREADS
 };
 
 bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 {
 	action->doctype = OSCAP_DOCUMENT_OVAL_DEFINITIONS;
 	action->probe_root = NULL;
+	action->threads = 1;
 
 	/* Command-options */
 	struct option long_options[] = {
@@ -632,6 +636,7 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		{ "oval-id",    required_argument, NULL, OVAL_OPT_OVAL_ID},
 		{ "skip-valid",	no_argument, &action->validate, 0 },
 		{ "probe-root", required_argument, NULL, OVAL_OPT_PROBE_ROOT},
+		{ "threads",    required_argument, NULL, OVAL_OPT_THREADS},
 		{ 0, 0, 0, 0 }
 	};
 
@@ -646,6 +651,15 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		case OVAL_OPT_DATASTREAM_ID: action->f_datastream_id = optarg;	break;
 		case OVAL_OPT_OVAL_ID: action->f_oval_id = optarg;	break;
 		case OVAL_OPT_PROBE_ROOT: action->probe_root = optarg; break;
+		case OVAL_OPT_THREADS: {
+			char *end;
+			unsigned long threads = strtoul(optarg, &end, 10);
+
+			if (*optarg == '\0' || *end != '\0' || threads == 0 || threads > 1024)
+				return oscap_module_usage(action->module, stderr, "Invalid number of threads: %s", optarg);
+			action->threads = threads;
+			break;
+		}
 		case 0: break;
 		default: return oscap_module_usage(action->module, stderr, NULL);
 		}
@@ -149,6 +149,7 @@ struct oscap_action {
 	int export_variables;
         int list_dynamic;
 	char *probe_root;
+	unsigned int threads;
 };
 
 int app_xslt(const char *infile, const char *xsltfile, const char *outfile, const char **params);